@@ -0,0 +1,10 @@
+######################################################################
+# Benchmarks of the Simple Image Browser
+######################################################################
+
+TEMPLATE = subdirs
+SUBDIRS = exif \
+          imagescaler \
+          model \
+          scrolling \
+          thumbnails
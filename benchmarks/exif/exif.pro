@@ -0,0 +1,17 @@
+######################################################################
+# Throughput benchmark of the EXIF reader
+######################################################################
+
+TEMPLATE = app
+TARGET = tst_bench_exif
+INCLUDEPATH += . ../shared
+QT += testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include(../../simpleimagebrowser.pri)
+
+# Input
+HEADERS += ../shared/ibbenchmark.hpp
+SOURCES += ../shared/ibbenchmark.cpp \
+           tst_bench_exif.cpp
@@ -0,0 +1,284 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include <QFile>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "ibbenchmark.hpp"
+#include "ibexifreader.hpp"
+
+/* number of files of every layout of the corpus */
+static const int iCorpusSize = 1000;
+
+/* Appends the value (value) with the given number of bytes (size) in the given byte order (littleendian) to the
+   data (data). */
+static void appendValue(QByteArray *data, quint32 value, int size, bool littleendian)
+{
+   int idx;
+
+   for(idx = 0; idx < size; idx++)
+   {
+      data->append(char(littleendian ? value >> (8 * idx) : value >> (8 * (size - 1 - idx))));
+   }
+}
+
+/* Appends an IFD entry with the tag (tag), the type (type), the number of values (count) and the value or its offset
+   (value) in the given byte order (littleendian) to the data (data). */
+static void appendEntry(QByteArray *data, quint16 tag, quint16 type, quint32 count, quint32 value, bool littleendian)
+{
+   appendValue(data, tag, 2, littleendian);
+   appendValue(data, type, 2, littleendian);
+   appendValue(data, count, 4, littleendian);
+
+   /* a single short is stored in the first two bytes of the value */
+   if(type == 3 && count == 1)
+   {
+      appendValue(data, value, 2, littleendian);
+      appendValue(data, 0, 2, littleendian);
+   }
+   else
+   {
+      appendValue(data, value, 4, littleendian);
+   }
+}
+
+/* class IBExifBenchmark */
+
+class IBExifBenchmark : public QObject
+{
+   Q_OBJECT
+
+   private slots:
+      void initTestCase();
+
+      void readFile_data();
+      void readFile();
+      void parse_data();
+      void parse();
+
+   private:
+      static void addRows(bool metrics);
+      static QByteArray createTiff(int index, bool littleendian, int padding);
+      static QByteArray createJpeg(const QByteArray &tiff, int scansize);
+      static QByteArray createFile(const QString &layout, int index);
+
+      /* directory of the corpus, which is removed after the benchmark */
+      QTemporaryDir tdCorpus;
+      /* files of the corpus by their layout */
+      QHash<QString, QStringList> hshFiles;
+};
+
+/* Returns a TIFF structure with IFD0, which contains the camera model, the orientation and the timestamp of the
+   last modification, and the EXIF IFD, which contains the timestamp of the capture. The timestamps depend on the
+   index (index). The padding (padding) is inserted between the IFDs like the maker notes of real cameras. */
+QByteArray IBExifBenchmark::createTiff(int index, bool littleendian, int padding)
+{
+   QByteArray model = QByteArray("Synthetic Camera").append('\0');
+   QByteArray date = QString("%1:%2:%3 12:00:00").arg(2010 + index % 10).arg(1 + index % 12, 2, 10, QChar('0'))
+                                                 .arg(1 + index % 28, 2, 10, QChar('0')).toLatin1().append('\0');
+   quint32 modeloffset = 8 + 2 + 4 * 12 + 4;
+   quint32 dateoffset = modeloffset + quint32(model.size());
+   quint32 exifoffset = dateoffset + quint32(date.size() + padding);
+   QByteArray tiff(littleendian ? "II" : "MM");
+
+   appendValue(&tiff, 42, 2, littleendian);
+   appendValue(&tiff, 8, 4, littleendian);
+
+   appendValue(&tiff, 4, 2, littleendian);
+   appendEntry(&tiff, 0x0110, 2, quint32(model.size()), modeloffset, littleendian);
+   appendEntry(&tiff, 0x0112, 3, 1, 6, littleendian);
+   appendEntry(&tiff, 0x0132, 2, quint32(date.size()), dateoffset, littleendian);
+   appendEntry(&tiff, 0x8769, 4, 1, exifoffset, littleendian);
+   appendValue(&tiff, 0, 4, littleendian);
+   tiff += model;
+   tiff += date;
+   tiff += QByteArray(padding, '\0');
+
+   appendValue(&tiff, 1, 2, littleendian);
+   appendEntry(&tiff, 0x9003, 2, quint32(date.size()), exifoffset + 2 + 12 + 4, littleendian);
+   appendValue(&tiff, 0, 4, littleendian);
+   tiff += date;
+
+   return tiff;
+}
+
+/* Returns a JPEG file with a JFIF segment, the TIFF structure (tiff) in the EXIF segment and random scan data of the
+   given size (scansize). The scan data is not decodable, because only the metadata is read. */
+QByteArray IBExifBenchmark::createJpeg(const QByteArray &tiff, int scansize)
+{
+   QRandomGenerator random(quint32(tiff.size()));
+   QByteArray jpeg("\xFF\xD8\xFF\xE0\x00\x10JFIF\x00\x01\x01\x00\x00\x01\x00\x01\x00\x00", 20);
+   int idx;
+
+   jpeg += "\xFF\xE1";
+   appendValue(&jpeg, quint32(tiff.size() + 8), 2, false);
+   jpeg += QByteArray("Exif\x00\x00", 6);
+   jpeg += tiff;
+   jpeg += QByteArray("\xFF\xDA\x00\x08\x01\x01\x00\x00\x3F\x00", 10);
+
+   for(idx = 0; idx < scansize; idx++)
+   {
+      jpeg.append(char(random.bounded(255)));
+   }
+
+   jpeg += "\xFF\xD9";
+
+   return jpeg;
+}
+
+/* Returns the content of the file with the given index (index) of the given layout (layout). The layouts are JPEG
+   files in Intel and Motorola byte order, JPEG files, whose EXIF IFD lies beyond the first read block, TIFF files and
+   PNG files, which are rejected by their signature. */
+QByteArray IBExifBenchmark::createFile(const QString &layout, int index)
+{
+   if(layout == "jpeg-intel")
+   {
+      return IBExifBenchmark::createJpeg(IBExifBenchmark::createTiff(index, true, 512), 8192);
+   }
+
+   if(layout == "jpeg-motorola")
+   {
+      return IBExifBenchmark::createJpeg(IBExifBenchmark::createTiff(index, false, 512), 8192);
+   }
+
+   if(layout == "jpeg-far")
+   {
+      return IBExifBenchmark::createJpeg(IBExifBenchmark::createTiff(index, true, 16384), 8192);
+   }
+
+   if(layout == "tiff")
+   {
+      return IBExifBenchmark::createTiff(index, false, 512) + QByteArray(8192, '\0');
+   }
+
+   return QByteArray("\x89PNG\x0D\x0A\x1A\x0A", 8) + QByteArray(8192, '\0');
+}
+
+/* Writes the corpus of all layouts into the temporary directory. */
+void IBExifBenchmark::initTestCase()
+{
+   QStringList layouts = {"jpeg-intel", "jpeg-motorola", "jpeg-far", "tiff", "png"};
+   QString path;
+   QFile file;
+   int idx;
+
+   QVERIFY(this->tdCorpus.isValid());
+
+   for(const QString &layout : layouts)
+   {
+      for(idx = 0; idx < iCorpusSize; idx++)
+      {
+         path = QString("%1/%2-%3").arg(this->tdCorpus.path(), layout).arg(idx, 4, 10, QChar('0'));
+         file.setFileName(path);
+
+         QVERIFY(file.open(QIODevice::WriteOnly));
+         file.write(IBExifBenchmark::createFile(layout, idx));
+         file.close();
+
+         this->hshFiles[layout].append(path);
+      }
+   }
+}
+
+/* Adds the columns and the rows for every layout and, if metrics is true, for every metric. Otherwise the wall time
+   is measured. */
+void IBExifBenchmark::addRows(bool metrics)
+{
+   QList<QPair<const char *, bool>> layouts = {{"jpeg-intel", true}, {"jpeg-motorola", true}, {"jpeg-far", true},
+                                               {"tiff", true}, {"png", false}};
+   QList<QByteArray> metricnames = {"ns"};
+
+   QTest::addColumn<QString>("layout");
+   QTest::addColumn<bool>("exif");
+   QTest::addColumn<QByteArray>("metric");
+
+   if(metrics)
+   {
+      metricnames.append("allocs");
+   }
+
+   for(const QPair<const char *, bool> &layout : layouts)
+   {
+      for(const QByteArray &metric : metricnames)
+      {
+         QTest::addRow("%s/%s", layout.first, metric.constData()) << QString(layout.first) << layout.second << metric;
+      }
+   }
+}
+
+/* Rows of readFile. */
+void IBExifBenchmark::readFile_data()
+{
+   IBExifBenchmark::addRows(false);
+}
+
+/* Measures the reading of the EXIF metadata per file on a warm page cache, like the metadata pass of the thumbnail
+   loader with a reused buffer. */
+void IBExifBenchmark::readFile()
+{
+   QFETCH(QString, layout);
+   QFETCH(bool, exif);
+   QFETCH(QByteArray, metric);
+   QStringList files = this->hshFiles.value(layout);
+   QByteArray buffer;
+   IBExifData data;
+   int found = 0;
+
+   /* the first pass warms the page cache */
+   for(const QString &file : files)
+   {
+      IBExifReader::readFile(file, &data, &buffer);
+   }
+
+   IBBenchmark::measure(metric, files.size(), [&]()
+   {
+      found = 0;
+
+      for(const QString &file : files)
+      {
+         found += IBExifReader::readFile(file, &data, &buffer) ? 1 : 0;
+      }
+   });
+
+   QCOMPARE(found, exif ? files.size() : 0);
+
+   if(exif)
+   {
+      QVERIFY(data.dtTaken.isValid());
+      QCOMPARE(data.iOrientation, 6);
+      QCOMPARE(data.strCameraModel, QString("Synthetic Camera"));
+   }
+}
+
+/* Rows of parse. */
+void IBExifBenchmark::parse_data()
+{
+   IBExifBenchmark::addRows(true);
+}
+
+/* Measures the parsing of the start of a file, which is already read, without the file access. */
+void IBExifBenchmark::parse()
+{
+   QFETCH(QString, layout);
+   QFETCH(bool, exif);
+   QFETCH(QByteArray, metric);
+   QByteArray content = IBExifBenchmark::createFile(layout, 0).left(IBExifReader::iMaxReadSize);
+   const uchar *data = reinterpret_cast<const uchar *>(content.constData());
+   IBExifData result;
+   bool found = false;
+
+   IBBenchmark::measure(metric, 1, [&]()
+   {
+      IBExifReader reader(data, content.size());
+      found = reader.read(&result);
+   });
+
+   QCOMPARE(found, exif);
+}
+
+QTEST_GUILESS_MAIN(IBExifBenchmark)
+
+#include "tst_bench_exif.moc"
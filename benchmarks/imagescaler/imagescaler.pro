@@ -0,0 +1,15 @@
+######################################################################
+# Micro-benchmark of the area-averaging thumbnail scaler
+######################################################################
+
+TEMPLATE = app
+TARGET = tst_bench_imagescaler
+INCLUDEPATH += .
+QT += testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include(../../simpleimagebrowser.pri)
+
+# Input
+SOURCES += tst_bench_imagescaler.cpp
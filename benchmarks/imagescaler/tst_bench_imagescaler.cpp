@@ -0,0 +1,194 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include <QImage>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtTest>
+
+#include "ibimagescaler.hpp"
+
+/* scaling methods compared by the benchmark, the values >= 0 are IBImageScaler::Implementation */
+enum ScaleMethod
+{
+   QtFastTransformation = -2,
+   QtSmoothTransformation = -1
+};
+
+/* class IBImageScalerBenchmark */
+
+class IBImageScalerBenchmark : public QObject
+{
+   Q_OBJECT
+
+   private slots:
+      void scale_data();
+      void scale();
+      void quality_data();
+      void quality();
+
+   private:
+      static QImage createImage(const QSize &size, QImage::Format format);
+      static QImage scaleWith(int method, const QImage &image, const QSize &size);
+};
+
+/* Creates a deterministic test image of the given size (size) and format (format) with gradients,
+   sharp edges and a little noise. */
+QImage IBImageScalerBenchmark::createImage(const QSize &size, QImage::Format format)
+{
+   QRandomGenerator random(42);
+   QImage image(size, QImage::Format_ARGB32);
+   QRgb *line;
+   int x, y, noise;
+
+   for(y = 0; y < size.height(); y++)
+   {
+      line = reinterpret_cast<QRgb *>(image.scanLine(y));
+
+      for(x = 0; x < size.width(); x++)
+      {
+         noise = int(random.bounded(16));
+         line[x] = qRgba((x * 255 / size.width() + noise) & 0xFF,
+                         (y * 255 / size.height() + noise) & 0xFF,
+                         ((x / 37 + y / 37) % 2) ? 220 : 30,
+                         format == QImage::Format_RGB32 ? 255 : 128 + (x * 127 / size.width()));
+      }
+   }
+
+   return image.convertToFormat(format);
+}
+
+/* Scales the image (image) into the given size (size) with the given method (method). */
+QImage IBImageScalerBenchmark::scaleWith(int method, const QImage &image, const QSize &size)
+{
+   switch(method)
+   {
+      case QtFastTransformation:
+         return image.scaled(size, Qt::KeepAspectRatio, Qt::FastTransformation);
+
+      case QtSmoothTransformation:
+         return image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+      default:
+         IBImageScaler::setImplementation(static_cast<IBImageScaler::Implementation>(method));
+         return IBImageScaler::scale(image, size, Qt::KeepAspectRatio);
+   }
+}
+
+/* Rows of the throughput benchmark: every method for typical camera and screenshot sizes in both formats. */
+void IBImageScalerBenchmark::scale_data()
+{
+   QList<QSize> sizes = {QSize(1920, 1080), QSize(6000, 4000)};
+   QList<QPair<int, const char *>> methods = {{QtFastTransformation, "qt-fast"},
+                                              {QtSmoothTransformation, "qt-smooth"},
+                                              {IBImageScaler::Scalar, "ib-scalar"},
+                                              {IBImageScaler::SSE2, "ib-sse2"},
+                                              {IBImageScaler::AVX2, "ib-avx2"}};
+   QList<QPair<QImage::Format, const char *>> formats = {{QImage::Format_RGB32, "rgb32"},
+                                                         {QImage::Format_ARGB32_Premultiplied, "argb32pm"}};
+
+   QTest::addColumn<int>("method");
+   QTest::addColumn<QSize>("sourcesize");
+   QTest::addColumn<int>("format");
+
+   for(const QSize &size : sizes)
+   {
+      for(const QPair<QImage::Format, const char *> &format : formats)
+      {
+         for(const QPair<int, const char *> &method : methods)
+         {
+            QTest::addRow("%dx%d/%s/%s", size.width(), size.height(), format.second, method.second)
+               << method.first << size << int(format.first);
+         }
+      }
+   }
+}
+
+/* Measures the time of scaling an image into the thumbnail size of the image list. */
+void IBImageScalerBenchmark::scale()
+{
+   QFETCH(int, method);
+   QFETCH(QSize, sourcesize);
+   QFETCH(int, format);
+   QImage source, result;
+   QSize thumbsize(232, 130);
+
+   if(method >= 0 && !IBImageScaler::isImplementationSupported(static_cast<IBImageScaler::Implementation>(method)))
+   {
+      QSKIP("The implementation is not supported by this CPU.");
+   }
+
+   source = IBImageScalerBenchmark::createImage(sourcesize, static_cast<QImage::Format>(format));
+
+   QBENCHMARK
+   {
+      result = IBImageScalerBenchmark::scaleWith(method, source, thumbsize);
+   }
+
+   QCOMPARE(result.size(), sourcesize.scaled(thumbsize, Qt::KeepAspectRatio));
+   IBImageScaler::setImplementation(IBImageScaler::Automatic);
+}
+
+/* Rows of the quality comparison: every implementation of IBImageScaler in both formats. */
+void IBImageScalerBenchmark::quality_data()
+{
+   QTest::addColumn<int>("method");
+   QTest::addColumn<int>("format");
+
+   QTest::newRow("rgb32/ib-scalar") << int(IBImageScaler::Scalar) << int(QImage::Format_RGB32);
+   QTest::newRow("rgb32/ib-sse2") << int(IBImageScaler::SSE2) << int(QImage::Format_RGB32);
+   QTest::newRow("rgb32/ib-avx2") << int(IBImageScaler::AVX2) << int(QImage::Format_RGB32);
+   QTest::newRow("argb32pm/ib-scalar") << int(IBImageScaler::Scalar) << int(QImage::Format_ARGB32_Premultiplied);
+   QTest::newRow("argb32pm/ib-sse2") << int(IBImageScaler::SSE2) << int(QImage::Format_ARGB32_Premultiplied);
+   QTest::newRow("argb32pm/ib-avx2") << int(IBImageScaler::AVX2) << int(QImage::Format_ARGB32_Premultiplied);
+}
+
+/* Compares the result of the scaler with Qt::SmoothTransformation. The mean absolute difference of the channels
+   has to stay below one quantization step plus rounding, while Qt::FastTransformation is reported for reference. */
+void IBImageScalerBenchmark::quality()
+{
+   QFETCH(int, method);
+   QFETCH(int, format);
+   QImage source, reference, fast, result;
+   QSize thumbsize(232, 130);
+   double diff = 0.0, fastdiff = 0.0;
+   const uchar *refline, *resline, *fastline;
+   int x, y;
+
+   if(!IBImageScaler::isImplementationSupported(static_cast<IBImageScaler::Implementation>(method)))
+   {
+      QSKIP("The implementation is not supported by this CPU.");
+   }
+
+   source = IBImageScalerBenchmark::createImage(QSize(3000, 2000), static_cast<QImage::Format>(format));
+   reference = IBImageScalerBenchmark::scaleWith(QtSmoothTransformation, source, thumbsize);
+   fast = IBImageScalerBenchmark::scaleWith(QtFastTransformation, source, thumbsize);
+   result = IBImageScalerBenchmark::scaleWith(method, source, thumbsize);
+   IBImageScaler::setImplementation(IBImageScaler::Automatic);
+
+   QCOMPARE(result.size(), reference.size());
+   QCOMPARE(result.format(), reference.format());
+
+   for(y = 0; y < result.height(); y++)
+   {
+      refline = reference.constScanLine(y);
+      resline = result.constScanLine(y);
+      fastline = fast.constScanLine(y);
+
+      for(x = 0; x < result.width() * 4; x++)
+      {
+         diff += qAbs(int(refline[x]) - int(resline[x]));
+         fastdiff += qAbs(int(refline[x]) - int(fastline[x]));
+      }
+   }
+
+   diff /= result.width() * result.height() * 4.0;
+   fastdiff /= result.width() * result.height() * 4.0;
+
+   qInfo("mean absolute difference to Qt::SmoothTransformation: %.3f (Qt::FastTransformation: %.3f)", diff, fastdiff);
+   QVERIFY(diff < 2.0);
+}
+
+QTEST_GUILESS_MAIN(IBImageScalerBenchmark)
+
+#include "tst_bench_imagescaler.moc"
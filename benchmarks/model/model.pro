@@ -0,0 +1,19 @@
+######################################################################
+# Benchmarks of the image list model and its section list
+######################################################################
+
+TEMPLATE = app
+TARGET = tst_bench_model
+INCLUDEPATH += . ../shared
+QT += testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include(../../simpleimagebrowser.pri)
+
+# Input
+HEADERS += ../shared/ibbenchmark.hpp \
+           ../shared/ibsyntheticdata.hpp
+SOURCES += ../shared/ibbenchmark.cpp \
+           ../shared/ibsyntheticdata.cpp \
+           tst_bench_model.cpp
@@ -0,0 +1,437 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include <QDir>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "ibbenchmark.hpp"
+#include "ibimagehash.hpp"
+#include "ibimagelistmodel.hpp"
+#include "ibsyntheticdata.hpp"
+
+/* class IBBenchmarkImageListModel */
+
+class IBBenchmarkImageListModel : public IBImageListModel
+{
+   public:
+      using IBImageListModel::IBImageListModel;
+      using IBImageListModel::buildItemsList;
+};
+
+/* class IBModelBenchmark */
+
+class IBModelBenchmark : public QObject
+{
+   Q_OBJECT
+
+   private slots:
+      void initTestCase();
+      void cleanupTestCase();
+
+      void buildItemsList_data();
+      void buildItemsList();
+      void getItemByLinearIndex_data();
+      void getItemByLinearIndex();
+      void getLinearIndexOfItem_data();
+      void getLinearIndexOfItem();
+      void totalSize_data();
+      void totalSize();
+      void sortSections_data();
+      void sortSections();
+      void findSimilarImages_data();
+      void findSimilarImages();
+      void setFileNameFilter_data();
+      void setFileNameFilter();
+
+   private:
+      static void addRows(bool sortfields);
+      static void addCountRows();
+      static QList<int> createIndices(int count, int range);
+      void prepareModel(int count);
+      void fillSectionList(IBImageListSectionList &list, IBImageListModel::IBListSectionType type);
+
+      /* temporary, empty working directory, which is scanned by the model on construction */
+      QTemporaryDir tdWorkingDir;
+      /* model of the current data set */
+      IBBenchmarkImageListModel *mdlModel = nullptr;
+      /* items of the current data set, they are owned by the model */
+      QList<IBImageListImageItem *> lstItems;
+};
+
+/* Changes into an empty working directory, so that the construction of the model does not read any images. */
+void IBModelBenchmark::initTestCase()
+{
+   QVERIFY(this->tdWorkingDir.isValid());
+   QDir::setCurrent(this->tdWorkingDir.path());
+}
+
+/* Destroys the model of the last data set. */
+void IBModelBenchmark::cleanupTestCase()
+{
+   delete this->mdlModel;
+   this->mdlModel = nullptr;
+   this->lstItems.clear();
+}
+
+/* Adds the columns and the rows for every data set size, section type, image sort field, if sortfields is true,
+   and metric. Data sets larger than IBBenchmark::getMaximumItemCount are skipped. */
+void IBModelBenchmark::addRows(bool sortfields)
+{
+   QList<int> counts = {1000, 10000, 100000, 1000000};
+   QList<QPair<IBImageListModel::IBListSectionType, const char *>> sections =
+      {{IBImageListModel::NoSection, "none"}, {IBImageListModel::AlphabeticSection, "alphabetic"},
+       {IBImageListModel::DateSection, "date"}, {IBImageListModel::FileTypeSection, "filetype"},
+       {IBImageListModel::HueSection, "hue"}, {IBImageListModel::CaptureDateSection, "capture"}};
+   QList<QPair<IBImageListModel::IBImageSortField, const char *>> fields =
+      {{IBImageListModel::SortByName, "name"}, {IBImageListModel::SortByDate, "date"},
+       {IBImageListModel::SortByFileType, "filetype"}, {IBImageListModel::SortByColor, "color"},
+       {IBImageListModel::SortByCaptureDate, "capture"}};
+   QList<QByteArray> metrics = {"ns", "allocs"};
+
+   QTest::addColumn<int>("count");
+   QTest::addColumn<int>("sectiontype");
+   QTest::addColumn<int>("sortfield");
+   QTest::addColumn<QByteArray>("metric");
+
+   if(!sortfields)
+   {
+      fields = {{IBImageListModel::SortByName, "name"}};
+   }
+
+   for(int count : counts)
+   {
+      if(count > IBBenchmark::getMaximumItemCount())
+      {
+         continue;
+      }
+
+      for(const QPair<IBImageListModel::IBListSectionType, const char *> &section : sections)
+      {
+         for(const QPair<IBImageListModel::IBImageSortField, const char *> &field : fields)
+         {
+            for(const QByteArray &metric : metrics)
+            {
+               if(sortfields)
+               {
+                  QTest::addRow("%d/%s/%s/%s", count, section.second, field.second, metric.constData())
+                     << count << int(section.first) << int(field.first) << metric;
+               }
+               else
+               {
+                  QTest::addRow("%d/%s/%s", count, section.second, metric.constData())
+                     << count << int(section.first) << int(field.first) << metric;
+               }
+            }
+         }
+      }
+   }
+}
+
+/* Adds the columns and the rows for every data set size and metric, for the benchmarks, which depend on neither the
+   section type nor the image sort field. Data sets larger than IBBenchmark::getMaximumItemCount are skipped. */
+void IBModelBenchmark::addCountRows()
+{
+   QList<int> counts = {1000, 10000, 100000, 1000000};
+   QList<QByteArray> metrics = {"ns", "allocs"};
+
+   QTest::addColumn<int>("count");
+   QTest::addColumn<QByteArray>("metric");
+
+   for(int count : counts)
+   {
+      if(count > IBBenchmark::getMaximumItemCount())
+      {
+         continue;
+      }
+
+      for(const QByteArray &metric : metrics)
+      {
+         QTest::addRow("%d/%s", count, metric.constData()) << count << metric;
+      }
+   }
+}
+
+/* Returns the given number (count) of deterministic indices in the range from 0 to range - 1. */
+QList<int> IBModelBenchmark::createIndices(int count, int range)
+{
+   QRandomGenerator random(quint32(range));
+   QList<int> indices;
+   int idx;
+
+   for(idx = 0; idx < count; idx++)
+   {
+      indices.append(int(random.bounded(quint32(qMax(1, range)))));
+   }
+
+   return indices;
+}
+
+/* Creates the model with a data set of the given size (count), if the current data set has another size. */
+void IBModelBenchmark::prepareModel(int count)
+{
+   if(this->mdlModel && this->lstItems.size() == count)
+   {
+      return;
+   }
+
+   delete this->mdlModel;
+   this->mdlModel = new IBBenchmarkImageListModel();
+   this->lstItems = IBSyntheticData::createImageItems(count);
+   this->mdlModel->setImageItems(this->lstItems, false);
+}
+
+/* Fills the section list (list) with the items of the current data set according to the section type (type). */
+void IBModelBenchmark::fillSectionList(IBImageListSectionList &list, IBImageListModel::IBListSectionType type)
+{
+   QList<IBImageListImageItem *>::iterator it;
+   QVariant section;
+
+   list.clear();
+
+   for(it = this->lstItems.begin(); it != this->lstItems.end(); ++it)
+   {
+      section = IBImageListModel::getSectionId(type, *it);
+      list.addImageItem(section, *it);
+   }
+
+   list.sortSections(Qt::AscendingOrder);
+   list.sortImageItems(IBImageListModel::SortByName, Qt::AscendingOrder);
+}
+
+/* Rows of buildItemsList. */
+void IBModelBenchmark::buildItemsList_data()
+{
+   IBModelBenchmark::addRows(true);
+}
+
+/* Measures the (re-)structuring of the whole model per call. */
+void IBModelBenchmark::buildItemsList()
+{
+   QFETCH(int, count);
+   QFETCH(int, sectiontype);
+   QFETCH(int, sortfield);
+   QFETCH(QByteArray, metric);
+
+   this->prepareModel(count);
+   this->mdlModel->setSectionType(static_cast<IBImageListModel::IBListSectionType>(sectiontype));
+   this->mdlModel->setImageSortField(static_cast<IBImageListModel::IBImageSortField>(sortfield));
+
+   IBBenchmark::measure(metric, 1, [this]() { this->mdlModel->buildItemsList(); });
+
+   QVERIFY(this->mdlModel->rowCount() >= count);
+}
+
+/* Rows of getItemByLinearIndex. */
+void IBModelBenchmark::getItemByLinearIndex_data()
+{
+   IBModelBenchmark::addRows(false);
+}
+
+/* Measures the lookup of items by random linear indices per lookup. */
+void IBModelBenchmark::getItemByLinearIndex()
+{
+   QFETCH(int, count);
+   QFETCH(int, sectiontype);
+   QFETCH(QByteArray, metric);
+   IBImageListSectionList list;
+   QList<int> indices;
+   int found = 0;
+
+   this->prepareModel(count);
+   this->fillSectionList(list, static_cast<IBImageListModel::IBListSectionType>(sectiontype));
+   indices = IBModelBenchmark::createIndices(1000, list.totalSize());
+
+   IBBenchmark::measure(metric, indices.size(), [&list, &indices, &found]()
+      {
+         for(int index : indices)
+         {
+            found += list.getItemByLinearIndex(index) ? 1 : 0;
+         }
+      });
+
+   QVERIFY(found > 0);
+   list.clear();
+}
+
+/* Rows of getLinearIndexOfItem. */
+void IBModelBenchmark::getLinearIndexOfItem_data()
+{
+   IBModelBenchmark::addRows(false);
+}
+
+/* Measures the lookup of the linear indices of random items per lookup. */
+void IBModelBenchmark::getLinearIndexOfItem()
+{
+   QFETCH(int, count);
+   QFETCH(int, sectiontype);
+   QFETCH(QByteArray, metric);
+   IBImageListSectionList list;
+   QList<IBImageListAbstractItem *> items;
+   int found = 0;
+
+   this->prepareModel(count);
+   this->fillSectionList(list, static_cast<IBImageListModel::IBListSectionType>(sectiontype));
+
+   for(int index : IBModelBenchmark::createIndices(1000, count))
+   {
+      items.append(this->lstItems[index]);
+   }
+
+   IBBenchmark::measure(metric, items.size(), [&list, &items, &found]()
+      {
+         for(IBImageListAbstractItem *item : items)
+         {
+            found += list.getLinearIndexOfItem(item) >= 0 ? 1 : 0;
+         }
+      });
+
+   QVERIFY(found > 0);
+   list.clear();
+}
+
+/* Rows of totalSize. */
+void IBModelBenchmark::totalSize_data()
+{
+   IBModelBenchmark::addRows(false);
+}
+
+/* Measures the computation of the number of rows per call. */
+void IBModelBenchmark::totalSize()
+{
+   QFETCH(int, count);
+   QFETCH(int, sectiontype);
+   QFETCH(QByteArray, metric);
+   IBImageListSectionList list;
+   qint64 size = 0;
+
+   this->prepareModel(count);
+   this->fillSectionList(list, static_cast<IBImageListModel::IBListSectionType>(sectiontype));
+
+   IBBenchmark::measure(metric, 1000, [&list, &size]()
+      {
+         for(int idx = 0; idx < 1000; idx++)
+         {
+            size += list.totalSize();
+         }
+      });
+
+   QVERIFY(size > 0);
+   list.clear();
+}
+
+/* Rows of sortSections. */
+void IBModelBenchmark::sortSections_data()
+{
+   IBModelBenchmark::addRows(false);
+}
+
+/* Measures the sorting of the sections per call. The order alternates, so that every call has to reorder. */
+void IBModelBenchmark::sortSections()
+{
+   QFETCH(int, count);
+   QFETCH(int, sectiontype);
+   QFETCH(QByteArray, metric);
+   IBImageListSectionList list;
+   bool ascending = false;
+
+   this->prepareModel(count);
+   this->fillSectionList(list, static_cast<IBImageListModel::IBListSectionType>(sectiontype));
+
+   IBBenchmark::measure(metric, 1, [&list, &ascending]()
+      {
+         list.sortSections(ascending ? Qt::AscendingOrder : Qt::DescendingOrder);
+         ascending = !ascending;
+      });
+
+   QVERIFY(list.totalSize() >= count);
+   list.clear();
+}
+
+/* Rows of findSimilarImages, one per data set size and metric. */
+void IBModelBenchmark::findSimilarImages_data()
+{
+   IBModelBenchmark::addCountRows();
+}
+
+/* Measures the lookup of the similar images of random images in the hash tree per lookup. The hashes form bursts of
+   eight images, which differ in up to two bits from each other, like the series of a camera. */
+void IBModelBenchmark::findSimilarImages()
+{
+   QFETCH(int, count);
+   QFETCH(QByteArray, metric);
+   QRandomGenerator random(quint32(count));
+   IBImageHashTree tree;
+   QList<quint64> hashes;
+   QList<int> indices;
+   quint64 burst = 0;
+   int idx, found = 0;
+
+   for(idx = 0; idx < count; idx++)
+   {
+      if(idx % 8 == 0)
+      {
+         burst = random.generate64();
+      }
+
+      hashes.append(burst ^ (quint64(1) << random.bounded(64)));
+      tree.insert(hashes.last(), idx);
+   }
+
+   indices = IBModelBenchmark::createIndices(1000, count);
+
+   IBBenchmark::measure(metric, indices.size(), [&tree, &hashes, &indices, &found]()
+      {
+         for(int index : indices)
+         {
+            found += int(tree.find(hashes[index], 6).size());
+         }
+      });
+
+   QVERIFY(found >= indices.size());
+}
+
+/* Rows of setFileNameFilter, one per data set size and metric. */
+void IBModelBenchmark::setFileNameFilter_data()
+{
+   IBModelBenchmark::addCountRows();
+}
+
+/* Measures the filtering of the alphabetically sectioned model per keystroke. A query is typed and erased again
+   character by character. The file name index is built before the measurement. */
+void IBModelBenchmark::setFileNameFilter()
+{
+   QFETCH(int, count);
+   QFETCH(QByteArray, metric);
+   QString query = QStringLiteral("holiday");
+   int shown = 0;
+
+   this->prepareModel(count);
+   this->mdlModel->setSectionType(IBImageListModel::AlphabeticSection);
+   this->mdlModel->setFileNameFilter(query);
+   shown = this->mdlModel->rowCount();
+   this->mdlModel->setFileNameFilter(QString());
+
+   IBBenchmark::measure(metric, 2 * query.size(), [this, &query]()
+      {
+         int idx;
+
+         for(idx = 1; idx <= query.size(); idx++)
+         {
+            this->mdlModel->setFileNameFilter(query.left(idx));
+         }
+
+         for(idx = query.size() - 1; idx >= 0; idx--)
+         {
+            this->mdlModel->setFileNameFilter(query.left(idx));
+         }
+      });
+
+   QVERIFY(shown > 0 && shown < count);
+   QVERIFY(this->mdlModel->rowCount() >= count);
+}
+
+IB_BENCHMARK_MAIN(IBModelBenchmark)
+
+#include "tst_bench_model.moc"
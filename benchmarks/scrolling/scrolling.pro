@@ -0,0 +1,19 @@
+######################################################################
+# Frame time benchmark of scrolling the image list view
+######################################################################
+
+TEMPLATE = app
+TARGET = tst_bench_scrolling
+INCLUDEPATH += . ../shared
+QT += testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include(../../simpleimagebrowser.pri)
+
+# Input
+HEADERS += ../shared/ibbenchmark.hpp \
+           ../shared/ibsyntheticdata.hpp
+SOURCES += ../shared/ibbenchmark.cpp \
+           ../shared/ibsyntheticdata.cpp \
+           tst_bench_scrolling.cpp
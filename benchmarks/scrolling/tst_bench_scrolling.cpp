@@ -0,0 +1,267 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include <QDir>
+#include <QHash>
+#include <QScrollBar>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <algorithm>
+#include <cmath>
+
+#include "ibbenchmark.hpp"
+#include "ibimagelistwidget.hpp"
+#include "ibsyntheticdata.hpp"
+
+/* class IBScrollingBenchmark */
+
+class IBScrollingBenchmark : public QObject
+{
+   Q_OBJECT
+
+   private slots:
+      void initTestCase();
+      void cleanupTestCase();
+
+      void scroll_data();
+      void scroll();
+      void resize_data();
+      void resize();
+      void switchSections_data();
+      void switchSections();
+
+   private:
+      static void addRows(bool sectiontypes);
+      static void reportPercentile(QVector<qint64> frames, const QByteArray &metric);
+      void prepareView(IBImageListModel::IBListSectionType type, const QSize &size);
+
+      /* temporary, empty working directory, which is scanned by the model of the view on construction */
+      QTemporaryDir tdWorkingDir;
+      /* view under test */
+      IBImageListWidget *ilwView = nullptr;
+      /* frame times in nanoseconds of the already measured configurations */
+      QHash<QString, QVector<qint64>> hshFrames;
+};
+
+/* Creates the view with a synthetic data set of 20000 items with loaded thumbnails. The data set is limited by
+   IBBenchmark::getMaximumItemCount. */
+void IBScrollingBenchmark::initTestCase()
+{
+   QList<IBImageListImageItem *> items;
+   IBImageListModel *model;
+
+   QVERIFY(this->tdWorkingDir.isValid());
+   QDir::setCurrent(this->tdWorkingDir.path());
+
+   this->ilwView = new IBImageListWidget();
+   model = qobject_cast<IBImageListModel *>(this->ilwView->model());
+   QVERIFY(model);
+
+   items = IBSyntheticData::createImageItems(int(qMin<qint64>(20000, IBBenchmark::getMaximumItemCount())));
+   IBSyntheticData::setThumbnails(items, QSize(232, 130));
+   model->setImageItems(items, false);
+
+   this->ilwView->show();
+   QVERIFY(QTest::qWaitForWindowExposed(this->ilwView));
+}
+
+/* Destroys the view. */
+void IBScrollingBenchmark::cleanupTestCase()
+{
+   delete this->ilwView;
+   this->ilwView = nullptr;
+}
+
+/* Adds the columns and the rows for every window size, section type, if sectiontypes is true, and percentile. */
+void IBScrollingBenchmark::addRows(bool sectiontypes)
+{
+   QList<QSize> sizes = {QSize(1280, 800), QSize(1920, 1080), QSize(3840, 2160)};
+   QList<QPair<IBImageListModel::IBListSectionType, const char *>> sections =
+      {{IBImageListModel::NoSection, "none"}, {IBImageListModel::AlphabeticSection, "alphabetic"},
+       {IBImageListModel::DateSection, "date"}, {IBImageListModel::FileTypeSection, "filetype"}};
+   QList<QByteArray> metrics = {"p50", "p95", "p99"};
+
+   QTest::addColumn<QSize>("size");
+   QTest::addColumn<int>("sectiontype");
+   QTest::addColumn<QByteArray>("metric");
+
+   if(!sectiontypes)
+   {
+      sections = {{IBImageListModel::NoSection, "all"}};
+   }
+
+   for(const QSize &size : sizes)
+   {
+      for(const QPair<IBImageListModel::IBListSectionType, const char *> &section : sections)
+      {
+         for(const QByteArray &metric : metrics)
+         {
+            QTest::addRow("%dx%d/%s/%s", size.width(), size.height(), section.second, metric.constData())
+               << size << int(section.first) << metric;
+         }
+      }
+   }
+}
+
+/* Reports the given percentile (metric) of the frame times (frames) as the benchmark result of the current row. */
+void IBScrollingBenchmark::reportPercentile(QVector<qint64> frames, const QByteArray &metric)
+{
+   double percentile = metric.mid(1).toDouble() / 100.0;
+   int idx;
+
+   std::sort(frames.begin(), frames.end());
+   idx = qBound(0, int(std::ceil(percentile * frames.size())) - 1, int(frames.size()) - 1);
+
+   QTest::setBenchmarkResult(qreal(frames.value(idx)), QTest::WalltimeNanoseconds);
+}
+
+/* Sets the section type (type) and the size of the window (size), lays out the items and scrolls to the top. */
+void IBScrollingBenchmark::prepareView(IBImageListModel::IBListSectionType type, const QSize &size)
+{
+   this->ilwView->setSectionType(type);
+   this->ilwView->resize(size);
+   this->ilwView->doItemsLayout();
+   this->ilwView->verticalScrollBar()->setValue(0);
+   QCoreApplication::processEvents();
+}
+
+/* Rows of scroll. */
+void IBScrollingBenchmark::scroll_data()
+{
+   IBScrollingBenchmark::addRows(true);
+}
+
+/* Measures the frames of scrolling down and up again in steps of a mouse wheel notch. A frame is the change of
+   the scroll bar and the repaint of the viewport. At most 400 frames are painted per direction. */
+void IBScrollingBenchmark::scroll()
+{
+   QFETCH(QSize, size);
+   QFETCH(int, sectiontype);
+   QFETCH(QByteArray, metric);
+   QString key = QString("%1x%2/%3").arg(size.width()).arg(size.height()).arg(sectiontype);
+   QScrollBar *scrollbar = this->ilwView->verticalScrollBar();
+   QElapsedTimer timer;
+   QVector<qint64> frames;
+   int step, frame;
+
+   if(!this->hshFrames.contains("scroll/" + key))
+   {
+      this->prepareView(static_cast<IBImageListModel::IBListSectionType>(sectiontype), size);
+      step = qMax(120, scrollbar->maximum() / 400);
+
+      for(frame = 0; frame < 800 && scrollbar->maximum() > 0; frame++)
+      {
+         QCoreApplication::processEvents();
+
+         timer.start();
+         scrollbar->setValue(frame < 400 ? scrollbar->value() + step : scrollbar->value() - step);
+         this->ilwView->viewport()->repaint();
+         frames.append(timer.nsecsElapsed());
+      }
+
+      QVERIFY2(!frames.isEmpty(), "The items fit into the window.");
+      this->hshFrames.insert("scroll/" + key, frames);
+   }
+
+   IBScrollingBenchmark::reportPercentile(this->hshFrames.value("scroll/" + key), metric);
+}
+
+/* Rows of resize. */
+void IBScrollingBenchmark::resize_data()
+{
+   IBScrollingBenchmark::addRows(true);
+}
+
+/* Measures the frames of shrinking the window to 60 % and growing it again in steps of 16 pixels. A frame is the
+   resize, the layout of the items and the repaint of the viewport. */
+void IBScrollingBenchmark::resize()
+{
+   QFETCH(QSize, size);
+   QFETCH(int, sectiontype);
+   QFETCH(QByteArray, metric);
+   QString key = QString("%1x%2/%3").arg(size.width()).arg(size.height()).arg(sectiontype);
+   QElapsedTimer timer;
+   QVector<qint64> frames;
+   int width;
+
+   if(!this->hshFrames.contains("resize/" + key))
+   {
+      this->prepareView(static_cast<IBImageListModel::IBListSectionType>(sectiontype), size);
+
+      for(width = size.width(); width > size.width() * 6 / 10; width -= 16)
+      {
+         QCoreApplication::processEvents();
+
+         timer.start();
+         this->ilwView->resize(width, size.height());
+         this->ilwView->doItemsLayout();
+         this->ilwView->viewport()->repaint();
+         frames.append(timer.nsecsElapsed());
+      }
+
+      for(; width <= size.width(); width += 16)
+      {
+         QCoreApplication::processEvents();
+
+         timer.start();
+         this->ilwView->resize(width, size.height());
+         this->ilwView->doItemsLayout();
+         this->ilwView->viewport()->repaint();
+         frames.append(timer.nsecsElapsed());
+      }
+
+      this->hshFrames.insert("resize/" + key, frames);
+   }
+
+   IBScrollingBenchmark::reportPercentile(this->hshFrames.value("resize/" + key), metric);
+}
+
+/* Rows of switchSections. */
+void IBScrollingBenchmark::switchSections_data()
+{
+   IBScrollingBenchmark::addRows(false);
+}
+
+/* Measures the frames of switching between all section types for eight rounds. A frame is the restructuring of
+   the model, the layout of the items and the repaint of the viewport. */
+void IBScrollingBenchmark::switchSections()
+{
+   QFETCH(QSize, size);
+   QFETCH(QByteArray, metric);
+   QString key = QString("%1x%2").arg(size.width()).arg(size.height());
+   QList<IBImageListModel::IBListSectionType> types = {IBImageListModel::AlphabeticSection,
+                                                       IBImageListModel::DateSection,
+                                                       IBImageListModel::FileTypeSection,
+                                                       IBImageListModel::NoSection};
+   QElapsedTimer timer;
+   QVector<qint64> frames;
+   int round;
+
+   if(!this->hshFrames.contains("sections/" + key))
+   {
+      this->prepareView(IBImageListModel::NoSection, size);
+
+      for(round = 0; round < 8; round++)
+      {
+         for(IBImageListModel::IBListSectionType type : types)
+         {
+            QCoreApplication::processEvents();
+
+            timer.start();
+            this->ilwView->setSectionType(type);
+            this->ilwView->doItemsLayout();
+            this->ilwView->viewport()->repaint();
+            frames.append(timer.nsecsElapsed());
+         }
+      }
+
+      this->hshFrames.insert("sections/" + key, frames);
+   }
+
+   IBScrollingBenchmark::reportPercentile(this->hshFrames.value("sections/" + key), metric);
+}
+
+IB_BENCHMARK_MAIN(IBScrollingBenchmark)
+
+#include "tst_bench_scrolling.moc"
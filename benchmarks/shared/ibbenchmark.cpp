@@ -0,0 +1,152 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibbenchmark.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/* is true while the heap allocations are counted */
+static std::atomic<bool> bCountAllocations(false);
+/* number of heap allocations since the last reset */
+static std::atomic<quint64> iAllocationCount(0);
+/* number of allocated bytes since the last reset */
+static std::atomic<quint64> iAllocatedBytes(0);
+
+/* Counts an allocation of the given size (size), if the counting is enabled. */
+static inline void countAllocation(std::size_t size)
+{
+   if(bCountAllocations.load(std::memory_order_relaxed))
+   {
+      iAllocationCount.fetch_add(1, std::memory_order_relaxed);
+      iAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+   }
+}
+
+#if defined(__GLIBC__)
+
+/* The containers of Qt allocate with malloc, so the allocation functions of the C library are interposed.
+   The implementations of glibc are still reachable through their internal names. */
+extern "C"
+{
+   void *__libc_malloc(std::size_t size);
+   void *__libc_calloc(std::size_t count, std::size_t size);
+   void *__libc_realloc(void *ptr, std::size_t size);
+   void __libc_free(void *ptr);
+
+   void *malloc(std::size_t size)
+   {
+      countAllocation(size);
+      return __libc_malloc(size);
+   }
+
+   void *calloc(std::size_t count, std::size_t size)
+   {
+      countAllocation(count * size);
+      return __libc_calloc(count, size);
+   }
+
+   void *realloc(void *ptr, std::size_t size)
+   {
+      countAllocation(size);
+      return __libc_realloc(ptr, size);
+   }
+
+   void free(void *ptr)
+   {
+      __libc_free(ptr);
+   }
+}
+
+#else
+
+/* Without glibc only the allocations of operator new are counted. */
+void *operator new(std::size_t size)
+{
+   void *ptr;
+
+   countAllocation(size);
+   ptr = std::malloc(size ? size : 1);
+
+   if(!ptr)
+   {
+      throw std::bad_alloc();
+   }
+
+   return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+   return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+   std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+   std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+   std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+   std::free(ptr);
+}
+
+#endif /*defined(__GLIBC__)*/
+
+/* class IBBenchmark */
+
+/* Enables or disables (enable) the counting of heap allocations. */
+void IBBenchmark::setAllocationCounting(bool enable)
+{
+   bCountAllocations.store(enable);
+}
+
+/* Resets the number of counted allocations and bytes. */
+void IBBenchmark::resetAllocationCount()
+{
+   iAllocationCount.store(0);
+   iAllocatedBytes.store(0);
+}
+
+/* Returns the number of heap allocations counted since the last reset. */
+quint64 IBBenchmark::getAllocationCount()
+{
+   return iAllocationCount.load();
+}
+
+/* Returns the number of bytes allocated since the last reset. */
+quint64 IBBenchmark::getAllocatedBytes()
+{
+   return iAllocatedBytes.load();
+}
+
+/* Selects the offscreen platform plugin, if no platform is given by the environment, so that the benchmarks
+   run without a display. */
+void IBBenchmark::setOffscreenPlatform()
+{
+   if(!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+   {
+      qputenv("QT_QPA_PLATFORM", "offscreen");
+   }
+}
+
+/* Returns the maximum number of items of the synthetic data sets. It is 1000000 or the value of the environment
+   variable IB_BENCHMARK_MAX_ITEMS. */
+qint64 IBBenchmark::getMaximumItemCount()
+{
+   bool ok;
+   qint64 count = qEnvironmentVariable("IB_BENCHMARK_MAX_ITEMS").toLongLong(&ok);
+
+   return ok && count > 0 ? count : 1000000;
+}
@@ -0,0 +1,86 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBBENCHMARK
+#define H_IBBENCHMARK
+
+#include <QApplication>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QtTest>
+
+/* class IBBenchmark */
+
+class IBBenchmark
+{
+   public:
+      static void setAllocationCounting(bool enable);
+      static void resetAllocationCount();
+      static quint64 getAllocationCount();
+      static quint64 getAllocatedBytes();
+
+      static void setOffscreenPlatform();
+      static qint64 getMaximumItemCount();
+
+      template<typename Function>
+      static void measure(const QByteArray &metric, qint64 operations, Function function);
+};
+
+/* Runs the function (function), which performs the given number of operations (operations), and reports the
+   result of the given metric (metric) per operation as the benchmark result of the current test row.
+   The metric "ns" reports the wall time in nanoseconds, it repeats the function for at least 200 ms.
+   The metric "allocs" reports the number of heap allocations and the metric "bytes" the allocated bytes of a
+   single run. */
+template<typename Function>
+void IBBenchmark::measure(const QByteArray &metric, qint64 operations, Function function)
+{
+   QElapsedTimer timer;
+   qint64 iterations = 0;
+
+   operations = qMax<qint64>(1, operations);
+
+   if(metric == "ns")
+   {
+      timer.start();
+
+      do
+      {
+         function();
+         iterations++;
+      }
+      while(timer.nsecsElapsed() < 200000000LL);
+
+      QTest::setBenchmarkResult(qreal(timer.nsecsElapsed()) / qreal(iterations * operations),
+                                QTest::WalltimeNanoseconds);
+   }
+   else
+   {
+      IBBenchmark::resetAllocationCount();
+      IBBenchmark::setAllocationCounting(true);
+      function();
+      IBBenchmark::setAllocationCounting(false);
+
+      if(metric == "bytes")
+      {
+         QTest::setBenchmarkResult(qreal(IBBenchmark::getAllocatedBytes()) / qreal(operations),
+                                   QTest::BytesAllocated);
+      }
+      else
+      {
+         QTest::setBenchmarkResult(qreal(IBBenchmark::getAllocationCount()) / qreal(operations), QTest::Events);
+      }
+   }
+}
+
+/* Defines the main function of a benchmark (testobject), which runs on the offscreen platform by default. */
+#define IB_BENCHMARK_MAIN(testobject) \
+int main(int argc, char *argv[]) \
+{ \
+   IBBenchmark::setOffscreenPlatform(); \
+   QApplication app(argc, argv); \
+   testobject tc; \
+   QTEST_SET_MAIN_SOURCE_PATH \
+   return QTest::qExec(&tc, argc, argv); \
+}
+
+#endif /*H_IBBENCHMARK*/
@@ -0,0 +1,98 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibsyntheticdata.hpp"
+
+#include <QColor>
+#include <QLinearGradient>
+#include <QPainter>
+#include <QPixmap>
+#include <QRandomGenerator>
+
+/* class IBSyntheticData */
+
+/* Creates the given number (count) of deterministic image items with typical camera and screenshot file names,
+   several file types, modification dates spread over three years, dominant colors of all hues and EXIF data, of which
+   four of five items have a capture date. No file is accessed. */
+QList<IBImageListImageItem *> IBSyntheticData::createImageItems(int count)
+{
+   QRandomGenerator random(quint32(count));
+   QRandomGenerator colors(quint32(count) + 1);
+   QRandomGenerator captures(quint32(count) + 2);
+   QStringList types = {"jpg", "jpg", "jpg", "JPG", "jpeg", "png", "png", "bmp", "ppm", "xpm"};
+   QStringList words = {"beach", "birthday", "garden", "holiday", "mountains", "party", "screenshot", "wedding",
+                        "zoo", "2019", "2020", "2021"};
+   QDateTime start(QDate(2019, 1, 1), QTime(0, 0));
+   QList<IBImageListImageItem *> items;
+   IBExifData exif;
+   QString name;
+   int idx;
+
+   items.reserve(count);
+
+   for(idx = 0; idx < count; idx++)
+   {
+      switch(random.bounded(3))
+      {
+         case 0:
+            name = QString("IMG_%1").arg(idx, 6, 10, QChar('0'));
+            break;
+
+         case 1:
+            name = QString("DSC%1").arg(idx, 6, 10, QChar('0'));
+            break;
+
+         default:
+            name = QString("%1_%2_%3").arg(words[random.bounded(words.size())], words[random.bounded(words.size())])
+                                      .arg(idx);
+      }
+
+      name = QString("/synthetic/%1.%2").arg(name, types[random.bounded(types.size())]);
+      items.append(new IBImageListImageItem(name, start.addSecs(qint64(random.bounded(3 * 365 * 24 * 3600)))));
+      items.last()->setDominantColor(QColor::fromHsv(colors.bounded(360), colors.bounded(256),
+                                                     colors.bounded(32, 256)).rgb());
+
+      exif.dtTaken = captures.bounded(5) != 0 ? start.addSecs(qint64(captures.bounded(3 * 365 * 24 * 3600)))
+                                              : QDateTime();
+      exif.iOrientation = 1;
+      exif.strCameraModel = QStringLiteral("Synthetic Camera");
+      items.last()->setExifData(exif);
+   }
+
+   return items;
+}
+
+/* Sets painted thumbnails, which fit into the given size (thumbsize), to the items (items). Landscape and portrait
+   thumbnails of 16 colors alternate, the pixmaps are shared between the items. */
+void IBSyntheticData::setThumbnails(const QList<IBImageListImageItem *> &items, const QSize &thumbsize)
+{
+   QList<QPixmap> thumbnails;
+   QList<QSize> imagesizes;
+   QLinearGradient gradient;
+   QPainter painter;
+   QPixmap pixmap;
+   QSize imagesize;
+   int idx;
+
+   for(idx = 0; idx < 16; idx++)
+   {
+      imagesize = (idx % 3 == 2) ? QSize(3000, 4000) : QSize(6000, 4000);
+      pixmap = QPixmap(imagesize.scaled(thumbsize, Qt::KeepAspectRatio));
+
+      gradient = QLinearGradient(0, 0, pixmap.width(), pixmap.height());
+      gradient.setColorAt(0.0, QColor::fromHsv(idx * 360 / 16, 180, 230));
+      gradient.setColorAt(1.0, QColor::fromHsv((idx * 360 / 16 + 120) % 360, 200, 70));
+
+      painter.begin(&pixmap);
+      painter.fillRect(pixmap.rect(), gradient);
+      painter.end();
+
+      thumbnails.append(pixmap);
+      imagesizes.append(imagesize);
+   }
+
+   for(idx = 0; idx < items.size(); idx++)
+   {
+      items[idx]->setThumbnail(thumbnails[idx % thumbnails.size()], imagesizes[idx % imagesizes.size()]);
+   }
+}
@@ -0,0 +1,21 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBSYNTHETICDATA
+#define H_IBSYNTHETICDATA
+
+#include <QList>
+#include <QSize>
+
+#include "ibimagelistmodel.hpp"
+
+/* class IBSyntheticData */
+
+class IBSyntheticData
+{
+   public:
+      static QList<IBImageListImageItem *> createImageItems(int count);
+      static void setThumbnails(const QList<IBImageListImageItem *> &items, const QSize &thumbsize);
+};
+
+#endif /*H_IBSYNTHETICDATA*/
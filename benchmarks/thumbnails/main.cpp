@@ -0,0 +1,421 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImageWriter>
+#include <QLinearGradient>
+#include <QPainter>
+#include <QPixmap>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QThread>
+
+#include "ibbenchmark.hpp"
+#include "ibthumbnaildecoder.hpp"
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif /*Q_OS_LINUX*/
+
+/* version of the corpus layout, a corpus of another version is generated again */
+static const int iCorpusVersion = 2;
+
+/* class IBThumbnailWorker */
+
+class IBThumbnailWorker : public QThread
+{
+   public:
+      IBThumbnailWorker(const QStringList &files, QAtomicInt *next, const QSize &thumbsize);
+
+      void run() override;
+
+      /* work of the decoder */
+      IBThumbnailDecoderStatistics dsStatistics;
+      /* time of converting the thumbnails into pixmaps in nanoseconds */
+      qint64 iConvertTime;
+
+   private:
+      /* files of the corpus */
+      const QStringList &lstFiles;
+      /* index of the next file, which is shared by all workers */
+      QAtomicInt *iNext;
+      /* size of the thumbnails */
+      QSize szThumbnail;
+};
+
+/* Constructs a worker, which decodes the files (files) into thumbnails of the given size (thumbsize). The next
+   file to decode is taken from the shared index (next). */
+IBThumbnailWorker::IBThumbnailWorker(const QStringList &files, QAtomicInt *next, const QSize &thumbsize)
+   : iConvertTime(0), lstFiles(files), iNext(next), szThumbnail(thumbsize)
+{
+}
+
+/* Decodes the files like IBThumbnailLoader, until all files are taken. */
+void IBThumbnailWorker::run()
+{
+   IBThumbnailDecoder decoder;
+   QElapsedTimer timer;
+   QPixmap pixmap;
+   QImage image;
+   QSize imagesize;
+   int idx;
+
+   while((idx = this->iNext->fetchAndAddRelaxed(1)) < this->lstFiles.size())
+   {
+      image = decoder.decode(this->lstFiles[idx], this->szThumbnail, &imagesize);
+
+      timer.start();
+      pixmap = QPixmap::fromImage(std::move(image));
+      this->iConvertTime += timer.nsecsElapsed();
+   }
+
+   this->dsStatistics = decoder.getStatistics();
+}
+
+/* Paints a deterministic image of the given size (size) with gradients, shapes and noise, which depends on the
+   seed (seed). */
+static QImage createImage(const QSize &size, quint32 seed)
+{
+   QRandomGenerator random(seed);
+   QImage image(size, QImage::Format_RGB32);
+   QPainter painter(&image);
+   QLinearGradient gradient(0, 0, size.width(), size.height());
+   QRgb *line;
+   int idx, x, y, noise;
+
+   gradient.setColorAt(0.0, QColor::fromHsv(int(random.bounded(360)), 160, 230));
+   gradient.setColorAt(1.0, QColor::fromHsv(int(random.bounded(360)), 200, 60));
+   painter.fillRect(image.rect(), gradient);
+   painter.setRenderHint(QPainter::Antialiasing);
+
+   for(idx = 0; idx < 40; idx++)
+   {
+      painter.setBrush(QColor::fromHsv(int(random.bounded(360)), 200, int(random.bounded(256)), 160));
+      painter.setPen(Qt::NoPen);
+      painter.drawEllipse(QPoint(int(random.bounded(size.width())), int(random.bounded(size.height()))),
+                          int(random.bounded(size.width() / 4 + 1)), int(random.bounded(size.height() / 4 + 1)));
+   }
+
+   painter.end();
+
+   /* noise, so that the compression ratio is similar to photos */
+   for(y = 0; y < size.height(); y++)
+   {
+      line = reinterpret_cast<QRgb *>(image.scanLine(y));
+
+      for(x = 0; x < size.width(); x++)
+      {
+         noise = int(random.bounded(13)) - 6;
+         line[x] = qRgb(qBound(0, qRed(line[x]) + noise, 255), qBound(0, qGreen(line[x]) + noise, 255),
+                        qBound(0, qBlue(line[x]) + noise, 255));
+      }
+   }
+
+   return image;
+}
+
+/* Appends an IFD entry with the tag (tag), the type (type), the number of values (count) and the value or its offset
+   (value) in little endian order to the TIFF structure (tiff). */
+static void appendEntry(QByteArray *tiff, quint16 tag, quint16 type, quint32 count, quint32 value)
+{
+   QDataStream stream(tiff, QIODevice::WriteOnly | QIODevice::Append);
+
+   stream.setByteOrder(QDataStream::LittleEndian);
+   stream << tag << type << count << value;
+}
+
+/* Writes a RAW file (path) like a DNG file with the image (image) as its full-size JPEG preview. IFD0 refers to two
+   SubIFDs, the raw data, which is a lossless JPEG stream of noise with half a byte per pixel, and the preview, so
+   that the decoder has to walk the IFDs and to skip the raw data by its frame header. Returns false, if the file
+   cannot be written. */
+static bool writeRawFile(const QString &path, const QImage &image)
+{
+   QRandomGenerator random(quint32(image.width() * image.height()));
+   QByteArray tiff("II*\0\x08\0\0\0", 8), preview, raw;
+   QBuffer buffer(&preview);
+   QImageWriter writer(&buffer, "jpeg");
+   QFile file(path);
+   quint32 previewoffset = 166;
+   int idx;
+
+   writer.setQuality(90);
+
+   if(!buffer.open(QIODevice::WriteOnly) || !writer.write(image))
+   {
+      return false;
+   }
+
+   /* the frame header of a lossless JPEG stream with 12 bit samples and one component */
+   raw = QByteArray("\xFF\xD8\xFF\xC3\x00\x0B\x0C", 7);
+   raw.append(char(image.height() >> 8)).append(char(image.height())).append(char(image.width() >> 8))
+      .append(char(image.width())).append("\x01\x00\x11\x00", 4);
+
+   for(idx = raw.size(); idx < image.width() * image.height() / 2; idx++)
+   {
+      raw.append(char(random.bounded(256)));
+   }
+
+   /* IFD0 at offset 8 with the offsets of the SubIFDs at offset 50 */
+   tiff.append("\x03\x00", 2);
+   appendEntry(&tiff, 0x00FE, 4, 1, 1);
+   appendEntry(&tiff, 0x0103, 3, 1, 1);
+   appendEntry(&tiff, 0x014A, 4, 2, 50);
+   tiff.append(QByteArray(4, '\0'));
+   tiff.append("\x3A\0\0\0\x70\0\0\0", 8);
+
+   /* SubIFD of the raw data at offset 58 and SubIFD of the preview at offset 112 */
+   tiff.append("\x04\x00", 2);
+   appendEntry(&tiff, 0x00FE, 4, 1, 0);
+   appendEntry(&tiff, 0x0103, 3, 1, 7);
+   appendEntry(&tiff, 0x0111, 4, 1, previewoffset + quint32(preview.size()));
+   appendEntry(&tiff, 0x0117, 4, 1, quint32(raw.size()));
+   tiff.append(QByteArray(4, '\0'));
+   tiff.append("\x04\x00", 2);
+   appendEntry(&tiff, 0x00FE, 4, 1, 1);
+   appendEntry(&tiff, 0x0103, 3, 1, 7);
+   appendEntry(&tiff, 0x0111, 4, 1, previewoffset);
+   appendEntry(&tiff, 0x0117, 4, 1, quint32(preview.size()));
+   tiff.append(QByteArray(4, '\0'));
+
+   return file.open(QIODevice::WriteOnly) && file.write(tiff) == tiff.size() && file.write(preview) == preview.size()
+          && file.write(raw) == raw.size();
+}
+
+/* Generates the corpus of the given number of images (count) in the directory (dir) and returns its files.
+   The formats JPEG, PNG, BMP, PPM and DNG alternate, every 25th image is larger than the streaming threshold of the
+   decoder. An existing corpus of the same version and size is reused. */
+static QStringList generateCorpus(const QString &dir, int count, QTextStream &log)
+{
+   QList<QSize> sizes = {QSize(640, 480), QSize(1920, 1080), QSize(3000, 2000), QSize(4000, 3000)};
+   QStringList formats = {"jpg", "png", "bmp", "ppm", "dng"};
+   QString manifest = QString("version=%1 count=%2").arg(iCorpusVersion).arg(count);
+   QDir corpusdir(dir);
+   QFile manifestfile(corpusdir.filePath("corpus.txt"));
+   QStringList files;
+   QImageWriter writer;
+   QSize size;
+   int idx;
+
+   corpusdir.mkpath(".");
+
+   for(idx = 0; idx < count; idx++)
+   {
+      size = (idx % 25 == 24) ? QSize(7000, 4000) : sizes[idx % sizes.size()];
+      files << corpusdir.filePath(QString("corpus_%1_%2x%3.%4").arg(idx, 5, 10, QChar('0'))
+                                  .arg(size.width()).arg(size.height()).arg(formats[(idx / 4) % formats.size()]));
+   }
+
+   if(manifestfile.open(QIODevice::ReadOnly) && manifestfile.readAll().trimmed() == manifest.toLatin1())
+   {
+      return files;
+   }
+
+   manifestfile.close();
+   log << "generating " << count << " images in " << corpusdir.absolutePath() << '\n';
+   log.flush();
+
+   for(idx = 0; idx < count; idx++)
+   {
+      size = (idx % 25 == 24) ? QSize(7000, 4000) : sizes[idx % sizes.size()];
+
+      if(files[idx].endsWith(".dng"))
+      {
+         if(!writeRawFile(files[idx], createImage(size, quint32(idx))))
+         {
+            log << "cannot write " << files[idx] << '\n';
+            return QStringList();
+         }
+
+         continue;
+      }
+
+      writer.setFileName(files[idx]);
+      writer.setQuality(90);
+
+      if(!writer.write(createImage(size, quint32(idx))))
+      {
+         log << "cannot write " << files[idx] << ": " << writer.errorString() << '\n';
+         return QStringList();
+      }
+   }
+
+   if(manifestfile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+   {
+      manifestfile.write(manifest.toLatin1());
+   }
+
+   return files;
+}
+
+/* Drops the files (files) from the page cache, if cold is true, or reads them into the page cache otherwise. */
+static void prepareCache(const QStringList &files, bool cold)
+{
+   QFile file;
+
+   for(const QString &path : files)
+   {
+      file.setFileName(path);
+
+      if(!file.open(QIODevice::ReadOnly))
+      {
+         continue;
+      }
+
+      if(cold)
+      {
+#ifdef Q_OS_LINUX
+         posix_fadvise(file.handle(), 0, 0, POSIX_FADV_DONTNEED);
+#endif /*Q_OS_LINUX*/
+      }
+      else
+      {
+         while(!file.read(1024 * 1024).isEmpty())
+         {
+         }
+      }
+
+      file.close();
+   }
+}
+
+/* Resets the peak resident set size of the process, if the kernel supports it. */
+static void resetPeakMemory()
+{
+   QFile file("/proc/self/clear_refs");
+
+   if(file.open(QIODevice::WriteOnly))
+   {
+      file.write("5");
+   }
+}
+
+/* Returns the peak resident set size of the process in KiB or -1, if it is not available. */
+static qint64 getPeakMemory()
+{
+   QFile file("/proc/self/status");
+   QByteArray line;
+
+   if(file.open(QIODevice::ReadOnly))
+   {
+      while(!(line = file.readLine()).isEmpty())
+      {
+         if(line.startsWith("VmHWM:"))
+         {
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+         }
+      }
+   }
+
+   return -1;
+}
+
+/* Generates the corpus and measures the thumbnail throughput for 1 to N threads on a cold and a warm page cache.
+   The results are written as CSV to the standard output. */
+int main(int argc, char *argv[])
+{
+   IBBenchmark::setOffscreenPlatform();
+   QApplication app(argc, argv);
+   QCommandLineParser parser;
+   QCommandLineOption corpusoption("corpus", "Directory of the generated image corpus.", "dir",
+                                   QDir::temp().filePath("simpleimagebrowser-corpus"));
+   QCommandLineOption countoption("count", "Number of images in the corpus.", "count", "200");
+   QCommandLineOption threadsoption("threads", "Maximum number of decoding threads.", "threads",
+                                    QString::number(QThread::idealThreadCount()));
+   QCommandLineOption sizeoption("thumbsize", "Size of the thumbnails.", "WxH", "232x130");
+   QTextStream out(stdout), log(stderr);
+   QList<IBThumbnailWorker *> workers;
+   IBThumbnailDecoderStatistics total;
+   QElapsedTimer timer;
+   QStringList files, sizeparts;
+   QList<int> threadcounts;
+   QAtomicInt next;
+   QSize thumbsize;
+   qint64 converttime, elapsed;
+   int maxthreads, idx;
+
+   parser.setApplicationDescription("Measures the throughput of the thumbnail pipeline.");
+   parser.addHelpOption();
+   parser.addOption(corpusoption);
+   parser.addOption(countoption);
+   parser.addOption(threadsoption);
+   parser.addOption(sizeoption);
+   parser.process(app);
+
+   sizeparts = parser.value(sizeoption).split('x');
+   thumbsize = sizeparts.size() == 2 ? QSize(sizeparts[0].toInt(), sizeparts[1].toInt()) : QSize(232, 130);
+   maxthreads = qMax(1, parser.value(threadsoption).toInt());
+
+   for(idx = 1; idx < maxthreads; idx *= 2)
+   {
+      threadcounts << idx;
+   }
+   threadcounts << maxthreads;
+
+   files = generateCorpus(parser.value(corpusoption), qMax(1, parser.value(countoption).toInt()), log);
+
+   if(files.isEmpty())
+   {
+      return 1;
+   }
+
+   out << "cache,threads,images,failures,seconds,thumbs_per_second,read_ms,decode_ms,scale_ms,convert_ms,"
+          "peak_rss_kib\n";
+
+   for(bool cold : {true, false})
+   {
+      for(int threads : threadcounts)
+      {
+         prepareCache(files, cold);
+         resetPeakMemory();
+         next.storeRelaxed(0);
+         total = IBThumbnailDecoderStatistics();
+         converttime = 0;
+
+         timer.start();
+
+         for(idx = 0; idx < threads; idx++)
+         {
+            workers.append(new IBThumbnailWorker(files, &next, thumbsize));
+            workers.last()->start();
+         }
+
+         for(IBThumbnailWorker *worker : workers)
+         {
+            worker->wait();
+         }
+
+         elapsed = timer.nsecsElapsed();
+
+         for(IBThumbnailWorker *worker : workers)
+         {
+            total.iImages += worker->dsStatistics.iImages;
+            total.iFailures += worker->dsStatistics.iFailures;
+            total.iReadTime += worker->dsStatistics.iReadTime;
+            total.iDecodeTime += worker->dsStatistics.iDecodeTime;
+            total.iScaleTime += worker->dsStatistics.iScaleTime;
+            converttime += worker->iConvertTime;
+         }
+
+         qDeleteAll(workers);
+         workers.clear();
+
+         out << (cold ? "cold" : "warm") << ',' << threads << ',' << total.iImages << ',' << total.iFailures << ','
+             << QString::number(elapsed / 1e9, 'f', 3) << ','
+             << QString::number(total.iImages / (elapsed / 1e9), 'f', 1) << ','
+             << QString::number(total.iReadTime / 1e6, 'f', 1) << ','
+             << QString::number(total.iDecodeTime / 1e6, 'f', 1) << ','
+             << QString::number(total.iScaleTime / 1e6, 'f', 1) << ','
+             << QString::number(converttime / 1e6, 'f', 1) << ',' << getPeakMemory() << '\n';
+         out.flush();
+      }
+   }
+
+   return 0;
+}
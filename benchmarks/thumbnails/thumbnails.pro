@@ -0,0 +1,17 @@
+######################################################################
+# Throughput benchmark of the thumbnail pipeline
+######################################################################
+
+TEMPLATE = app
+TARGET = bench_thumbnails
+INCLUDEPATH += . ../shared
+QT += testlib
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../simpleimagebrowser.pri)
+
+# Input
+HEADERS += ../shared/ibbenchmark.hpp
+SOURCES += ../shared/ibbenchmark.cpp \
+           main.cpp
@@ -0,0 +1,217 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibdirectoryindex.hpp"
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif /*Q_OS_UNIX*/
+
+/* magic number ("IBDI") and version of the index files */
+static const quint32 iIndexMagic = 0x49424449;
+static const quint16 iIndexVersion = 3;
+/* smallest size of a stored entry in bytes, which has a file name of one character and empty strings otherwise */
+static const qint64 iMinEntrySize = 72;
+
+QString IBDirectoryIndex::strDefaultIndexDir;
+
+/* Writes the index entry (entry) to the stream (stream). */
+QDataStream &operator<<(QDataStream &stream, const IBDirectoryIndexEntry &entry)
+{
+   stream << entry.strFileName << entry.iSize << entry.iModified << entry.iInode << entry.szImage << entry.baFormat
+          << entry.iPerceptualHash << entry.bPerceptualHash << quint32(entry.rgbDominantColor) << entry.bExif
+          << entry.iTaken << entry.iOrientation << entry.strCameraModel;
+
+   return stream;
+}
+
+/* Reads the index entry (entry) from the stream (stream). */
+QDataStream &operator>>(QDataStream &stream, IBDirectoryIndexEntry &entry)
+{
+   quint32 color;
+
+   stream >> entry.strFileName >> entry.iSize >> entry.iModified >> entry.iInode >> entry.szImage >> entry.baFormat
+          >> entry.iPerceptualHash >> entry.bPerceptualHash >> color >> entry.bExif >> entry.iTaken
+          >> entry.iOrientation >> entry.strCameraModel;
+   entry.rgbDominantColor = QRgb(color);
+
+   return stream;
+}
+
+/* class IBDirectoryIndex */
+
+/* Constructs a directory index in the default index directory. see IBDirectoryIndex::getDefaultIndexDir */
+IBDirectoryIndex::IBDirectoryIndex()
+   : strIndexDir(IBDirectoryIndex::getDefaultIndexDir()), bEnabled(true)
+{
+}
+
+/* Constructs a directory index in the given directory (indexdir). */
+IBDirectoryIndex::IBDirectoryIndex(const QString &indexdir)
+   : strIndexDir(indexdir), bEnabled(true)
+{
+}
+
+/* Sets the directory (indexdir) of the index files. */
+void IBDirectoryIndex::setIndexDir(const QString &indexdir)
+{
+   this->strIndexDir = indexdir;
+}
+
+/* Returns the directory of the index files. */
+QString IBDirectoryIndex::getIndexDir() const
+{
+   return this->strIndexDir;
+}
+
+/* Enables or disables (enabled) the loading and the storing of indexes. */
+void IBDirectoryIndex::setEnabled(bool enabled)
+{
+   this->bEnabled = enabled;
+}
+
+/* Returns true, if indexes are loaded and stored. Otherwise false. */
+bool IBDirectoryIndex::isEnabled() const
+{
+   return this->bEnabled && !this->strIndexDir.isEmpty();
+}
+
+/* Returns the path of the index file of the image directory (dirpath). Like the thumbnails, the name of the file is
+   the MD5 hash of the URI of the directory. */
+QString IBDirectoryIndex::getIndexFilePath(const QString &dirpath) const
+{
+   QByteArray hash = QCryptographicHash::hash(QUrl::fromLocalFile(dirpath).toEncoded(), QCryptographicHash::Md5);
+
+   return QStringLiteral("%1/%2.idx").arg(this->strIndexDir).arg(QString::fromLatin1(hash.toHex()));
+}
+
+/* Loads the entries of the image directory (dirpath) into entries and the timestamp of the last modification of the
+   directory, when the index was stored, into dirmodified. Only the index file is read, not the directory. Returns
+   false, if no valid index of the directory exists. */
+bool IBDirectoryIndex::load(const QString &dirpath, QList<IBDirectoryIndexEntry> *entries,
+                            QDateTime *dirmodified) const
+{
+   QFile file(this->getIndexFilePath(dirpath));
+   QDataStream stream;
+   QString path;
+   quint32 magic, count, idx;
+   quint16 version;
+   qint64 modified;
+
+   entries->clear();
+
+   if(!this->isEnabled() || !file.open(QIODevice::ReadOnly))
+   {
+      return false;
+   }
+
+   stream.setDevice(&file);
+   stream.setVersion(QDataStream::Qt_5_12);
+
+   stream >> magic >> version >> path >> modified >> count;
+
+   /* the path guards against collisions of the hashes */
+   if(stream.status() != QDataStream::Ok || magic != iIndexMagic || version != iIndexVersion || path != dirpath)
+   {
+      return false;
+   }
+
+   /* the count of a truncated or corrupt file is bounded by the remaining bytes */
+   entries->reserve(int(qMin<qint64>(count, (file.size() - file.pos()) / iMinEntrySize)));
+
+   for(idx = 0; idx < count && stream.status() == QDataStream::Ok; idx++)
+   {
+      entries->append(IBDirectoryIndexEntry());
+      stream >> entries->last();
+   }
+
+   if(stream.status() != QDataStream::Ok)
+   {
+      entries->clear();
+      return false;
+   }
+
+   *dirmodified = QDateTime::fromMSecsSinceEpoch(modified);
+
+   return true;
+}
+
+/* Stores the entries (entries) of the image directory (dirpath) with the timestamp of the last modification of the
+   directory (dirmodified), when it was listed. The file is replaced atomically, so that several processes may share
+   the index directory. Returns false, if the index could not be written. */
+bool IBDirectoryIndex::store(const QString &dirpath, const QDateTime &dirmodified,
+                             const QList<IBDirectoryIndexEntry> &entries) const
+{
+   QString indexpath = this->getIndexFilePath(dirpath);
+   QSaveFile file(indexpath);
+   QDataStream stream;
+   QList<IBDirectoryIndexEntry>::const_iterator it;
+
+   if(!this->isEnabled() || !QDir().mkpath(QFileInfo(indexpath).path()) || !file.open(QIODevice::WriteOnly))
+   {
+      return false;
+   }
+
+   stream.setDevice(&file);
+   stream.setVersion(QDataStream::Qt_5_12);
+
+   stream << iIndexMagic << iIndexVersion << dirpath << dirmodified.toMSecsSinceEpoch() << quint32(entries.size());
+
+   for(it = entries.begin(); it != entries.end(); ++it)
+   {
+      stream << *it;
+   }
+
+   if(stream.status() != QDataStream::Ok)
+   {
+      file.cancelWriting();
+      return false;
+   }
+
+   return file.commit();
+}
+
+/* Returns the inode of the file (path). On systems without inodes or if the file does not exist, 0 is returned. */
+quint64 IBDirectoryIndex::getInode(const QString &path)
+{
+#ifdef Q_OS_UNIX
+   struct stat buf;
+
+   if(::stat(QFile::encodeName(path).constData(), &buf) == 0)
+   {
+      return quint64(buf.st_ino);
+   }
+#else
+   Q_UNUSED(path)
+#endif /*Q_OS_UNIX*/
+
+   return 0;
+}
+
+/* Sets the directory (indexdir) of the indexes, which are constructed afterwards. It has to be called before any
+   thread uses an index. */
+void IBDirectoryIndex::setDefaultIndexDir(const QString &indexdir)
+{
+   IBDirectoryIndex::strDefaultIndexDir = indexdir;
+}
+
+/* Returns the directory of the indexes, which are constructed without a directory. If it is not set, the environment
+   variable IB_DIRECTORY_INDEX or the subdirectory simpleimagebrowser/index of the generic cache location of the user
+   is used. */
+QString IBDirectoryIndex::getDefaultIndexDir()
+{
+   QString indexdir = IBDirectoryIndex::strDefaultIndexDir;
+
+   if(indexdir.isEmpty())
+   {
+      indexdir = qEnvironmentVariable("IB_DIRECTORY_INDEX");
+   }
+
+   if(indexdir.isEmpty())
+   {
+      indexdir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+      indexdir = indexdir.isEmpty() ? QString() : indexdir + QStringLiteral("/simpleimagebrowser/index");
+   }
+
+   return indexdir;
+}
@@ -0,0 +1,89 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBDIRECTORYINDEX
+#define H_IBDIRECTORYINDEX
+
+#include <QByteArray>
+#include <QColor>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QSaveFile>
+#include <QSize>
+#include <QStandardPaths>
+#include <QString>
+#include <QUrl>
+
+/* struct IBDirectoryIndexEntry */
+
+struct IBDirectoryIndexEntry
+{
+   /* name of the file without its directory */
+   QString strFileName;
+   /* size of the file in bytes */
+   qint64 iSize = 0;
+   /* timestamp of the last modification of the file in milliseconds since the epoch */
+   qint64 iModified = 0;
+   /* inode of the file, 0 if it is unknown */
+   quint64 iInode = 0;
+   /* original size of the image, invalid if it is unknown */
+   QSize szImage;
+   /* format of the image as detected from its content, empty if it is unknown */
+   QByteArray baFormat;
+   /* perceptual hash of the image, it is valid if bPerceptualHash is true, since a blank image has the hash 0 */
+   quint64 iPerceptualHash = 0;
+   bool bPerceptualHash = false;
+   /* dominant color of the image, 0 if it is not computed */
+   QRgb rgbDominantColor = 0;
+   /* is true, if the EXIF metadata of the image was read, even if the image has none */
+   bool bExif = false;
+   /* timestamp of the capture of the image in milliseconds since the epoch, 0 if it is unknown */
+   qint64 iTaken = 0;
+   /* orientation of the image from 1 to 8, 0 if it is unknown */
+   qint32 iOrientation = 0;
+   /* model of the camera, empty if it is unknown */
+   QString strCameraModel;
+};
+
+QDataStream &operator<<(QDataStream &stream, const IBDirectoryIndexEntry &entry);
+QDataStream &operator>>(QDataStream &stream, IBDirectoryIndexEntry &entry);
+
+/* class IBDirectoryIndex */
+
+class IBDirectoryIndex
+{
+   public:
+      IBDirectoryIndex();
+      IBDirectoryIndex(const QString &indexdir);
+
+      void setIndexDir(const QString &indexdir);
+      QString getIndexDir() const;
+
+      void setEnabled(bool enabled);
+      bool isEnabled() const;
+
+      QString getIndexFilePath(const QString &dirpath) const;
+      bool load(const QString &dirpath, QList<IBDirectoryIndexEntry> *entries, QDateTime *dirmodified) const;
+      bool store(const QString &dirpath, const QDateTime &dirmodified, const QList<IBDirectoryIndexEntry> &entries) const;
+
+      static quint64 getInode(const QString &path);
+
+      static void setDefaultIndexDir(const QString &indexdir);
+      static QString getDefaultIndexDir();
+
+   private:
+      /* directory with one index file per image directory */
+      QString strIndexDir;
+      /* is false, if indexes are neither loaded nor stored */
+      bool bEnabled;
+
+      /* index directory of new indexes, it is set once at the start */
+      static QString strDefaultIndexDir;
+};
+
+#endif /*H_IBDIRECTORYINDEX*/
@@ -0,0 +1,385 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibdirectoryprefetcher.hpp"
+
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* constants of the ioprio_set system call, which has no wrapper in the C library */
+static const int iIoPrioWhoProcess = 1;
+static const int iIoPrioClassIdle = 3;
+static const int iIoPrioClassShift = 13;
+#endif /*Q_OS_LINUX*/
+
+/* number of sibling directories, which are queued after the given directories */
+static const int iSiblingCount = 4;
+
+/* class IBDirectoryPrefetcher */
+
+/* Constructs the thread for prefetching directories with a memory budget of 32 MiB, a quarter of one core and
+   256 MiB of image files per call of prefetch. */
+IBDirectoryPrefetcher::IBDirectoryPrefetcher(QObject *parent)
+   : QThread(parent), szThumbnailSize(IBImageListModel::getDefaultThumbnailSize()),
+     iMemoryBudget(32 * 1024 * 1024), iCpuBudget(25), iReadBudget(256 * 1024 * 1024), iReadBytes(0),
+     iGeneration(0), bYield(false)
+{
+   this->chSnapshots.setMaxCost(this->iMemoryBudget / 1024);
+}
+
+/* Stops the thread before it is destroyed. */
+IBDirectoryPrefetcher::~IBDirectoryPrefetcher()
+{
+   this->stop();
+}
+
+/* Enumerates the queued directories one after another and loads their thumbnails within the budgets. The siblings
+   of a directory are queued, when the queue is empty. A prefetched directory is kept as a snapshot, also if the
+   thread yielded before all its thumbnails were loaded, and the signal directoryPrefetched is emitted. A snapshot,
+   which is queued again, is completed. On Linux, the thread runs in the idle I/O priority class. */
+void IBDirectoryPrefetcher::run()
+{
+   IBImageListSnapshot *snapshot;
+   QStringList siblings;
+   QString path, siblingsof;
+   QSize thumbsize;
+   quint64 generation;
+   qint64 cost;
+
+#ifdef Q_OS_LINUX
+   /* the reads of the thread are only served, when no other process reads from the disk */
+   syscall(SYS_ioprio_set, iIoPrioWhoProcess, 0, iIoPrioClassIdle << iIoPrioClassShift);
+#endif /*Q_OS_LINUX*/
+
+   forever
+   {
+      this->mtxQueue.lock();
+
+      while(this->slQueue.isEmpty() && this->strSiblingsOf.isEmpty() && !this->isInterruptionRequested())
+      {
+         this->wcQueue.wait(&this->mtxQueue);
+      }
+
+      if(this->isInterruptionRequested())
+      {
+         this->mtxQueue.unlock();
+         return;
+      }
+
+      if(this->slQueue.isEmpty())
+      {
+         siblingsof = this->strSiblingsOf;
+         generation = this->iGeneration;
+         this->strSiblingsOf.clear();
+         this->mtxQueue.unlock();
+
+         siblings = IBDirectoryPrefetcher::getSiblingDirectories(siblingsof, iSiblingCount);
+
+         /* the siblings are dropped, if prefetch or yield was called in the meantime */
+         this->mtxQueue.lock();
+         for(const QString &sibling : siblings)
+         {
+            if(generation == this->iGeneration && !this->slExcluded.contains(sibling))
+            {
+               this->slQueue.append(sibling);
+            }
+         }
+         this->mtxQueue.unlock();
+         continue;
+      }
+
+      path = this->slQueue.takeFirst();
+      IB_TRACE_COUNTER("prefetch", "directoriesQueued", this->slQueue.size());
+      snapshot = this->chSnapshots.take(path);
+      thumbsize = this->szThumbnailSize;
+      this->mtxQueue.unlock();
+
+      if(!snapshot)
+      {
+         snapshot = this->createSnapshot(path);
+      }
+
+      if(!snapshot)
+      {
+         continue;
+      }
+
+      this->loadThumbnails(snapshot, thumbsize);
+      cost = (snapshot->getThumbnailBytes() + qint64(snapshot->lstFileData.size()) * 512) / 1024 + 1;
+
+      this->mtxQueue.lock();
+      this->chSnapshots.insert(path, snapshot, int(cost));
+      this->mtxQueue.unlock();
+
+      emit this->directoryPrefetched(path);
+   }
+}
+
+/* Sets the size (size) of the thumbnails. */
+void IBDirectoryPrefetcher::setThumbnailSize(const QSize &size)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->szThumbnailSize = size;
+}
+
+/* Returns the size of the thumbnails. */
+QSize IBDirectoryPrefetcher::getThumbnailSize() const
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   return this->szThumbnailSize;
+}
+
+/* Sets the upper bound (bytes) of the memory used by the prefetched directories. */
+void IBDirectoryPrefetcher::setMemoryBudget(qint64 bytes)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->iMemoryBudget = bytes;
+   this->chSnapshots.setMaxCost(bytes / 1024);
+}
+
+/* Returns the upper bound of the memory used by the prefetched directories. */
+qint64 IBDirectoryPrefetcher::getMemoryBudget() const
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   return this->iMemoryBudget;
+}
+
+/* Sets the share of one core (percent), which the thread may use. */
+void IBDirectoryPrefetcher::setCpuBudget(int percent)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->iCpuBudget = qBound(1, percent, 100);
+}
+
+/* Returns the share of one core in percent, which the thread may use. */
+int IBDirectoryPrefetcher::getCpuBudget() const
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   return this->iCpuBudget;
+}
+
+/* Sets the upper bound (bytes) of the image files, which are read by one call of prefetch. */
+void IBDirectoryPrefetcher::setReadBudget(qint64 bytes)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->iReadBudget = bytes;
+}
+
+/* Returns the upper bound of the image files, which are read by one call of prefetch. */
+qint64 IBDirectoryPrefetcher::getReadBudget() const
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   return this->iReadBudget;
+}
+
+/* Replaces the queued directories by the given directories (paths) ordered by priority, followed by the nearest
+   sibling directories of the directory (siblingsof), and wakes the thread. The directories (excluded) are skipped.
+   The read budget is renewed. */
+void IBDirectoryPrefetcher::prefetch(const QStringList &paths, const QString &siblingsof, const QStringList &excluded)
+{
+   QStringList::const_iterator it;
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->slQueue.clear();
+   this->slExcluded.clear();
+
+   for(it = excluded.begin(); it != excluded.end(); ++it)
+   {
+      this->slExcluded.append(QDir::cleanPath(*it));
+   }
+
+   for(it = paths.begin(); it != paths.end(); ++it)
+   {
+      if(!it->isEmpty() && !this->slQueue.contains(QDir::cleanPath(*it))
+         && !this->slExcluded.contains(QDir::cleanPath(*it)))
+      {
+         this->slQueue.append(QDir::cleanPath(*it));
+      }
+   }
+
+   this->strSiblingsOf = siblingsof.isEmpty() ? QString() : QDir::cleanPath(siblingsof);
+   this->iReadBytes = 0;
+   this->iGeneration++;
+   this->bYield = false;
+
+   if(!this->slQueue.isEmpty() || !this->strSiblingsOf.isEmpty())
+   {
+      if(!this->isRunning())
+      {
+         this->start(QThread::IdlePriority);
+      }
+      this->wcQueue.wakeOne();
+   }
+}
+
+/* Removes the snapshot of the directory (path) from the prefetched directories and returns it. The caller takes the
+   ownership of the snapshot. If the directory is not prefetched, nullptr is returned. */
+IBImageListSnapshot *IBDirectoryPrefetcher::takeSnapshot(const QString &path)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   return this->chSnapshots.take(QDir::cleanPath(path));
+}
+
+/* Discards the queued directories and lets the thread stop the current directory after the current image. It is
+   called on every action of the user, so that the prefetching does not compete with the requested work. */
+void IBDirectoryPrefetcher::yield()
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->slQueue.clear();
+   this->strSiblingsOf.clear();
+   this->iGeneration++;
+   this->bYield = true;
+   this->wcQueue.wakeAll();
+}
+
+/* Stops the thread and discards the queued directories. */
+void IBDirectoryPrefetcher::stop()
+{
+   this->mtxQueue.lock();
+   this->slQueue.clear();
+   this->strSiblingsOf.clear();
+   this->bYield = true;
+   this->requestInterruption();
+   this->wcQueue.wakeAll();
+   this->mtxQueue.unlock();
+
+   this->wait();
+}
+
+/* Returns up to count sibling directories of the directory (path) ordered by their distance to it in the sorted
+   list of siblings. The following directory precedes the preceding one. */
+QStringList IBDirectoryPrefetcher::getSiblingDirectories(const QString &path, int count)
+{
+   QDir parent(path);
+   QStringList names, siblings;
+   int idx, dist;
+
+   if(count <= 0 || !parent.cdUp())
+   {
+      return siblings;
+   }
+
+   names = parent.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable, QDir::Name | QDir::IgnoreCase);
+   idx = int(names.indexOf(QFileInfo(path).fileName()));
+
+   if(idx < 0)
+   {
+      return siblings;
+   }
+
+   for(dist = 1; siblings.size() < count && (idx + dist < names.size() || idx - dist >= 0); dist++)
+   {
+      if(idx + dist < names.size())
+      {
+         siblings.append(parent.absoluteFilePath(names.at(idx + dist)));
+      }
+
+      if(idx - dist >= 0 && siblings.size() < count)
+      {
+         siblings.append(parent.absoluteFilePath(names.at(idx - dist)));
+      }
+   }
+
+   return siblings;
+}
+
+/* Enumerates the images of the directory (path) like IBImageListModel into a new snapshot without thumbnails.
+   If the directory does not exist, nullptr is returned. */
+IBImageListSnapshot *IBDirectoryPrefetcher::createSnapshot(const QString &path)
+{
+   IB_TRACE_SCOPE("prefetch", "createSnapshot");
+   IBImageListSnapshot *snapshot;
+   QFileInfoList fileinfos;
+   QList<QFileInfo>::iterator it;
+   QDir dir(path);
+
+   if(!dir.exists())
+   {
+      return nullptr;
+   }
+
+   dir.setNameFilters(IBImageListModel::getImageNameFilters());
+   fileinfos = dir.entryInfoList();
+
+   snapshot = new IBImageListSnapshot();
+   snapshot->strPath = dir.path();
+   snapshot->dtModified = QFileInfo(dir.absolutePath()).lastModified();
+
+   for(it = fileinfos.begin(); it != fileinfos.end(); ++it)
+   {
+      snapshot->lstFileData.append(new IBImageListImageItem(*it));
+   }
+
+   return snapshot;
+}
+
+/* Loads the missing thumbnails of the given size (thumbsize) of the snapshot (snapshot) in the order of the file
+   names, until the thread has to yield or the read budget is spent. The thumbnails are taken from and stored in the
+   thumbnail cache. */
+void IBDirectoryPrefetcher::loadThumbnails(IBImageListSnapshot *snapshot, QSize &thumbsize)
+{
+   IB_TRACE_SCOPE("prefetch", "loadThumbnails");
+   QList<IBImageListImageItem *>::iterator it;
+   IBImageListMetadata metadata;
+   QElapsedTimer timer;
+   qint64 size;
+   bool spent;
+
+   for(it = snapshot->lstFileData.begin(); it != snapshot->lstFileData.end() && !this->bYield; ++it)
+   {
+      if((*it)->isImageLoaded())
+      {
+         continue;
+      }
+
+      size = QFileInfo((*it)->getFilePath()).size();
+
+      this->mtxQueue.lock();
+      spent = this->iReadBytes >= this->iReadBudget;
+      this->iReadBytes += spent ? 0 : size;
+      this->mtxQueue.unlock();
+
+      if(spent)
+      {
+         break;
+      }
+
+      timer.start();
+      metadata = IBImageListMetadata();
+      (*it)->loadImage(thumbsize, this->tdDecoder, this->tcCache, &metadata);
+      (*it)->setMetadata(metadata);
+
+      if(!this->pause(timer.nsecsElapsed()))
+      {
+         break;
+      }
+   }
+
+   this->tdDecoder.releaseScratchBuffers();
+}
+
+/* Sleeps after the work of worktime nanoseconds, so that the thread stays within its CPU budget. The sleep is
+   interrupted by yield and stop. Returns false, if the thread has to yield. Otherwise true. */
+bool IBDirectoryPrefetcher::pause(qint64 worktime)
+{
+   QMutexLocker locker(&this->mtxQueue);
+   qint64 sleeptime = worktime / 1000000 * (100 - this->iCpuBudget) / this->iCpuBudget;
+
+   if(!this->bYield && !this->isInterruptionRequested() && sleeptime > 0)
+   {
+      this->wcQueue.wait(&this->mtxQueue, (unsigned long)sleeptime);
+   }
+
+   return !this->bYield && !this->isInterruptionRequested();
+}
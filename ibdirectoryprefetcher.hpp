@@ -0,0 +1,95 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBDIRECTORYPREFETCHER
+#define H_IBDIRECTORYPREFETCHER
+
+#include <QCache>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+
+#include "ibimagelistmodel.hpp"
+#include "ibthumbnailcache.hpp"
+#include "ibthumbnaildecoder.hpp"
+#include "ibtrace.hpp"
+
+/* class IBDirectoryPrefetcher */
+
+class IBDirectoryPrefetcher : public QThread
+{
+   Q_OBJECT
+
+   public:
+      IBDirectoryPrefetcher(QObject *parent = nullptr);
+      ~IBDirectoryPrefetcher();
+
+      void run() override;
+
+      void setThumbnailSize(const QSize &size);
+      QSize getThumbnailSize() const;
+
+      void setMemoryBudget(qint64 bytes);
+      qint64 getMemoryBudget() const;
+      void setCpuBudget(int percent);
+      int getCpuBudget() const;
+      void setReadBudget(qint64 bytes);
+      qint64 getReadBudget() const;
+
+      void prefetch(const QStringList &paths, const QString &siblingsof = QString(),
+                    const QStringList &excluded = QStringList());
+      IBImageListSnapshot *takeSnapshot(const QString &path);
+      void yield();
+      void stop();
+
+      static QStringList getSiblingDirectories(const QString &path, int count);
+
+   signals:
+      void directoryPrefetched(const QString &path);
+
+   private:
+      IBImageListSnapshot *createSnapshot(const QString &path);
+      void loadThumbnails(IBImageListSnapshot *snapshot, QSize &thumbsize);
+      bool pause(qint64 worktime);
+
+      /* protects the queue, the snapshots and the budgets */
+      mutable QMutex mtxQueue;
+      /* wakes the thread when new paths are queued or the thread has to yield */
+      QWaitCondition wcQueue;
+      /* directories to be prefetched, ordered by priority */
+      QStringList slQueue;
+      /* directory, whose siblings are queued after slQueue */
+      QString strSiblingsOf;
+      /* directories, which are not prefetched, because they are cached elsewhere */
+      QStringList slExcluded;
+      /* prefetched directories by their paths, the cost of an entry is its memory in KiB */
+      QCache<QString, IBImageListSnapshot> chSnapshots;
+      /* size of the thumbnails */
+      QSize szThumbnailSize;
+      /* upper bound of the memory used by the prefetched directories in bytes */
+      qint64 iMemoryBudget;
+      /* share of one core in percent, which the thread may use */
+      int iCpuBudget;
+      /* upper bound of the bytes of image files, which are read by one call of prefetch */
+      qint64 iReadBudget;
+      /* bytes of image files, which are read since the last call of prefetch */
+      qint64 iReadBytes;
+      /* is increased by prefetch and yield, so that the thread can detect outdated work */
+      quint64 iGeneration;
+      /* is true, if the thread has to stop the current directory after the current image */
+      std::atomic<bool> bYield;
+      /* decodes and scales the images */
+      IBThumbnailDecoder tdDecoder;
+      /* persistent thumbnails, which are shared with IBThumbnailLoader */
+      IBThumbnailCache tcCache;
+};
+
+#endif /*H_IBDIRECTORYPREFETCHER*/
@@ -0,0 +1,727 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibdirectorytreemodel.hpp"
+
+#include <algorithm>
+
+/* number of counted files, after which a count checks for queued listings */
+static const int iCountCheckInterval = 256;
+
+/* class IBDirectoryLister */
+
+/* Constructs the thread for listing the subdirectories of directories. */
+IBDirectoryLister::IBDirectoryLister(QObject *parent)
+   : QThread(parent)
+{
+}
+
+/* Stops the thread before it is destroyed. */
+IBDirectoryLister::~IBDirectoryLister()
+{
+   this->stop();
+}
+
+/* Lists the queued directories one after another and emits the signal directoryListed with the names of their
+   subdirectories. The images of the directories are counted, when no directory is queued for listing, and the
+   signal directoryCounted is emitted. A count is given up and queued again, as soon as a directory is queued for
+   listing, so that the expansion of a directory does not wait for the count of a large directory. A count is reused,
+   as long as the timestamp of the last modification of the directory does not change. A slow or hanging mount only
+   delays the thread, but never the GUI thread. */
+void IBDirectoryLister::run()
+{
+   IBDirectoryImageCount imagecount;
+   QStringList names;
+   QDateTime modified;
+   QString path;
+   bool exists, listing, counted;
+
+   forever
+   {
+      this->mtxQueue.lock();
+
+      while(this->slQueue.isEmpty() && this->slCountQueue.isEmpty() && !this->isInterruptionRequested())
+      {
+         this->wcQueue.wait(&this->mtxQueue);
+      }
+
+      if(this->isInterruptionRequested())
+      {
+         this->mtxQueue.unlock();
+         return;
+      }
+
+      listing = !this->slQueue.isEmpty();
+      path = listing ? this->slQueue.takeFirst() : this->slCountQueue.takeLast();
+      this->mtxQueue.unlock();
+
+      if(listing)
+      {
+         IB_TRACE_SCOPE("directories", "listDirectory");
+         QDir dir(path);
+
+         exists = dir.exists();
+         names = exists ? dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Unsorted) : QStringList();
+
+         emit this->directoryListed(path, names, exists);
+         continue;
+      }
+
+      modified = QFileInfo(path).lastModified();
+
+      this->mtxQueue.lock();
+      imagecount = this->hshCounts.value(path);
+      this->mtxQueue.unlock();
+
+      if(!modified.isValid() || imagecount.dtModified != modified)
+      {
+         IB_TRACE_SCOPE("directories", "countImages");
+
+         imagecount.dtModified = modified;
+         counted = this->countImages(path, &imagecount.iImages);
+
+         this->mtxQueue.lock();
+
+         if(!counted)
+         {
+            /* the count is given up for a queued listing and resumed from the start, when it is counted next */
+            if(!this->slCountQueue.contains(path))
+            {
+               this->slCountQueue.append(path);
+            }
+
+            this->mtxQueue.unlock();
+            continue;
+         }
+
+         this->hshCounts.insert(path, imagecount);
+         this->mtxQueue.unlock();
+      }
+
+      emit this->directoryCounted(path, imagecount.iImages);
+   }
+}
+
+/* Queues the directory (path) for listing, if it is not queued yet, and wakes the thread. */
+void IBDirectoryLister::list(const QString &path)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   if(!this->slQueue.contains(path))
+   {
+      this->slQueue.append(path);
+   }
+
+   if(!this->isRunning())
+   {
+      this->start(QThread::LowPriority);
+   }
+
+   this->wcQueue.wakeOne();
+}
+
+/* Queues the directory (path) for counting its images and wakes the thread. The directory, which is queued last,
+   is counted first, so that the directories, which were shown last, are counted before the ones scrolled away. */
+void IBDirectoryLister::count(const QString &path)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->slCountQueue.removeAll(path);
+   this->slCountQueue.append(path);
+
+   if(!this->isRunning())
+   {
+      this->start(QThread::LowPriority);
+   }
+
+   this->wcQueue.wakeOne();
+}
+
+/* Stops the thread and discards the queued directories. A running listing is finished first. */
+void IBDirectoryLister::stop()
+{
+   this->mtxQueue.lock();
+   this->slQueue.clear();
+   this->slCountQueue.clear();
+   this->requestInterruption();
+   this->wcQueue.wakeAll();
+   this->mtxQueue.unlock();
+
+   this->wait();
+}
+
+/* Counts the files in the directory (path), which match the name filters of IBImageListModel, and stores their
+   number in (images). The subdirectories are not counted. Returns false without a number, if a directory is queued
+   for listing or the thread is stopped during the count. */
+bool IBDirectoryLister::countImages(const QString &path, int *images)
+{
+   QDirIterator it(path, IBImageListModel::getImageNameFilters(), QDir::Files);
+   bool yield;
+
+   *images = 0;
+
+   while(it.hasNext())
+   {
+      it.next();
+      (*images)++;
+
+      if((*images) % iCountCheckInterval == 0)
+      {
+         this->mtxQueue.lock();
+         yield = !this->slQueue.isEmpty() || this->isInterruptionRequested();
+         this->mtxQueue.unlock();
+
+         if(yield)
+         {
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+/* class IBDirectoryTreeModel */
+
+/* Constructs a model of the directory tree, which only contains the root directories. The subdirectories of a
+   directory are listed in the background, when a view fetches them or when a path is looked up by index. */
+IBDirectoryTreeModel::IBDirectoryTreeModel(QObject *parent)
+   : QAbstractItemModel(parent), iAccountedNodes(0), iAccountedBytes(0)
+{
+   QFileInfoList drives = QDir::drives();
+   QFileInfoList::const_iterator it;
+
+   this->ndRoot = new IBDirectoryNode;
+   this->ndRoot->bListed = true;
+
+   for(it = drives.constBegin(); it != drives.constEnd(); ++it)
+   {
+      this->insertChild(this->ndRoot, it->absoluteFilePath());
+   }
+
+   this->icnFolder = QFileIconProvider().icon(QFileIconProvider::Folder);
+
+   this->dlLister = new IBDirectoryLister(this);
+   this->connect(this->dlLister, SIGNAL(directoryListed(const QString &, const QStringList &, bool)),
+                 SLOT(onDirectoryListed(const QString &, const QStringList &, bool)));
+   this->connect(this->dlLister, SIGNAL(directoryCounted(const QString &, int)),
+                 SLOT(onDirectoryCounted(const QString &, int)));
+
+   this->fswWatcher = new QFileSystemWatcher(this);
+   this->connect(this->fswWatcher, SIGNAL(directoryChanged(const QString &)),
+                 SLOT(onDirectoryChanged(const QString &)));
+}
+
+/* Destructs the model with all its nodes. A running listing is finished first. */
+IBDirectoryTreeModel::~IBDirectoryTreeModel()
+{
+   this->dlLister->stop();
+   this->deleteNode(this->ndRoot);
+}
+
+/* reimpl. */
+QModelIndex IBDirectoryTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+   IBDirectoryNode *node = this->getNode(parent);
+
+   if(row < 0 || column < 0 || column >= IBDirectoryTreeModel::ColumnCount || row >= node->lstChildren.size())
+   {
+      return QModelIndex();
+   }
+
+   return this->createIndex(row, column, node->lstChildren.at(row));
+}
+
+/* Returns the index of the directory (path). The nodes of the directory and its ancestors are created without
+   listing their siblings, so that the path can be expanded before the directories are listed. */
+QModelIndex IBDirectoryTreeModel::index(const QString &path)
+{
+   return this->getNodeIndex(this->findNode(path, true));
+}
+
+/* reimpl. */
+QModelIndex IBDirectoryTreeModel::parent(const QModelIndex &index) const
+{
+   IBDirectoryNode *node = this->getNode(index);
+
+   if(node == this->ndRoot || node->ndParent == this->ndRoot)
+   {
+      return QModelIndex();
+   }
+
+   return this->getNodeIndex(node->ndParent);
+}
+
+/* reimpl. */
+int IBDirectoryTreeModel::rowCount(const QModelIndex &parent) const
+{
+   if(parent.column() > 0)
+   {
+      return 0;
+   }
+
+   return int(this->getNode(parent)->lstChildren.size());
+}
+
+/* reimpl. */
+int IBDirectoryTreeModel::columnCount(const QModelIndex &parent) const
+{
+   Q_UNUSED(parent)
+
+   return IBDirectoryTreeModel::ColumnCount;
+}
+
+/* reimpl. A directory, which is not listed yet, is assumed to have subdirectories, so that it can be expanded
+   without accessing the file system. */
+bool IBDirectoryTreeModel::hasChildren(const QModelIndex &parent) const
+{
+   IBDirectoryNode *node = this->getNode(parent);
+
+   if(parent.column() > 0)
+   {
+      return false;
+   }
+
+   return !node->bListed || !node->lstChildren.isEmpty();
+}
+
+/* reimpl. The images of a directory are counted in the background, when its count is shown the first time. */
+QVariant IBDirectoryTreeModel::data(const QModelIndex &index, int role) const
+{
+   IBDirectoryNode *node = this->getNode(index);
+
+   if(!index.isValid())
+   {
+      return QVariant();
+   }
+
+   if(role == IBDirectoryTreeModel::FilePathRole)
+   {
+      return this->getNodePath(node);
+   }
+   else if(role == IBDirectoryTreeModel::ImageCountRole)
+   {
+      return node->iImageCount;
+   }
+
+   if(index.column() == IBDirectoryTreeModel::ImageCountColumn)
+   {
+      switch(role)
+      {
+         case Qt::DisplayRole:
+            if(node->iImageCount < 0 && !node->bCounting)
+            {
+               this->requestCount(node);
+            }
+            return node->iImageCount >= 0 ? QString::number(node->iImageCount) : QString();
+
+         case Qt::TextAlignmentRole:
+            return int(Qt::AlignRight | Qt::AlignVCenter);
+
+         default:
+            return QVariant();
+      }
+   }
+
+   switch(role)
+   {
+      case Qt::DisplayRole:
+         return node->strName;
+
+      case Qt::DecorationRole:
+         return this->icnFolder;
+
+      default:
+         return QVariant();
+   }
+}
+
+/* reimpl. */
+bool IBDirectoryTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+   IBDirectoryNode *node = this->getNode(parent);
+
+   return parent.column() <= 0 && !node->bListed && !node->bListing;
+}
+
+/* reimpl. The subdirectories are inserted, when the lister has listed the directory. */
+void IBDirectoryTreeModel::fetchMore(const QModelIndex &parent)
+{
+   IBDirectoryNode *node = this->getNode(parent);
+
+   if(parent.column() <= 0 && !node->bListed && !node->bListing)
+   {
+      this->requestListing(node);
+   }
+}
+
+/* Returns the path of the directory of the given index (index). */
+QString IBDirectoryTreeModel::filePath(const QModelIndex &index) const
+{
+   return index.isValid() ? this->getNodePath(this->getNode(index)) : QString();
+}
+
+/* Starts or stops (watched) watching the directory of the given index (index) for changes. Only the expanded
+   directories are watched. A directory, which was listed before, is listed again on starting, because it may have
+   changed in the meantime. */
+void IBDirectoryTreeModel::setWatched(const QModelIndex &index, bool watched)
+{
+   IBDirectoryNode *node = this->getNode(index);
+
+   if(!index.isValid() || node->bWatched == watched)
+   {
+      return;
+   }
+
+   if(watched)
+   {
+      node->bWatched = this->fswWatcher->addPath(this->getNodePath(node));
+
+      if(node->bListed && !node->bListing)
+      {
+         this->requestListing(node);
+      }
+   }
+   else
+   {
+      this->fswWatcher->removePath(this->getNodePath(node));
+      node->bWatched = false;
+   }
+}
+
+/* Stops watching all directories, e.g. when the view is hidden or all its nodes are collapsed. */
+void IBDirectoryTreeModel::unwatchAll()
+{
+   QStringList paths = this->fswWatcher->directories();
+   QStringList::const_iterator it;
+   IBDirectoryNode *node;
+
+   for(it = paths.constBegin(); it != paths.constEnd(); ++it)
+   {
+      node = this->findNode(*it, false);
+
+      if(node)
+      {
+         node->bWatched = false;
+      }
+   }
+
+   if(!paths.isEmpty())
+   {
+      this->fswWatcher->removePaths(paths);
+   }
+}
+
+/* Merges the listed subdirectories (names) into the node of the directory (path). Removed subdirectories are removed
+   from the model with their nodes. If the directory does not exist any longer (exists), it is removed. */
+void IBDirectoryTreeModel::onDirectoryListed(const QString &path, const QStringList &names, bool exists)
+{
+   IB_TRACE_SCOPE("directories", "mergeDirectory");
+   IBDirectoryNode *node = this->findNode(path, false);
+   QStringList sortednames = names;
+   QStringList::const_iterator it;
+   QSet<QString> listed, known;
+   qint64 bytes = 0;
+   int row;
+
+   if(!node)
+   {
+      return;
+   }
+
+   node->bListing = false;
+
+   if(!exists)
+   {
+      if(node->ndParent != this->ndRoot)
+      {
+         this->removeChild(node->ndParent, int(node->ndParent->lstChildren.indexOf(node)));
+      }
+      return;
+   }
+
+   std::sort(sortednames.begin(), sortednames.end(), IBDirectoryTreeModel::lessThan);
+
+   if(node->lstChildren.isEmpty() && !sortednames.isEmpty())
+   {
+      /* the first listing is inserted at once */
+      this->beginInsertRows(this->getNodeIndex(node), 0, int(sortednames.size()) - 1);
+
+      for(it = sortednames.constBegin(); it != sortednames.constEnd(); ++it)
+      {
+         node->lstChildren.append(new IBDirectoryNode);
+         node->lstChildren.last()->strName = *it;
+         node->lstChildren.last()->ndParent = node;
+         bytes += IBDirectoryTreeModel::getNodeBytes(node->lstChildren.last());
+      }
+
+      IBMemoryAccounting::allocate(IBMemoryAccounting::DirectoryTree, bytes, sortednames.size());
+      this->iAccountedNodes += sortednames.size();
+      this->iAccountedBytes += bytes;
+      this->endInsertRows();
+   }
+   else
+   {
+      listed = QSet<QString>(sortednames.constBegin(), sortednames.constEnd());
+
+      for(row = int(node->lstChildren.size()) - 1; row >= 0; row--)
+      {
+         if(!listed.contains(node->lstChildren.at(row)->strName))
+         {
+            this->removeChild(node, row);
+         }
+         else
+         {
+            known.insert(node->lstChildren.at(row)->strName);
+         }
+      }
+
+      for(it = sortednames.constBegin(); it != sortednames.constEnd(); ++it)
+      {
+         if(!known.contains(*it))
+         {
+            this->insertChild(node, *it);
+         }
+      }
+   }
+
+   node->bListed = true;
+
+   /* the expander of a directory without subdirectories is removed */
+   if(node->lstChildren.isEmpty() && node != this->ndRoot)
+   {
+      emit this->dataChanged(this->getNodeIndex(node), this->getNodeIndex(node));
+   }
+}
+
+/* Shows the number of images (images) of the directory (path). */
+void IBDirectoryTreeModel::onDirectoryCounted(const QString &path, int images)
+{
+   IBDirectoryNode *node = this->findNode(path, false);
+   QModelIndex index;
+
+   if(!node)
+   {
+      return;
+   }
+
+   node->bCounting = false;
+
+   if(node->iImageCount != images)
+   {
+      node->iImageCount = images;
+      index = this->getNodeIndex(node, IBDirectoryTreeModel::ImageCountColumn);
+      emit this->dataChanged(index, index);
+   }
+}
+
+/* Lists the changed directory (path) again and counts its images again, if they were counted before. */
+void IBDirectoryTreeModel::onDirectoryChanged(const QString &path)
+{
+   IBDirectoryNode *node = this->findNode(path, false);
+
+   if(!node)
+   {
+      return;
+   }
+
+   if(!node->bListing)
+   {
+      this->requestListing(node);
+   }
+
+   if(node->iImageCount >= 0 && !node->bCounting)
+   {
+      this->requestCount(node);
+   }
+}
+
+/* Returns the node of the given index (index), the invisible root node for an invalid index. */
+IBDirectoryNode *IBDirectoryTreeModel::getNode(const QModelIndex &index) const
+{
+   return index.isValid() ? static_cast<IBDirectoryNode *>(index.internalPointer()) : this->ndRoot;
+}
+
+/* Returns the node of the directory (path). If create is true, missing nodes of the path are inserted without
+   accessing the file system. Otherwise nullptr is returned for a missing node. */
+IBDirectoryNode *IBDirectoryTreeModel::findNode(const QString &path, bool create)
+{
+   QString cleanpath = QDir::cleanPath(QDir(QDir::fromNativeSeparators(path)).absolutePath());
+   QList<IBDirectoryNode *>::const_iterator nodeit;
+   QStringList components;
+   QStringList::const_iterator it;
+   IBDirectoryNode *node = nullptr, *child;
+
+   for(nodeit = this->ndRoot->lstChildren.constBegin(); nodeit != this->ndRoot->lstChildren.constEnd(); ++nodeit)
+   {
+      if(cleanpath.startsWith((*nodeit)->strName, Qt::CaseInsensitive)
+         && (!node || (*nodeit)->strName.size() > node->strName.size()))
+      {
+         node = *nodeit;
+      }
+   }
+
+   if(!node)
+   {
+      return nullptr;
+   }
+
+   components = cleanpath.mid(node->strName.size()).split('/');
+
+   for(it = components.constBegin(); it != components.constEnd() && node; ++it)
+   {
+      if(it->isEmpty())
+      {
+         continue;
+      }
+
+      nodeit = std::lower_bound(node->lstChildren.constBegin(), node->lstChildren.constEnd(), *it,
+                                [](const IBDirectoryNode *item, const QString &name)
+                                {
+                                   return IBDirectoryTreeModel::lessThan(item->strName, name);
+                                });
+
+      if(nodeit != node->lstChildren.constEnd() && (*nodeit)->strName == *it)
+      {
+         child = *nodeit;
+      }
+      else
+      {
+         child = create ? this->insertChild(node, *it) : nullptr;
+      }
+
+      node = child;
+   }
+
+   return node;
+}
+
+/* Returns the index of the node (node) in the given column (column), an invalid index for the invisible root node. */
+QModelIndex IBDirectoryTreeModel::getNodeIndex(IBDirectoryNode *node, int column) const
+{
+   if(!node || node == this->ndRoot)
+   {
+      return QModelIndex();
+   }
+
+   return this->createIndex(int(node->ndParent->lstChildren.indexOf(node)), column, node);
+}
+
+/* Returns the path of the directory of the node (node). */
+QString IBDirectoryTreeModel::getNodePath(const IBDirectoryNode *node) const
+{
+   QString path;
+
+   if(!node || node == this->ndRoot)
+   {
+      return QString();
+   }
+
+   if(node->ndParent == this->ndRoot)
+   {
+      return node->strName;
+   }
+
+   path = this->getNodePath(node->ndParent);
+
+   return path.endsWith('/') ? path + node->strName : path + '/' + node->strName;
+}
+
+/* Inserts a node with the name (name) at its sorted position into the children of the node (parent) and returns
+   it. The new directory is not listed. */
+IBDirectoryNode *IBDirectoryTreeModel::insertChild(IBDirectoryNode *parent, const QString &name)
+{
+   QList<IBDirectoryNode *>::iterator it;
+   IBDirectoryNode *node = new IBDirectoryNode;
+   int row;
+
+   node->strName = name;
+   node->ndParent = parent;
+
+   it = std::lower_bound(parent->lstChildren.begin(), parent->lstChildren.end(), name,
+                         [](const IBDirectoryNode *item, const QString &itemname)
+                         {
+                            return IBDirectoryTreeModel::lessThan(item->strName, itemname);
+                         });
+   row = int(it - parent->lstChildren.begin());
+
+   this->beginInsertRows(this->getNodeIndex(parent), row, row);
+   parent->lstChildren.insert(row, node);
+   this->endInsertRows();
+
+   IBMemoryAccounting::allocate(IBMemoryAccounting::DirectoryTree, IBDirectoryTreeModel::getNodeBytes(node));
+   this->iAccountedNodes++;
+   this->iAccountedBytes += IBDirectoryTreeModel::getNodeBytes(node);
+
+   return node;
+}
+
+/* Removes the child of the node (parent) in the given row (row) with all its descendants. */
+void IBDirectoryTreeModel::removeChild(IBDirectoryNode *parent, int row)
+{
+   IBDirectoryNode *node;
+
+   if(row < 0 || row >= parent->lstChildren.size())
+   {
+      return;
+   }
+
+   this->beginRemoveRows(this->getNodeIndex(parent), row, row);
+   node = parent->lstChildren.takeAt(row);
+   this->deleteNode(node);
+   this->endRemoveRows();
+}
+
+/* Deletes the node (node) with all its descendants, stops watching them and releases their accounted memory. */
+void IBDirectoryTreeModel::deleteNode(IBDirectoryNode *node)
+{
+   QList<IBDirectoryNode *>::const_iterator it;
+
+   for(it = node->lstChildren.constBegin(); it != node->lstChildren.constEnd(); ++it)
+   {
+      this->deleteNode(*it);
+   }
+
+   if(node->bWatched)
+   {
+      this->fswWatcher->removePath(this->getNodePath(node));
+   }
+
+   if(node != this->ndRoot)
+   {
+      IBMemoryAccounting::release(IBMemoryAccounting::DirectoryTree, IBDirectoryTreeModel::getNodeBytes(node));
+      this->iAccountedNodes--;
+      this->iAccountedBytes -= IBDirectoryTreeModel::getNodeBytes(node);
+   }
+
+   delete node;
+}
+
+/* Queues the directory of the node (node) for listing. */
+void IBDirectoryTreeModel::requestListing(IBDirectoryNode *node)
+{
+   node->bListing = true;
+   this->dlLister->list(this->getNodePath(node));
+}
+
+/* Queues the directory of the node (node) for counting its images. */
+void IBDirectoryTreeModel::requestCount(IBDirectoryNode *node) const
+{
+   node->bCounting = true;
+   this->dlLister->count(this->getNodePath(node));
+}
+
+/* Returns true, if the directory name (name1) is sorted before the other name (name2). The names are compared case
+   insensitive first, so that the order is the same as in a file manager. */
+bool IBDirectoryTreeModel::lessThan(const QString &name1, const QString &name2)
+{
+   int cmp = QString::compare(name1, name2, Qt::CaseInsensitive);
+
+   return cmp != 0 ? cmp < 0 : name1 < name2;
+}
+
+/* Returns the estimated memory of a node (node) with its name and its entry in the list of its parent. */
+qint64 IBDirectoryTreeModel::getNodeBytes(const IBDirectoryNode *node)
+{
+   return qint64(sizeof(IBDirectoryNode) + sizeof(void *)) + qint64(sizeof(QChar)) * node->strName.size();
+}
@@ -0,0 +1,171 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBDIRECTORYTREEMODEL
+#define H_IBDIRECTORYTREEMODEL
+
+#include <QAbstractItemModel>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileIconProvider>
+#include <QFileInfo>
+#include <QHash>
+#include <QFileSystemWatcher>
+#include <QIcon>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "ibimagelistmodel.hpp"
+#include "ibmemoryaccounting.hpp"
+#include "ibtrace.hpp"
+
+/* struct IBDirectoryNode */
+
+struct IBDirectoryNode
+{
+   /* name of the directory, the root directory is named by its path */
+   QString strName;
+   /* parent node, nullptr for the invisible root node */
+   IBDirectoryNode *ndParent = nullptr;
+   /* subdirectories sorted by IBDirectoryTreeModel::lessThan */
+   QList<IBDirectoryNode *> lstChildren;
+   /* is true, if the subdirectories are listed */
+   bool bListed = false;
+   /* is true, while the subdirectories are listed by the lister */
+   bool bListing = false;
+   /* is true, if the directory is watched for changes */
+   bool bWatched = false;
+   /* number of images in the directory, -1 if not counted yet */
+   int iImageCount = -1;
+   /* is true, while the images are counted by the lister */
+   bool bCounting = false;
+};
+
+/* struct IBDirectoryImageCount */
+
+struct IBDirectoryImageCount
+{
+   /* timestamp of the last modification of the directory, when it was counted */
+   QDateTime dtModified;
+   /* number of images in the directory */
+   int iImages = 0;
+};
+
+/* class IBDirectoryLister */
+
+class IBDirectoryLister : public QThread
+{
+   Q_OBJECT
+
+   public:
+      IBDirectoryLister(QObject *parent = nullptr);
+      ~IBDirectoryLister();
+
+      void run() override;
+
+      void list(const QString &path);
+      void count(const QString &path);
+      void stop();
+
+   signals:
+      void directoryListed(const QString &path, const QStringList &names, bool exists);
+      void directoryCounted(const QString &path, int images);
+
+   private:
+      bool countImages(const QString &path, int *images);
+
+      /* paths, which are not listed yet */
+      QStringList slQueue;
+      /* paths, whose images are not counted yet, the last one is counted first */
+      QStringList slCountQueue;
+      /* image counts of the directories, which are valid as long as the directories are not modified */
+      QHash<QString, IBDirectoryImageCount> hshCounts;
+      /* guards the queues and the image counts */
+      QMutex mtxQueue;
+      /* wakes the thread, if paths are queued */
+      QWaitCondition wcQueue;
+};
+
+/* class IBDirectoryTreeModel */
+
+class IBDirectoryTreeModel : public QAbstractItemModel
+{
+   Q_OBJECT
+
+   public:
+      /* additional roles of the model */
+      enum Roles
+      {
+         FilePathRole = Qt::UserRole + 1,
+         ImageCountRole = Qt::UserRole + 2
+      };
+      Q_ENUM(Roles)
+
+      /* columns of the model */
+      enum Columns
+      {
+         NameColumn,
+         ImageCountColumn,
+         ColumnCount
+      };
+      Q_ENUM(Columns)
+
+      IBDirectoryTreeModel(QObject *parent = nullptr);
+      ~IBDirectoryTreeModel();
+
+      QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+      QModelIndex index(const QString &path);
+      QModelIndex parent(const QModelIndex &index) const override;
+      int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+      int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+      bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+      QVariant data(const QModelIndex &index, int role) const override;
+
+      bool canFetchMore(const QModelIndex &parent) const override;
+      void fetchMore(const QModelIndex &parent) override;
+
+      QString filePath(const QModelIndex &index) const;
+      void setWatched(const QModelIndex &index, bool watched);
+      void unwatchAll();
+
+   private slots:
+      void onDirectoryListed(const QString &path, const QStringList &names, bool exists);
+      void onDirectoryCounted(const QString &path, int images);
+      void onDirectoryChanged(const QString &path);
+
+   private:
+      Q_DISABLE_COPY(IBDirectoryTreeModel)
+
+      IBDirectoryNode *getNode(const QModelIndex &index) const;
+      IBDirectoryNode *findNode(const QString &path, bool create);
+      QModelIndex getNodeIndex(IBDirectoryNode *node, int column = 0) const;
+      QString getNodePath(const IBDirectoryNode *node) const;
+      IBDirectoryNode *insertChild(IBDirectoryNode *parent, const QString &name);
+      void removeChild(IBDirectoryNode *parent, int row);
+      void deleteNode(IBDirectoryNode *node);
+      void requestListing(IBDirectoryNode *node);
+      void requestCount(IBDirectoryNode *node) const;
+
+      static bool lessThan(const QString &name1, const QString &name2);
+      static qint64 getNodeBytes(const IBDirectoryNode *node);
+
+      /* invisible root node, its children are the root directories */
+      IBDirectoryNode *ndRoot;
+      /* lists the directories outside of the GUI thread */
+      IBDirectoryLister *dlLister;
+      /* watches the expanded directories */
+      QFileSystemWatcher *fswWatcher;
+      /* icon of the directories */
+      QIcon icnFolder;
+      /* number of nodes and their bytes, which are accounted in IBMemoryAccounting */
+      qint64 iAccountedNodes;
+      qint64 iAccountedBytes;
+};
+
+#endif /*H_IBDIRECTORYTREEMODEL*/
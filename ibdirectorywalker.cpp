@@ -0,0 +1,266 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibdirectorywalker.hpp"
+#include "ibimagelistmodel.hpp"
+
+/* class IBDirectoryReader */
+
+/* Constructs a reader of the given walker (walker). */
+IBDirectoryReader::IBDirectoryReader(IBDirectoryWalker *walker)
+   : dwWalker(walker)
+{
+}
+
+/* Takes the next directory of the queue of the walker, reads it and hands its subdirectories and images over to the
+   walker, until all directories are read or the walk is stopped. The reader, which reads the last directory, finishes
+   the walk. */
+void IBDirectoryReader::run()
+{
+   QList<IBImageListImageItem *> items;
+   QStringList subdirs;
+   QString path;
+   bool notify, finished;
+
+   forever
+   {
+      this->dwWalker->mtxQueue.lock();
+
+      while(this->dwWalker->slQueue.isEmpty() && !this->dwWalker->bStopped && !this->dwWalker->bFinished)
+      {
+         this->dwWalker->wcQueue.wait(&this->dwWalker->mtxQueue);
+      }
+
+      if(this->dwWalker->bStopped || this->dwWalker->bFinished)
+      {
+         this->dwWalker->mtxQueue.unlock();
+         return;
+      }
+
+      path = this->dwWalker->slQueue.takeFirst();
+      this->dwWalker->iActive++;
+      this->dwWalker->mtxQueue.unlock();
+
+      subdirs.clear();
+      items.clear();
+      this->dwWalker->readDirectory(path, &subdirs, &items);
+
+      this->dwWalker->mtxQueue.lock();
+      this->dwWalker->iActive--;
+
+      if(this->dwWalker->bStopped)
+      {
+         this->dwWalker->mtxQueue.unlock();
+         qDeleteAll(items);
+         return;
+      }
+
+      notify = this->dwWalker->lstItems.isEmpty() && !items.isEmpty();
+      this->dwWalker->slQueue.append(subdirs);
+      this->dwWalker->lstItems.append(items);
+      this->dwWalker->iDirectories++;
+      this->dwWalker->iImages += items.size();
+      finished = this->dwWalker->slQueue.isEmpty() && this->dwWalker->iActive == 0;
+
+      if(finished)
+      {
+         this->dwWalker->bFinished = true;
+      }
+
+      if(finished || !subdirs.isEmpty())
+      {
+         this->dwWalker->wcQueue.wakeAll();
+      }
+
+      this->dwWalker->mtxQueue.unlock();
+
+      /* the signals are only emitted, if the found items were taken before, so the GUI is not flooded */
+      if(notify)
+      {
+         emit this->dwWalker->itemsAvailable();
+      }
+
+      if(finished)
+      {
+         emit this->dwWalker->finished();
+      }
+   }
+}
+
+/* class IBDirectoryWalker */
+
+/* Constructs a walker with four readers and without name filters. */
+IBDirectoryWalker::IBDirectoryWalker(QObject *parent)
+   : QObject(parent), iReaders(4), iActive(0), bStopped(false), bFinished(true), iDirectories(0), iImages(0)
+{
+}
+
+/* Stops the walk before the walker is destroyed. */
+IBDirectoryWalker::~IBDirectoryWalker()
+{
+   this->stop();
+}
+
+/* Sets the maximal number of readers (readers), which read directories at the same time. It is used by the next
+   walk. */
+void IBDirectoryWalker::setReaders(int readers)
+{
+   this->iReaders = qMax(1, readers);
+}
+
+/* Returns the maximal number of readers, which read directories at the same time. */
+int IBDirectoryWalker::getReaders() const
+{
+   return this->iReaders;
+}
+
+/* Sets the name filters (filters) of the images in the form "*.ext". The extensions are compared case-insensitively
+   like the name filters of QDir. */
+void IBDirectoryWalker::setNameFilters(const QStringList &filters)
+{
+   QStringList::const_iterator it;
+
+   this->stSuffixes.clear();
+
+   for(it = filters.begin(); it != filters.end(); ++it)
+   {
+      this->stSuffixes.insert(it->mid(it->lastIndexOf(QLatin1Char('.')) + 1).toLower());
+   }
+}
+
+/* Returns the name filters of the images. */
+QStringList IBDirectoryWalker::getNameFilters() const
+{
+   QSet<QString>::const_iterator it;
+   QStringList filters;
+
+   for(it = this->stSuffixes.begin(); it != this->stSuffixes.end(); ++it)
+   {
+      filters.append(QStringLiteral("*.") + *it);
+   }
+
+   filters.sort();
+
+   return filters;
+}
+
+/* Stops a running walk and starts the walk of the directory (path) and its subdirectories. Symbolic links to
+   directories are not followed, so that the walk ends also for cyclic links. */
+void IBDirectoryWalker::start(const QString &path)
+{
+   QString root = QFileInfo(path).canonicalFilePath();
+   int idx;
+
+   this->stop();
+
+   if(root.isEmpty())
+   {
+      return;
+   }
+
+   this->mtxQueue.lock();
+   this->slQueue.append(root);
+   this->iActive = 0;
+   this->iDirectories = 0;
+   this->iImages = 0;
+   this->bStopped = false;
+   this->bFinished = false;
+   this->mtxQueue.unlock();
+
+   for(idx = 0; idx < this->iReaders; idx++)
+   {
+      this->lstReaders.append(new IBDirectoryReader(this));
+      this->lstReaders.last()->start(QThread::LowPriority);
+   }
+}
+
+/* Stops the walk and waits for the readers. The found items, which are not taken yet, are destroyed. */
+void IBDirectoryWalker::stop()
+{
+   this->mtxQueue.lock();
+   this->bStopped = true;
+   this->wcQueue.wakeAll();
+   this->mtxQueue.unlock();
+
+   for(IBDirectoryReader *reader : this->lstReaders)
+   {
+      reader->wait();
+   }
+
+   qDeleteAll(this->lstReaders);
+   this->lstReaders.clear();
+
+   this->mtxQueue.lock();
+   qDeleteAll(this->lstItems);
+   this->lstItems.clear();
+   this->slQueue.clear();
+   this->bFinished = true;
+   this->mtxQueue.unlock();
+}
+
+/* Returns true, while directories are read. Otherwise false. */
+bool IBDirectoryWalker::isRunning() const
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   return !this->bFinished && !this->bStopped;
+}
+
+/* Returns the found items, which were not taken yet. The caller takes the ownership of the items. */
+QList<IBImageListImageItem *> IBDirectoryWalker::takeItems()
+{
+   QList<IBImageListImageItem *> items;
+   QMutexLocker locker(&this->mtxQueue);
+
+   items.swap(this->lstItems);
+
+   return items;
+}
+
+/* Returns the number of found items, which were not taken yet. */
+int IBDirectoryWalker::getPendingItemCount() const
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   return int(this->lstItems.size());
+}
+
+/* Returns the current statistics of the walk. */
+IBDirectoryWalkerStatistics IBDirectoryWalker::getStatistics() const
+{
+   IBDirectoryWalkerStatistics stats;
+   QMutexLocker locker(&this->mtxQueue);
+
+   stats.iDirectories = this->iDirectories;
+   stats.iImages = this->iImages;
+   stats.iPending = this->slQueue.size() + this->iActive;
+
+   return stats;
+}
+
+/* Reads the directory (path) and appends its subdirectories to subdirs and an item for each of its images to items.
+   It is called by the readers without the mutex. */
+void IBDirectoryWalker::readDirectory(const QString &path, QStringList *subdirs, QList<IBImageListImageItem *> *items)
+{
+   IB_TRACE_SCOPE("walker", "readDirectory");
+   QDirIterator it(path, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+   QFileInfo info;
+
+   while(it.hasNext() && !this->bStopped)
+   {
+      it.next();
+      info = it.fileInfo();
+
+      if(info.isDir())
+      {
+         if(!info.isSymLink())
+         {
+            subdirs->append(info.absoluteFilePath());
+         }
+      }
+      else if(this->stSuffixes.contains(info.suffix().toLower()))
+      {
+         items->append(new IBImageListImageItem(info.absoluteFilePath(), info.lastModified(), info.size()));
+      }
+   }
+}
@@ -0,0 +1,112 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBDIRECTORYWALKER
+#define H_IBDIRECTORYWALKER
+
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+
+#include "ibtrace.hpp"
+
+/* forward definitions of class */
+
+class IBDirectoryWalker;
+class IBImageListImageItem;
+
+/* struct IBDirectoryWalkerStatistics */
+
+struct IBDirectoryWalkerStatistics
+{
+   /* number of read directories */
+   qint64 iDirectories = 0;
+   /* number of found images */
+   qint64 iImages = 0;
+   /* number of directories, which are queued or read at the moment */
+   qint64 iPending = 0;
+};
+
+/* class IBDirectoryReader */
+
+class IBDirectoryReader : public QThread
+{
+   public:
+      IBDirectoryReader(IBDirectoryWalker *walker);
+
+      void run() override;
+
+   private:
+      /* walker, which shares its queue of directories with all its readers */
+      IBDirectoryWalker *dwWalker;
+};
+
+/* class IBDirectoryWalker */
+
+class IBDirectoryWalker : public QObject
+{
+   Q_OBJECT
+
+   friend class IBDirectoryReader;
+
+   public:
+      IBDirectoryWalker(QObject *parent = nullptr);
+      ~IBDirectoryWalker();
+
+      void setReaders(int readers);
+      int getReaders() const;
+
+      void setNameFilters(const QStringList &filters);
+      QStringList getNameFilters() const;
+
+      void start(const QString &path);
+      void stop();
+      bool isRunning() const;
+
+      QList<IBImageListImageItem *> takeItems();
+      int getPendingItemCount() const;
+      IBDirectoryWalkerStatistics getStatistics() const;
+
+   signals:
+      void itemsAvailable();
+      void finished();
+
+   private:
+      Q_DISABLE_COPY(IBDirectoryWalker)
+
+      void readDirectory(const QString &path, QStringList *subdirs, QList<IBImageListImageItem *> *items);
+
+      /* readers of the walk */
+      QList<IBDirectoryReader *> lstReaders;
+      /* maximal number of readers */
+      int iReaders;
+      /* lower case extensions of the images, which are taken from the name filters */
+      QSet<QString> stSuffixes;
+      /* protects the queue, the found items and the counters */
+      mutable QMutex mtxQueue;
+      /* wakes the readers, if directories are queued or the walk is finished */
+      QWaitCondition wcQueue;
+      /* directories, which are not read yet */
+      QStringList slQueue;
+      /* found items, which are not taken yet */
+      QList<IBImageListImageItem *> lstItems;
+      /* number of readers, which read a directory at the moment */
+      int iActive;
+      /* is true, if the walk has to stop, it is also read without the mutex by the readers */
+      std::atomic<bool> bStopped;
+      /* is true, after all directories are read */
+      bool bFinished;
+      /* counters of IBDirectoryWalkerStatistics */
+      qint64 iDirectories, iImages;
+};
+
+#endif /*H_IBDIRECTORYWALKER*/
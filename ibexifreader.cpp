@@ -0,0 +1,394 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibexifreader.hpp"
+
+#include <cstring>
+
+/* tags of the IFD entries, which are read */
+static const quint16 iTagModel = 0x0110;
+static const quint16 iTagOrientation = 0x0112;
+static const quint16 iTagDateTime = 0x0132;
+static const quint16 iTagExifIfd = 0x8769;
+static const quint16 iTagDateTimeOriginal = 0x9003;
+static const quint16 iTagDateTimeDigitized = 0x9004;
+
+/* types of the values of the IFD entries */
+static const quint16 iTypeAscii = 2;
+static const quint16 iTypeShort = 3;
+static const quint16 iTypeLong = 4;
+static const quint16 iTypeIfd = 13;
+
+/* Returns the decimal number with the given number of digits (length) stored at the given position (text). Returns -1,
+   if a character is not a digit. */
+static inline int parseNumber(const char *text, int length)
+{
+   int number = 0, idx;
+
+   for(idx = 0; idx < length; idx++)
+   {
+      if(text[idx] < '0' || text[idx] > '9')
+      {
+         return -1;
+      }
+
+      number = number * 10 + (text[idx] - '0');
+   }
+
+   return number;
+}
+
+/* class IBExifReader */
+
+/* Constructs a reader of the EXIF metadata in the start of a file (data) with the given number of read bytes (size).
+   The data is not copied and has to outlive the reader. */
+IBExifReader::IBExifReader(const uchar *data, int size)
+   : pData(data), iSize(size), iTiffOffset(0), iTiffSize(0), bLittleEndian(false), bTruncated(false),
+     iOrientation(0)
+{
+}
+
+/* Reads the EXIF metadata of a JPEG or TIFF file into exif. The timestamp of the capture is taken from
+   DateTimeOriginal, else from DateTimeDigitized or from the timestamp of the last modification in IFD0. Returns false,
+   if the data contains no EXIF metadata, exif is empty then. */
+bool IBExifReader::read(IBExifData *exif)
+{
+   *exif = IBExifData();
+
+   if(!this->findTiffHeader())
+   {
+      return false;
+   }
+
+   this->readIfd(this->readLong(4), false);
+
+   exif->dtTaken = this->dtOriginal.isValid() ? this->dtOriginal
+                   : (this->dtDigitized.isValid() ? this->dtDigitized : this->dtModified);
+   exif->iOrientation = this->iOrientation;
+   exif->strCameraModel = this->strCameraModel;
+
+   return true;
+}
+
+/* Returns true, if a value of the metadata lies beyond the read data, so that more data of the file has to be read.
+   Otherwise false. */
+bool IBExifReader::isTruncated() const
+{
+   return this->bTruncated;
+}
+
+/* Reads the EXIF metadata of the JPEG or TIFF file (path) into exif. Only the start of the file is read, first
+   iInitialReadSize bytes, which usually contain all IFDs, and up to iMaxReadSize bytes, if a value lies beyond. Other
+   files are rejected by the signature of their first bytes. The data is read into buffer, if given, so that it is
+   reused for the next file. Returns false, if the file contains no EXIF metadata. */
+bool IBExifReader::readFile(const QString &path, IBExifData *exif, QByteArray *buffer)
+{
+   QFile file(path);
+   QByteArray localbuffer;
+   QByteArray *data = buffer ? buffer : &localbuffer;
+   const uchar *bytes;
+   qint64 size, read;
+   bool found, truncated;
+
+   *exif = IBExifData();
+
+   if(!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+   {
+      return false;
+   }
+
+   data->resize(IBExifReader::iMaxReadSize);
+   bytes = reinterpret_cast<const uchar *>(data->constData());
+   size = file.read(data->data(), IBExifReader::iInitialReadSize);
+
+   if(size < 4 || !IBExifReader::hasSignature(bytes, int(size)))
+   {
+      return false;
+   }
+
+   {
+      IBExifReader reader(bytes, int(size));
+      found = reader.read(exif);
+      truncated = reader.isTruncated();
+   }
+
+   if(truncated && size == IBExifReader::iInitialReadSize)
+   {
+      read = file.read(data->data() + size, IBExifReader::iMaxReadSize - size);
+
+      if(read > 0)
+      {
+         IBExifReader reader(bytes, int(size + read));
+         found = reader.read(exif);
+      }
+   }
+
+   return found;
+}
+
+/* Returns true, if the data (data) of the given size (size) starts like a JPEG or TIFF file, which can contain EXIF
+   metadata. Otherwise false. */
+bool IBExifReader::hasSignature(const uchar *data, int size)
+{
+   if(size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+   {
+      return true;
+   }
+
+   return size >= 4 && (memcmp(data, "II*\0", 4) == 0 || memcmp(data, "MM\0*", 4) == 0);
+}
+
+/* Finds the TIFF structure, which is either the whole file or embedded in the APP1 segment of a JPEG file, and reads
+   its byte order. The segments of a JPEG file are skipped by their lengths until the APP1 segment with the EXIF
+   identifier or the start of the scan is found. Returns false, if there is no valid TIFF header. */
+bool IBExifReader::findTiffHeader()
+{
+   quint32 pos = 2, length;
+   uchar marker;
+
+   if(this->iSize >= 2 && this->pData[0] == 0xFF && this->pData[1] == 0xD8)
+   {
+      forever
+      {
+         if(pos + 4 > quint32(this->iSize))
+         {
+            this->bTruncated = true;
+            return false;
+         }
+
+         if(this->pData[pos] != 0xFF)
+         {
+            return false;
+         }
+
+         marker = this->pData[pos + 1];
+
+         /* fill bytes and markers without a segment */
+         if(marker == 0xFF)
+         {
+            pos++;
+            continue;
+         }
+
+         if(marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+         {
+            pos += 2;
+            continue;
+         }
+
+         /* the metadata precedes the start of the scan */
+         if(marker == 0xDA || marker == 0xD9)
+         {
+            return false;
+         }
+
+         length = (quint32(this->pData[pos + 2]) << 8) | quint32(this->pData[pos + 3]);
+
+         if(marker == 0xE1 && length >= 16)
+         {
+            if(pos + 10 > quint32(this->iSize))
+            {
+               this->bTruncated = true;
+               return false;
+            }
+
+            if(memcmp(this->pData + pos + 4, "Exif\0\0", 6) == 0)
+            {
+               this->iTiffOffset = int(pos) + 10;
+               this->iTiffSize = length - 8;
+               break;
+            }
+         }
+
+         pos += 2 + length;
+      }
+   }
+   else
+   {
+      /* the offsets of a TIFF file are only limited by the file */
+      this->iTiffOffset = 0;
+      this->iTiffSize = Q_INT64_C(0xFFFFFFFF);
+   }
+
+   if(!this->isAvailable(0, 8))
+   {
+      return false;
+   }
+
+   if(this->pData[this->iTiffOffset] == 'I' && this->pData[this->iTiffOffset + 1] == 'I')
+   {
+      this->bLittleEndian = true;
+   }
+   else if(this->pData[this->iTiffOffset] == 'M' && this->pData[this->iTiffOffset + 1] == 'M')
+   {
+      this->bLittleEndian = false;
+   }
+   else
+   {
+      return false;
+   }
+
+   return this->readShort(2) == 42;
+}
+
+/* Reads the entries of the IFD at the given offset (offset). IFD0 refers to the EXIF IFD (exififd), which is read
+   afterwards. Entries, whose values were not read, are skipped. An offset within the TIFF header is invalid. */
+void IBExifReader::readIfd(quint32 offset, bool exififd)
+{
+   quint32 count, idx, exifoffset = 0;
+   qint64 entry;
+   quint16 tag, type;
+
+   if(offset < 8 || !this->isAvailable(offset, 2))
+   {
+      return;
+   }
+
+   count = this->readShort(offset);
+
+   for(idx = 0; idx < count; idx++)
+   {
+      entry = qint64(offset) + 2 + qint64(idx) * 12;
+
+      if(!this->isAvailable(entry, 12))
+      {
+         break;
+      }
+
+      tag = this->readShort(quint32(entry));
+      type = this->readShort(quint32(entry) + 2);
+
+      if(exififd)
+      {
+         if(tag == iTagDateTimeOriginal)
+         {
+            this->dtOriginal = IBExifReader::parseDateTime(this->readAscii(quint32(entry)));
+         }
+         else if(tag == iTagDateTimeDigitized)
+         {
+            this->dtDigitized = IBExifReader::parseDateTime(this->readAscii(quint32(entry)));
+         }
+      }
+      else if(tag == iTagModel)
+      {
+         this->strCameraModel = QString::fromLatin1(this->readAscii(quint32(entry))).trimmed();
+      }
+      else if(tag == iTagOrientation && type == iTypeShort)
+      {
+         this->iOrientation = this->readShort(quint32(entry) + 8);
+         this->iOrientation = this->iOrientation >= 1 && this->iOrientation <= 8 ? this->iOrientation : 0;
+      }
+      else if(tag == iTagDateTime)
+      {
+         this->dtModified = IBExifReader::parseDateTime(this->readAscii(quint32(entry)));
+      }
+      else if(tag == iTagExifIfd && (type == iTypeLong || type == iTypeIfd))
+      {
+         exifoffset = this->readLong(quint32(entry) + 8);
+      }
+   }
+
+   if(exifoffset != 0)
+   {
+      this->readIfd(exifoffset, true);
+   }
+}
+
+/* Returns true, if the given number of bytes (size) at the offset (offset) of the TIFF structure were read. If they
+   lie beyond the read data, but within the TIFF structure, the data is marked as truncated. */
+bool IBExifReader::isAvailable(qint64 offset, qint64 size)
+{
+   if(offset + size > this->iTiffSize)
+   {
+      return false;
+   }
+
+   if(this->iTiffOffset + offset + size > this->iSize)
+   {
+      this->bTruncated = true;
+      return false;
+   }
+
+   return true;
+}
+
+/* Returns the 16 bit value at the offset (offset) of the TIFF structure in its byte order. */
+quint16 IBExifReader::readShort(quint32 offset) const
+{
+   const uchar *data = this->pData + this->iTiffOffset + offset;
+
+   if(this->bLittleEndian)
+   {
+      return quint16(data[0] | (data[1] << 8));
+   }
+
+   return quint16((data[0] << 8) | data[1]);
+}
+
+/* Returns the 32 bit value at the offset (offset) of the TIFF structure in its byte order. */
+quint32 IBExifReader::readLong(quint32 offset) const
+{
+   const uchar *data = this->pData + this->iTiffOffset + offset;
+
+   if(this->bLittleEndian)
+   {
+      return (quint32(data[3]) << 24) | (quint32(data[2]) << 16) | (quint32(data[1]) << 8) | quint32(data[0]);
+   }
+
+   return (quint32(data[0]) << 24) | (quint32(data[1]) << 16) | (quint32(data[2]) << 8) | quint32(data[3]);
+}
+
+/* Returns the ASCII value of the IFD entry at the offset (entry) up to its first null character. Returns an empty
+   value, if the entry has another type or its value was not read. */
+QByteArray IBExifReader::readAscii(quint32 entry)
+{
+   quint32 count = this->readLong(entry + 4), offset = entry + 8;
+   const char *value;
+
+   if(this->readShort(entry + 2) != iTypeAscii || count == 0)
+   {
+      return QByteArray();
+   }
+
+   /* values of more than four bytes are stored at an offset */
+   if(count > 4)
+   {
+      offset = this->readLong(entry + 8);
+   }
+
+   if(!this->isAvailable(offset, count))
+   {
+      return QByteArray();
+   }
+
+   value = reinterpret_cast<const char *>(this->pData + this->iTiffOffset + offset);
+
+   return QByteArray(value, int(qstrnlen(value, count)));
+}
+
+/* Returns the timestamp of the EXIF date (value) in the form "YYYY:MM:DD HH:MM:SS" in local time. The separators are
+   not checked, because some cameras write other ones. Returns an invalid timestamp, if the date is malformed or
+   unset like "0000:00:00 00:00:00". */
+QDateTime IBExifReader::parseDateTime(const QByteArray &value)
+{
+   const char *text = value.constData();
+   int year;
+   QDate date;
+   QTime time;
+
+   if(value.size() < 19)
+   {
+      return QDateTime();
+   }
+
+   year = parseNumber(text, 4);
+   date = QDate(year, parseNumber(text + 5, 2), parseNumber(text + 8, 2));
+   time = QTime(parseNumber(text + 11, 2), parseNumber(text + 14, 2), parseNumber(text + 17, 2));
+
+   if(year <= 0 || !date.isValid() || !time.isValid())
+   {
+      return QDateTime();
+   }
+
+   return QDateTime(date, time);
+}
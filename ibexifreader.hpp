@@ -0,0 +1,73 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBEXIFREADER
+#define H_IBEXIFREADER
+
+#include <QByteArray>
+#include <QDate>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <QTime>
+
+/* struct IBExifData */
+
+struct IBExifData
+{
+   /* timestamp of the capture of the image in local time, invalid if it is unknown */
+   QDateTime dtTaken;
+   /* orientation of the image from 1 to 8 as defined by EXIF, 0 if it is unknown */
+   int iOrientation = 0;
+   /* model of the camera, empty if it is unknown */
+   QString strCameraModel;
+};
+
+/* class IBExifReader */
+
+class IBExifReader
+{
+   public:
+      IBExifReader(const uchar *data, int size);
+
+      bool read(IBExifData *exif);
+      bool isTruncated() const;
+
+      static bool readFile(const QString &path, IBExifData *exif, QByteArray *buffer = nullptr);
+      static bool hasSignature(const uchar *data, int size);
+
+      /* number of bytes, which are read first from the start of a file */
+      static const int iInitialReadSize = 4096;
+      /* maximal number of bytes, which are read from the start of a file */
+      static const int iMaxReadSize = 65536;
+
+   private:
+      bool findTiffHeader();
+      void readIfd(quint32 offset, bool exififd);
+      bool isAvailable(qint64 offset, qint64 size);
+      quint16 readShort(quint32 offset) const;
+      quint32 readLong(quint32 offset) const;
+      QByteArray readAscii(quint32 entry);
+
+      static QDateTime parseDateTime(const QByteArray &value);
+
+      /* start of the file and the number of its bytes, which were read */
+      const uchar *pData;
+      int iSize;
+      /* offset of the TIFF structure in the data and its size, the offsets of the IFDs are relative to its start */
+      int iTiffOffset;
+      qint64 iTiffSize;
+      /* is true, if the values of the TIFF structure are stored in little endian order */
+      bool bLittleEndian;
+      /* is true, if a value lies beyond the read data, but may lie within the file */
+      bool bTruncated;
+      /* timestamps of the capture, of the digitization and of the last modification of the image */
+      QDateTime dtOriginal;
+      QDateTime dtDigitized;
+      QDateTime dtModified;
+      /* orientation and camera model found in the IFDs */
+      int iOrientation;
+      QString strCameraModel;
+};
+
+#endif /*H_IBEXIFREADER*/
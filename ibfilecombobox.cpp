@@ -3,29 +3,14 @@
 
 #include "ibfilecombobox.hpp"
 
-/* class IBFileSystemModel */
-
-/* Constructs a file system model. */
-IBFileSystemModel::IBFileSystemModel(QObject *parent)
-   : QFileSystemModel(parent)
-{
-}
-
-/* reimpl. */
-int IBFileSystemModel::columnCount(const QModelIndex &parent) const
-{
-   Q_UNUSED(parent);
-
-   return 1;
-}
-
 /* class IBFileComboBox */
 
-/* Constructs a combobox for selecting a file system path. */
+/* Constructs a combobox for selecting a file system path, which starts in the home directory. */
 IBFileComboBox::IBFileComboBox(QWidget *parent)
    : QComboBox(parent)
 {
    this->initComboBox();
+   this->goToHomeDirectory();
 }
 
 /* Constructs a combobox for selecting a file system path with a given file system path (path). */
@@ -36,27 +21,35 @@ IBFileComboBox::IBFileComboBox(const QString &path, QWidget *parent)
    this->setPath(path);
 }
 
-/* Initializes all components of the combobox (TreeView, FileSystemModel). */
+/* Initializes all components of the combobox (TreeView, IBDirectoryTreeModel). The directory tree is populated
+   lazily, only the ancestors of the current path and the expanded directories are listed. The expanded directories
+   are watched for changes. The second column of the TreeView shows the number of images of the directories. The
+   TreeView tracks the mouse for the signal directoryHovered. */
 void IBFileComboBox::initComboBox()
 {
    this->iCurrentHistoryIndex = -1;
    this->setEditable(true);
    this->connect(this, SIGNAL(currentIndexChanged(int)), SLOT(onIndexChanged(int)));
 
-   this->fsModel = new IBFileSystemModel(this);
-   this->fsModel->setFilter(QDir::Dirs | QDir::NoDotAndDotDot | QDir::AllDirs | QDir::Drives);
+   this->dtmModel = new IBDirectoryTreeModel(this);
    this->tvView = new QTreeView(this);
    this->tvView->setHeaderHidden(true);
+   this->tvView->setMouseTracking(true);
    this->tvView->viewport()->installEventFilter(this);
 
-   this->setModel(this->fsModel);
+   this->setModel(this->dtmModel);
    this->setView(this->tvView);
+   this->setRootModelIndex(this->dtmModel->index(QDir::rootPath()));
+   this->tvView->header()->setStretchLastSection(false);
+   this->tvView->header()->setSectionResizeMode(IBDirectoryTreeModel::NameColumn, QHeaderView::Stretch);
+   this->tvView->header()->setSectionResizeMode(IBDirectoryTreeModel::ImageCountColumn,
+                                                QHeaderView::ResizeToContents);
    this->bSkipNextHide = false;
-   this->fsModel->setRootPath(QDir::rootPath());
-   this->setRootModelIndex(this->fsModel->index(QDir::rootPath()));
+
+   this->connect(this->tvView, SIGNAL(expanded(const QModelIndex &)), SLOT(onExpanded(const QModelIndex &)));
+   this->connect(this->tvView, SIGNAL(collapsed(const QModelIndex &)), SLOT(onCollapsed(const QModelIndex &)));
 
    this->slHistory.clear();
-   this->goToHomeDirectory();
 }
 
 /* Decreases the current history index */
@@ -120,6 +113,17 @@ QString IBFileComboBox::getPath() const
     return this->currentText();
 }
 
+/* Returns the path of the next history entry, if the history can go forward. Otherwise an empty string. */
+QString IBFileComboBox::getForwardHistoryPath() const
+{
+   if(this->isHistoryAtLastIndex())
+   {
+      return QString();
+   }
+
+   return this->slHistory[this->iCurrentHistoryIndex + 1];
+}
+
 /* Filters the Enter- and Return-KeyPressed event for clearing the objects focus. */
 bool IBFileComboBox::event(QEvent *e)
 {
@@ -138,7 +142,8 @@ bool IBFileComboBox::event(QEvent *e)
 }
 
 /* Filters the MouseButtonPress event on the viewport of the treeview object 
-   for preventing premature closing of the popup widget. */
+   for preventing premature closing of the popup widget. The MouseMove event emits the signal directoryHovered,
+   when the mouse enters another directory. */
 bool IBFileComboBox::eventFilter(QObject* object, QEvent* event)
 {
    if(event->type() == QEvent::MouseButtonPress && object == view()->viewport())
@@ -150,22 +155,39 @@ bool IBFileComboBox::eventFilter(QObject* object, QEvent* event)
          this->bSkipNextHide = true;
       }
    }
+   else if(event->type() == QEvent::MouseMove && object == view()->viewport())
+   {
+      QMouseEvent* mouseEvent = dynamic_cast<QMouseEvent *>(event); 
+      QModelIndex index = this->tvView->indexAt(mouseEvent->pos());
+      QString path = index.isValid() ? this->dtmModel->filePath(index) : QString();
+
+      if(path != this->strHoveredPath)
+      {
+         this->strHoveredPath = path;
+
+         if(!path.isEmpty())
+         {
+            emit this->directoryHovered(path);
+         }
+      }
+   }
    
    return false;
 }
 
 /* Prepare the treeview object with expanding items to the currently used path
-   and popup the treeview. */
+   and popup the treeview. Only the ancestors of the path are listed and watched. */
 void IBFileComboBox::showPopup()
 {
    QDir expdir = this->currentText();
 
-   this->tvView->setCurrentIndex(this->fsModel->index(this->currentText()));
+   this->dtmModel->unwatchAll();
    this->tvView->collapseAll();
+   this->tvView->setCurrentIndex(this->dtmModel->index(this->currentText()));
    
    do
    {   
-      this->tvView->setExpanded(this->fsModel->index(expdir.absolutePath()), true);
+      this->tvView->setExpanded(this->dtmModel->index(expdir.absolutePath()), true);
    }while(expdir.cdUp());
 
    QComboBox::showPopup();
@@ -181,13 +203,34 @@ void IBFileComboBox::hidePopup()
    else
    {
       QComboBox::hidePopup();
+      this->dtmModel->unwatchAll();
    }
 }
 
-/* Sets the selected path to the combobox. */
+/* Sets the selected path to the combobox. Changes of the current index without a selected directory, e.g. when
+   the first directories are inserted by the lister, do not change the path. */
 void IBFileComboBox::onIndexChanged(int index)
 {
    Q_UNUSED(index)
 
-   this->navigateTo(this->fsModel->filePath(this->tvView->currentIndex()), false);
+   if(this->tvView->currentIndex().isValid())
+   {
+      this->navigateTo(this->dtmModel->filePath(this->tvView->currentIndex()), false);
+   }
+   else if(this->iCurrentHistoryIndex >= 0)
+   {
+      this->setEditText(this->slHistory[this->iCurrentHistoryIndex]);
+   }
+}
+
+/* Starts watching the expanded directory (index). */
+void IBFileComboBox::onExpanded(const QModelIndex &index)
+{
+   this->dtmModel->setWatched(index, true);
+}
+
+/* Stops watching the collapsed directory (index). */
+void IBFileComboBox::onCollapsed(const QModelIndex &index)
+{
+   this->dtmModel->setWatched(index, false);
 }
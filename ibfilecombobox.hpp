@@ -5,7 +5,7 @@
 #define H_IBFILECOMBOBOX
 
 #include <QComboBox>
-#include <QFileSystemModel>
+#include <QHeaderView>
 #include <QLineEdit>
 #include <QMouseEvent>
 #include <QStringList>
@@ -14,14 +14,7 @@
 
 #include <QDebug>
 
-/* class IBFileSystemModel */
-
-class IBFileSystemModel : public QFileSystemModel
-{
-   public:
-      IBFileSystemModel(QObject *parent = nullptr);
-      int columnCount(const QModelIndex &parent = QModelIndex()) const override;
-};
+#include "ibdirectorytreemodel.hpp"
 
 /* class IBFileComboBox */
 
@@ -35,6 +28,7 @@ class IBFileComboBox : public QComboBox
      
       void setPath(const QString &newpath);
       QString getPath() const;
+      QString getForwardHistoryPath() const;
 
     public:
       /* Returns true, if the this->iCurrentHistoryIndex is at the begin of the history list.
@@ -59,26 +53,31 @@ class IBFileComboBox : public QComboBox
 
    signals:
       void pathChanged(const QString &path);
+      void directoryHovered(const QString &path);
 
    protected:
       void navigateTo(const QString &path, bool fromhistory = false);
 
    protected slots:
       void onIndexChanged(int index);
+      void onExpanded(const QModelIndex &index);
+      void onCollapsed(const QModelIndex &index);
 
    private:
       void initComboBox();
 
       /* Treeview for the popup widget */
       QTreeView *tvView;
-      /* file system model for the Treeview */
-      IBFileSystemModel *fsModel;
+      /* lazily listed directory tree for the Treeview */
+      IBDirectoryTreeModel *dtmModel;
       /* prevention of premature closing of the popup widget */
       bool bSkipNextHide;
       /* history list */
       QStringList slHistory;
       /* current index of the history list */
       int iCurrentHistoryIndex;
+      /* directory under the mouse in the popup widget */
+      QString strHoveredPath;
 };
 
 #endif /*H_IBFILECOMBOBOX*/
@@ -0,0 +1,114 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibfilenameindex.hpp"
+
+#include <algorithm>
+
+/* class IBFileNameIndex */
+
+/* Constructs an empty index. */
+IBFileNameIndex::IBFileNameIndex()
+{
+}
+
+/* Appends the name (name) to the index. Its position is the number of the names, which were appended before. The name
+   is case folded and every trigram of it refers to its position once. */
+void IBFileNameIndex::append(const QString &name)
+{
+   QString folded = name.toCaseFolded();
+   int position = int(this->vecNames.size()), idx;
+
+   for(idx = 0; idx + 3 <= folded.size(); idx++)
+   {
+      QVector<int> &positions = this->hshTrigrams[IBFileNameIndex::getTrigram(folded.constData() + idx)];
+
+      if(positions.isEmpty() || positions.last() != position)
+      {
+         positions.append(position);
+      }
+   }
+
+   this->vecNames.append(folded);
+}
+
+/* Returns the ascending positions of the names, which contain the query (query) regardless of the case. If the
+   ascending positions of candidates (candidates) are given, only these are considered, e.g. the result of a shorter
+   query. The names referred by the rarest trigram of the query or the candidates are compared, whichever are fewer.
+   Queries shorter than a trigram are compared with all names or the candidates. */
+QVector<int> IBFileNameIndex::find(const QString &query, const QVector<int> *candidates) const
+{
+   QString folded = query.toCaseFolded();
+   QHash<quint64, QVector<int> >::const_iterator it;
+   const QVector<int> *positions = nullptr;
+   QVector<int> matches;
+   int idx;
+
+   for(idx = 0; idx + 3 <= folded.size(); idx++)
+   {
+      it = this->hshTrigrams.constFind(IBFileNameIndex::getTrigram(folded.constData() + idx));
+
+      if(it == this->hshTrigrams.constEnd())
+      {
+         return matches;
+      }
+
+      if(!positions || it.value().size() < positions->size())
+      {
+         positions = &it.value();
+      }
+   }
+
+   if(positions && (!candidates || positions->size() < candidates->size()))
+   {
+      for(int position : *positions)
+      {
+         if((!candidates || std::binary_search(candidates->constBegin(), candidates->constEnd(), position))
+            && this->vecNames.at(position).contains(folded))
+         {
+            matches.append(position);
+         }
+      }
+   }
+   else if(candidates)
+   {
+      for(int position : *candidates)
+      {
+         if(position < this->vecNames.size() && this->vecNames.at(position).contains(folded))
+         {
+            matches.append(position);
+         }
+      }
+   }
+   else
+   {
+      for(idx = 0; idx < this->vecNames.size(); idx++)
+      {
+         if(this->vecNames.at(idx).contains(folded))
+         {
+            matches.append(idx);
+         }
+      }
+   }
+
+   return matches;
+}
+
+/* Removes all names. */
+void IBFileNameIndex::clear()
+{
+   this->vecNames.clear();
+   this->hshTrigrams.clear();
+}
+
+/* Returns the number of names. */
+int IBFileNameIndex::size() const
+{
+   return int(this->vecNames.size());
+}
+
+/* Returns the key of the trigram, which starts at the characters (chars). */
+quint64 IBFileNameIndex::getTrigram(const QChar *chars)
+{
+   return (quint64(chars[0].unicode()) << 32) | (quint64(chars[1].unicode()) << 16) | quint64(chars[2].unicode());
+}
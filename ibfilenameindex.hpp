@@ -0,0 +1,33 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBFILENAMEINDEX
+#define H_IBFILENAMEINDEX
+
+#include <QChar>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/* class IBFileNameIndex */
+
+class IBFileNameIndex
+{
+   public:
+      IBFileNameIndex();
+
+      void append(const QString &name);
+      QVector<int> find(const QString &query, const QVector<int> *candidates = nullptr) const;
+      void clear();
+      int size() const;
+
+   private:
+      static quint64 getTrigram(const QChar *chars);
+
+      /* case folded names, the position of a name is its number of insertion */
+      QVector<QString> vecNames;
+      /* ascending positions of the names by the trigrams, which the names contain */
+      QHash<quint64, QVector<int> > hshTrigrams;
+};
+
+#endif /*H_IBFILENAMEINDEX*/
@@ -0,0 +1,146 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibimagecolor.hpp"
+#include "ibtrace.hpp"
+
+/* colors with a smaller difference of their largest and smallest channel are gray */
+static const int iMinChroma = 32;
+/* weight of a gray pixel in the histogram, a colored pixel weighs its chroma */
+static const int iGrayWeight = 64;
+
+/* class IBImageColor */
+
+/* Returns the average of the heaviest hue or gray bucket of the image (image) reduced to 16x16 pixels, colored pixels
+   weigh their chroma. Returns 0 for a null or transparent image, computed colors are opaque. */
+QRgb IBImageColor::computeDominantColor(const QImage &image, IBImageScalerBuffers *buffers)
+{
+   IB_TRACE_SCOPE("thumbnails", "computeDominantColor");
+   qint64 weights[IBImageColor::iHueBuckets + 1] = {0};
+   qint64 sums[IBImageColor::iHueBuckets + 1][3] = {{0}};
+   int counts[IBImageColor::iHueBuckets + 1] = {0};
+   QImage reduced;
+   const QRgb *line;
+   QRgb pixel;
+   int x, y, bucket, chroma, heaviest = 0;
+
+   if(image.isNull())
+   {
+      return 0;
+   }
+
+   reduced = IBImageScaler::scale(image, QSize(16, 16), Qt::IgnoreAspectRatio, buffers);
+
+   if(reduced.format() != QImage::Format_RGB32 && reduced.format() != QImage::Format_ARGB32_Premultiplied)
+   {
+      reduced = reduced.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+   }
+
+   for(y = 0; y < reduced.height(); y++)
+   {
+      line = reinterpret_cast<const QRgb *>(reduced.constScanLine(y));
+
+      for(x = 0; x < reduced.width(); x++)
+      {
+         if(qAlpha(line[x]) == 0)
+         {
+            continue;
+         }
+
+         pixel = qUnpremultiply(line[x]);
+         bucket = IBImageColor::getHueBucket(pixel);
+         chroma = qMax(qRed(pixel), qMax(qGreen(pixel), qBlue(pixel)))
+                  - qMin(qRed(pixel), qMin(qGreen(pixel), qBlue(pixel)));
+
+         weights[bucket] += bucket == IBImageColor::iHueBuckets ? iGrayWeight : chroma;
+         sums[bucket][0] += qRed(pixel);
+         sums[bucket][1] += qGreen(pixel);
+         sums[bucket][2] += qBlue(pixel);
+         counts[bucket]++;
+      }
+   }
+
+   for(bucket = 1; bucket <= IBImageColor::iHueBuckets; bucket++)
+   {
+      if(weights[bucket] > weights[heaviest])
+      {
+         heaviest = bucket;
+      }
+   }
+
+   if(counts[heaviest] == 0)
+   {
+      return 0;
+   }
+
+   return qRgb(int(sums[heaviest][0] / counts[heaviest]), int(sums[heaviest][1] / counts[heaviest]),
+               int(sums[heaviest][2] / counts[heaviest]));
+}
+
+/* Returns the hue of the color (color) in degrees from 0 to 359. If the color is gray, -1 is returned. */
+int IBImageColor::getHue(QRgb color)
+{
+   int red = qRed(color), green = qGreen(color), blue = qBlue(color);
+   int max = qMax(red, qMax(green, blue));
+   int chroma = max - qMin(red, qMin(green, blue));
+   int hue;
+
+   if(chroma < iMinChroma)
+   {
+      return -1;
+   }
+
+   if(max == red)
+   {
+      hue = 60 * (green - blue) / chroma;
+   }
+   else if(max == green)
+   {
+      hue = 120 + 60 * (blue - red) / chroma;
+   }
+   else
+   {
+      hue = 240 + 60 * (red - green) / chroma;
+   }
+
+   return hue < 0 ? hue + 360 : hue;
+}
+
+/* Returns the hue bucket of the color (color). Every bucket covers 30 degrees around its hue, starting with red.
+   Gray colors are in the bucket iHueBuckets. */
+int IBImageColor::getHueBucket(QRgb color)
+{
+   int hue = IBImageColor::getHue(color);
+
+   if(hue < 0)
+   {
+      return IBImageColor::iHueBuckets;
+   }
+
+   return ((hue + 15) / 30) % IBImageColor::iHueBuckets;
+}
+
+/* Returns the name of the hue bucket (bucket), which starts with its hue, so that the names are sorted by hue and
+   the gray bucket follows the colored ones. */
+QString IBImageColor::getHueBucketName(int bucket)
+{
+   static const char *names[IBImageColor::iHueBuckets] = {"Red", "Orange", "Yellow", "Chartreuse", "Green",
+                                                          "Spring green", "Cyan", "Azure", "Blue", "Violet",
+                                                          "Magenta", "Rose"};
+
+   if(bucket < 0 || bucket >= IBImageColor::iHueBuckets)
+   {
+      return QStringLiteral("Gray");
+   }
+
+   return QStringLiteral("%1\u00B0 %2").arg(bucket * 30, 3, 10, QLatin1Char('0')).arg(QLatin1String(names[bucket]));
+}
+
+/* Returns the key of the color (color) for sorting by color. The colors are ordered by their hue and then by their
+   luminance, the gray colors follow the colored ones ordered by their luminance. */
+int IBImageColor::getSortKey(QRgb color)
+{
+   int hue = IBImageColor::getHue(color);
+
+   return (hue < 0 ? 360 : hue) * 256 + qGray(color);
+}
@@ -0,0 +1,28 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBIMAGECOLOR
+#define H_IBIMAGECOLOR
+
+#include <QColor>
+#include <QImage>
+#include <QString>
+
+#include "ibimagescaler.hpp"
+
+/* class IBImageColor */
+
+class IBImageColor
+{
+   public:
+      /* number of hue buckets of the histogram, the gray bucket follows them */
+      static const int iHueBuckets = 12;
+
+      static QRgb computeDominantColor(const QImage &image, IBImageScalerBuffers *buffers = nullptr);
+      static int getHue(QRgb color);
+      static int getHueBucket(QRgb color);
+      static QString getHueBucketName(int bucket);
+      static int getSortKey(QRgb color);
+};
+
+#endif /*H_IBIMAGECOLOR*/
@@ -0,0 +1,137 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibimagehash.hpp"
+#include "ibtrace.hpp"
+
+#include <QtGlobal>
+
+/* class IBImageHash */
+
+/* Returns the difference hash of the image (image) reduced to 9x8 pixels, every bit tells whether a pixel is darker
+   than its right neighbour. Returns 0 for a null image. */
+quint64 IBImageHash::computeDifferenceHash(const QImage &image, IBImageScalerBuffers *buffers)
+{
+   IB_TRACE_SCOPE("thumbnails", "computeDifferenceHash");
+   QImage reduced;
+   const QRgb *line;
+   quint64 hash = 0;
+   int x, y;
+
+   if(image.isNull())
+   {
+      return 0;
+   }
+
+   reduced = IBImageScaler::scale(image, QSize(9, 8), Qt::IgnoreAspectRatio, buffers);
+
+   if(reduced.format() != QImage::Format_RGB32 && reduced.format() != QImage::Format_ARGB32_Premultiplied)
+   {
+      reduced = reduced.convertToFormat(QImage::Format_RGB32);
+   }
+
+   for(y = 0; y < 8; y++)
+   {
+      line = reinterpret_cast<const QRgb *>(reduced.constScanLine(y));
+
+      for(x = 0; x < 8; x++)
+      {
+         hash = (hash << 1) | (qGray(line[x]) < qGray(line[x + 1]) ? 1 : 0);
+      }
+   }
+
+   return hash;
+}
+
+/* Returns the Hamming distance of the hashes (hashA, hashB), the number of differing bits. */
+int IBImageHash::getDistance(quint64 hashA, quint64 hashB)
+{
+   return int(qPopulationCount(hashA ^ hashB));
+}
+
+/* class IBImageHashTree */
+
+/* Constructs an empty BK-tree of image hashes. */
+IBImageHashTree::IBImageHashTree()
+{
+}
+
+/* Inserts the hash (hash) with the given value (value). Every child of a node has another distance to the node, so
+   the hash descends along the children with its own distance, until the child is missing. */
+void IBImageHashTree::insert(quint64 hash, int value)
+{
+   IBImageHashTreeNode node = {hash, value, 0, -1, -1};
+   int current = 0, child;
+
+   while(!this->vecNodes.isEmpty())
+   {
+      node.iDistance = IBImageHash::getDistance(hash, this->vecNodes[current].iHash);
+
+      for(child = this->vecNodes[current].iFirstChild; child >= 0; child = this->vecNodes[child].iNextSibling)
+      {
+         if(this->vecNodes[child].iDistance == node.iDistance)
+         {
+            break;
+         }
+      }
+
+      if(child < 0)
+      {
+         node.iNextSibling = this->vecNodes[current].iFirstChild;
+         this->vecNodes[current].iFirstChild = int(this->vecNodes.size());
+         break;
+      }
+
+      current = child;
+   }
+
+   this->vecNodes.append(node);
+}
+
+/* Returns the values of all hashes with a Hamming distance of at most maxdistance to the hash (hash). By the triangle
+   inequality, only the children, whose distance differs from the distance of the hash by at most maxdistance, can
+   contain matches, so a small distance visits a small part of the tree. */
+QList<int> IBImageHashTree::find(quint64 hash, int maxdistance) const
+{
+   QVector<int> stack;
+   QList<int> values;
+   int current, child, distance;
+
+   if(!this->vecNodes.isEmpty())
+   {
+      stack.append(0);
+   }
+
+   while(!stack.isEmpty())
+   {
+      current = stack.takeLast();
+      distance = IBImageHash::getDistance(hash, this->vecNodes[current].iHash);
+
+      if(distance <= maxdistance)
+      {
+         values.append(this->vecNodes[current].iValue);
+      }
+
+      for(child = this->vecNodes[current].iFirstChild; child >= 0; child = this->vecNodes[child].iNextSibling)
+      {
+         if(qAbs(this->vecNodes[child].iDistance - distance) <= maxdistance)
+         {
+            stack.append(child);
+         }
+      }
+   }
+
+   return values;
+}
+
+/* Removes all hashes. */
+void IBImageHashTree::clear()
+{
+   this->vecNodes.clear();
+}
+
+/* Returns the number of hashes. */
+int IBImageHashTree::size() const
+{
+   return int(this->vecNodes.size());
+}
@@ -0,0 +1,53 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBIMAGEHASH
+#define H_IBIMAGEHASH
+
+#include <QImage>
+#include <QList>
+#include <QVector>
+
+#include "ibimagescaler.hpp"
+
+/* class IBImageHash */
+
+class IBImageHash
+{
+   public:
+      static quint64 computeDifferenceHash(const QImage &image, IBImageScalerBuffers *buffers = nullptr);
+      static int getDistance(quint64 hashA, quint64 hashB);
+};
+
+/* node of IBImageHashTree, the children of a node are linked as siblings */
+struct IBImageHashTreeNode
+{
+   /* hash of the node */
+   quint64 iHash;
+   /* value, which was inserted with the hash */
+   int iValue;
+   /* distance of the hash to the hash of the parent node */
+   int iDistance;
+   /* index of the first child and of the next sibling, -1 if there is none */
+   int iFirstChild;
+   int iNextSibling;
+};
+
+/* class IBImageHashTree */
+
+class IBImageHashTree
+{
+   public:
+      IBImageHashTree();
+
+      void insert(quint64 hash, int value);
+      QList<int> find(quint64 hash, int maxdistance) const;
+      void clear();
+      int size() const;
+
+   private:
+      /* nodes of the tree, the first node is the root */
+      QVector<IBImageHashTreeNode> vecNodes;
+};
+
+#endif /*H_IBIMAGEHASH*/
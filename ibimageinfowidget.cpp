@@ -8,10 +8,16 @@ static const char *strPixelFormat[] = {"RGB", "BGR", "Color Palette", "Grayscale
 
 /* Constructs the widget */
 IBImageInfoWidget::IBImageInfoWidget(QWidget *parent)
-   : QWidget(parent)
+   : QWidget(parent), ppfPrefetcher(nullptr), iAccountedBytes(0)
 {
 }
 
+/* Destructs the widget and releases the accounted memory of the loaded image. */
+IBImageInfoWidget::~IBImageInfoWidget()
+{
+   IBMemoryAccounting::resize(IBMemoryAccounting::Preview, this->iAccountedBytes, 0);
+}
+
 /* reimpl. Draw the image and its information. */
 void IBImageInfoWidget::paintEvent(QPaintEvent *event)
 {
@@ -64,7 +70,14 @@ void IBImageInfoWidget::paintEvent(QPaintEvent *event)
       txtpos += QPoint(0, 17);
       painter.drawText(txtpos, QString("Last modification: %1").arg(finfo.lastModified().toString("yyyy-MM-dd HH:mm:ss")));
       txtpos += QPoint(0, 17);
-      painter.drawText(txtpos, QString("Image size (WxH): %1x%2").arg(this->imgData.width()).arg(this->imgData.height()));
+      painter.drawText(txtpos, QString("Date taken: %1").arg(this->edExif.dtTaken.isValid() ?
+                                                             this->edExif.dtTaken.toString("yyyy-MM-dd HH:mm:ss") :
+                                                             QString("unknown")));
+      txtpos += QPoint(0, 17);
+      painter.drawText(txtpos, QString("Camera: %1").arg(this->edExif.strCameraModel.isEmpty() ?
+                                                         QString("unknown") : this->edExif.strCameraModel));
+      txtpos += QPoint(0, 17);
+      painter.drawText(txtpos, QString("Image size (WxH): %1x%2").arg(this->szImageSize.width()).arg(this->szImageSize.height()));
       txtpos += QPoint(0, 17);
       painter.drawText(txtpos, QString("Color model: %1").arg(strPixelFormat[this->imgData.pixelFormat().colorModel()]));
       txtpos += QPoint(0, 17);
@@ -76,21 +89,86 @@ void IBImageInfoWidget::paintEvent(QPaintEvent *event)
    }
 }
 
-/* Sets the path of an image file and loads it. */ 
+/* reimpl. Reloads the image, if the previously loaded preview is noticeably smaller than the new size. */
+void IBImageInfoWidget::resizeEvent(QResizeEvent *event)
+{
+   QSize previewsize = this->getPreviewSize();
+
+   QWidget::resizeEvent(event);
+
+   if(this->ppfPrefetcher)
+   {
+      this->ppfPrefetcher->setPreviewSize(previewsize);
+   }
+
+   if(!this->imgData.isNull() && this->imgData.size() != this->szImageSize &&
+      this->imgData.width() * 5 < previewsize.width() * 4 && this->imgData.height() * 5 < previewsize.height() * 4)
+   {
+      this->loadImage();
+   }
+}
+
+/* Sets the path of an image file and loads it together with its EXIF metadata. */ 
 void IBImageInfoWidget::setImagePath(const QString &path)
 {
    this->strPath = path;
-   this->imgData.load(path);
+   IBExifReader::readFile(path, &this->edExif);
+   this->loadImage();
    this->update();
 }
 
+/* Loads the image of the current path scaled down to the preview size. A preview of the prefetcher is used,
+   if it exists. Otherwise the image is decoded and handed over to the prefetcher for later reuse. The image is
+   accounted as preview, even if it is shared with the cache of the prefetcher. */
+void IBImageInfoWidget::loadImage()
+{
+   QSize previewsize = this->getPreviewSize();
+
+   if(!this->ppfPrefetcher || 
+      !this->ppfPrefetcher->findPreview(this->strPath, previewsize, &this->imgData, &this->szImageSize))
+   {
+      this->imgData = IBPreviewPrefetcher::loadPreview(this->strPath, previewsize, &this->szImageSize);
+
+      if(this->ppfPrefetcher)
+      {
+         this->ppfPrefetcher->insertPreview(this->strPath, this->imgData, this->szImageSize, previewsize);
+      }
+   }
+
+   IBMemoryAccounting::resize(IBMemoryAccounting::Preview, this->iAccountedBytes, this->imgData.sizeInBytes());
+   this->iAccountedBytes = this->imgData.sizeInBytes();
+}
+
+/* Returns the size of the area in which the image is drawn. */
+QSize IBImageInfoWidget::getPreviewSize() const
+{
+   return QSize(this->width() - 40, this->height() - 200).expandedTo(QSize(1, 1));
+}
+
+/* Sets the prefetcher (prefetcher) which supplies the previews. */
+void IBImageInfoWidget::setPrefetcher(IBPreviewPrefetcher *prefetcher)
+{
+   this->ppfPrefetcher = prefetcher;
+
+   if(prefetcher)
+   {
+      prefetcher->setPreviewSize(this->getPreviewSize());
+   }
+}
+
+/* Returns the prefetcher which supplies the previews. */
+IBPreviewPrefetcher *IBImageInfoWidget::getPrefetcher() const
+{
+   return this->ppfPrefetcher;
+}
+
 /* Returns the path of an image file. */
 QString IBImageInfoWidget::getImagePath() const
 {
    return this->strPath; 
 }
 
-/* Returns the loaded image. */
+/* Returns the loaded image scaled down to the preview size. */
 QImage IBImageInfoWidget::getImage() const
 {
    return this->imgData;
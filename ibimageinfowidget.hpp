@@ -11,25 +11,47 @@
 #include <QPainter>
 #include <QPaintEvent>
 #include <QPixelFormat>
+#include <QResizeEvent>
 #include <QString>
 #include <QWidget>
 
+#include "ibexifreader.hpp"
+#include "ibmemoryaccounting.hpp"
+#include "ibpreviewprefetcher.hpp"
+
 class IBImageInfoWidget : public QWidget
 {
    public:
       IBImageInfoWidget(QWidget *parent = nullptr);
+      ~IBImageInfoWidget();
       void setImagePath(const QString &path);
       QString getImagePath() const;
       QImage getImage() const;
+      QSize getPreviewSize() const;
+
+      void setPrefetcher(IBPreviewPrefetcher *prefetcher);
+      IBPreviewPrefetcher *getPrefetcher() const;
 
    protected:
       void paintEvent(QPaintEvent *event) override;
+      void resizeEvent(QResizeEvent *event) override;
 
    private:
+      void loadImage();
+
+
       /* contains the path to the displayed image */
       QString strPath;
-      /* contains the loaded image */
+      /* contains the loaded image scaled down to the preview size */
       QImage imgData;
+      /* contains the original size of the loaded image */
+      QSize szImageSize;
+      /* contains the EXIF metadata of the loaded image */
+      IBExifData edExif;
+      /* supplies prefetched previews, if it is set */
+      IBPreviewPrefetcher *ppfPrefetcher;
+      /* bytes of the loaded image, which are accounted in IBMemoryAccounting */
+      qint64 iAccountedBytes;
 };
 
 #endif /*IBIMAGEINFOWIDGET_H*/
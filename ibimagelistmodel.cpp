@@ -3,57 +3,85 @@
 
 #include "ibimagelistmodel.hpp"
 
+/* time in milliseconds, after which the thumbnail loader stores the index again with the loaded metadata */
+static const qint64 iIndexStoreInterval = 5000;
+
+/* Returns the group of the image (idx) in the forest of groups (parents), whose roots are their first images. */
+static int findSimilarGroup(QVector<int> &parents, int idx)
+{
+   while(parents[idx] != idx)
+   {
+      parents[idx] = parents[parents[idx]];
+      idx = parents[idx];
+   }
+
+   return idx;
+}
+
 /* class IBImageListModel */
 
 /* Constructs the Image List Model with the given parent. */
 IBImageListModel::IBImageListModel(QObject * parent)
    : QAbstractListModel(parent), szThumbnailSize(QSize(0,0)), stSectionType(NoSection),
-     soSectionSortOrder(Qt::AscendingOrder), isfImageSortField(SortByName), soImageSortOrder(Qt::AscendingOrder)
+     soSectionSortOrder(Qt::AscendingOrder), isfImageSortField(SortByName), soImageSortOrder(Qt::AscendingOrder),
+     iPresetThumbnailBytes(0), bRecursive(false), iSimilarityDistance(6),
+     bThumbnailsChanged(false), bFileNameIndexStale(true)
 {
    this->lstItems = new IBImageListSectionList();
    this->initThumbnailLoader();
+   this->initWalker();
    this->initImageDir();
 }
 
 /* Constructs the Image List Model with the given image path (imagepath) and parent. */
 IBImageListModel::IBImageListModel(QString& imagepath, QObject * parent)
    : QAbstractListModel(parent), szThumbnailSize(QSize(0,0)), stSectionType(NoSection),
-     soSectionSortOrder(Qt::AscendingOrder), isfImageSortField(SortByName), soImageSortOrder(Qt::AscendingOrder)
+     soSectionSortOrder(Qt::AscendingOrder), isfImageSortField(SortByName), soImageSortOrder(Qt::AscendingOrder),
+     iPresetThumbnailBytes(0), bRecursive(false), iSimilarityDistance(6),
+     bThumbnailsChanged(false), bFileNameIndexStale(true)
 {
    this->lstItems = new IBImageListSectionList();
    this->initThumbnailLoader();
+   this->initWalker();
    this->initImageDir(imagepath);
 }
 
 /* Constructs the Image List Model with the given image path (imagepath), size of thumbnails (thumbsize) and parent. */
 IBImageListModel::IBImageListModel(QString& imagepath, QSize& thumbsize, QObject * parent)
    : QAbstractListModel(parent), szThumbnailSize(thumbsize), stSectionType(NoSection),
-     soSectionSortOrder(Qt::AscendingOrder), isfImageSortField(SortByName), soImageSortOrder(Qt::AscendingOrder)
+     soSectionSortOrder(Qt::AscendingOrder), isfImageSortField(SortByName), soImageSortOrder(Qt::AscendingOrder),
+     iPresetThumbnailBytes(0), bRecursive(false), iSimilarityDistance(6),
+     bThumbnailsChanged(false), bFileNameIndexStale(true)
 {
    this->lstItems = new IBImageListSectionList();
    this->initThumbnailLoader();
+   this->initWalker();
    this->initImageDir(imagepath);
 }
    
 /* Constructs the Image List Model with the given size of thumbnails (thumbsize) and parent. */
 IBImageListModel::IBImageListModel(QSize& thumbsize, QObject * parent)
    : QAbstractListModel(parent), szThumbnailSize(thumbsize), stSectionType(NoSection),
-     soSectionSortOrder(Qt::AscendingOrder), isfImageSortField(SortByName), soImageSortOrder(Qt::AscendingOrder)
+     soSectionSortOrder(Qt::AscendingOrder), isfImageSortField(SortByName), soImageSortOrder(Qt::AscendingOrder),
+     iPresetThumbnailBytes(0), bRecursive(false), iSimilarityDistance(6),
+     bThumbnailsChanged(false), bFileNameIndexStale(true)
 {
    this->lstItems = new IBImageListSectionList();
    this->initThumbnailLoader();
+   this->initWalker();
    this->initImageDir();
 }
 
 /* Destructs the model. The model destroys all its items. */
 IBImageListModel::~IBImageListModel()
 {
-   if(this->thdThumbLoader->isRunning())
-   {
-      this->thdThumbLoader->terminate();
-      this->thdThumbLoader->wait();
-   }
+   this->stopWalker();
+   this->stopThumbnailLoader();
    delete this->thdThumbLoader;
+
+   this->lstItems->clear();
+   delete this->lstItems;
+   qDeleteAll(this->lstFileData);
 }
 
 /* reimpl. */
@@ -118,7 +146,38 @@ QVariant IBImageListModel::data(const QModelIndex &index, int role) const
                case IBImageListModel::ItemImageLoaded:
                   return dynamic_cast<IBImageListImageItem *>(item)->isImageLoaded();
 
+               case IBImageListModel::ItemImageFailed:
+                  return dynamic_cast<IBImageListImageItem *>(item)->isImageFailed();
+
+               case IBImageListModel::ItemDominantColor:
+                  if(dynamic_cast<IBImageListImageItem *>(item)->hasDominantColor())
+                  {
+                     return QColor(dynamic_cast<IBImageListImageItem *>(item)->getDominantColor());
+                  }
+                  return QVariant();
+
+               case IBImageListModel::ItemHue:
+                  if(dynamic_cast<IBImageListImageItem *>(item)->hasDominantColor())
+                  {
+                     return IBImageColor::getHue(dynamic_cast<IBImageListImageItem *>(item)->getDominantColor());
+                  }
+                  return QVariant();
+
+               case IBImageListModel::ItemDateTaken:
+                  if(dynamic_cast<IBImageListImageItem *>(item)->getExifData().dtTaken.isValid())
+                  {
+                     return dynamic_cast<IBImageListImageItem *>(item)->getExifData().dtTaken;
+                  }
+                  return QVariant();
+
+               case IBImageListModel::ItemCameraModel:
+                  return dynamic_cast<IBImageListImageItem *>(item)->getExifData().strCameraModel;
+
+               case IBImageListModel::ItemOrientation:
+                  return dynamic_cast<IBImageListImageItem *>(item)->getExifData().iOrientation;
+
                case IBImageListModel::ItemThumbnail:
+                  this->requestThumbnail(dynamic_cast<IBImageListImageItem *>(item));
                   return dynamic_cast<IBImageListImageItem *>(item)->getThumbnail();
             }
          }
@@ -127,37 +186,214 @@ QVariant IBImageListModel::data(const QModelIndex &index, int role) const
 
    return QVariant();
 }
-/* Loads the file data, invokes the generation of the model structure and starts the loading of thumbnails. */
-void IBImageListModel::loadImageData()
+
+/* Loads the file data, invokes the generation of the model structure and starts the loading of thumbnails. If
+   reusethumbnails is true, the thumbnails of the previous items are kept for the files, which are not modified.
+   In recursive mode the model is emptied and the walker is started, which adds the images of the directory and its
+   subdirectories in the background. Their thumbnails are loaded on demand, the persistent thumbnail cache makes the
+   reloading cheap.
+   Otherwise the index of the directory is read first. If the directory was not modified since the index was stored,
+   the items are created from the index alone and the loader revalidates the timestamps of the files in the background.
+   Else the directory is listed and only the metadata of new and modified files is probed by the loader, which stores
+   the updated index at once and completes it, while the thumbnails are loaded. */
+void IBImageListModel::loadImageData(bool reusethumbnails)
 {   
+   IB_TRACE_SCOPE("model", "loadImageData");
+   QHash<QString, IBImageListImageItem *> loaded;
+   QList<IBImageListImageItem *> olddata;
+   IBImageListImageItem *newitem, *olditem;
    QFileInfoList fileinfos;
    QList<QFileInfo>::iterator it;
+   QList<IBDirectoryIndexEntry> entries;
+   QHash<QString, const IBDirectoryIndexEntry *> indexednames;
+   QHash<quint64, const IBDirectoryIndexEntry *> indexedinodes;
+   const IBDirectoryIndexEntry *entry;
+   QDateTime indexmodified;
+   QString dirpath = this->dirImages.absolutePath(), canonicaldir;
+   bool indexed, modified = false;
+
+   this->stopWalker();
+   this->stopThumbnailLoader();
+
+   this->thdThumbLoader->resetStatistics();
+   this->iPresetThumbnailBytes = 0;
+   this->lstItems->clear();
+   olddata.swap(this->lstFileData);
+   this->bFileNameIndexStale = true;
 
-  
-   if(this->thdThumbLoader->isRunning())
+   if(this->bRecursive)
    {
-      this->thdThumbLoader->terminate();
-      this->thdThumbLoader->wait();
+      qDeleteAll(olddata);
+      this->dtDirModified = QDateTime();
+      this->buildItemsList();
+      this->dwWalker->start(this->dirImages.absolutePath());
+      return;
    }
 
-   this->lstFileData.clear();
+   if(reusethumbnails)
+   {
+      for(IBImageListImageItem *item : olddata)
+      {
+         if(item->isImageLoaded())
+         {
+            loaded.insert(item->getFilePath(), item);
+         }
+      }
+   }
+
+   {
+      IB_TRACE_SCOPE("model", "loadIndex");
+      this->dtDirModified = QFileInfo(dirpath).lastModified();
+      indexed = this->diIndex.load(dirpath, &entries, &indexmodified);
+   }
+
+   if(indexed && !reusethumbnails && indexmodified == this->dtDirModified)
+   {
+      canonicaldir = QFileInfo(dirpath).canonicalFilePath();
+
+      for(const IBDirectoryIndexEntry &indexentry : entries)
+      {
+         newitem = new IBImageListImageItem(canonicaldir + QLatin1Char('/') + indexentry.strFileName,
+                                            QDateTime::fromMSecsSinceEpoch(indexentry.iModified));
+         newitem->setIndexEntry(indexentry);
+         this->lstFileData.append(newitem);
+
+         /* an index without the sizes of images, which were not loaded yet, without the hashes or colors of
+            decodable images or without the EXIF metadata is completed by the loader */
+         modified = modified || !indexentry.szImage.isValid()
+                    || ((!indexentry.bPerceptualHash || indexentry.rgbDominantColor == 0)
+                        && !indexentry.szImage.isEmpty()) || !indexentry.bExif;
+      }
+
+      qDeleteAll(olddata);
+
+      if(modified)
+      {
+         this->thdThumbLoader->setIndexing(dirpath, this->dtDirModified);
+      }
+
+      this->buildItemsList();
+      this->thdThumbLoader->setRevalidation(dirpath, this->dtDirModified, true);
+      this->thdThumbLoader->start();
+      return;
+   }
+
+   for(const IBDirectoryIndexEntry &indexentry : entries)
+   {
+      indexednames.insert(indexentry.strFileName, &indexentry);
+
+      if(indexentry.iInode != 0)
+      {
+         indexedinodes.insert(indexentry.iInode, &indexentry);
+      }
+   }
 
-   fileinfos = this->dirImages.entryInfoList();
+   {
+      IB_TRACE_SCOPE("model", "entryInfoList");
+      fileinfos = this->dirImages.entryInfoList();
+   }
 
    for(it = fileinfos.begin(); it != fileinfos.end(); ++it)
    {
-      lstFileData.append(new IBImageListImageItem(*it));
+      newitem = new IBImageListImageItem(*it);
+      entry = indexednames.value(newitem->getFileName(), nullptr);
+
+      /* a renamed file is found by its inode, which is only looked up for the files with an unknown name */
+      if(!entry && !indexedinodes.isEmpty())
+      {
+         entry = indexedinodes.value(IBDirectoryIndex::getInode(newitem->getFilePath()), nullptr);
+      }
+
+      if(entry && entry->iSize == newitem->getFileSize()
+         && entry->iModified == newitem->getLastModified().toMSecsSinceEpoch())
+      {
+         newitem->setIndexEntry(*entry);
+      }
+      else
+      {
+         modified = true;
+      }
+
+      olditem = loaded.value(newitem->getFilePath());
+
+      if(olditem && olditem->getLastModified() == newitem->getLastModified())
+      {
+         newitem->setThumbnail(olditem->getThumbnail().value<QPixmap>(), olditem->getImageSize());
+         this->iPresetThumbnailBytes += newitem->getThumbnailBytes();
+
+         if(olditem->hasPerceptualHash())
+         {
+            newitem->setPerceptualHash(olditem->getPerceptualHash());
+         }
+
+         newitem->setDominantColor(olditem->getDominantColor());
+
+         if(olditem->hasExifData())
+         {
+            newitem->setExifData(olditem->getExifData());
+         }
+      }
+
+      this->lstFileData.append(newitem);
+   }
+
+   qDeleteAll(olddata);
+
+   if(modified || !indexed || entries.size() != this->lstFileData.size())
+   {
+      this->thdThumbLoader->setIndexing(dirpath, this->dtDirModified);
    }
 
    this->buildItemsList();
    this->thdThumbLoader->start();
 }
 
-/* Invokes the repreparing of the model data */
+/* Stops a running thumbnail loader. The loader is interrupted and finishes its current image, so that the image items,
+   the trace events and the cache files stay consistent. The metadata computed by the loader is applied, before the
+   image items may be deleted. Afterwards the loader handles all image items of the model again. */
+void IBImageListModel::stopThumbnailLoader()
+{
+   if(this->thdThumbLoader->isRunning())
+   {
+      this->thdThumbLoader->requestInterruption();
+      this->thdThumbLoader->wait();
+   }
+
+   this->applyLoaderMetadata();
+   this->thdThumbLoader->setImageList(&this->lstFileData);
+   this->lstLoading.clear();
+}
+
+/* Applies the hashes, the colors and the EXIF metadata, which the loader computed since the last call, to the image
+   items. They are only written here, so that the sorting, the grouping and the data of the model do not race with
+   the loader. */
+void IBImageListModel::applyLoaderMetadata()
+{
+   QHash<IBImageListImageItem *, IBImageListMetadata> metadata = this->thdThumbLoader->takeMetadata();
+   QHash<IBImageListImageItem *, IBImageListMetadata>::const_iterator it;
+
+   for(it = metadata.constBegin(); it != metadata.constEnd(); ++it)
+   {
+      it.key()->setMetadata(it.value());
+   }
+}
+
+/* Stops a running walker and forgets the requested thumbnails. The thumbnail loader has to be stopped afterwards,
+   because it may still load the requested thumbnails. */
+void IBImageListModel::stopWalker()
+{
+   this->dwWalker->stop();
+   this->tmFlush->stop();
+   this->tmRequest->stop();
+   this->lstRequested.clear();
+   this->stRequested.clear();
+}
+
+/* Invokes the repreparing of the model data. The thumbnails of unmodified files are kept. */
 void IBImageListModel::refresh()
 {
    this->dirImages.refresh();
-   this->loadImageData(); 
+   this->loadImageData(true); 
 }
 
 /* Sets the path to images (imagepath) and invokes the preparing of the model data */
@@ -194,6 +430,25 @@ QSize IBImageListModel::getThumbnailSize() const
    return this->szThumbnailSize;
 }
 
+/* Sets, whether the images of the subdirectories of the image path are listed too (recursive), and invokes the
+   preparing of the model data. */
+void IBImageListModel::setRecursive(bool recursive)
+{
+   if(this->bRecursive == recursive)
+   {
+      return;
+   }
+
+   this->bRecursive = recursive;
+   this->loadImageData();
+}
+
+/* Returns true, if the images of the subdirectories of the image path are listed too. Otherwise false. */
+bool IBImageListModel::isRecursive() const
+{
+   return this->bRecursive;
+}
+
 /* Sets the type (type) of section heads and invokes the restructure of the model. If the index of the 
    currently selected item (selected) is given, the new index of this item is returned. 
    see IBImageListModel::IBListSectionType */
@@ -205,6 +460,7 @@ QModelIndex IBImageListModel::setSectionType(const IBListSectionType type, const
    {
       selitem = this->getRawItem(selected);
       this->stSectionType = type;
+      this->thdThumbLoader->setMetadataFirst(this->isCaptureDateDependent());
       this->buildItemsList();
       return this->getRawItemIndex(selitem);
    }
@@ -279,6 +535,7 @@ QModelIndex IBImageListModel::setImageSortField(IBImageSortField field, const QM
    {
       selitem = this->getRawItem(selected);
       this->isfImageSortField = field;
+      this->thdThumbLoader->setMetadataFirst(this->isCaptureDateDependent());
       this->lstItems->sortImageItems(field, this->soImageSortOrder);
       emit this->layoutChanged();
       return this->getRawItemIndex(selitem);
@@ -293,200 +550,1310 @@ IBImageListModel::IBImageSortField IBImageListModel::getImageSortField() const
    return this->isfImageSortField;
 } 
 
-/* Resets and (re-)structures the data of the model. */
-void IBImageListModel::buildItemsList()
+/* Sets the maximal Hamming distance (distance) of the perceptual hashes of similar images and regroups the similar
+   images, if they are the sections. If the index of the currently selected item (selected) is given, the new index
+   of this item is returned. */
+QModelIndex IBImageListModel::setSimilarityDistance(int distance, const QModelIndex &selected)
 {
-   QList<IBImageListImageItem *>::iterator it;
-   QString hstr = QStringLiteral("");
-   QDate hdate;
-  
-   this->beginResetModel();
-   this->lstItems->clear();
+   IBImageListAbstractItem *selitem;
 
-   for(it = this->lstFileData.begin(); it != this->lstFileData.end(); ++it)
-   {
-      switch(this->stSectionType)
-      {
-         case IBImageListModel::DateSection:
-            hdate = (*it)->getLastModified().date();
-            this->lstItems->addImageItem(hdate, (*it));
-            break;   
+   distance = qBound(0, distance, 64);
 
-         case IBImageListModel::AlphabeticSection:
-            if((*it)->getName()[0].isDigit())
-            {
-               hstr = QStringLiteral("#");
-            }
-            else
-            {
-               hstr = (*it)->getName().left(1).toUpper();
-            }
-            this->lstItems->addImageItem(hstr, (*it));
-            break;
-            
-         case IBImageListModel::FileTypeSection:
-            hstr = (*it)->getFileType().toUpper();
-            this->lstItems->addImageItem(hstr, (*it));
-            break;
+   if(this->iSimilarityDistance != distance)
+   {
+      this->iSimilarityDistance = distance;
 
-         case IBImageListModel::NoSection:
-         default:
-            this->lstItems->addImageItem(hstr, (*it));
+      if(this->stSectionType == IBImageListModel::SimilarSection)
+      {
+         selitem = this->getRawItem(selected);
+         this->buildItemsList();
+         return this->getRawItemIndex(selitem);
       }
-
    }
 
-   this->lstItems->sortSections(this->soSectionSortOrder);
-   this->lstItems->sortImageItems(this->isfImageSortField, this->soImageSortOrder);
-   
-   this->endResetModel();
+   return selected;
 }
 
-/* Converts the integer index (index) of an item into the corresponding model index and emits the signal itemChanged. */
-void IBImageListModel::onImageLoaded(int index)
+/* Returns the maximal Hamming distance of the perceptual hashes of similar images. */
+int IBImageListModel::getSimilarityDistance() const
 {
-   int lidx = this->lstItems->getLinearIndexOfItem(lstFileData[index]);
-   emit this->itemChanged(this->index(lidx, 0));
+   return this->iSimilarityDistance;
 }
 
-/* Returns the item object of the given model index (index). If the index does not exist, nullptr is returned. */
-IBImageListAbstractItem *IBImageListModel::getRawItem(const QModelIndex &index)
+/* Returns the indexes of the images, which are similar to the image of the given index (index), ordered by their
+   similarity. Images are similar, if the Hamming distance of their perceptual hashes is at most maxdistance, or the
+   similarity distance of the model if maxdistance is negative. Only the images with a loaded thumbnail or an indexed
+   hash are compared and the images hidden by the file name filter are skipped. The hash tree is only rebuilt, if
+   hashes were added since the last query. */
+QModelIndexList IBImageListModel::findSimilarImages(const QModelIndex &index, int maxdistance)
 {
-   if(!index.isValid())
+   IB_TRACE_SCOPE("model", "findSimilarImages");
+   IBImageListAbstractItem *rawitem = this->getRawItem(index);
+   IBImageListImageItem *item, *other;
+   QList<QPair<int, int> > matches;
+   QModelIndexList indexes;
+   QModelIndex matchindex;
+   int idx;
+
+   if(!rawitem || rawitem->getType() != IBImageListAbstractItem::Image)
    {
-      return nullptr;
+      return indexes;
    }
-   
-   return this->lstItems->getItemByLinearIndex(index.row());
-}  
-
-/* Returns the corresponding model index of an item index (item). If the item is not indexed, an invalid model index 
-   is returned. */
-QModelIndex IBImageListModel::getRawItemIndex(IBImageListAbstractItem *item)
-{
-   int lidx = this->lstItems->getLinearIndexOfItem(item);
-   return this->index(lidx, 0);
-}
 
-/* Initializes the structure for the fetching the image data. */
-void IBImageListModel::initImageDir()
-{
-   QString curpath = QDir::currentPath();
-   this->initImageDir(curpath);
-}
+   item = dynamic_cast<IBImageListImageItem *>(rawitem);
 
-/* Initializes the structure for the fetching the image data. */
-void IBImageListModel::initImageDir(const QString& imagepath)
-{
-   QStringList namefilters;
+   if(!item->hasPerceptualHash())
+   {
+      return indexes;
+   }
 
-   namefilters << "*.bmp" << "*.jpeg" << "*.jpg" << "*.png" << "*.ppm" << "*.xbm" << "*.xpm";
-   this->dirImages.setNameFilters(namefilters);
-   this->dirImages.setPath(QDir::currentPath());
-   this->setImagePath(imagepath);
-}
+   if(this->isHashTreeStale())
+   {
+      this->htSimilar.clear();
 
-/* Initializes the thread for loading the image thumbnails. */
-void IBImageListModel::initThumbnailLoader()
-{
-   this->thdThumbLoader = new IBThumbnailLoader(this);
-   this->thdThumbLoader->setImageList(&this->lstFileData);
-   this->thdThumbLoader->setThumbnailSize(this->szThumbnailSize);
-   this->connect(this->thdThumbLoader, SIGNAL(imageLoaded(int)), SLOT(onImageLoaded(int)));
-}
+      for(idx = 0; idx < this->lstFileData.size(); idx++)
+      {
+         if(this->lstFileData.at(idx)->hasPerceptualHash())
+         {
+            this->htSimilar.insert(this->lstFileData.at(idx)->getPerceptualHash(), idx);
+         }
+      }
+   }
 
-/* Class IBImageListAbstractItem */
+   for(int match : this->htSimilar.find(item->getPerceptualHash(),
+                                        maxdistance < 0 ? this->iSimilarityDistance : maxdistance))
+   {
+      other = this->lstFileData.at(match);
 
-/* Constructs an abstract object of an item for the image list model with the given type of item (itemtype).
-   see IBImageListAbstractItem::ItemType */
-IBImageListAbstractItem::IBImageListAbstractItem(IBImageListAbstractItem::ItemType itemtype)
-   : itType(itemtype)
-{
-}
+      if(other != item)
+      {
+         matches.append(qMakePair(IBImageHash::getDistance(item->getPerceptualHash(), other->getPerceptualHash()),
+                                  match));
+      }
+   }
 
-/* Returns the type of an image list model item. see IBImageListAbstractItem::ItemType */
-IBImageListAbstractItem::ItemType IBImageListAbstractItem::getType() const
-{
-   return this->itType;
-}
+   std::sort(matches.begin(), matches.end());
 
-/* Returns the type (itemtype) of an image list model item. see IBImageListAbstractItem::ItemType */
-void IBImageListAbstractItem::setType(IBImageListAbstractItem::ItemType itemtype)
-{
-   this->itType = itemtype; 
-} 
+   for(const QPair<int, int> &match : matches)
+   {
+      matchindex = this->getRawItemIndex(this->lstFileData.at(match.second));
 
-/* class IBImageListImageItem */
+      if(matchindex.isValid())
+      {
+         indexes.append(matchindex);
+      }
+   }
 
-/* Constructs an empty image data item for the image list model. */
-IBImageListImageItem::IBImageListImageItem()
-   : IBImageListAbstractItem(IBImageListAbstractItem::Image)
-{
+   return indexes;
 }
 
-/* Constructs an image data item for the image list model with given file information (info). */
-IBImageListImageItem::IBImageListImageItem(QFileInfo &info)
-   : IBImageListAbstractItem(IBImageListAbstractItem::Image)
+/* Sets the fragment (filter) of the file names of the shown image items, the case is ignored. An empty filter shows
+   all image items. The matches are looked up in the file name index, which is built once after the image items were
+   replaced, and a growing filter only searches the matches of the previous one. The section items are updated from
+   the changed matches and the layout is changed instead of resetting the model. If the index of the currently
+   selected item (selected) is given, the new index of this item is returned, it is invalid if the item is hidden. */
+QModelIndex IBImageListModel::setFileNameFilter(const QString &filter, const QModelIndex &selected)
 {
-   this->load(info);
-}
+   IB_TRACE_SCOPE("model", "setFileNameFilter");
+   QList<IBImageListAbstractItem *> rawitems;
+   QModelIndexList oldindexes, newindexes;
+   IBImageListAbstractItem *selitem, *rawitem;
+   QVector<int> matches;
+   bool narrowing;
 
-/* Loads the data of an image data item with the given file information (info). */
-void IBImageListImageItem::load(QFileInfo &info)
-{
-   this->strFileName = info.fileName();
-   this->strFileType = info.suffix();
-   this->strFilePath = info.canonicalFilePath();
-   this->dtLastModified = info.lastModified();
-   this->bImageLoaded = false;
-}
+   if(this->strFileNameFilter == filter)
+   {
+      return selected;
+   }
 
-/* Loads the image data of an item and scales it to the given size (thumbsize). It generates the thumbnail.*/
-void IBImageListImageItem::loadImage(QSize &thumbsize)
-{
-   QPixmap pixtmp;
+   /* section items may be dropped, so only the image items are mapped */
+   selitem = this->getRawItem(selected);
+   if(selitem && selitem->getType() != IBImageListAbstractItem::Image)
+   {
+      selitem = nullptr;
+   }
 
-   pixtmp.load(this->strFilePath);
-   this->szImageSize = pixtmp.size();
+   this->updateFileNameIndex();
+   narrowing = !this->strFileNameFilter.isEmpty()
+               && filter.toCaseFolded().contains(this->strFileNameFilter.toCaseFolded());
 
-   if(pixtmp.width() <= thumbsize.width() && pixtmp.height() <= thumbsize.height())
+   if(!filter.isEmpty())
    {
-      this->pxThumbnail = pixtmp;
+      matches = this->fniNames.find(filter, narrowing ? &this->vecFilteredItems : nullptr);
    }
-   else
+
+   emit this->layoutAboutToBeChanged();
+
+   oldindexes = this->persistentIndexList();
+   for(const QModelIndex &index : oldindexes)
    {
-      this->pxThumbnail = pixtmp.scaled(thumbsize, Qt::KeepAspectRatio);
+      rawitem = this->getRawItem(index);
+      rawitems.append(rawitem && rawitem->getType() == IBImageListAbstractItem::Image ? rawitem : nullptr);
    }
 
-   this->bImageLoaded = true;
-}
+   this->updateFilteredItems(filter, matches);
 
-/* Returns the name of item. It is the name of the corresponding file without extension. */
-QString IBImageListImageItem::getName() const
-{
-   return QString(this->strFileName).remove(QRegularExpression(QString(".%1$").arg(this->strFileType)));
-}
+   for(IBImageListAbstractItem *imageitem : rawitems)
+   {
+      newindexes.append(imageitem ? this->getRawItemIndex(imageitem) : QModelIndex());
+   }
 
-/* Returns the corresponding filename of the item. */
-QString IBImageListImageItem::getFileName() const
-{
-   return this->strFileName;
+   this->changePersistentIndexList(oldindexes, newindexes);
+   emit this->layoutChanged();
+
+   return this->getRawItemIndex(selitem);
 }
 
-/* Returns the file type of the corresponding file. It is the extension of the file. */
-QString IBImageListImageItem::getFileType() const
+/* Returns the fragment of the file names of the shown image items. */
+QString IBImageListModel::getFileNameFilter() const
 {
-   return this->strFileType;
+   return this->strFileNameFilter;
 }
 
-/* Returns the path of the corresponding file. */
-QString IBImageListImageItem::getFilePath() const
+/* Replaces the images of the model by the given items (items) without reading the image directory and invokes the
+   generation of the model structure. The model takes the ownership of the items. If loadthumbnails is true, the
+   loading of the thumbnails, which are not set yet, is started. */
+void IBImageListModel::setImageItems(const QList<IBImageListImageItem *> &items, bool loadthumbnails)
 {
-   return this->strFilePath;
+   this->stopWalker();
+   this->stopThumbnailLoader();
+
+   this->thdThumbLoader->resetStatistics();
+   this->iPresetThumbnailBytes = 0;
+   this->lstItems->clear();
+   qDeleteAll(this->lstFileData);
+   this->lstFileData = items;
+   this->bFileNameIndexStale = true;
+
+   this->buildItemsList();
+
+   for(IBImageListImageItem *item : this->lstFileData)
+   {
+      this->iPresetThumbnailBytes += item->getThumbnailBytes();
+   }
+
+   if(loadthumbnails)
+   {
+      this->thdThumbLoader->start();
+   }
 }
 
-/* Returns the original size of the image. */
-QSize IBImageListImageItem::getImageSize() const
+/* Hands the image items and their structure over to a snapshot, which can be restored by restoreSnapshot, and leaves
+   the model empty. The loader is stopped after its current image, so that the items stay consistent. The caller takes
+   the ownership of the snapshot. */
+IBImageListSnapshot *IBImageListModel::takeSnapshot()
+{
+   IBImageListSnapshot *snapshot = new IBImageListSnapshot();
+
+   this->stopWalker();
+   this->stopThumbnailLoader();
+   this->thdThumbLoader->resetStatistics();
+   this->iPresetThumbnailBytes = 0;
+
+   this->beginResetModel();
+
+   snapshot->strPath = this->dirImages.path();
+   snapshot->dtModified = this->dtDirModified;
+   snapshot->lstFileData.swap(this->lstFileData);
+   snapshot->lstItems = this->lstItems;
+   this->htSimilar.clear();
+   this->bFileNameIndexStale = true;
+   snapshot->stSectionType = this->stSectionType;
+   snapshot->soSectionSortOrder = this->soSectionSortOrder;
+   snapshot->isfImageSortField = this->isfImageSortField;
+   snapshot->soImageSortOrder = this->soImageSortOrder;
+   snapshot->strFileNameFilter = this->strFileNameFilter;
+   this->lstItems = new IBImageListSectionList();
+
+   this->endResetModel();
+
+   return snapshot;
+}
+
+/* Replaces the images of the model by the items of the snapshot (snapshot) and destroys the snapshot. The structure
+   of the snapshot is kept, if it matches the current sort, section and filter state of the model, otherwise it is
+   rebuilt.
+   The loader completes the missing thumbnails and revalidates the directory against its timestamp of the last
+   modification. If the directory was modified, the signal directoryModified is emitted. */
+void IBImageListModel::restoreSnapshot(IBImageListSnapshot *snapshot)
+{
+   IB_TRACE_SCOPE("model", "restoreSnapshot");
+   bool keepstructure = snapshot->lstItems && snapshot->stSectionType == this->stSectionType
+                        && snapshot->soSectionSortOrder == this->soSectionSortOrder
+                        && snapshot->isfImageSortField == this->isfImageSortField
+                        && snapshot->soImageSortOrder == this->soImageSortOrder
+                        && snapshot->strFileNameFilter == this->strFileNameFilter;
+
+   this->stopWalker();
+   this->stopThumbnailLoader();
+   this->thdThumbLoader->resetStatistics();
+   this->iPresetThumbnailBytes = 0;
+
+   this->beginResetModel();
+
+   this->lstItems->clear();
+   qDeleteAll(this->lstFileData);
+   this->lstFileData.clear();
+   this->lstFileData.swap(snapshot->lstFileData);
+   this->bFileNameIndexStale = true;
+   this->dirImages.setPath(snapshot->strPath);
+   this->dtDirModified = snapshot->dtModified;
+
+   if(keepstructure)
+   {
+      delete this->lstItems;
+      this->lstItems = snapshot->lstItems;
+      snapshot->lstItems = nullptr;
+      this->htSimilar.clear();
+   }
+
+   this->endResetModel();
+
+   if(!keepstructure)
+   {
+      this->buildItemsList();
+   }
+
+   for(IBImageListImageItem *item : this->lstFileData)
+   {
+      this->iPresetThumbnailBytes += item->getThumbnailBytes();
+   }
+
+   delete snapshot;
+
+   this->thdThumbLoader->setRevalidation(this->dirImages.absolutePath(), this->dtDirModified);
+   this->thdThumbLoader->start();
+}
+
+/* Returns the model index of the image item with the given file path (filepath). If the model has no such item, an
+   invalid model index is returned. */
+QModelIndex IBImageListModel::getImageIndex(const QString &filepath)
+{
+   for(IBImageListImageItem *item : this->lstFileData)
+   {
+      if(item->getFilePath() == filepath)
+      {
+         return this->getRawItemIndex(item);
+      }
+   }
+
+   return QModelIndex();
+}
+
+/* Returns the current statistics of the model and its thumbnail loader. It is cheap enough to be polled
+   by the GUI. */
+IBImageListModelStatistics IBImageListModel::getStatistics() const
+{
+   IBImageListModelStatistics stats;
+
+   stats.iImages = this->lstFileData.size();
+   stats.iSections = this->lstItems->sectionCount();
+   stats.lsLoader = this->thdThumbLoader->getStatistics();
+   stats.iThumbnailBytes = this->iPresetThumbnailBytes + stats.lsLoader.iThumbnailBytes;
+
+   return stats;
+}
+
+/* Returns the id of the section, which the image item (item) belongs to for the given type of sections (type).
+   see IBImageListModel::IBListSectionType */
+QVariant IBImageListModel::getSectionId(IBImageListModel::IBListSectionType type, IBImageListImageItem *item)
+{
+   QString name;
+
+   switch(type)
+   {
+      case IBImageListModel::DateSection:
+         return QVariant(item->getLastModified().date());
+
+      case IBImageListModel::AlphabeticSection:
+         name = item->getName();
+         if(!name.isEmpty() && name[0].isDigit())
+         {
+            return QVariant(QStringLiteral("#"));
+         }
+         return QVariant(name.left(1).toUpper());
+
+      case IBImageListModel::FileTypeSection:
+         return QVariant(item->getFileType().toUpper());
+
+      case IBImageListModel::FolderSection:
+         return QVariant(item->getDirectoryPath());
+
+      case IBImageListModel::SimilarSection:
+         return QVariant(item->getSimilarGroup());
+
+      case IBImageListModel::HueSection:
+         if(!item->hasDominantColor())
+         {
+            return QVariant(QStringLiteral("Not analyzed yet"));
+         }
+         return QVariant(IBImageColor::getHueBucketName(IBImageColor::getHueBucket(item->getDominantColor())));
+
+      case IBImageListModel::CaptureDateSection:
+         return QVariant(item->getCaptureDate().date());
+
+      case IBImageListModel::NoSection:
+      default:
+         return QVariant(QStringLiteral(""));
+   }
+}
+
+/* Resets and (re-)structures the data of the model. */
+void IBImageListModel::buildItemsList()
+{
+   IB_TRACE_SCOPE("model", "buildItemsList");
+
+   this->beginResetModel();
+   this->fillItemsList();
+   this->endResetModel();
+}
+
+/* Fills the section list with the image items according to the section type and sorts it. The similar images are
+   grouped before, if they are the sections. Otherwise the hash tree is dropped, because the image items may have
+   been replaced. If a file name filter is set, only the matching image items are filled in and the others are
+   detached from their former section items. */
+void IBImageListModel::fillItemsList()
+{
+   QList<IBImageListImageItem *>::iterator it;
+   QVariant section;
+
+   if(this->stSectionType == IBImageListModel::SimilarSection)
+   {
+      this->groupSimilarImages();
+   }
+   else
+   {
+      this->htSimilar.clear();
+   }
+
+   this->lstItems->clear();
+
+   if(this->strFileNameFilter.isEmpty())
+   {
+      for(it = this->lstFileData.begin(); it != this->lstFileData.end(); ++it)
+      {
+         section = IBImageListModel::getSectionId(this->stSectionType, *it);
+         this->lstItems->addImageItem(section, (*it));
+      }
+   }
+   else
+   {
+      this->updateFileNameIndex();
+
+      for(it = this->lstFileData.begin(); it != this->lstFileData.end(); ++it)
+      {
+         (*it)->setSection(nullptr, -1);
+      }
+
+      for(int match : this->vecFilteredItems)
+      {
+         section = IBImageListModel::getSectionId(this->stSectionType, this->lstFileData.at(match));
+         this->lstItems->addImageItem(section, this->lstFileData.at(match));
+      }
+   }
+
+   this->lstItems->sortSections(this->soSectionSortOrder);
+   this->lstItems->sortImageItems(this->isfImageSortField, this->soImageSortOrder);
+   this->lstItems->updateMemoryAccounting();
+   this->bThumbnailsChanged = false;
+}
+
+/* Restructures the model like buildItemsList, but keeps the persistent indexes of the image items, so that the
+   selection and the current item survive. The persistent indexes of the section items are invalidated. */
+void IBImageListModel::updateItemsLayout()
+{
+   IB_TRACE_SCOPE("model", "updateItemsLayout");
+   QList<IBImageListAbstractItem *> rawitems;
+   QModelIndexList oldindexes, newindexes;
+   IBImageListAbstractItem *rawitem;
+
+   emit this->layoutAboutToBeChanged();
+
+   oldindexes = this->persistentIndexList();
+   for(const QModelIndex &index : oldindexes)
+   {
+      rawitem = this->getRawItem(index);
+      rawitems.append(rawitem && rawitem->getType() == IBImageListAbstractItem::Image ? rawitem : nullptr);
+   }
+
+   this->fillItemsList();
+
+   for(IBImageListAbstractItem *imageitem : rawitems)
+   {
+      newindexes.append(imageitem ? this->getRawItemIndex(imageitem) : QModelIndex());
+   }
+
+   this->changePersistentIndexList(oldindexes, newindexes);
+   emit this->layoutChanged();
+}
+
+/* Groups the image items, whose perceptual hashes have a Hamming distance of at most the similarity distance, also
+   transitively, and names the group of every item after the first image of the group. Every image is looked up in
+   the hash tree of the preceding images, before it is inserted, so that every pair is compared once. Images
+   without near-duplicates and images without a hash form a group each. */
+void IBImageListModel::groupSimilarImages()
+{
+   IB_TRACE_SCOPE("model", "groupSimilarImages");
+   QVector<int> parents(this->lstFileData.size()), counts(this->lstFileData.size(), 0);
+   IBImageListImageItem *item;
+   int idx, group, other;
+
+   this->htSimilar.clear();
+
+   for(idx = 0; idx < this->lstFileData.size(); idx++)
+   {
+      item = this->lstFileData.at(idx);
+      parents[idx] = idx;
+
+      if(!item->hasPerceptualHash())
+      {
+         continue;
+      }
+
+      for(int match : this->htSimilar.find(item->getPerceptualHash(), this->iSimilarityDistance))
+      {
+         group = findSimilarGroup(parents, idx);
+         other = findSimilarGroup(parents, match);
+         parents[qMax(group, other)] = qMin(group, other);
+      }
+
+      this->htSimilar.insert(item->getPerceptualHash(), idx);
+   }
+
+   for(idx = 0; idx < this->lstFileData.size(); idx++)
+   {
+      counts[findSimilarGroup(parents, idx)]++;
+   }
+
+   for(idx = 0; idx < this->lstFileData.size(); idx++)
+   {
+      item = this->lstFileData.at(idx);
+      group = findSimilarGroup(parents, idx);
+
+      if(!item->hasPerceptualHash())
+      {
+         item->setSimilarGroup(QStringLiteral("Not compared yet"));
+      }
+      else if(counts[group] == 1)
+      {
+         item->setSimilarGroup(QStringLiteral("Unique images"));
+      }
+      else
+      {
+         item->setSimilarGroup(QStringLiteral("Similar to %1").arg(this->lstFileData.at(group)->getName()));
+      }
+   }
+}
+
+/* Returns true, if the hash tree does not contain the perceptual hashes of all image items. */
+bool IBImageListModel::isHashTreeStale() const
+{
+   int count = 0;
+
+   for(IBImageListImageItem *item : this->lstFileData)
+   {
+      count += item->hasPerceptualHash() ? 1 : 0;
+   }
+
+   return count != this->htSimilar.size();
+}
+
+/* Rebuilds the file name index, if the image items were replaced since it was built, and looks up the matches of
+   the filter again. */
+void IBImageListModel::updateFileNameIndex()
+{
+   IB_TRACE_SCOPE("model", "updateFileNameIndex");
+
+   if(!this->bFileNameIndexStale)
+   {
+      return;
+   }
+
+   this->fniNames.clear();
+
+   for(IBImageListImageItem *item : this->lstFileData)
+   {
+      this->fniNames.append(item->getFileName());
+   }
+
+   this->vecFilteredItems = this->strFileNameFilter.isEmpty() ? QVector<int>()
+                                                              : this->fniNames.find(this->strFileNameFilter);
+   this->bFileNameIndexStale = false;
+}
+
+/* Shows the image items of the matches (matches) of the filter (filter) instead of the currently shown ones. The
+   image items, which do not match anymore, are removed from their section items and empty section items are dropped.
+   The new matching image items are merged into the sorted section items, so the shown image items are not sorted
+   again. */
+void IBImageListModel::updateFilteredItems(const QString &filter, const QVector<int> &matches)
+{
+   IB_TRACE_SCOPE("model", "updateFilteredItems");
+   QVector<char> states(this->lstFileData.size(), this->strFileNameFilter.isEmpty() ? 1 : 0);
+   QSet<IBImageListImageItem *> removed;
+   QList<IBImageListImageItem *> added;
+   QVariant section;
+   int idx;
+
+   /* bit 0 marks the shown image items and bit 1 the matching ones */
+   for(int match : this->vecFilteredItems)
+   {
+      states[match] = 1;
+   }
+
+   if(filter.isEmpty())
+   {
+      for(idx = 0; idx < states.size(); idx++)
+      {
+         states[idx] |= 2;
+      }
+   }
+   else
+   {
+      for(int match : matches)
+      {
+         states[match] |= 2;
+      }
+   }
+
+   for(idx = 0; idx < states.size(); idx++)
+   {
+      if(states.at(idx) == 1)
+      {
+         removed.insert(this->lstFileData.at(idx));
+      }
+      else if(states.at(idx) == 2)
+      {
+         added.append(this->lstFileData.at(idx));
+      }
+   }
+
+   if(!removed.isEmpty())
+   {
+      this->lstItems->removeImageItems(removed);
+   }
+
+   for(IBImageListImageItem *item : added)
+   {
+      section = IBImageListModel::getSectionId(this->stSectionType, item);
+      this->lstItems->addImageItem(section, item);
+   }
+
+   this->lstItems->sortSections(this->soSectionSortOrder);
+   this->lstItems->mergeImageItems(this->isfImageSortField, this->soImageSortOrder);
+   this->lstItems->updateMemoryAccounting();
+   this->strFileNameFilter = filter;
+   this->vecFilteredItems = filter.isEmpty() ? QVector<int>() : matches;
+}
+
+/* Adds the image items found by the walker to the model and merges them into the sorted structure. The layout is
+   changed instead of resetting the model, so that the selection and the scroll position are kept. A built file name
+   index is extended by the new items and only the new items, which match the filter, are shown. */
+void IBImageListModel::flushWalkedItems()
+{
+   IB_TRACE_SCOPE("model", "flushWalkedItems");
+   QList<IBImageListImageItem *> items = this->dwWalker->takeItems();
+   QList<IBImageListAbstractItem *> rawitems;
+   QModelIndexList oldindexes, newindexes;
+   QVector<int> positions;
+   QVariant section;
+   int idx;
+
+   this->tmFlush->stop();
+
+   if(items.isEmpty())
+   {
+      return;
+   }
+
+   if(this->lstFileData.isEmpty())
+   {
+      this->lstFileData.swap(items);
+      this->bFileNameIndexStale = true;
+      this->buildItemsList();
+      return;
+   }
+
+   emit this->layoutAboutToBeChanged();
+
+   oldindexes = this->persistentIndexList();
+   for(const QModelIndex &index : oldindexes)
+   {
+      rawitems.append(this->getRawItem(index));
+   }
+
+   if(!this->strFileNameFilter.isEmpty())
+   {
+      this->updateFileNameIndex();
+   }
+
+   if(!this->bFileNameIndexStale)
+   {
+      for(idx = 0; idx < items.size(); idx++)
+      {
+         this->fniNames.append(items.at(idx)->getFileName());
+         positions.append(this->lstFileData.size() + idx);
+      }
+   }
+
+   if(this->strFileNameFilter.isEmpty())
+   {
+      for(IBImageListImageItem *item : items)
+      {
+         section = IBImageListModel::getSectionId(this->stSectionType, item);
+         this->lstItems->addImageItem(section, item);
+      }
+   }
+   else
+   {
+      positions = this->fniNames.find(this->strFileNameFilter, &positions);
+
+      for(int position : positions)
+      {
+         section = IBImageListModel::getSectionId(this->stSectionType, items.at(position - this->lstFileData.size()));
+         this->lstItems->addImageItem(section, items.at(position - this->lstFileData.size()));
+      }
+
+      this->vecFilteredItems += positions;
+   }
+
+   this->lstFileData.append(items);
+   this->lstItems->sortSections(this->soSectionSortOrder);
+   this->lstItems->mergeImageItems(this->isfImageSortField, this->soImageSortOrder);
+   this->lstItems->updateMemoryAccounting();
+
+   for(IBImageListAbstractItem *rawitem : rawitems)
+   {
+      newindexes.append(this->getRawItemIndex(rawitem));
+   }
+
+   this->changePersistentIndexList(oldindexes, newindexes);
+   emit this->layoutChanged();
+}
+
+/* Adds the found image items to the model, if the model is empty, the walker is finished or the found items are at
+   least a quarter of the listed ones. Otherwise they are added by a timer, whose interval grows with the model. So
+   the number of the updates grows only logarithmically with the number of images. */
+void IBImageListModel::onItemsAvailable()
+{
+   int pending = this->dwWalker->getPendingItemCount();
+
+   if(this->lstFileData.isEmpty() || pending >= this->lstFileData.size() / 4 || !this->dwWalker->isRunning())
+   {
+      this->flushWalkedItems();
+   }
+   else if(!this->tmFlush->isActive())
+   {
+      this->tmFlush->start(250 + int(this->lstFileData.size() / 1000));
+   }
+}
+
+/* Adds the remaining image items to the model, after the walker is finished. */
+void IBImageListModel::onWalkFinished()
+{
+   this->flushWalkedItems();
+}
+
+/* Remembers the image item (item) for the loading of its thumbnail in recursive mode, if its thumbnail is neither
+   loaded nor requested yet. It is called by data, so only the thumbnails of the painted items are loaded. */
+void IBImageListModel::requestThumbnail(IBImageListImageItem *item) const
+{
+   if(!this->bRecursive || item->isImageLoaded() || this->stRequested.contains(item))
+   {
+      return;
+   }
+
+   this->lstRequested.append(item);
+   this->stRequested.insert(item);
+
+   if(!this->tmRequest->isActive())
+   {
+      this->tmRequest->start();
+   }
+}
+
+/* Hands the latest requested thumbnails over to the loader, if it is idle. Older requests are dropped, because their
+   items were likely scrolled out of the viewport, and are requested again when they are painted. The slot is invoked
+   again, when the loader is finished. */
+void IBImageListModel::onThumbnailsRequested()
+{
+   int count = int(this->lstRequested.size());
+   int idx;
+
+   if(this->lstRequested.isEmpty() || this->thdThumbLoader->isRunning())
+   {
+      return;
+   }
+
+   for(idx = 0; idx < count - 256; idx++)
+   {
+      this->stRequested.remove(this->lstRequested.at(idx));
+   }
+
+   this->applyLoaderMetadata();
+   this->lstLoading = this->lstRequested.mid(qMax(0, count - 256));
+   this->lstRequested.clear();
+   this->thdThumbLoader->setImageList(&this->lstLoading);
+   this->thdThumbLoader->start();
+}
+
+/* Restructures the model after the loader finished, if thumbnails were loaded and the sections or the sorting depend
+   on the hashes or the colors of the thumbnails. In recursive mode the thumbnails are only loaded on demand, so the
+   structure is only updated, when it is rebuilt. */
+void IBImageListModel::onThumbnailsLoaded()
+{
+   bool dependent = this->stSectionType == IBImageListModel::SimilarSection
+                    || this->stSectionType == IBImageListModel::HueSection
+                    || this->isfImageSortField == IBImageListModel::SortByColor;
+
+   this->applyLoaderMetadata();
+
+   if(dependent && this->bThumbnailsChanged && !this->bRecursive && !this->thdThumbLoader->isRunning())
+   {
+      this->updateItemsLayout();
+   }
+}
+
+/* Restructures the model after the loader read the EXIF metadata of its images, if the sections or the sorting depend
+   on the capture dates. The metadata is read before the thumbnails in this case, so the structure is updated early. */
+void IBImageListModel::onMetadataLoaded()
+{
+   this->applyLoaderMetadata();
+
+   if(this->isCaptureDateDependent() && !this->bRecursive)
+   {
+      this->updateItemsLayout();
+   }
+}
+
+/* Returns true, if the sections or the sorting of the images depend on the capture dates. Otherwise false. */
+bool IBImageListModel::isCaptureDateDependent() const
+{
+   return this->stSectionType == IBImageListModel::CaptureDateSection
+          || this->isfImageSortField == IBImageListModel::SortByCaptureDate;
+}
+
+/* Applies the metadata computed by the loader, converts the integer index (index) of an item of the list of the
+   loader into the corresponding model index and emits the signal itemChanged. */
+void IBImageListModel::onImageLoaded(int index)
+{
+   QList<IBImageListImageItem *> *data = this->thdThumbLoader->getImageList();
+   int lidx;
+
+   this->applyLoaderMetadata();
+
+   /* a queued signal of a stopped loader can refer to a replaced image list */
+   if(!data || index < 0 || index >= data->size())
+   {
+      return;
+   }
+
+   this->bThumbnailsChanged = true;
+   lidx = this->lstItems->getLinearIndexOfItem(data->at(index));
+   emit this->itemChanged(this->index(lidx, 0));
+}
+
+/* Emits the signal directoryModified, if the loader found the current image directory (path) modified since it was
+   enumerated. */
+void IBImageListModel::onDirectoryModified(const QString &path)
+{
+   /* a queued signal can refer to a directory, which is not shown anymore */
+   if(path == this->dirImages.absolutePath())
+   {
+      emit this->directoryModified();
+   }
+}
+
+/* Returns the item object of the given model index (index). If the index does not exist, nullptr is returned. */
+IBImageListAbstractItem *IBImageListModel::getRawItem(const QModelIndex &index)
+{
+   if(!index.isValid())
+   {
+      return nullptr;
+   }
+   
+   return this->lstItems->getItemByLinearIndex(index.row());
+}  
+
+/* Returns the corresponding model index of an item index (item). If the item is not indexed, an invalid model index 
+   is returned. */
+QModelIndex IBImageListModel::getRawItemIndex(IBImageListAbstractItem *item)
+{
+   int lidx = this->lstItems->getLinearIndexOfItem(item);
+   return this->index(lidx, 0);
+}
+
+/* Initializes the structure for the fetching the image data. */
+void IBImageListModel::initImageDir()
+{
+   QString curpath = QDir::currentPath();
+   this->initImageDir(curpath);
+}
+
+/* Initializes the structure for the fetching the image data and loads the directory (imagepath) once. */
+void IBImageListModel::initImageDir(const QString& imagepath)
+{
+   this->dirImages.setNameFilters(IBImageListModel::getImageNameFilters());
+   this->dirImages.setPath(imagepath);
+   this->loadImageData();
+}
+
+/* Returns the name filters of the image files, which are listed by the model. RAW files are listed too, they are
+   displayed by their embedded previews. */
+QStringList IBImageListModel::getImageNameFilters()
+{
+   QStringList namefilters;
+
+   namefilters << "*.bmp" << "*.jpeg" << "*.jpg" << "*.png" << "*.ppm" << "*.tif" << "*.tiff" << "*.xbm" << "*.xpm";
+   namefilters << IBRawPreview::getNameFilters();
+
+   return namefilters;
+}
+
+/* Returns the size of the thumbnails of the image list view. */
+QSize IBImageListModel::getDefaultThumbnailSize()
+{
+   return QSize(232, 130);
+}
+
+/* Initializes the thread for loading the image thumbnails. */
+void IBImageListModel::initThumbnailLoader()
+{
+   this->thdThumbLoader = new IBThumbnailLoader(this);
+   this->thdThumbLoader->setImageList(&this->lstFileData);
+   this->thdThumbLoader->setThumbnailSize(this->szThumbnailSize);
+   this->connect(this->thdThumbLoader, SIGNAL(imageLoaded(int)), SLOT(onImageLoaded(int)));
+   this->connect(this->thdThumbLoader, SIGNAL(metadataLoaded()), SLOT(onMetadataLoaded()));
+   this->connect(this->thdThumbLoader, SIGNAL(directoryModified(const QString &)),
+                 SLOT(onDirectoryModified(const QString &)));
+   this->connect(this->thdThumbLoader, SIGNAL(finished()), SLOT(onThumbnailsRequested()));
+   this->connect(this->thdThumbLoader, SIGNAL(finished()), SLOT(onThumbnailsLoaded()));
+}
+
+/* Initializes the walker and the timers of the recursive mode. */
+void IBImageListModel::initWalker()
+{
+   this->dwWalker = new IBDirectoryWalker(this);
+   this->dwWalker->setNameFilters(IBImageListModel::getImageNameFilters());
+   this->dwWalker->setReaders(qMin(4, QThread::idealThreadCount()));
+   this->connect(this->dwWalker, SIGNAL(itemsAvailable()), SLOT(onItemsAvailable()));
+   this->connect(this->dwWalker, SIGNAL(finished()), SLOT(onWalkFinished()));
+
+   this->tmFlush = new QTimer(this);
+   this->tmFlush->setSingleShot(true);
+   this->connect(this->tmFlush, SIGNAL(timeout()), SLOT(flushWalkedItems()));
+
+   this->tmRequest = new QTimer(this);
+   this->tmRequest->setSingleShot(true);
+   this->tmRequest->setInterval(50);
+   this->connect(this->tmRequest, SIGNAL(timeout()), SLOT(onThumbnailsRequested()));
+}
+
+/* Class IBImageListAbstractItem */
+
+/* Constructs an abstract object of an item for the image list model with the given type of item (itemtype).
+   see IBImageListAbstractItem::ItemType */
+IBImageListAbstractItem::IBImageListAbstractItem(IBImageListAbstractItem::ItemType itemtype)
+   : itType(itemtype)
+{
+}
+
+/* Returns the type of an image list model item. see IBImageListAbstractItem::ItemType */
+IBImageListAbstractItem::ItemType IBImageListAbstractItem::getType() const
+{
+   return this->itType;
+}
+
+/* Returns the type (itemtype) of an image list model item. see IBImageListAbstractItem::ItemType */
+void IBImageListAbstractItem::setType(IBImageListAbstractItem::ItemType itemtype)
+{
+   this->itType = itemtype; 
+} 
+
+/* class IBImageListImageItem */
+
+/* Constructs an empty image data item for the image list model. */
+IBImageListImageItem::IBImageListImageItem()
+   : IBImageListAbstractItem(IBImageListAbstractItem::Image), bImageLoaded(false), bImageFailed(false), iFileSize(0),
+     iInode(0), bProbed(false), iPerceptualHash(0), bPerceptualHash(false), rgbDominantColor(0), iColorKey(INT_MAX),
+     bExifData(false), iCaptureTime(0), iAccountedBytes(0), iAccountedThumbnailBytes(0), secSection(nullptr),
+     iSectionIndex(-1)
+{
+   this->updateMemoryAccounting();
+}
+
+/* Constructs an image data item for the image list model with given file information (info). */
+IBImageListImageItem::IBImageListImageItem(QFileInfo &info)
+   : IBImageListAbstractItem(IBImageListAbstractItem::Image), bImageFailed(false), iFileSize(0), iInode(0),
+     bProbed(false), iPerceptualHash(0), bPerceptualHash(false), rgbDominantColor(0), iColorKey(INT_MAX),
+     bExifData(false), iCaptureTime(0), iAccountedBytes(0), iAccountedThumbnailBytes(0), secSection(nullptr),
+     iSectionIndex(-1)
+{
+   this->load(info);
+}
+
+/* Constructs an image data item for the image list model with the given file path (filepath), the timestamp of the
+   last modification (lastmodified) and the size of the file (filesize) without accessing the file. */
+IBImageListImageItem::IBImageListImageItem(const QString &filepath, const QDateTime &lastmodified, qint64 filesize)
+   : IBImageListAbstractItem(IBImageListAbstractItem::Image), bImageFailed(false), iFileSize(filesize), iInode(0),
+     bProbed(false), iPerceptualHash(0), bPerceptualHash(false), rgbDominantColor(0), iColorKey(INT_MAX),
+     bExifData(false), iCaptureTime(0), iAccountedBytes(0), iAccountedThumbnailBytes(0), secSection(nullptr),
+     iSectionIndex(-1)
+{
+   QFileInfo info(filepath);
+
+   this->strFileName = info.fileName();
+   this->strFileType = info.suffix();
+   this->strFilePath = filepath;
+   this->dtLastModified = lastmodified;
+   this->iCaptureTime = lastmodified.toMSecsSinceEpoch();
+   this->bImageLoaded = false;
+   this->updateMemoryAccounting();
+}
+
+/* Destructs the item and releases its accounted memory. */
+IBImageListImageItem::~IBImageListImageItem()
+{
+   IBMemoryAccounting::resize(IBMemoryAccounting::ModelItems, this->iAccountedBytes, 0);
+   IBMemoryAccounting::resize(IBMemoryAccounting::Thumbnails, this->iAccountedThumbnailBytes, 0);
+}
+
+/* Loads the data of an image data item with the given file information (info). */
+void IBImageListImageItem::load(QFileInfo &info)
+{
+   this->strFileName = info.fileName();
+   this->strFileType = info.suffix();
+   this->strFilePath = info.canonicalFilePath();
+   this->dtLastModified = info.lastModified();
+   this->iFileSize = info.size();
+   this->bImageLoaded = false;
+   this->bImageFailed = false;
+   this->bPerceptualHash = false;
+   this->rgbDominantColor = 0;
+   this->iColorKey = INT_MAX;
+   this->edExif = IBExifData();
+   this->bExifData = false;
+   this->iCaptureTime = this->dtLastModified.toMSecsSinceEpoch();
+   this->updateMemoryAccounting();
+   this->updateThumbnailAccounting();
+}
+
+/* Loads the image data of an item with the given decoder (decoder) and scales it to the given size (thumbsize). 
+   It generates the thumbnail. An up-to-date thumbnail of the cache (cache) is used instead of decoding the image and
+   a decoded thumbnail is stored in the cache. A failed decode of a read file is recorded in the cache too, so that the
+   unchanged file is not decoded again. The perceptual hash and the dominant color of the thumbnail are written to the
+   metadata (metadata) instead of the item, because the model sorts and groups by them, see setMetadata. Returns
+   false, if the image could not be decoded. */
+bool IBImageListImageItem::loadImage(QSize &thumbsize, IBThumbnailDecoder &decoder, const IBThumbnailCache &cache,
+                                     IBImageListMetadata *metadata)
+{
+   QImage thumbnail;
+
+   if(!cache.load(this->strFilePath, this->dtLastModified, thumbsize, &thumbnail, &this->szImageSize))
+   {
+      if(cache.containsFailure(this->strFilePath, this->dtLastModified, this->iFileSize))
+      {
+         this->szImageSize = QSize(0, 0);
+      }
+      else
+      {
+         thumbnail = decoder.decode(this->strFilePath, thumbsize, &this->szImageSize, &this->baFormat);
+
+         /* a file, which could not be read, is neither recorded as broken nor indexed with a size, so that it is
+            decoded again next time */
+         if(thumbnail.isNull() && this->szImageSize.isValid())
+         {
+            cache.storeFailure(this->strFilePath, this->dtLastModified, this->iFileSize);
+         }
+         else if(!thumbnail.isNull())
+         {
+            cache.store(this->strFilePath, this->dtLastModified, thumbsize, thumbnail, this->szImageSize);
+         }
+      }
+   }
+
+   if(!thumbnail.isNull())
+   {
+      metadata->iPerceptualHash = IBImageHash::computeDifferenceHash(thumbnail);
+      metadata->bPerceptualHash = true;
+      metadata->rgbDominantColor = IBImageColor::computeDominantColor(thumbnail);
+   }
+
+   this->pxThumbnail = QPixmap::fromImage(thumbnail);
+   this->bImageLoaded = true;
+   this->bImageFailed = this->pxThumbnail.isNull();
+   this->updateThumbnailAccounting();
+
+   return !this->pxThumbnail.isNull();
+}
+
+/* Reads the EXIF metadata of the image from the start of its file into the buffer (buffer) and writes it to the
+   metadata (metadata). It is marked as read, even if the file has no metadata. */
+void IBImageListImageItem::loadExifData(QByteArray *buffer, IBImageListMetadata *metadata) const
+{
+   IBExifReader::readFile(this->strFilePath, &metadata->edExif, buffer);
+   metadata->bExif = true;
+}
+
+/* Sets the thumbnail (thumbnail) and the original size of the image (imagesize) without loading the image.
+   The item is marked as loaded, without a thumbnail it is marked as failed. */
+void IBImageListImageItem::setThumbnail(const QPixmap &thumbnail, const QSize &imagesize)
+{
+   this->pxThumbnail = thumbnail;
+   this->szImageSize = imagesize;
+   this->bImageLoaded = true;
+   this->bImageFailed = thumbnail.isNull();
+   this->updateThumbnailAccounting();
+}
+
+/* Accounts the current size of the item with its strings in IBMemoryAccounting. */
+void IBImageListImageItem::updateMemoryAccounting()
+{
+   int bytes = int(sizeof(IBImageListImageItem)) + int(sizeof(QChar)) * int(this->strFileName.capacity() 
+               + this->strFileType.capacity() + this->strFilePath.capacity() + this->edExif.strCameraModel.capacity());
+
+   IBMemoryAccounting::resize(IBMemoryAccounting::ModelItems, this->iAccountedBytes, bytes);
+   this->iAccountedBytes = bytes;
+}
+
+/* Accounts the current size of the thumbnail in IBMemoryAccounting. It is separated from updateMemoryAccounting,
+   because the thumbnail is set by the loader, while the metadata of the same item may be set by the model. */
+void IBImageListImageItem::updateThumbnailAccounting()
+{
+   int thumbnailbytes = int(this->getThumbnailBytes());
+
+   IBMemoryAccounting::resize(IBMemoryAccounting::Thumbnails, this->iAccountedThumbnailBytes, thumbnailbytes);
+   this->iAccountedThumbnailBytes = thumbnailbytes;
+}
+
+/* Returns the size of the corresponding file in bytes. */
+qint64 IBImageListImageItem::getFileSize() const
+{
+   return this->iFileSize;
+}
+
+/* Sets the perceptual hash (hash) of the image, e.g. of an item with the same unmodified file. */
+void IBImageListImageItem::setPerceptualHash(quint64 hash)
+{
+   this->iPerceptualHash = hash;
+   this->bPerceptualHash = true;
+}
+
+/* Returns the difference hash of the thumbnail. It is only valid, if hasPerceptualHash returns true. */
+quint64 IBImageListImageItem::getPerceptualHash() const
+{
+   return this->iPerceptualHash;
+}
+
+/* Returns true, if the perceptual hash of the image is computed or taken from the directory index. Otherwise
+   false. */
+bool IBImageListImageItem::hasPerceptualHash() const
+{
+   return this->bPerceptualHash;
+}
+
+/* Sets the name of the group of similar images (group), which contains the item. */
+void IBImageListImageItem::setSimilarGroup(const QString &group)
+{
+   this->strSimilarGroup = group;
+}
+
+/* Returns the name of the group of similar images, which contains the item. */
+QString IBImageListImageItem::getSimilarGroup() const
+{
+   return this->strSimilarGroup;
+}
+
+/* Sets the dominant color (color) of the image and precomputes its key for sorting by color. A color of 0 marks the
+   color as not computed, the items without a color follow the others. */
+void IBImageListImageItem::setDominantColor(QRgb color)
+{
+   this->rgbDominantColor = color;
+   this->iColorKey = color != 0 ? IBImageColor::getSortKey(color) : INT_MAX;
+}
+
+/* Returns the dominant color of the thumbnail. It is only valid, if hasDominantColor returns true. */
+QRgb IBImageListImageItem::getDominantColor() const
+{
+   return this->rgbDominantColor;
+}
+
+/* Returns true, if the dominant color of the image is computed or taken from the directory index. Otherwise
+   false. */
+bool IBImageListImageItem::hasDominantColor() const
+{
+   return this->rgbDominantColor != 0;
+}
+
+/* Returns the key of the dominant color for sorting by color. see IBImageColor::getSortKey */
+int IBImageListImageItem::getColorKey() const
+{
+   return this->iColorKey;
+}
+
+/* Sets the EXIF metadata (exif) of the image, e.g. of an item with the same unmodified file, and marks it as read.
+   The timestamp of the capture for sorting is precomputed, without a capture date it is the timestamp of the last
+   modification. */
+void IBImageListImageItem::setExifData(const IBExifData &exif)
+{
+   this->edExif = exif;
+   this->bExifData = true;
+   this->iCaptureTime = (exif.dtTaken.isValid() ? exif.dtTaken : this->dtLastModified).toMSecsSinceEpoch();
+   this->updateMemoryAccounting();
+}
+
+/* Returns the EXIF metadata of the image. It is only valid, if hasExifData returns true. */
+IBExifData IBImageListImageItem::getExifData() const
+{
+   return this->edExif;
+}
+
+/* Returns true, if the EXIF metadata of the image is read or taken from the directory index, even if the file has
+   none. Otherwise false. */
+bool IBImageListImageItem::hasExifData() const
+{
+   return this->bExifData;
+}
+
+/* Returns the timestamp of the capture of the image. If it is unknown, the timestamp of the last modification of the
+   file is returned. */
+QDateTime IBImageListImageItem::getCaptureDate() const
+{
+   return this->edExif.dtTaken.isValid() ? this->edExif.dtTaken : this->dtLastModified;
+}
+
+/* Returns the timestamp of getCaptureDate in milliseconds since the epoch, it is precomputed for sorting. */
+qint64 IBImageListImageItem::getCaptureTime() const
+{
+   return this->iCaptureTime;
+}
+
+/* Sets the valid parts of the metadata (metadata), which was computed by the thumbnail loader. It is called by the
+   thread, which owns the item, so that the sort keys do not change while the items are sorted. */
+void IBImageListImageItem::setMetadata(const IBImageListMetadata &metadata)
+{
+   if(metadata.bPerceptualHash)
+   {
+      this->setPerceptualHash(metadata.iPerceptualHash);
+   }
+
+   if(metadata.rgbDominantColor != 0)
+   {
+      this->setDominantColor(metadata.rgbDominantColor);
+   }
+
+   if(metadata.bExif)
+   {
+      this->setExifData(metadata.edExif);
+   }
+}
+
+/* Takes the size of the file, its inode, the original size of the image, its format, its perceptual hash, its
+   dominant color and its EXIF metadata from the index entry (entry), so that the image does not have to be probed.
+   The entry has to belong to the unmodified file. */
+void IBImageListImageItem::setIndexEntry(const IBDirectoryIndexEntry &entry)
+{
+   IBExifData exif;
+
+   this->iFileSize = entry.iSize;
+   this->iInode = entry.iInode;
+   this->baFormat = entry.baFormat;
+
+   if(entry.bPerceptualHash)
+   {
+      this->setPerceptualHash(entry.iPerceptualHash);
+   }
+
+   if(entry.rgbDominantColor != 0)
+   {
+      this->setDominantColor(entry.rgbDominantColor);
+   }
+
+   if(entry.bExif)
+   {
+      exif.dtTaken = entry.iTaken != 0 ? QDateTime::fromMSecsSinceEpoch(entry.iTaken) : QDateTime();
+      exif.iOrientation = entry.iOrientation;
+      exif.strCameraModel = entry.strCameraModel;
+      this->setExifData(exif);
+   }
+
+   if(!this->bImageLoaded)
+   {
+      this->szImageSize = entry.szImage;
+   }
+}
+
+/* Returns the index entry of the item. The inode, the format, the perceptual hash, the dominant color and the EXIF
+   metadata are empty, if they are unknown. The valid parts of the given metadata (metadata) are taken instead of
+   the fields of the item, which may be set by the model at the same time. */
+IBDirectoryIndexEntry IBImageListImageItem::getIndexEntry(const IBImageListMetadata *metadata) const
+{
+   IBDirectoryIndexEntry entry;
+   bool hash = metadata && metadata->bPerceptualHash;
+   bool color = metadata && metadata->rgbDominantColor != 0;
+   bool exif = metadata && metadata->bExif;
+   const IBExifData &exifdata = exif ? metadata->edExif : this->edExif;
+
+   entry.strFileName = this->strFileName;
+   entry.iSize = this->iFileSize;
+   entry.iModified = this->dtLastModified.toMSecsSinceEpoch();
+   entry.iInode = this->iInode;
+   entry.szImage = this->szImageSize;
+   entry.baFormat = this->baFormat;
+   entry.iPerceptualHash = hash ? metadata->iPerceptualHash : this->iPerceptualHash;
+   entry.bPerceptualHash = hash || this->bPerceptualHash;
+   entry.rgbDominantColor = color ? metadata->rgbDominantColor : this->rgbDominantColor;
+   entry.bExif = exif || this->bExifData;
+   entry.iTaken = exifdata.dtTaken.isValid() ? exifdata.dtTaken.toMSecsSinceEpoch() : 0;
+   entry.iOrientation = exifdata.iOrientation;
+   entry.strCameraModel = exifdata.strCameraModel;
+
+   return entry;
+}
+
+/* Returns the memory of the thumbnail in bytes. */
+qint64 IBImageListImageItem::getThumbnailBytes() const
+{
+   return qint64(this->pxThumbnail.width()) * this->pxThumbnail.height() * this->pxThumbnail.depth() / 8;
+}
+
+/* Returns the name of item. It is the name of the corresponding file without extension. It is called by every
+   comparison of the sorting, therefore the extension is cut off instead of matched. */
+QString IBImageListImageItem::getName() const
+{
+   if(this->strFileType.isEmpty())
+   {
+      return this->strFileName;
+   }
+
+   return this->strFileName.left(this->strFileName.size() - this->strFileType.size() - 1);
+}
+
+/* Returns the corresponding filename of the item. */
+QString IBImageListImageItem::getFileName() const
+{
+   return this->strFileName;
+}
+
+/* Returns the file type of the corresponding file. It is the extension of the file. */
+QString IBImageListImageItem::getFileType() const
+{
+   return this->strFileType;
+}
+
+/* Returns the path of the corresponding file. */
+QString IBImageListImageItem::getFilePath() const
+{
+   return this->strFilePath;
+}
+
+/* Returns the path of the directory, which contains the corresponding file. */
+QString IBImageListImageItem::getDirectoryPath() const
+{
+   return this->strFilePath.left(this->strFilePath.lastIndexOf(QLatin1Char('/')));
+}
+
+/* Returns the original size of the image. */
+QSize IBImageListImageItem::getImageSize() const
 {
    return this->szImageSize;
 }
@@ -513,31 +1880,61 @@ bool IBImageListImageItem::isImageLoaded() const
    return this->bImageLoaded;
 }
 
+/* Returns true if the image could not be decoded. Otherwise false. */
+bool IBImageListImageItem::isImageFailed() const
+{
+   return this->bImageFailed;
+}
+
+/* Sets the section item (section), which contains the item, and the position (index) of the item in it. It is set by
+   IBImageListSectionList, when its linear indexes are updated. */
+void IBImageListImageItem::setSection(IBImageListSectionItem *section, int index)
+{
+   this->secSection = section;
+   this->iSectionIndex = index;
+}
+
+/* Returns the section item, which contains the item. If the item is not structured yet, nullptr is returned. */
+IBImageListSectionItem *IBImageListImageItem::getSection() const
+{
+   return this->secSection;
+}
+
+/* Returns the position of the item in its section item. */
+int IBImageListImageItem::getSectionIndex() const
+{
+   return this->iSectionIndex;
+}
+
 /* class IBImageListSectionItem */
 
 /* Constructs an section object of the image list model. */ 
 IBImageListSectionItem::IBImageListSectionItem()
-   : QList<IBImageListImageItem *>(), IBImageListAbstractItem(IBImageListAbstractItem::Section)
+   : QList<IBImageListImageItem *>(), IBImageListAbstractItem(IBImageListAbstractItem::Section), iOffset(-1),
+     iSortedSize(0)
 {
 }
 
 /* Constructs an section object of the image list model with the name (itemid) as the type of QVariant. */ 
 IBImageListSectionItem::IBImageListSectionItem(QVariant &itemid)
-   : QList<IBImageListImageItem *>(), IBImageListAbstractItem(IBImageListAbstractItem::Section)
+   : QList<IBImageListImageItem *>(), IBImageListAbstractItem(IBImageListAbstractItem::Section), iOffset(-1),
+     iSortedSize(0)
 {
    this->setItemID(itemid);
 }
 
 /* Constructs an section object of the image list model with the name (itemid) as the type of QString. */
 IBImageListSectionItem::IBImageListSectionItem(QString &itemid)
-   : QList<IBImageListImageItem *>(), IBImageListAbstractItem(IBImageListAbstractItem::Section)
+   : QList<IBImageListImageItem *>(), IBImageListAbstractItem(IBImageListAbstractItem::Section), iOffset(-1),
+     iSortedSize(0)
 {
    this->setItemID(itemid);
 }
 
 /* Constructs an section object of the image list model with the name (itemid) as the type of QDate. */
 IBImageListSectionItem::IBImageListSectionItem(QDate &itemid)
-   : QList<IBImageListImageItem *>(), IBImageListAbstractItem(IBImageListAbstractItem::Section)
+   : QList<IBImageListImageItem *>(), IBImageListAbstractItem(IBImageListAbstractItem::Section), iOffset(-1),
+     iSortedSize(0)
 {
    this->setItemID(itemid);
 }
@@ -561,64 +1958,149 @@ void IBImageListSectionItem::setItemID(QVariant &itemid)
    this->varId = itemid;
 }
 
-/* Sets the name (itemid) of the section item as the type of QString. */
-void IBImageListSectionItem::setItemID(QString &itemid)
-{
-   this->varId = QVariant(itemid);
-}
+/* Sets the name (itemid) of the section item as the type of QString. */
+void IBImageListSectionItem::setItemID(QString &itemid)
+{
+   this->varId = QVariant(itemid);
+}
+
+/* Sets the name (itemid) of the section item as the type of QDate. */
+void IBImageListSectionItem::setItemID(QDate &itemid)
+{
+   this->varId = QVariant(itemid);
+}
+
+/* Returns the name of the section item as a QVariant value. */
+QVariant IBImageListSectionItem::getItemID() const
+{
+   return this->varId;
+}
+
+/* Sorts the images items of the item according to given the field (field) and the order (order). */ 
+void IBImageListSectionItem::sortItems(IBImageListModel::IBImageSortField field, Qt::SortOrder order)
+{
+   std::sort(this->begin(), this->end(), [field, order](IBImageListImageItem *itemA, IBImageListImageItem *itemB)
+     {
+        return IBImageListSectionItem::lessThan(itemA, itemB, field, order);
+     });
+   this->iSortedSize = this->size();
+}
+
+/* Sorts the image items, which were appended since the last sorting, according to the field (field) and the order
+   (order) and merges them into the sorted image items. The field and the order have to be the same as by the last
+   sorting. */
+void IBImageListSectionItem::mergeItems(IBImageListModel::IBImageSortField field, Qt::SortOrder order)
+{
+   auto lessthan = [field, order](IBImageListImageItem *itemA, IBImageListImageItem *itemB)
+     {
+        return IBImageListSectionItem::lessThan(itemA, itemB, field, order);
+     };
+
+   if(this->iSortedSize < this->size())
+   {
+      std::sort(this->begin() + this->iSortedSize, this->end(), lessthan);
+      std::inplace_merge(this->begin(), this->begin() + this->iSortedSize, this->end(), lessthan);
+      this->iSortedSize = this->size();
+   }
+}
+
+/* Removes the image items (items) from the item and detaches them from it. The remaining image items keep their
+   order, so the sorted ones stay sorted. */
+void IBImageListSectionItem::removeItems(const QSet<IBImageListImageItem *> &items)
+{
+   IBImageListImageItem *item;
+   int idx, kept = 0, sorted = 0;
+
+   for(idx = 0; idx < this->size(); idx++)
+   {
+      item = this->at(idx);
+
+      if(items.contains(item))
+      {
+         item->setSection(nullptr, -1);
+      }
+      else
+      {
+         (*this)[kept++] = item;
+         sorted += idx < this->iSortedSize ? 1 : 0;
+      }
+   }
+
+   this->erase(this->begin() + kept, this->end());
+   this->iSortedSize = sorted;
+}
+
+/* Returns true, if the image item (itemA) precedes the image item (itemB) according to the field (field) and the
+   order (order). Otherwise false. */
+bool IBImageListSectionItem::lessThan(IBImageListImageItem *itemA, IBImageListImageItem *itemB,
+                                      IBImageListModel::IBImageSortField field, Qt::SortOrder order)
+{
+   switch(field)
+   {
+      case IBImageListModel::SortByName:
+         if(order ==  Qt::AscendingOrder)
+         {
+            return QString::compare(itemA->getName(), itemB->getName(), Qt::CaseInsensitive) < 0;
+         }
+         else
+         {
+            return QString::compare(itemA->getName(), itemB->getName(), Qt::CaseInsensitive) > 0;
+         }
+
+      case IBImageListModel::SortByDate:
+         if(order ==  Qt::AscendingOrder)
+         {
+            return itemA->getLastModified().date() < itemB->getLastModified().date();
+         }
+         else
+         {
+            return itemA->getLastModified().date() > itemB->getLastModified().date();
+         }
+
+      case IBImageListModel::SortByFileType:
+         if(order ==  Qt::AscendingOrder)
+         {
+            return QString::compare(itemA->getFileType(), itemB->getFileType(), Qt::CaseInsensitive) < 0;
+         }
+         else
+         {
+            return QString::compare(itemA->getFileType(), itemB->getFileType(), Qt::CaseInsensitive) > 0;
+         }
+
+      case IBImageListModel::SortByColor:
+         if(order ==  Qt::AscendingOrder)
+         {
+            return itemA->getColorKey() < itemB->getColorKey();
+         }
+         else
+         {
+            return itemA->getColorKey() > itemB->getColorKey();
+         }
 
-/* Sets the name (itemid) of the section item as the type of QDate. */
-void IBImageListSectionItem::setItemID(QDate &itemid)
-{
-   this->varId = QVariant(itemid);
+      case IBImageListModel::SortByCaptureDate:
+         if(order ==  Qt::AscendingOrder)
+         {
+            return itemA->getCaptureTime() < itemB->getCaptureTime();
+         }
+         else
+         {
+            return itemA->getCaptureTime() > itemB->getCaptureTime();
+         }
+   }
+
+   return false;
 }
 
-/* Returns the name of the section item as a QVariant value. */
-QVariant IBImageListSectionItem::getItemID() const
+/* Sets the linear index (offset) of the section item in its list, -1 if the section item is not shown. */
+void IBImageListSectionItem::setOffset(int offset)
 {
-   return this->varId;
+   this->iOffset = offset;
 }
 
-/* Sorts the images items of the item according to given the field (field) and the order (order). */ 
-void IBImageListSectionItem::sortItems(IBImageListModel::IBImageSortField field, Qt::SortOrder order)
+/* Returns the linear index of the section item in its list, -1 if the section item is not shown. */
+int IBImageListSectionItem::getOffset() const
 {
-   std::sort(this->begin(), this->end(), [field, order](IBImageListImageItem *itemA, IBImageListImageItem *itemB)
-     {
-        switch(field)
-        {
-           case IBImageListModel::SortByName:
-              if(order ==  Qt::AscendingOrder)
-              {
-                 return QString::compare(itemA->getName(), itemB->getName(), Qt::CaseInsensitive) < 0;
-              }
-              else
-              {
-                 return QString::compare(itemA->getName(), itemB->getName(), Qt::CaseInsensitive) > 0;
-              }
-
-           case IBImageListModel::SortByDate:
-              if(order ==  Qt::AscendingOrder)
-              {
-                 return itemA->getLastModified().date() < itemB->getLastModified().date();
-              }
-              else
-              {
-                 return itemA->getLastModified().date() > itemB->getLastModified().date();
-              }
-
-
-           case IBImageListModel::SortByFileType:
-              if(order ==  Qt::AscendingOrder)
-              {
-                 return QString::compare(itemA->getFileType(), itemB->getFileType(), Qt::CaseInsensitive) < 0;
-              }
-              else
-              {
-                 return QString::compare(itemA->getFileType(), itemB->getFileType(), Qt::CaseInsensitive) > 0;
-              }
-        }
-        return false;
-     });
+   return this->iOffset;
 }
 
 /* Returns true if the name of the item is less than the given item (item). Otherwise false is returned. 
@@ -698,33 +2180,26 @@ bool IBImageListSectionItem::operator> (const IBImageListSectionItem &item) noex
 /* Constructs a list object for all model data. */
 
 IBImageListSectionList::IBImageListSectionList()
-  : QList<IBImageListSectionItem *>()
+  : QList<IBImageListSectionItem *>(), iAccountedBytes(0), iAccountedSections(0), iTotalSize(0), bIndexed(false)
 {
 }
 
-/* Adds a given item (item) to a given section item (section). If the section item does not exist, it will be created. */
+/* Adds a given item (item) to a given section item (section). If the section item does not exist, it will be created.
+   The section item is looked up by the string of its name. */
 void IBImageListSectionList::addImageItem(QVariant &section, IBImageListImageItem *item)
 {
-   QList<IBImageListSectionItem *>::iterator it;
-   IBImageListSectionItem *newsec;
-
-   bool found = false;
+   QString key = section.toString();
+   IBImageListSectionItem *sec = this->hshSections.value(key, nullptr);
 
-   for(it = this->begin(); it != this->end() && !found; ++it)
+   if(!sec)
    {
-      if((*it) == section)
-      {
-        (*it)->append(item);
-        found = true;
-      }
+      sec = new IBImageListSectionItem(section);
+      this->append(sec);
+      this->hshSections.insert(key, sec);
    }
 
-   if(!found)
-   {
-      newsec = new IBImageListSectionItem(section);
-      newsec->append(item);
-      this->append(newsec);
-   }  
+   sec->append(item);
+   this->bIndexed = false;
 }
 
 /* Adds a given item (item) to a given section item (section). If the section item does not exist, it will be created. */
@@ -741,150 +2216,228 @@ void IBImageListSectionList::addImageItem(QDate &section, IBImageListImageItem *
    this->addImageItem(sec, item);
 }
 
-/* Return the item of a given index (index). The 2D data list are handled like a 1D list. */ 
+/* Return the item of a given index (index). The 2D data list are handled like a 1D list. The section item is found by
+   a binary search of the linear indexes of the section items. */ 
 IBImageListAbstractItem *IBImageListSectionList::getItemByLinearIndex(int index) const
 {
-   QList<IBImageListSectionItem *>::const_iterator it;
-   IBImageListAbstractItem *retitem = nullptr;
-   int revidx;
+   QVector<int>::const_iterator it;
+   IBImageListSectionItem *section;
+   int relidx;
 
-   if(this->isEmpty() && index < 0)
+   if(this->isEmpty() || index < 0)
    {
       return nullptr;
    }
 
-   if(this->first() == this->last() && this->first()->getName().isEmpty())
+   this->updateIndexes();
+
+   if(this->isHeadless())
    {
-      if(index < this->first()->size())
-      {
-         retitem = this->first()->at(index);
-      }
+      return this->first()->value(index, nullptr);
    }
-   else
-   {
-      revidx = index;
-      for(it = this->begin(); it != this->end() && !retitem; ++it)
-      {
-         if(revidx <= (*it)->size())
-         {
-            if(revidx == 0)
-            {
-               retitem = (*it); 
-            }
-            else
-            {
-               retitem = (*it)->at(revidx - 1);
-            }
-         }
 
-         revidx -= (*it)->size() + 1;
-      }
+   it = std::upper_bound(this->vecOffsets.constBegin(), this->vecOffsets.constEnd(), index);
+   section = this->at(int(it - this->vecOffsets.constBegin()) - 1);
+   relidx = index - section->getOffset();
+
+   if(relidx == 0)
+   {
+      return section;
    }
 
-   return retitem;
+   return section->value(relidx - 1, nullptr);
 }
 
-/* Return the index of a given item (item). The 2D data list are handled like a 1D list. */ 
+/* Return the index of a given item (item). The 2D data list are handled like a 1D list. An image item knows its
+   section item and its position in it, therefore no search is needed. */ 
 int IBImageListSectionList::getLinearIndexOfItem(IBImageListAbstractItem *item) const
 {
-   QList<IBImageListSectionItem *>::const_iterator sit;
-   IBImageListSectionItem::const_iterator iit;
-   int itmidx = 0;
-   
-   if(!item)
+   IBImageListSectionItem *section;
+   IBImageListImageItem *imageitem = nullptr;
+
+   if(!item || this->isEmpty())
    {
       return -1;
    }
- 
-   if(this->first() == this->last() && this->first()->getName().isEmpty())
+
+   this->updateIndexes();
+
+   if(item->getType() == IBImageListAbstractItem::Image)
    {
-      for(iit = this->first()->begin(); iit != this->first()->end(); ++iit)
-      {
-         if((*iit) == item)
-         {
-            return itmidx;
-         }
-         itmidx++;
-       }
+      imageitem = dynamic_cast<IBImageListImageItem *>(item);
+      section = imageitem->getSection();
    }
    else
    {
-      for(sit = this->begin(); sit != this->end(); ++sit)
-      {
-         if((*sit) == item)
-         {
-            return itmidx; 
-         }
-         itmidx++;
+      section = dynamic_cast<IBImageListSectionItem *>(item);
+   }
 
-         for(iit = (*sit)->begin(); iit != (*sit)->end(); ++iit)
-         {
-            if((*iit) == item)
-            {
-               return itmidx;
-            }
-            itmidx++;
-         }
+   /* the item may belong to another list, e.g. of a snapshot */
+   if(!section || this->hshSections.value(section->getItemID().toString(), nullptr) != section)
+   {
+      return -1;
+   }
+
+   if(imageitem)
+   {
+      return section->getOffset() + 1 + imageitem->getSectionIndex();
+   }
+
+   return section->getOffset();
+}
+
+/* Returns true, if the list consists of a single section item with an empty name, which is not shown. */
+bool IBImageListSectionList::isHeadless() const
+{
+   return this->size() == 1 && this->first()->getName().isEmpty();
+}
+
+/* Updates the linear indexes of the section items and the positions of the image items in their section items, if
+   the list was changed since the last update. */
+void IBImageListSectionList::updateIndexes() const
+{
+   bool headless = this->isHeadless();
+   IBImageListSectionItem *section;
+   int sidx, iidx, offset = 0;
+
+   if(this->bIndexed)
+   {
+      return;
+   }
+
+   this->vecOffsets.resize(this->size());
+
+   for(sidx = 0; sidx < this->size(); sidx++)
+   {
+      section = this->at(sidx);
+      section->setOffset(headless ? -1 : offset);
+      this->vecOffsets[sidx] = offset;
+
+      for(iidx = 0; iidx < section->size(); iidx++)
+      {
+         section->at(iidx)->setSection(section, iidx);
       }
+
+      offset += section->size() + (headless ? 0 : 1);
    }
 
-   return -1;
+   this->iTotalSize = offset;
+   this->bIndexed = true;
 }
 
-/* reimpl. */
+/* reimpl. The section items are destroyed, their image items are not. */
 void IBImageListSectionList::clear()
 {
-   QList<IBImageListSectionItem *>::iterator it;
+   qDeleteAll(this->begin(), this->end());
+   QList<IBImageListSectionItem *>::clear();
+   this->hshSections.clear();
+   this->vecOffsets.clear();
+   this->bIndexed = false;
+   this->updateMemoryAccounting();
+}
+
+/* Accounts the current size of the section items, their lists of image items and the index of the section items in
+   IBMemoryAccounting. The lists are estimated by their number of pointers. */
+void IBImageListSectionList::updateMemoryAccounting()
+{
+   QList<IBImageListSectionItem *>::const_iterator it;
+   qint64 bytes = qint64(this->size()) * qint64(sizeof(IBImageListSectionItem *) + sizeof(int)
+                  + sizeof(QString) + sizeof(IBImageListSectionItem *));
 
    for(it = this->begin(); it != this->end(); ++it)
    {
-      (*it)->clear();
+      bytes += qint64(sizeof(IBImageListSectionItem)) + qint64((*it)->size()) * qint64(sizeof(IBImageListImageItem *));
    }
-   QList<IBImageListSectionItem *>::clear();
+
+   IBMemoryAccounting::release(IBMemoryAccounting::SectionLists, this->iAccountedBytes, this->iAccountedSections);
+   IBMemoryAccounting::allocate(IBMemoryAccounting::SectionLists, bytes, this->size());
+   this->iAccountedBytes = bytes;
+   this->iAccountedSections = this->size();
 }
 
 /* Returns the number of section items and its image items. If only one section item exists and 
    its name is empty, then the number of its image items is returned. */
 int IBImageListSectionList::totalSize() const
 {
-   QList<IBImageListSectionItem *>::const_iterator it;
-   int size;
- 
    if(this->isEmpty())
    {
       return 0;
    }
 
-   if(this->first() == this->last() && this->first()->getName().isEmpty())
-   {
-      size = this->first()->size();
-   }
-   else
+   this->updateIndexes();
+
+   return this->iTotalSize;
+}
+
+/* Returns the number of section items. A single section item with an empty name is not counted. */
+int IBImageListSectionList::sectionCount() const
+{
+   if(this->size() == 1 && this->first()->getName().isEmpty())
    {
-      size = this->size();
-      for(it = this->begin(); it != this->end(); ++it)
-      {
-         size += (*it)->size();
-      }
+      return 0;
    }
-   
-   return size;
+
+   return this->size();
 }
 
 /* Invoke the sorting the images items of the section items according to given the field (field) and the order (order). */
 void IBImageListSectionList::sortImageItems(IBImageListModel::IBImageSortField field, Qt::SortOrder order)
 {
+   IB_TRACE_SCOPE("model", "sortImageItems");
    QList<IBImageListSectionItem *>::iterator it;
 
    for(it = this->begin(); it != this->end(); ++it)
    {
       (*it)->sortItems(field, order);
    } 
+
+   this->bIndexed = false;
+}
+
+/* Merges the image items, which were added since the last sorting, into the sorted image items of the section items
+   according to the field (field) and the order (order). see IBImageListSectionItem::mergeItems */
+void IBImageListSectionList::mergeImageItems(IBImageListModel::IBImageSortField field, Qt::SortOrder order)
+{
+   IB_TRACE_SCOPE("model", "mergeImageItems");
+   QList<IBImageListSectionItem *>::iterator it;
+
+   for(it = this->begin(); it != this->end(); ++it)
+   {
+      (*it)->mergeItems(field, order);
+   }
+
+   this->bIndexed = false;
+}
+
+/* Removes the image items (items) from their section items. Section items, which become empty, are destroyed. */
+void IBImageListSectionList::removeImageItems(const QSet<IBImageListImageItem *> &items)
+{
+   IB_TRACE_SCOPE("model", "removeImageItems");
+   QList<IBImageListSectionItem *>::iterator it = this->begin();
+
+   while(it != this->end())
+   {
+      (*it)->removeItems(items);
+
+      if((*it)->isEmpty())
+      {
+         this->hshSections.remove((*it)->getItemID().toString());
+         delete (*it);
+         it = this->erase(it);
+      }
+      else
+      {
+         ++it;
+      }
+   }
+
+   this->bIndexed = false;
 }
 
 /* Sorts the section item according to given the order (order). */
 void IBImageListSectionList::sortSections(Qt::SortOrder order)
 {
+   IB_TRACE_SCOPE("model", "sortSections");
    std::sort(this->begin(), this->end(), [order](IBImageListSectionItem *itemA, IBImageListSectionItem *itemB)
                                              { 
                                                 if(order == Qt::AscendingOrder)
@@ -892,41 +2445,183 @@ void IBImageListSectionList::sortSections(Qt::SortOrder order)
                                                     return (*itemA) < (*itemB); 
                                                 }
                                                 return  (*itemA) > (*itemB);});
+   this->bIndexed = false;
+}
+
+/* struct IBImageListSnapshot */
+
+/* Destructs the snapshot with its image items and their structure. */
+IBImageListSnapshot::~IBImageListSnapshot()
+{
+   if(this->lstItems)
+   {
+      this->lstItems->clear();
+      delete this->lstItems;
+   }
+
+   qDeleteAll(this->lstFileData);
+}
+
+/* Returns the memory of the thumbnails of the snapshot in bytes. */
+qint64 IBImageListSnapshot::getThumbnailBytes() const
+{
+   qint64 bytes = 0;
+
+   for(IBImageListImageItem *item : this->lstFileData)
+   {
+      bytes += item->getThumbnailBytes();
+   }
+
+   return bytes;
 }
 
 /* class IBThumbnailLoader */
 
 /* Constructs the thread for loading the image thumbnails */
 IBThumbnailLoader::IBThumbnailLoader(QObject *parent)
-   : QThread(parent), lstFileData(nullptr), szThumbnailSize(QSize(0,0))
+   : QThread(parent), lstFileData(nullptr), szThumbnailSize(QSize(0,0)), iPending(0), iInFlight(0), iDone(0),
+     iFailed(0), iLoadTime(0), iThumbnailBytes(0), bRevalidateFiles(false), bMetadataFirst(false)
 {
 }
 
 /* Constructs the thread for loading the image thumbnails with size of the thumbnails (thumbsize) and
    the image list (data). */
 IBThumbnailLoader::IBThumbnailLoader(QSize &thumbsize, QList<IBImageListImageItem *> *data, QObject *parent)
-   : QThread(parent), lstFileData(data), szThumbnailSize(thumbsize)
-{
-}
-
-/* Loads the images and invokes the creation of the thumbnail. It is finished, the signal imageLoaded is emitted. */
+   : QThread(parent), lstFileData(data), szThumbnailSize(thumbsize), iPending(0), iInFlight(0), iDone(0),
+     iFailed(0), iLoadTime(0), iThumbnailBytes(0), bRevalidateFiles(false), bMetadataFirst(false)
+{
+}
+
+/* Loads the images and invokes the creation of the thumbnail. It is finished, the signal imageLoaded is emitted.
+   Images, whose thumbnails are already set, are skipped. The EXIF metadata, which is missing, is read for all images
+   after the thumbnails, or before the next image as soon as it is requested by setMetadataFirst, then the signal
+   metadataLoaded is emitted. The hashes, the colors and the EXIF metadata are not written to the images, they are
+   kept for the index and handed over to the model by takeMetadata. A requested interruption stops the loader after
+   the current image. If a directory is set by setRevalidation, it is checked first and the signal directoryModified
+   is emitted, if it was modified since. The timestamps of the images are checked after the last image, if requested.
+   The index set by setIndexing is stored at the start with the listed files, then with the loaded metadata every few
+   seconds, on an interruption and at the end. An index, whose images were taken from the index itself, is only stored
+   after a complete run, because the timestamps of its images are checked at the end. The scratch buffers of the
+   decoder are released after the last image. */
 void IBThumbnailLoader::run()
 {
    QList<IBImageListImageItem *>::iterator it;
-   QPixmap pixtmp;
+   IBImageListImageItem *item;
+   QElapsedTimer timer, storetimer;
+   QString revalidatepath = this->strRevalidatePath;
+   bool revalidatefiles = this->bRevalidateFiles;
+   QString indexpath = this->strIndexPath;
+   QHash<IBImageListImageItem *, IBImageListMetadata> metadata;
+   bool loaded, storing, indexstale, metadataread = false;
+
+   this->resetStatistics();
+   this->strRevalidatePath.clear();
+   this->bRevalidateFiles = false;
+   this->strIndexPath.clear();
+
+   if(!revalidatepath.isEmpty() && QFileInfo(revalidatepath).lastModified() != this->dtRevalidateModified)
+   {
+      emit directoryModified(revalidatepath);
+      revalidatefiles = false;
+   }
 
    if(!this->lstFileData)
    {
       return;
    }
+
+   this->iPending = this->lstFileData->size();
+   storing = !indexpath.isEmpty() && !revalidatefiles;
+
+   /* the listed files are indexed at once without probing them, so that the next listing is skipped even if this run
+      is interrupted */
+   if(storing)
+   {
+      this->storeIndex(indexpath, false, metadata);
+      storetimer.start();
+   }
+
+   indexstale = false;
   
-   for(it = this->lstFileData->begin(); it != this->lstFileData->end(); ++it)
+   for(it = this->lstFileData->begin(); it != this->lstFileData->end() && !this->isInterruptionRequested(); ++it)
    {
-      if((*it)->getType() == IBImageListAbstractItem::Image)
+      /* the structure depends on the capture dates, so the metadata of all images is needed before the thumbnails */
+      if(!metadataread && this->bMetadataFirst)
+      {
+         metadataread = true;
+
+         if(this->loadExifData(&metadata))
+         {
+            indexstale = true;
+
+            if(!this->isInterruptionRequested())
+            {
+               emit metadataLoaded();
+            }
+         }
+      }
+
+      IB_TRACE_COUNTER("thumbnails", "thumbnailsPending", this->lstFileData->end() - it);
+      this->iPending--;
+
+      if((*it)->getType() == IBImageListAbstractItem::Image && !(*it)->isImageLoaded())
       {
-         dynamic_cast<IBImageListImageItem *>(*it)->loadImage(this->szThumbnailSize);
+         IB_TRACE_SCOPE("thumbnails", "loadImage");
+         item = dynamic_cast<IBImageListImageItem *>(*it);
+
+         this->iInFlight++;
+         timer.start();
+         loaded = item->loadImage(this->szThumbnailSize, this->tdDecoder, this->tcCache, &metadata[item]);
+         this->iLoadTime += timer.nsecsElapsed();
+         this->iThumbnailBytes += item->getThumbnailBytes();
+         this->iFailed += loaded ? 0 : 1;
+         this->iDone++;
+         this->iInFlight--;
+         indexstale = true;
+
+         this->publishMetadata(item, metadata.value(item));
          emit imageLoaded(it - this->lstFileData->begin());
       }
+
+      if(storing && indexstale && storetimer.hasExpired(iIndexStoreInterval))
+      {
+         this->storeIndex(indexpath, true, metadata);
+         storetimer.restart();
+         indexstale = false;
+      }
+   }
+
+   if(!metadataread && !this->isInterruptionRequested() && this->loadExifData(&metadata))
+   {
+      indexstale = true;
+
+      if(!this->isInterruptionRequested())
+      {
+         emit metadataLoaded();
+      }
+   }
+
+   /* the scratch buffers are only reused within one image list */
+   this->tdDecoder.releaseScratchBuffers();
+   this->baExifBuffer = QByteArray();
+
+   if(this->isInterruptionRequested())
+   {
+      if(storing && indexstale)
+      {
+         this->storeIndex(indexpath, false, metadata);
+      }
+
+      return;
+   }
+
+   if(revalidatefiles && !this->revalidateFiles())
+   {
+      emit directoryModified(revalidatepath);
+   }
+   else if(!indexpath.isEmpty())
+   {
+      this->storeIndex(indexpath, true, metadata);
    }
 }
 
@@ -953,3 +2648,163 @@ QList<IBImageListImageItem *> *IBThumbnailLoader::getImageList() const
 {
    return this->lstFileData;
 }
+
+/* Returns the current statistics of the loader. It may be called from any thread while the loader is running. */
+IBThumbnailLoaderStatistics IBThumbnailLoader::getStatistics() const
+{
+   IBThumbnailLoaderStatistics stats;
+
+   stats.iPending = this->iPending;
+   stats.iInFlight = this->iInFlight;
+   stats.iDone = this->iDone;
+   stats.iFailed = this->iFailed;
+   stats.iLoadTime = this->iLoadTime;
+   stats.iThumbnailBytes = this->iThumbnailBytes;
+
+   return stats;
+}
+
+/* Sets the directory (path) and its timestamp of the last modification (lastmodified), which are checked once by the
+   next run of the loader. If files is true, the timestamps of the images are checked too, because they were taken
+   from the index of the directory. It must not be called while the loader is running. */
+void IBThumbnailLoader::setRevalidation(const QString &path, const QDateTime &lastmodified, bool files)
+{
+   this->strRevalidatePath = path;
+   this->dtRevalidateModified = lastmodified;
+   this->bRevalidateFiles = files;
+}
+
+/* Sets the directory (path) and its timestamp of the last modification (lastmodified), when it was listed. The index
+   of the directory is stored by the next run of the loader. It must not be called while the loader is running. */
+void IBThumbnailLoader::setIndexing(const QString &path, const QDateTime &lastmodified)
+{
+   this->strIndexPath = path;
+   this->dtIndexModified = lastmodified;
+}
+
+/* Sets, whether the EXIF metadata is read before the thumbnails (first), because the sections or the sorting of the
+   images depend on the capture dates. Otherwise it is read after the thumbnails, so that the first thumbnails are
+   not delayed by reading the start of every file. It may be called while the loader is running. */
+void IBThumbnailLoader::setMetadataFirst(bool first)
+{
+   this->bMetadataFirst = first;
+}
+
+/* Reads the EXIF metadata of the images, which is not known yet, into the metadata of the run (metadata). Only the
+   start of every file is read, so that this pass is much faster than the loading of the thumbnails. Returns true, if
+   the metadata of any image was read. */
+bool IBThumbnailLoader::loadExifData(QHash<IBImageListImageItem *, IBImageListMetadata> *metadata)
+{
+   IB_TRACE_SCOPE("thumbnails", "loadExifData");
+   QList<IBImageListImageItem *>::iterator it;
+   bool loaded = false;
+
+   for(it = this->lstFileData->begin(); it != this->lstFileData->end() && !this->isInterruptionRequested(); ++it)
+   {
+      if(!(*it)->hasExifData())
+      {
+         (*it)->loadExifData(&this->baExifBuffer, &(*metadata)[*it]);
+         this->publishMetadata(*it, metadata->value(*it));
+         loaded = true;
+      }
+   }
+
+   return loaded;
+}
+
+/* Returns true, if the timestamps of the last modification of all images match their files. Otherwise false. */
+bool IBThumbnailLoader::revalidateFiles() const
+{
+   IB_TRACE_SCOPE("thumbnails", "revalidateFiles");
+   QList<IBImageListImageItem *>::const_iterator it;
+
+   for(it = this->lstFileData->constBegin(); it != this->lstFileData->constEnd(); ++it)
+   {
+      if(QFileInfo((*it)->strFilePath).lastModified() != (*it)->dtLastModified)
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/* Stores the index of the directory (path) with the metadata of the images, which is taken from the metadata of the
+   run (metadata) if it was computed by the run. The format of a decoded image is taken from the decoder, the others
+   are taken from the previous index. If probe is true, the missing inodes and formats of new and modified images are
+   probed once from their files, until an interruption is requested. */
+void IBThumbnailLoader::storeIndex(const QString &path, bool probe,
+                                   const QHash<IBImageListImageItem *, IBImageListMetadata> &metadata)
+{
+   IB_TRACE_SCOPE("thumbnails", "storeIndex");
+   QList<IBImageListImageItem *>::iterator it;
+   QHash<IBImageListImageItem *, IBImageListMetadata>::const_iterator found;
+   QList<IBDirectoryIndexEntry> entries;
+   QFile file;
+
+   for(it = this->lstFileData->begin(); it != this->lstFileData->end(); ++it)
+   {
+      probe = probe && !this->isInterruptionRequested();
+
+      if(probe && !(*it)->bProbed)
+      {
+         if((*it)->iInode == 0)
+         {
+            (*it)->iInode = IBDirectoryIndex::getInode((*it)->strFilePath);
+         }
+
+         if((*it)->baFormat.isEmpty())
+         {
+            file.setFileName((*it)->strFilePath);
+
+            if(file.open(QIODevice::ReadOnly))
+            {
+               (*it)->baFormat = IBThumbnailDecoder::sniffFormat(file.peek(64));
+               file.close();
+            }
+         }
+
+         (*it)->bProbed = true;
+      }
+
+      found = metadata.constFind(*it);
+      entries.append((*it)->getIndexEntry(found != metadata.constEnd() ? &found.value() : nullptr));
+   }
+
+   this->diIndex.store(path, this->dtIndexModified, entries);
+}
+
+/* Hands the computed metadata (metadata) of the image (item) over to the model. It replaces metadata of the image,
+   which is not taken yet. */
+void IBThumbnailLoader::publishMetadata(IBImageListImageItem *item, const IBImageListMetadata &metadata)
+{
+   QMutexLocker locker(&this->mtxMetadata);
+
+   this->hshMetadata.insert(item, metadata);
+}
+
+/* Returns the metadata of the images, which was computed since the last call, and forgets it. The model applies it to
+   its images by IBImageListImageItem::setMetadata, so that the hashes, the colors and the capture dates are only
+   written by the GUI thread, which sorts and groups the images by them. It may be called while the loader is
+   running. */
+QHash<IBImageListImageItem *, IBImageListMetadata> IBThumbnailLoader::takeMetadata()
+{
+   QMutexLocker locker(&this->mtxMetadata);
+   QHash<IBImageListImageItem *, IBImageListMetadata> metadata;
+
+   metadata.swap(this->hshMetadata);
+
+   return metadata;
+}
+
+/* Resets the statistics of the loader. It is invoked at the start of a run and, by the model, after a running
+   loader was stopped. */
+void IBThumbnailLoader::resetStatistics()
+{
+   this->iPending = 0;
+   this->iInFlight = 0;
+   this->iDone = 0;
+   this->iFailed = 0;
+   this->iLoadTime = 0;
+   this->iThumbnailBytes = 0;
+}
@@ -8,19 +8,74 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
+#include <QImageReader>
 #include <QList>
+#include <QMutex>
 #include <QPixmap>
 #include <QRegularExpression>
+#include <QSet>
 #include <QSize>
 #include <QThread>
+#include <QTimer>
 #include <QVariant>
+#include <QVector>
+
+#include <atomic>
+#include <climits>
+
+#include "ibdirectoryindex.hpp"
+#include "ibdirectorywalker.hpp"
+#include "ibexifreader.hpp"
+#include "ibfilenameindex.hpp"
+#include "ibimagecolor.hpp"
+#include "ibimagehash.hpp"
+#include "ibmemoryaccounting.hpp"
+#include "ibrawpreview.hpp"
+#include "ibthumbnailcache.hpp"
+#include "ibthumbnaildecoder.hpp"
+#include "ibtrace.hpp"
 
 /* forward definitions of class */
 
 class IBThumbnailLoader;
 class IBImageListAbstractItem;
 class IBImageListImageItem;
+class IBImageListSectionItem;
 class IBImageListSectionList;
+struct IBImageListSnapshot;
+
+/* struct IBThumbnailLoaderStatistics */
+
+struct IBThumbnailLoaderStatistics
+{
+   /* number of images, whose thumbnails are not started yet */
+   qint64 iPending = 0;
+   /* number of images, whose thumbnails are loaded at the moment */
+   qint64 iInFlight = 0;
+   /* number of loaded thumbnails */
+   qint64 iDone = 0;
+   /* number of images, which could not be decoded */
+   qint64 iFailed = 0;
+   /* time of loading the thumbnails in nanoseconds */
+   qint64 iLoadTime = 0;
+   /* memory of the loaded thumbnails in bytes */
+   qint64 iThumbnailBytes = 0;
+};
+
+/* struct IBImageListModelStatistics */
+
+struct IBImageListModelStatistics
+{
+   /* number of image items */
+   qint64 iImages = 0;
+   /* number of named section items */
+   qint64 iSections = 0;
+   /* memory of all thumbnails of the model in bytes */
+   qint64 iThumbnailBytes = 0;
+   /* work of the thumbnail loader */
+   IBThumbnailLoaderStatistics lsLoader;
+};
 
 /* class IBImageListModel */
 
@@ -40,7 +95,13 @@ class IBImageListModel : public QAbstractListModel
          ItemImageSize = Qt::UserRole + 5,
          ItemImageLoaded = Qt::UserRole + 6,
          ItemThumbnail = Qt::UserRole + 7,
-         ItemIsSection = Qt::UserRole + 8
+         ItemIsSection = Qt::UserRole + 8,
+         ItemImageFailed = Qt::UserRole + 9,
+         ItemDominantColor = Qt::UserRole + 10,
+         ItemHue = Qt::UserRole + 11,
+         ItemDateTaken = Qt::UserRole + 12,
+         ItemCameraModel = Qt::UserRole + 13,
+         ItemOrientation = Qt::UserRole + 14
       };
       Q_ENUM(Roles)
 
@@ -49,7 +110,9 @@ class IBImageListModel : public QAbstractListModel
       {
          SortByName,
          SortByDate,
-         SortByFileType
+         SortByFileType,
+         SortByColor,
+         SortByCaptureDate
       };
       Q_ENUM(IBImageSortField)
 
@@ -59,7 +122,11 @@ class IBImageListModel : public QAbstractListModel
          NoSection,
          AlphabeticSection,
          DateSection,
-         FileTypeSection
+         FileTypeSection,
+         FolderSection,
+         SimilarSection,
+         HueSection,
+         CaptureDateSection
       };
       Q_ENUM(IBListSectionType)
       IBImageListModel(QObject * parent = 0);
@@ -78,6 +145,9 @@ class IBImageListModel : public QAbstractListModel
       void setThumbnailSize(QSize& size);
       QSize getThumbnailSize() const;
 
+      void setRecursive(bool recursive);
+      bool isRecursive() const;
+
       QModelIndex setSectionType(const IBImageListModel::IBListSectionType type, const QModelIndex &selected = QModelIndex());
       IBImageListModel::IBListSectionType getSectionType() const;
 
@@ -87,18 +157,45 @@ class IBImageListModel : public QAbstractListModel
       Qt::SortOrder getImageSortOrder() const;
       QModelIndex setImageSortField(IBImageListModel::IBImageSortField field, const QModelIndex &selected = QModelIndex());
       IBImageListModel::IBImageSortField getImageSortField() const;
+      QModelIndex setSimilarityDistance(int distance, const QModelIndex &selected = QModelIndex());
+      int getSimilarityDistance() const;
+
+      QModelIndexList findSimilarImages(const QModelIndex &index, int maxdistance = -1);
+
+      QModelIndex setFileNameFilter(const QString &filter, const QModelIndex &selected = QModelIndex());
+      QString getFileNameFilter() const;
+
+      void setImageItems(const QList<IBImageListImageItem *> &items, bool loadthumbnails = true);
+
+      IBImageListSnapshot *takeSnapshot();
+      void restoreSnapshot(IBImageListSnapshot *snapshot);
+      QModelIndex getImageIndex(const QString &filepath);
+
+      static QVariant getSectionId(IBImageListModel::IBListSectionType type, IBImageListImageItem *item);
+      static QStringList getImageNameFilters();
+      static QSize getDefaultThumbnailSize();
+
+      IBImageListModelStatistics getStatistics() const;
 
    public slots:
       void refresh();
 
    signals:
       void itemChanged(const QModelIndex &index);
+      void directoryModified();
 
    protected:
       void buildItemsList();
 
    protected slots:
       void onImageLoaded(int index);
+      void onDirectoryModified(const QString &path);
+      void onItemsAvailable();
+      void onWalkFinished();
+      void onThumbnailsRequested();
+      void onThumbnailsLoaded();
+      void onMetadataLoaded();
+      void flushWalkedItems();
 
    private:
       Q_DISABLE_COPY(IBImageListModel)
@@ -121,11 +218,56 @@ class IBImageListModel : public QAbstractListModel
       IBImageListModel::IBImageSortField isfImageSortField;
       /* specifies the order of image sorting */
       Qt::SortOrder soImageSortOrder;
+      /* memory of the thumbnails, which were set together with the image items, in bytes */
+      qint64 iPresetThumbnailBytes;
+      /* timestamp of the last modification of the image directory, when it was enumerated */
+      QDateTime dtDirModified;
+      /* metadata of the image directories, which is read instead of the image files */
+      IBDirectoryIndex diIndex;
+      /* is true, if the images of the subdirectories are listed too */
+      bool bRecursive;
+      /* finds the images of the directory and its subdirectories in recursive mode */
+      IBDirectoryWalker *dwWalker;
+      /* adds the found images to the model, if not enough images were found for an immediate update */
+      QTimer *tmFlush;
+      /* hands the requested thumbnails over to the loader in recursive mode */
+      QTimer *tmRequest;
+      /* image items, whose thumbnails were requested by data in recursive mode, the latest request is the last */
+      mutable QList<IBImageListImageItem *> lstRequested;
+      mutable QSet<IBImageListImageItem *> stRequested;
+      /* image items, whose thumbnails are loaded by the loader in recursive mode */
+      QList<IBImageListImageItem *> lstLoading;
+      /* maximal Hamming distance of the perceptual hashes of similar images */
+      int iSimilarityDistance;
+      /* perceptual hashes of the image items with their indexes in lstFileData */
+      IBImageHashTree htSimilar;
+      /* is true, if thumbnails were loaded since the model was structured */
+      bool bThumbnailsChanged;
+      /* file names of the image items by their indexes in lstFileData, it is built when the filter is used first */
+      IBFileNameIndex fniNames;
+      /* is true, if the image items were replaced since the file name index was built */
+      bool bFileNameIndexStale;
+      /* fragment of the file names of the shown image items, empty if all image items are shown */
+      QString strFileNameFilter;
+      /* ascending indexes in lstFileData of the image items, which match the filter */
+      QVector<int> vecFilteredItems;
 
       void initImageDir();
       void initThumbnailLoader();
+      void initWalker();
       void initImageDir(const QString& imagepath);
-      void loadImageData();
+      void loadImageData(bool reusethumbnails = false);
+      void fillItemsList();
+      void updateItemsLayout();
+      void groupSimilarImages();
+      bool isHashTreeStale() const;
+      bool isCaptureDateDependent() const;
+      void updateFileNameIndex();
+      void updateFilteredItems(const QString &filter, const QVector<int> &matches);
+      void stopThumbnailLoader();
+      void applyLoaderMetadata();
+      void stopWalker();
+      void requestThumbnail(IBImageListImageItem *item) const;
       QModelIndex getRawItemIndex(IBImageListAbstractItem *item);
       IBImageListAbstractItem *getRawItem(const QModelIndex &index);
 };
@@ -155,15 +297,32 @@ class IBImageListAbstractItem
       IBImageListAbstractItem::ItemType itType;
 };
 
+/* struct IBImageListMetadata */
+
+struct IBImageListMetadata
+{
+   /* difference hash of the thumbnail, it is valid if bPerceptualHash is true */
+   quint64 iPerceptualHash = 0;
+   bool bPerceptualHash = false;
+   /* dominant color of the thumbnail, 0 if it is not computed */
+   QRgb rgbDominantColor = 0;
+   /* EXIF metadata of the image, it is valid if bExif is true */
+   IBExifData edExif;
+   bool bExif = false;
+};
+
 /* class IBImageListImageItem */
 
 class IBImageListImageItem : public IBImageListAbstractItem
 {
    friend class IBThumbnailLoader;
+   friend class IBDirectoryPrefetcher;
 
    public:
       IBImageListImageItem();
       IBImageListImageItem(QFileInfo &info);
+      IBImageListImageItem(const QString &filepath, const QDateTime &lastmodified, qint64 filesize = 0);
+      ~IBImageListImageItem();
    
       void load(QFileInfo &info);
 
@@ -172,16 +331,51 @@ class IBImageListImageItem : public IBImageListAbstractItem
       QString getFileType() const;
       QString getFilePath() const;
       QVariant getThumbnail() const;
+      QString getDirectoryPath() const;
       QDateTime getLastModified() const;
       QSize getImageSize() const;
       bool isImageLoaded() const;
+      bool isImageFailed() const;
+      void setThumbnail(const QPixmap &thumbnail, const QSize &imagesize);
+      qint64 getThumbnailBytes() const;
+      qint64 getFileSize() const;
+
+      void setPerceptualHash(quint64 hash);
+      quint64 getPerceptualHash() const;
+      bool hasPerceptualHash() const;
+      void setSimilarGroup(const QString &group);
+      QString getSimilarGroup() const;
+      void setDominantColor(QRgb color);
+      QRgb getDominantColor() const;
+      bool hasDominantColor() const;
+      int getColorKey() const;
+      void setExifData(const IBExifData &exif);
+      IBExifData getExifData() const;
+      bool hasExifData() const;
+      QDateTime getCaptureDate() const;
+      qint64 getCaptureTime() const;
+      void setMetadata(const IBImageListMetadata &metadata);
+
+      void setIndexEntry(const IBDirectoryIndexEntry &entry);
+      IBDirectoryIndexEntry getIndexEntry(const IBImageListMetadata *metadata = nullptr) const;
+
+      void setSection(IBImageListSectionItem *section, int index);
+      IBImageListSectionItem *getSection() const;
+      int getSectionIndex() const;
 
    protected:
-      void loadImage(QSize &thumbsize);
+      bool loadImage(QSize &thumbsize, IBThumbnailDecoder &decoder, const IBThumbnailCache &cache,
+                     IBImageListMetadata *metadata);
+      void loadExifData(QByteArray *buffer, IBImageListMetadata *metadata) const;
 
    private:
+      void updateMemoryAccounting();
+      void updateThumbnailAccounting();
+
       /* is true if thumbnail is loaded successfully */
       bool bImageLoaded;
+      /* is true if the image could not be decoded, the item is loaded without a thumbnail then */
+      bool bImageFailed;
       /* contains the name of the corresponding file */
       QString strFileName;
       /* contains the extension of the corresponding file */
@@ -194,6 +388,34 @@ class IBImageListImageItem : public IBImageListAbstractItem
       QSize szImageSize;
       /* contains the timestamp of the last modification of the corresponding file */
       QDateTime dtLastModified;
+      /* size of the corresponding file in bytes */
+      qint64 iFileSize;
+      /* inode of the corresponding file, 0 if it is unknown */
+      quint64 iInode;
+      /* format of the image as detected from its content, empty if it is unknown */
+      QByteArray baFormat;
+      /* is true, if the inode and the format were probed for the index, even if the format is unknown */
+      bool bProbed;
+      /* difference hash of the thumbnail, it is valid if bPerceptualHash is true */
+      quint64 iPerceptualHash;
+      bool bPerceptualHash;
+      /* name of the group of similar images, which contains the item */
+      QString strSimilarGroup;
+      /* dominant color of the thumbnail, 0 if it is not computed */
+      QRgb rgbDominantColor;
+      /* precomputed key of the dominant color for sorting by color */
+      int iColorKey;
+      /* EXIF metadata of the image, it is valid if bExifData is true */
+      IBExifData edExif;
+      bool bExifData;
+      /* timestamp of the capture or, if it is unknown, of the last modification in milliseconds since the epoch */
+      qint64 iCaptureTime;
+      /* bytes of the item and of its thumbnail, which are accounted in IBMemoryAccounting */
+      int iAccountedBytes;
+      int iAccountedThumbnailBytes;
+      /* section item, which contains the item, and the position of the item in it */
+      IBImageListSectionItem *secSection;
+      int iSectionIndex;
 };
 
 /* class IBImageListSectionItem */
@@ -215,6 +437,15 @@ class IBImageListSectionItem : public QList<IBImageListImageItem *>, public IBIm
 
       void sortItems(IBImageListModel::IBImageSortField field = IBImageListModel::SortByName,  
                      Qt::SortOrder order = Qt::AscendingOrder);
+      void mergeItems(IBImageListModel::IBImageSortField field = IBImageListModel::SortByName,
+                      Qt::SortOrder order = Qt::AscendingOrder);
+      void removeItems(const QSet<IBImageListImageItem *> &items);
+
+      void setOffset(int offset);
+      int getOffset() const;
+
+      static bool lessThan(IBImageListImageItem *itemA, IBImageListImageItem *itemB,
+                           IBImageListModel::IBImageSortField field, Qt::SortOrder order);
 
       /*operator <*/
       bool operator< (const IBImageListSectionItem &item) noexcept(false);
@@ -254,6 +485,10 @@ class IBImageListSectionItem : public QList<IBImageListImageItem *>, public IBIm
    private:
       /* contains the name of the section items */
       QVariant varId;
+      /* linear index of the section item in its list, -1 if the section item is not shown */
+      int iOffset;
+      /* number of image items at the begin, which are sorted */
+      int iSortedSize;
 };
 
 /* class IBImageListSectionList */
@@ -270,9 +505,60 @@ class IBImageListSectionList : QList<IBImageListSectionItem *>
       int getLinearIndexOfItem(IBImageListAbstractItem *item) const;
       void clear();
       int totalSize() const;
+      int sectionCount() const;
       void sortImageItems(IBImageListModel::IBImageSortField field = IBImageListModel::SortByName,  
                           Qt::SortOrder order = Qt::AscendingOrder);
       void sortSections(Qt::SortOrder order = Qt::AscendingOrder);
+      void mergeImageItems(IBImageListModel::IBImageSortField field = IBImageListModel::SortByName,
+                           Qt::SortOrder order = Qt::AscendingOrder);
+      void removeImageItems(const QSet<IBImageListImageItem *> &items);
+      void updateMemoryAccounting();
+
+   private:
+      bool isHeadless() const;
+      void updateIndexes() const;
+
+      /* bytes and section items, which are accounted in IBMemoryAccounting */
+      qint64 iAccountedBytes;
+      qint64 iAccountedSections;
+      /* section items by the string of their names */
+      QHash<QString, IBImageListSectionItem *> hshSections;
+      /* linear indexes of the section items, they are updated lazily after the list was changed */
+      mutable QVector<int> vecOffsets;
+      /* number of linear indexes */
+      mutable int iTotalSize;
+      /* is true, if vecOffsets, the offsets of the section items and the positions of the image items are valid */
+      mutable bool bIndexed;
+};
+
+/* struct IBImageListSnapshot */
+
+struct IBImageListSnapshot
+{
+   IBImageListSnapshot() = default;
+   ~IBImageListSnapshot();
+   Q_DISABLE_COPY(IBImageListSnapshot)
+
+   qint64 getThumbnailBytes() const;
+
+   /* path of the image directory */
+   QString strPath;
+   /* timestamp of the last modification of the image directory, when it was enumerated */
+   QDateTime dtModified;
+   /* image items of the directory, which are owned by the snapshot */
+   QList<IBImageListImageItem *> lstFileData;
+   /* structured image items, nullptr if the structure was not kept */
+   IBImageListSectionList *lstItems = nullptr;
+   /* sort, section and filter state, which lstItems was structured with */
+   IBImageListModel::IBListSectionType stSectionType = IBImageListModel::NoSection;
+   Qt::SortOrder soSectionSortOrder = Qt::AscendingOrder;
+   IBImageListModel::IBImageSortField isfImageSortField = IBImageListModel::SortByName;
+   Qt::SortOrder soImageSortOrder = Qt::AscendingOrder;
+   QString strFileNameFilter;
+   /* position of the vertical scroll bar of the view */
+   int iScrollValue = 0;
+   /* path of the selected image, empty if no image was selected */
+   QString strSelectedPath;
 };
 
 /* class IBThumbnailLoader */
@@ -293,14 +579,53 @@ class IBThumbnailLoader : public QThread
      void setImageList(QList<IBImageListImageItem *> *data);
      QList<IBImageListImageItem *> *getImageList() const;
 
+     IBThumbnailLoaderStatistics getStatistics() const;
+     void resetStatistics();
+
+     void setRevalidation(const QString &path, const QDateTime &lastmodified, bool files = false);
+     void setIndexing(const QString &path, const QDateTime &lastmodified);
+     void setMetadataFirst(bool first);
+     QHash<IBImageListImageItem *, IBImageListMetadata> takeMetadata();
+
    signals:
       void imageLoaded(int index);
+      void metadataLoaded();
+      void directoryModified(const QString &path);
 
    private:
      /* represents a pointer to file data list to be handled */
      QList<IBImageListImageItem *> *lstFileData;
      /* size of the thumbnails */
      QSize szThumbnailSize;
+     /* decodes and scales the images */
+     IBThumbnailDecoder tdDecoder;
+     /* persistent thumbnails, which are shared with the batch generation */
+     IBThumbnailCache tcCache;
+     /* counters of IBThumbnailLoaderStatistics, they are written by the thread and read by the GUI */
+     std::atomic<qint64> iPending, iInFlight, iDone, iFailed, iLoadTime, iThumbnailBytes;
+     /* directory and its timestamp of the last modification, which are revalidated by the next run */
+     QString strRevalidatePath;
+     QDateTime dtRevalidateModified;
+     /* is true, if the timestamps of the images are revalidated by the next run too */
+     bool bRevalidateFiles;
+     /* is true, if the EXIF metadata is read before the thumbnails, it may be set while the thread is running */
+     std::atomic<bool> bMetadataFirst;
+     /* directory and its timestamp of the last modification, whose index is stored by the next run */
+     QString strIndexPath;
+     QDateTime dtIndexModified;
+     /* stores the metadata of the directory */
+     IBDirectoryIndex diIndex;
+     /* reusable buffer of the start of the files, whose EXIF metadata is read */
+     QByteArray baExifBuffer;
+     /* computed metadata of the images, which is not taken by the model yet, it is guarded by mtxMetadata */
+     QHash<IBImageListImageItem *, IBImageListMetadata> hshMetadata;
+     QMutex mtxMetadata;
+
+     bool loadExifData(QHash<IBImageListImageItem *, IBImageListMetadata> *metadata);
+     bool revalidateFiles() const;
+     void storeIndex(const QString &path, bool probe,
+                     const QHash<IBImageListImageItem *, IBImageListMetadata> &metadata);
+     void publishMetadata(IBImageListImageItem *item, const IBImageListMetadata &metadata);
 };
 
 
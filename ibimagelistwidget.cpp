@@ -3,12 +3,20 @@
 
 #include "ibimagelistwidget.hpp"
 
-/* Constructs the image list view with its item delegate and list model. */
+/* Constructs the image list view with its item delegate and list model on the current directory. */
 IBImageListWidget::IBImageListWidget(QWidget *parent)
-   : QListView(parent)
+   : IBImageListWidget(QDir::currentPath(), parent)
 {
-   QSize thumbsize(232,130);
-   QString path = QDir::currentPath();
+}
+
+/* Constructs the image list view with its item delegate and list model on the given directory (imagepath). 
+   The directory is loaded once by the construction. */
+IBImageListWidget::IBImageListWidget(const QString &imagepath, QWidget *parent)
+   : QListView(parent), bOverlayVisible(false), vecFrameTimes(64, -1), iFrameIndex(0), iVisibleItems(0),
+     bFirstFramePainted(false), bFirstThumbnailPainted(false)
+{
+   QSize thumbsize = IBImageListModel::getDefaultThumbnailSize();
+   QString path = imagepath;
 
    this->setResizeMode(QListView::Adjust);
    this->setViewMode(QListView::IconMode);
@@ -19,8 +27,173 @@ IBImageListWidget::IBImageListWidget(QWidget *parent)
    this->ifmImageModel = new IBImageListModel(path, thumbsize);
    this->ifmImageModel->setSectionType(IBImageListModel::NoSection);
    this->connect(this->ifmImageModel, SIGNAL(itemChanged(const QModelIndex &)), SLOT(update(const QModelIndex &)));
+   this->connect(this->ifmImageModel, SIGNAL(directoryModified()), SLOT(onDirectoryModified()));
 
    this->setModel(ifmImageModel);
+
+   this->tmOverlay = new QTimer(this);
+   this->tmOverlay->setInterval(500);
+   this->connect(this->tmOverlay, SIGNAL(timeout()), SLOT(onOverlayTimeout()));
+
+   /* 64 MiB of snapshots */
+   this->chSnapshots.setMaxCost(64 * 1024);
+
+   this->dpfPrefetcher = new IBDirectoryPrefetcher(this);
+   this->dpfPrefetcher->setThumbnailSize(thumbsize);
+
+   this->tmPrefetch = new QTimer(this);
+   this->tmPrefetch->setSingleShot(true);
+   this->tmPrefetch->setInterval(1000);
+   this->connect(this->tmPrefetch, SIGNAL(timeout()), SLOT(onPrefetchTimeout()));
+}
+
+/* Paints the visible items and measures the paint time of the frame. If the performance overlay is shown, it is 
+   painted on top of the items. Paint events, which only refresh the overlay, do not paint any items and are not
+   counted as frames. The signals firstFramePainted and firstThumbnailPainted are emitted once. */
+void IBImageListWidget::paintEvent(QPaintEvent *event)
+{
+   IB_TRACE_SCOPE("paint", "paintEvent");
+   QElapsedTimer timer;
+
+   if(!this->bOverlayVisible || this->rctOverlay.isEmpty() || !this->rctOverlay.contains(event->rect()))
+   {
+      this->idDelegate->beginFrame();
+      timer.start();
+
+      QListView::paintEvent(event);
+
+      this->vecFrameTimes[this->iFrameIndex] = timer.nsecsElapsed();
+      this->iFrameIndex = (this->iFrameIndex + 1) % int(this->vecFrameTimes.size());
+      this->dsLastFrame = this->idDelegate->getStatistics();
+
+      if(event->rect().contains(this->viewport()->rect()))
+      {
+         this->iVisibleItems = this->dsLastFrame.iFrameItems;
+      }
+
+      if(!this->bFirstFramePainted)
+      {
+         this->bFirstFramePainted = true;
+         emit this->firstFramePainted();
+      }
+
+      if(!this->bFirstThumbnailPainted && this->dsLastFrame.iFrameThumbnails > 0)
+      {
+         this->bFirstThumbnailPainted = true;
+         emit this->firstThumbnailPainted();
+      }
+   }
+
+   if(this->bOverlayVisible)
+   {
+      this->paintOverlay();
+   }
+}
+
+/* Paints the performance overlay in the top right corner of the viewport. It shows the paint time of the frames, 
+   the visible and painted items, the progress and the throughput of the thumbnail loader and the memory of the
+   thumbnails. */
+void IBImageListWidget::paintOverlay()
+{
+   IBImageListModelStatistics modelstats = this->ifmImageModel->getStatistics();
+   QPainter painter(this->viewport());
+   QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+   QStringList lines;
+   QRect textrect, overlayrect;
+   qint64 lastframe, sumframes = 0, maxframe = 0;
+   int frames = 0, frameslots = int(this->vecFrameTimes.size());
+   double throughput;
+
+   for(qint64 frametime : this->vecFrameTimes)
+   {
+      if(frametime >= 0)
+      {
+         sumframes += frametime;
+         maxframe = qMax(maxframe, frametime);
+         frames++;
+      }
+   }
+
+   lastframe = this->vecFrameTimes[(this->iFrameIndex + frameslots - 1) % frameslots];
+   throughput = modelstats.lsLoader.iLoadTime > 0 
+                ? modelstats.lsLoader.iDone * 1e9 / modelstats.lsLoader.iLoadTime : 0.0;
+
+   lines << QString("frame:      %1 ms (avg %2 ms, max %3 ms)")
+               .arg(qMax<qint64>(0, lastframe) / 1e6, 0, 'f', 2)
+               .arg(frames > 0 ? sumframes / 1e6 / frames : 0.0, 0, 'f', 2)
+               .arg(maxframe / 1e6, 0, 'f', 2);
+   lines << QString("items:      %1 visible, %2 painted")
+               .arg(this->iVisibleItems).arg(this->dsLastFrame.iFrameItems);
+   lines << QString("thumbnails: %1 pending, %2 in flight, %3 done, %4 failed")
+               .arg(modelstats.lsLoader.iPending).arg(modelstats.lsLoader.iInFlight)
+               .arg(modelstats.lsLoader.iDone).arg(modelstats.lsLoader.iFailed);
+   lines << QString("decode:     %1 images/s").arg(throughput, 0, 'f', 1);
+   lines << QString("memory:     %1 MiB thumbnails").arg(modelstats.iThumbnailBytes / 1048576.0, 0, 'f', 1);
+   lines << QString("model:      %1 images, %2 sections").arg(modelstats.iImages).arg(modelstats.iSections);
+
+   painter.setFont(font);
+   textrect = painter.fontMetrics().boundingRect(QRect(), Qt::AlignLeft | Qt::AlignTop, lines.join('\n'));
+   overlayrect = QRect(0, 0, textrect.width() + 16, textrect.height() + 12);
+   overlayrect.moveTopRight(this->viewport()->rect().topRight() + QPoint(-8, 8));
+
+   /* the area of a grown or shrunk overlay is repainted with the items */
+   if(overlayrect != this->rctOverlay)
+   {
+      this->viewport()->update(QRegion(this->rctOverlay).united(overlayrect));
+      this->rctOverlay = overlayrect;
+   }
+
+   painter.fillRect(overlayrect, QColor(32, 32, 32));
+   painter.setPen(QColor(230, 230, 230));
+   painter.drawText(overlayrect - QMargins(8, 6, 8, 6), Qt::AlignLeft | Qt::AlignTop, lines.join('\n'));
+}
+
+/* Repaints the performance overlay. */
+void IBImageListWidget::onOverlayTimeout()
+{
+   this->viewport()->update(this->rctOverlay);
+}
+
+/* Shows or hides the performance overlay (visible). While it is shown, it is refreshed twice per second. */
+void IBImageListWidget::setOverlayVisible(bool visible)
+{
+   if(this->bOverlayVisible == visible)
+   {
+      return;
+   }
+
+   this->bOverlayVisible = visible;
+   this->rctOverlay = QRect();
+
+   if(visible)
+   {
+      this->tmOverlay->start();
+   }
+   else
+   {
+      this->tmOverlay->stop();
+   }
+
+   this->viewport()->update();
+}
+
+/* Returns true, if the performance overlay is shown. */
+bool IBImageListWidget::isOverlayVisible() const
+{
+   return this->bOverlayVisible;
+}
+
+/* Scrolls the content of the viewport by dx and dy. The performance overlay is moved with the content, 
+   therefore its moved and its original area are repainted. The prefetcher yields to the scrolling. */
+void IBImageListWidget::scrollContentsBy(int dx, int dy)
+{
+   this->yieldPrefetch();
+   QListView::scrollContentsBy(dx, dy);
+
+   if(this->bOverlayVisible)
+   {
+      this->viewport()->update(QRegion(this->rctOverlay.translated(dx, dy)).united(this->rctOverlay));
+   }
 }
 
 /* Changes the visible size of the item delegate for the section items. */ 
@@ -37,10 +210,168 @@ void IBImageListWidget::refresh()
    this->ifmImageModel->refresh();
 }
 
-/* Sets a path (path) for the list model. */
+/* Sets a path (path) for the list model. The current directory is kept as a snapshot together with the scroll
+   position and the selected image. A snapshot or a prefetched snapshot of the new directory is restored immediately
+   and revalidated in the background, otherwise the directory is loaded. In recursive mode the directory is always
+   loaded. */
 void IBImageListWidget::setImagePath(const QString &path)
 {
-   this->ifmImageModel->setImagePath(path);
+   IBImageListSnapshot *snapshot;
+
+   if(QDir::cleanPath(path) == this->ifmImageModel->getImagePath())
+   {
+      return;
+   }
+
+   this->yieldPrefetch();
+
+   if(this->ifmImageModel->isRecursive())
+   {
+      this->ifmImageModel->setImagePath(path);
+      return;
+   }
+
+   this->storeSnapshot();
+   snapshot = this->chSnapshots.take(QDir::cleanPath(path));
+
+   if(!snapshot)
+   {
+      snapshot = this->dpfPrefetcher->takeSnapshot(path);
+   }
+
+   if(snapshot)
+   {
+      this->restoreSnapshot(snapshot);
+   }
+   else
+   {
+      this->ifmImageModel->setImagePath(path);
+   }
+}
+
+/* Keeps the current directory of the list model with the scroll position and the selected image in the cache of
+   snapshots. Its cost are the thumbnails and about 512 bytes per image item. Empty directories and directories
+   with their subdirectories are not kept. */
+void IBImageListWidget::storeSnapshot()
+{
+   IBImageListSnapshot *snapshot;
+   QModelIndex selidx = this->selectionModel()->currentIndex();
+   QString selpath = this->ifmImageModel->data(selidx, IBImageListModel::ItemFilePath).toString();
+   int scrollvalue = this->verticalScrollBar()->value();
+   qint64 cost;
+
+   if(this->ifmImageModel->rowCount() == 0 || this->ifmImageModel->isRecursive())
+   {
+      return;
+   }
+
+   snapshot = this->ifmImageModel->takeSnapshot();
+   snapshot->iScrollValue = scrollvalue;
+   snapshot->strSelectedPath = selpath;
+   cost = (snapshot->getThumbnailBytes() + qint64(snapshot->lstFileData.size()) * 512) / 1024 + 1;
+
+   this->chSnapshots.insert(QDir::cleanPath(snapshot->strPath), snapshot, int(cost));
+}
+
+/* Restores the directory of the snapshot (snapshot) in the list model together with its scroll position and its
+   selected image. The snapshot is destroyed. */
+void IBImageListWidget::restoreSnapshot(IBImageListSnapshot *snapshot)
+{
+   int scrollvalue = snapshot->iScrollValue;
+   QString selpath = snapshot->strSelectedPath;
+
+   this->ifmImageModel->restoreSnapshot(snapshot);
+   this->restoreViewState(scrollvalue, selpath);
+}
+
+/* Lays out the items at once and restores the selected image (selectedpath) and the position of the vertical scroll
+   bar (scrollvalue). */
+void IBImageListWidget::restoreViewState(int scrollvalue, const QString &selectedpath)
+{
+   QModelIndex selidx;
+
+   this->doItemsLayout();
+
+   if(!selectedpath.isEmpty())
+   {
+      selidx = this->ifmImageModel->getImageIndex(selectedpath);
+
+      if(selidx.isValid())
+      {
+         this->setCurrentIndex(selidx);
+      }
+   }
+
+   this->verticalScrollBar()->setValue(scrollvalue);
+}
+
+/* Sets the likely next directories (paths) ordered by priority. They and the nearest siblings of the current
+   directory are prefetched, when the view was idle for a second. */
+void IBImageListWidget::setPrefetchCandidates(const QStringList &paths)
+{
+   this->slPrefetchCandidates = paths;
+   this->tmPrefetch->start();
+}
+
+/* Lets the prefetcher yield to an action of the user and postpones the prefetching, until the view is idle again. */
+void IBImageListWidget::yieldPrefetch()
+{
+   this->dpfPrefetcher->yield();
+
+   if(this->tmPrefetch->isActive() || !this->slPrefetchCandidates.isEmpty())
+   {
+      this->tmPrefetch->start();
+   }
+}
+
+/* Starts the prefetching of the candidates and the siblings of the current directory, if the thumbnails of the
+   current directory are loaded. Otherwise the prefetching is postponed. The directories with a snapshot are skipped.
+   In recursive mode nothing is prefetched, because the prefetched directories do not contain their subdirectories. */
+void IBImageListWidget::onPrefetchTimeout()
+{
+   IBThumbnailLoaderStatistics loaderstats = this->ifmImageModel->getStatistics().lsLoader;
+
+   if(this->ifmImageModel->isRecursive())
+   {
+      return;
+   }
+
+   if(loaderstats.iPending > 0 || loaderstats.iInFlight > 0)
+   {
+      this->tmPrefetch->start();
+      return;
+   }
+
+   this->dpfPrefetcher->prefetch(this->slPrefetchCandidates, this->ifmImageModel->getImagePath(),
+                                 this->chSnapshots.keys() << this->ifmImageModel->getImagePath());
+}
+
+/* Reloads the directory, which was modified since its snapshot was taken, and keeps the scroll position and the
+   selected image. */
+void IBImageListWidget::onDirectoryModified()
+{
+   QModelIndex selidx = this->selectionModel()->currentIndex();
+   QString selpath = this->ifmImageModel->data(selidx, IBImageListModel::ItemFilePath).toString();
+   int scrollvalue = this->verticalScrollBar()->value();
+
+   this->ifmImageModel->refresh();
+   this->restoreViewState(scrollvalue, selpath);
+}
+
+/* Sets, whether the images of the subdirectories are listed too (recursive). In recursive mode the items are laid
+   out in batches, so that the view stays responsive with a huge number of images. */
+void IBImageListWidget::setRecursive(bool recursive)
+{
+   this->yieldPrefetch();
+   this->setLayoutMode(recursive ? QListView::Batched : QListView::SinglePass);
+   this->setBatchSize(1000);
+   this->ifmImageModel->setRecursive(recursive);
+}
+
+/* Returns true, if the images of the subdirectories are listed too. Otherwise false. */
+bool IBImageListWidget::isRecursive() const
+{
+   return this->ifmImageModel->isRecursive();
 }
 
 /* Returns the image path of the list model. */
@@ -49,6 +380,33 @@ QString IBImageListWidget::getImagePath() const
    return this->ifmImageModel->getImagePath();
 }
 
+/* Returns the file paths of up to count image items next to the given index (index) in the current sort order. 
+   The items are collected in the direction of step (1 = following items, -1 = preceding items) and 
+   section items are skipped. */
+QStringList IBImageListWidget::getNeighbourImagePaths(const QModelIndex &index, int step, int count) const
+{
+   QStringList paths;
+   QModelIndex hidx;
+   int row;
+
+   if(!index.isValid() || step == 0)
+   {
+      return paths;
+   }
+
+   for(row = index.row() + step; row >= 0 && row < this->ifmImageModel->rowCount() && paths.size() < count; row += step)
+   {
+      hidx = this->ifmImageModel->index(row, 0);
+
+      if(!this->ifmImageModel->data(hidx, IBImageListModel::ItemIsSection).toBool())
+      {
+         paths.append(this->ifmImageModel->data(hidx, IBImageListModel::ItemFilePath).toString());
+      }
+   }
+
+   return paths;
+}
+
 /* Sets a section type (type) for the list model and reselect the currently selected item. */ 
 void IBImageListWidget::setSectionType(IBImageListModel::IBListSectionType type)
 {
@@ -109,9 +467,42 @@ IBImageListModel::IBImageSortField IBImageListWidget::getImageSortField() const
    return this->ifmImageModel->getImageSortField();
 }
 
-/* Emits the signal selectionChanged with the first selected item. */
+/* Sets the maximal Hamming distance (distance) of similar images for the list model and reselect the currently
+   selected item. */
+void IBImageListWidget::setSimilarityDistance(int distance)
+{
+   QModelIndex selidx = this->selectionModel()->currentIndex();
+
+   selidx = this->ifmImageModel->setSimilarityDistance(distance, selidx);
+   this->setCurrentIndex(selidx);
+}
+
+/* Returns the maximal Hamming distance of similar images. */
+int IBImageListWidget::getSimilarityDistance() const
+{
+   return this->ifmImageModel->getSimilarityDistance();
+}
+
+/* Shows only the images, whose file names contain the fragment (filter), and reselects the currently selected item,
+   if it is still shown. */
+void IBImageListWidget::setFileNameFilter(const QString &filter)
+{
+   QModelIndex selidx = this->selectionModel()->currentIndex();
+
+   selidx = this->ifmImageModel->setFileNameFilter(filter, selidx);
+   this->setCurrentIndex(selidx);
+}
+
+/* Returns the fragment of the file names of the shown images. */
+QString IBImageListWidget::getFileNameFilter() const
+{
+   return this->ifmImageModel->getFileNameFilter();
+}
+
+/* Emits the signal selectionChanged with the first selected item. The prefetcher yields to the selection. */
 void IBImageListWidget::selectionChanged(const QItemSelection &selected, const QItemSelection &deselected)
 {
+   this->yieldPrefetch();
    QListView::selectionChanged(selected, deselected);
    emit this->selectionChanged(selected.indexes().value(0));
 }
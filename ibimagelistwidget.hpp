@@ -4,16 +4,26 @@
 #ifndef H_IBIMAGELISTWIDGET
 #define H_IBIMAGELISTWIDGET
 
+#include <QCache>
+#include <QElapsedTimer>
+#include <QFontDatabase>
 #include <QItemSelection>
+#include <QPaintEvent>
 #include <QListView>
+#include <QPainter>
 #include <QRect>
 #include <QRegion>
 #include <QResizeEvent>
 #include <QScrollBar>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
 #include <QWidget>
 
+#include "ibdirectoryprefetcher.hpp"
 #include "ibimagelistmodel.hpp"
 #include "ibitemdelegate.hpp"
+#include "ibtrace.hpp"
 
 class IBImageListWidget : public QListView
 {
@@ -21,6 +31,7 @@ class IBImageListWidget : public QListView
 
    public:
       IBImageListWidget(QWidget *parent = nullptr);
+      IBImageListWidget(const QString &imagepath, QWidget *parent = nullptr);
       void setSectionType(IBImageListModel::IBListSectionType type);
       IBImageListModel::IBListSectionType getSectionType();
 
@@ -31,25 +42,78 @@ class IBImageListWidget : public QListView
       Qt::SortOrder getImageSortOrder() const;
       void setImageSortField(IBImageListModel::IBImageSortField field);
       IBImageListModel::IBImageSortField getImageSortField() const;
+      void setSimilarityDistance(int distance);
+      int getSimilarityDistance() const;
+      QString getFileNameFilter() const;
 
       QString getImagePath() const;
 
+      void setRecursive(bool recursive);
+      bool isRecursive() const;
+      QStringList getNeighbourImagePaths(const QModelIndex &index, int step, int count) const;
+
+      bool isOverlayVisible() const;
+
+      void setPrefetchCandidates(const QStringList &paths);
+
    signals:
       void selectionChanged(const QModelIndex &index);
+      void firstFramePainted();
+      void firstThumbnailPainted();
 
    public slots:
       void setImagePath(const QString &path);
       void refresh();
+      void setOverlayVisible(bool visible);
+      void setFileNameFilter(const QString &filter);
 
    protected:
+      void paintEvent(QPaintEvent *event) override;
       void resizeEvent(QResizeEvent *event) override;
+      void scrollContentsBy(int dx, int dy) override;
       void selectionChanged(const QItemSelection &selected, const QItemSelection &deselected) override;
 
+   private slots:
+      void onOverlayTimeout();
+      void onDirectoryModified();
+      void onPrefetchTimeout();
+
    private:
+      void paintOverlay();
+      void storeSnapshot();
+      void restoreSnapshot(IBImageListSnapshot *snapshot);
+      void restoreViewState(int scrollvalue, const QString &selectedpath);
+      void yieldPrefetch();
+
       /* contains the ItemDelegate object of the view */ 
       IBItemDelegate *idDelegate;
       /* contains the List Model of the view */
       IBImageListModel *ifmImageModel;
+      /* is true if the performance overlay is shown */
+      bool bOverlayVisible;
+      /* area of the performance overlay on the viewport */
+      QRect rctOverlay;
+      /* refreshes the performance overlay */
+      QTimer *tmOverlay;
+      /* paint times of the last frames in nanoseconds, used as a ring buffer */
+      QVector<qint64> vecFrameTimes;
+      /* position of the next frame in vecFrameTimes */
+      int iFrameIndex;
+      /* counters of the item delegate at the end of the last frame */
+      IBItemDelegateStatistics dsLastFrame;
+      /* number of image items painted by the last frame, which covered the whole viewport */
+      qint64 iVisibleItems;
+      /* are true after the first frame and the first frame with a thumbnail are painted */
+      bool bFirstFramePainted;
+      bool bFirstThumbnailPainted;
+      /* snapshots of the recently shown directories by their paths, the cost is their memory in KiB */
+      QCache<QString, IBImageListSnapshot> chSnapshots;
+      /* enumerates the likely next directories and loads their thumbnails in advance */
+      IBDirectoryPrefetcher *dpfPrefetcher;
+      /* starts the prefetching, when the view and its model are idle */
+      QTimer *tmPrefetch;
+      /* likely next directories ordered by priority, the siblings of the current directory follow them */
+      QStringList slPrefetchCandidates;
 };
 
 #endif /*H_IBIMAGELISTWIDGET*/
@@ -0,0 +1,448 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibimagescaler.hpp"
+#include "ibtrace.hpp"
+
+#include <QAtomicInt>
+#include <QVector>
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IB_SCALER_X86
+#include <immintrin.h>
+#endif /*defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))*/
+
+/* adds the weighted bytes of a source row to the accumulated row */
+typedef void (*IBAccumulateFunction)(float *acc, const uchar *src, int count, float weight);
+/* reduces the accumulated row horizontally into the pixels of a target row */
+typedef void (*IBReduceFunction)(quint32 *dst, const float *acc, int width, const IBScalerContribution *contributions,
+                                 const float *weights);
+
+/* implementation selected by setImplementation */
+static QAtomicInt iSelectedImplementation(IBImageScaler::Automatic);
+
+/* Computes for every target pixel of an axis the contributing source pixels and their weights. The weight of a
+   source pixel is the part of its area, which is covered by the target pixel. */
+static void computeContributions(int sourcesize, int targetsize, QVector<IBScalerContribution> &contributions,
+                                 QVector<float> &weights)
+{
+   double ratio = double(sourcesize) / targetsize;
+   double begin, end;
+   int idx, pos, last;
+
+   contributions.resize(targetsize);
+   weights.clear();
+
+   for(idx = 0; idx < targetsize; idx++)
+   {
+      begin = idx * ratio;
+      end = qMin(double(sourcesize), (idx + 1) * ratio);
+      last = qMin(sourcesize, int(std::ceil(end))) - 1;
+
+      contributions[idx].iFirst = int(begin);
+      contributions[idx].iCount = last - int(begin) + 1;
+      contributions[idx].iWeightOffset = weights.size();
+
+      for(pos = int(begin); pos <= last; pos++)
+      {
+         weights.append(float((qMin(end, double(pos + 1)) - qMax(begin, double(pos))) / ratio));
+      }
+   }
+}
+
+/* Returns true if the rows of an image of the given format (format) are converted by convertRow. */
+static bool isRowConvertible(QImage::Format format)
+{
+   switch(format)
+   {
+      case QImage::Format_ARGB32:
+      case QImage::Format_RGB888:
+      case QImage::Format_Grayscale8:
+      case QImage::Format_Indexed8:
+         return true;
+
+      default:
+         return false;
+   }
+}
+
+/* Converts the row (y) of the image (image) into premultiplied pixels and stores them in row. The color table of
+   indexed images has to be premultiplied already (colortable). */
+static void convertRow(const QImage &image, int y, const QRgb *colortable, quint32 *row)
+{
+   const uchar *line = image.constScanLine(y);
+   const QRgb *pixels = reinterpret_cast<const QRgb *>(line);
+   int x;
+
+   switch(image.format())
+   {
+      case QImage::Format_ARGB32:
+         for(x = 0; x < image.width(); x++)
+         {
+            row[x] = qPremultiply(pixels[x]);
+         }
+         break;
+
+      case QImage::Format_RGB888:
+         for(x = 0; x < image.width(); x++)
+         {
+            row[x] = qRgb(line[x * 3], line[x * 3 + 1], line[x * 3 + 2]);
+         }
+         break;
+
+      case QImage::Format_Grayscale8:
+         for(x = 0; x < image.width(); x++)
+         {
+            row[x] = qRgb(line[x], line[x], line[x]);
+         }
+         break;
+
+      case QImage::Format_Indexed8:
+         for(x = 0; x < image.width(); x++)
+         {
+            row[x] = colortable[line[x]];
+         }
+         break;
+
+      default:
+         break;
+   }
+}
+
+/* Adds the bytes (src) multiplied with the weight (weight) to the accumulated values (acc). */
+static void accumulateScalar(float *acc, const uchar *src, int count, float weight)
+{
+   int idx;
+
+   for(idx = 0; idx < count; idx++)
+   {
+      acc[idx] += weight * src[idx];
+   }
+}
+
+/* Sums up the weighted accumulated pixels (acc) of every target pixel and stores the rounded result in dst. */
+static void reduceScalar(quint32 *dst, const float *acc, int width, const IBScalerContribution *contributions,
+                         const float *weights)
+{
+   const float *pixel;
+   float sum[4], weight;
+   uchar result[4];
+   int x, idx, channel;
+
+   for(x = 0; x < width; x++)
+   {
+      sum[0] = sum[1] = sum[2] = sum[3] = 0.0f;
+      pixel = acc + contributions[x].iFirst * 4;
+
+      for(idx = 0; idx < contributions[x].iCount; idx++)
+      {
+         weight = weights[contributions[x].iWeightOffset + idx];
+
+         for(channel = 0; channel < 4; channel++)
+         {
+            sum[channel] += weight * pixel[idx * 4 + channel];
+         }
+      }
+
+      for(channel = 0; channel < 4; channel++)
+      {
+         result[channel] = uchar(qBound(0, int(sum[channel] + 0.5f), 255));
+      }
+
+      memcpy(dst + x, result, 4);
+   }
+}
+
+#ifdef IB_SCALER_X86
+
+/* SSE2 version of accumulateScalar, which converts and adds 16 bytes per step. */
+__attribute__((target("sse2")))
+static void accumulateSSE2(float *acc, const uchar *src, int count, float weight)
+{
+   __m128i zero = _mm_setzero_si128();
+   __m128 vweight = _mm_set1_ps(weight);
+   __m128i bytes, low, high;
+   int idx;
+
+   for(idx = 0; idx + 16 <= count; idx += 16)
+   {
+      bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + idx));
+      low = _mm_unpacklo_epi8(bytes, zero);
+      high = _mm_unpackhi_epi8(bytes, zero);
+
+      _mm_storeu_ps(acc + idx, _mm_add_ps(_mm_loadu_ps(acc + idx),
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), vweight)));
+      _mm_storeu_ps(acc + idx + 4, _mm_add_ps(_mm_loadu_ps(acc + idx + 4),
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), vweight)));
+      _mm_storeu_ps(acc + idx + 8, _mm_add_ps(_mm_loadu_ps(acc + idx + 8),
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), vweight)));
+      _mm_storeu_ps(acc + idx + 12, _mm_add_ps(_mm_loadu_ps(acc + idx + 12),
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), vweight)));
+   }
+
+   accumulateScalar(acc + idx, src + idx, count - idx, weight);
+}
+
+/* SSE2 version of reduceScalar, which handles the four channels of a pixel in one register. */
+__attribute__((target("sse2")))
+static void reduceSSE2(quint32 *dst, const float *acc, int width, const IBScalerContribution *contributions,
+                       const float *weights)
+{
+   const float *pixel;
+   const float *weight;
+   __m128 sum;
+   __m128i result;
+   int x, idx;
+
+   for(x = 0; x < width; x++)
+   {
+      sum = _mm_setzero_ps();
+      pixel = acc + contributions[x].iFirst * 4;
+      weight = weights + contributions[x].iWeightOffset;
+
+      for(idx = 0; idx < contributions[x].iCount; idx++)
+      {
+         sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pixel + idx * 4), _mm_set1_ps(weight[idx])));
+      }
+
+      result = _mm_cvtps_epi32(sum);
+      result = _mm_packs_epi32(result, result);
+      result = _mm_packus_epi16(result, result);
+      dst[x] = quint32(_mm_cvtsi128_si32(result));
+   }
+}
+
+/* AVX2 version of accumulateScalar, which converts and adds 32 bytes per step. */
+__attribute__((target("avx2")))
+static void accumulateAVX2(float *acc, const uchar *src, int count, float weight)
+{
+   __m256 vweight = _mm256_set1_ps(weight);
+   __m256 values;
+   int idx, part;
+
+   for(idx = 0; idx + 32 <= count; idx += 32)
+   {
+      for(part = 0; part < 32; part += 8)
+      {
+         values = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+                     _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + idx + part))));
+         _mm256_storeu_ps(acc + idx + part, _mm256_add_ps(_mm256_loadu_ps(acc + idx + part),
+                          _mm256_mul_ps(values, vweight)));
+      }
+   }
+
+   accumulateScalar(acc + idx, src + idx, count - idx, weight);
+}
+
+#endif /*IB_SCALER_X86*/
+
+/* class IBImageScalerBuffers */
+
+/* Returns the number of bytes allocated by the buffers. */
+qint64 IBImageScalerBuffers::getSize() const
+{
+   return qint64(this->vecColumnContributions.capacity() + this->vecRowContributions.capacity())
+             * qint64(sizeof(IBScalerContribution))
+          + qint64(this->vecColumnWeights.capacity() + this->vecRowWeights.capacity()
+                   + this->vecAccumulator.capacity()) * qint64(sizeof(float))
+          + qint64(this->vecConvertedRow.capacity()) * qint64(sizeof(quint32));
+}
+
+/* Releases the memory of all buffers. */
+void IBImageScalerBuffers::clear()
+{
+   this->vecColumnContributions = QVector<IBScalerContribution>();
+   this->vecColumnWeights = QVector<float>();
+   this->vecRowContributions = QVector<IBScalerContribution>();
+   this->vecRowWeights = QVector<float>();
+   this->vecAccumulator = QVector<float>();
+   this->vecConvertedRow = QVector<quint32>();
+}
+
+/* class IBImageScaler */
+
+/* Scales an image (image) down to the given size (size) with an area-averaging filter. Every target pixel is the
+   average of the source area it covers, weighted by coverage, which matches the quality of Qt::SmoothTransformation
+   for down scaling. The images of the formats RGB32 and ARGB32_Premultiplied are scaled directly, all other formats
+   are converted to one of them, the common decoder formats row by row. Up scaling is handed over to QImage::scaled.
+   The intermediate buffers are taken from buffers, if given, so that repeated calls do not allocate them again. The
+   vectorized kernels make it cheap enough to reduce the thumbnails once more for their hashes and colors. */
+QImage IBImageScaler::scale(const QImage &image, const QSize &size, Qt::AspectRatioMode mode,
+                            IBImageScalerBuffers *buffers)
+{
+   IB_TRACE_SCOPE("thumbnails", "scale");
+   IBImageScalerBuffers localbuffers;
+   QSize targetsize = image.size().scaled(size, mode).expandedTo(QSize(1, 1));
+   IBAccumulateFunction accumulate = accumulateScalar;
+   IBReduceFunction reduce = reduceScalar;
+   QImage source = image;
+   QImage target;
+   QRgb colortable[256];
+   QVector<QRgb> colors;
+   const uchar *line;
+   bool convertrows = false;
+   int y, idx, row, rowbytes;
+
+   if(image.isNull() || size.isEmpty())
+   {
+      return QImage();
+   }
+
+   if(targetsize == image.size())
+   {
+      return image;
+   }
+
+   if(targetsize.width() > image.width() || targetsize.height() > image.height())
+   {
+      return image.scaled(targetsize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+   }
+
+   if(!buffers)
+   {
+      buffers = &localbuffers;
+   }
+
+   if(isRowConvertible(source.format()))
+   {
+      convertrows = true;
+      buffers->vecConvertedRow.resize(source.width());
+
+      if(source.format() == QImage::Format_Indexed8)
+      {
+         colors = source.colorTable();
+         memset(colortable, 0, sizeof(colortable));
+
+         for(idx = 0; idx < qMin(int(colors.size()), 256); idx++)
+         {
+            colortable[idx] = qPremultiply(colors[idx]);
+         }
+      }
+   }
+   else if(source.format() != QImage::Format_RGB32 && source.format() != QImage::Format_ARGB32_Premultiplied)
+   {
+      source = source.convertToFormat(source.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                                : QImage::Format_RGB32);
+   }
+
+#ifdef IB_SCALER_X86
+   switch(IBImageScaler::getImplementation())
+   {
+      case IBImageScaler::AVX2:
+         accumulate = accumulateAVX2;
+         reduce = reduceSSE2;
+         break;
+
+      case IBImageScaler::SSE2:
+         accumulate = accumulateSSE2;
+         reduce = reduceSSE2;
+         break;
+
+      default:
+         break;
+   }
+#endif /*IB_SCALER_X86*/
+
+   computeContributions(source.width(), targetsize.width(), buffers->vecColumnContributions,
+                        buffers->vecColumnWeights);
+   computeContributions(source.height(), targetsize.height(), buffers->vecRowContributions,
+                        buffers->vecRowWeights);
+
+   target = QImage(targetsize, source.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+   rowbytes = source.width() * 4;
+   buffers->vecAccumulator.resize(rowbytes);
+
+   for(y = 0; y < targetsize.height(); y++)
+   {
+      /* vertical pass: weighted sum of the source rows covered by the target row */
+      buffers->vecAccumulator.fill(0.0f);
+      for(idx = 0; idx < buffers->vecRowContributions[y].iCount; idx++)
+      {
+         row = buffers->vecRowContributions[y].iFirst + idx;
+
+         if(convertrows)
+         {
+            convertRow(source, row, colortable, buffers->vecConvertedRow.data());
+            line = reinterpret_cast<const uchar *>(buffers->vecConvertedRow.constData());
+         }
+         else
+         {
+            line = source.constScanLine(row);
+         }
+
+         accumulate(buffers->vecAccumulator.data(), line, rowbytes,
+                    buffers->vecRowWeights[buffers->vecRowContributions[y].iWeightOffset + idx]);
+      }
+
+      /* horizontal pass: weighted sum of the accumulated columns covered by each target pixel */
+      reduce(reinterpret_cast<quint32 *>(target.scanLine(y)), buffers->vecAccumulator.constData(),
+             targetsize.width(), buffers->vecColumnContributions.constData(), buffers->vecColumnWeights.constData());
+   }
+
+   return target;
+}
+
+/* Selects the kernel implementation (implementation) used by scale. Automatic selects the fastest implementation
+   supported by the CPU. Unsupported implementations fall back to Automatic. */
+void IBImageScaler::setImplementation(IBImageScaler::Implementation implementation)
+{
+   if(!IBImageScaler::isImplementationSupported(implementation))
+   {
+      implementation = IBImageScaler::Automatic;
+   }
+
+   iSelectedImplementation.storeRelaxed(implementation);
+}
+
+/* Returns the kernel implementation used by scale. Automatic is resolved to the fastest supported implementation. */
+IBImageScaler::Implementation IBImageScaler::getImplementation()
+{
+   IBImageScaler::Implementation implementation;
+
+   implementation = static_cast<IBImageScaler::Implementation>(iSelectedImplementation.loadRelaxed());
+
+   if(implementation == IBImageScaler::Automatic)
+   {
+      if(IBImageScaler::isImplementationSupported(IBImageScaler::AVX2))
+      {
+         implementation = IBImageScaler::AVX2;
+      }
+      else if(IBImageScaler::isImplementationSupported(IBImageScaler::SSE2))
+      {
+         implementation = IBImageScaler::SSE2;
+      }
+      else
+      {
+         implementation = IBImageScaler::Scalar;
+      }
+   }
+
+   return implementation;
+}
+
+/* Returns true if the kernel implementation (implementation) is supported by the CPU. Otherwise false. */
+bool IBImageScaler::isImplementationSupported(IBImageScaler::Implementation implementation)
+{
+   switch(implementation)
+   {
+      case IBImageScaler::Automatic:
+      case IBImageScaler::Scalar:
+         return true;
+
+#ifdef IB_SCALER_X86
+      case IBImageScaler::SSE2:
+         __builtin_cpu_init();
+         return __builtin_cpu_supports("sse2");
+
+      case IBImageScaler::AVX2:
+         __builtin_cpu_init();
+         return __builtin_cpu_supports("avx2");
+#endif /*IB_SCALER_X86*/
+
+      default:
+         return false;
+   }
+}
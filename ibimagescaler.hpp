@@ -0,0 +1,64 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBIMAGESCALER
+#define H_IBIMAGESCALER
+
+#include <QImage>
+#include <QSize>
+#include <QVector>
+
+/* contributions of the source pixels to one target pixel along an axis */
+struct IBScalerContribution
+{
+   /* first contributing source pixel */
+   int iFirst;
+   /* number of contributing source pixels */
+   int iCount;
+   /* index of the first weight */
+   int iWeightOffset;
+};
+
+/* class IBImageScalerBuffers */
+
+class IBImageScalerBuffers
+{
+   public:
+      qint64 getSize() const;
+      void clear();
+
+      /* contributions and weights of the target columns */
+      QVector<IBScalerContribution> vecColumnContributions;
+      QVector<float> vecColumnWeights;
+      /* contributions and weights of the target rows */
+      QVector<IBScalerContribution> vecRowContributions;
+      QVector<float> vecRowWeights;
+      /* weighted sums of the source rows of the current target row */
+      QVector<float> vecAccumulator;
+      /* source row converted into RGB32 or ARGB32_Premultiplied */
+      QVector<quint32> vecConvertedRow;
+};
+
+/* class IBImageScaler */
+
+class IBImageScaler
+{
+   public:
+      /*enumeration of the kernel implementations*/
+      enum Implementation
+      {
+         Automatic,
+         Scalar,
+         SSE2,
+         AVX2
+      };
+
+      static QImage scale(const QImage &image, const QSize &size, Qt::AspectRatioMode mode = Qt::KeepAspectRatio,
+                          IBImageScalerBuffers *buffers = nullptr);
+
+      static void setImplementation(IBImageScaler::Implementation implementation);
+      static IBImageScaler::Implementation getImplementation();
+      static bool isImplementationSupported(IBImageScaler::Implementation implementation);
+};
+
+#endif /*H_IBIMAGESCALER*/
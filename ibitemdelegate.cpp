@@ -34,6 +34,7 @@ void IBItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option
 /* Paints a section item with a given model index (index) and options (option) on a painter object (painter). */
 void IBItemDelegate::paintSection(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
 {
+   IB_TRACE_SCOPE("paint", "paintSection");
    QString fname;
    QFont paintfont;
 
@@ -55,22 +56,30 @@ void IBItemDelegate::paintSection(QPainter *painter, const QStyleOptionViewItem
    painter->restore();
 }
 
-/* Paints a normal item with a given model index (index) and options (option) on a painter object (painter). */
+/* Paints a normal item with a given model index (index) and options (option) on a painter object (painter). An
+   image, which could not be decoded, is painted as a crossed out frame. */
 void IBItemDelegate::paintItem(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
 {
+   IB_TRACE_SCOPE("paint", "paintItem");
    QString ftype, fname;
    QRect hbufrect(0 ,0, option.rect.width(),  option.rect.height());
    QPixmap thumbnail, hbufpxmp(hbufrect.width(),  hbufrect.height());
    QPainter *hbufpainter;
    QSize imagesize;
    QFont paintfont;
-   bool imageloaded;
+   QRect framerect;
+   QString sizetext;
+   bool imageloaded, imagefailed;
    
    ftype = index.model()->data(index, IBImageListModel::ItemFileType).toString();
    fname = index.model()->data(index, IBImageListModel::ItemName).toString();
    thumbnail = index.model()->data(index, IBImageListModel::ItemThumbnail).value<QPixmap>();
    imagesize = index.model()->data(index, IBImageListModel::ItemImageSize).toSize();
    imageloaded = index.model()->data(index, IBImageListModel::ItemImageLoaded).toBool();
+   imagefailed = index.model()->data(index, IBImageListModel::ItemImageFailed).toBool();
+
+   this->dsStatistics.iFrameItems++;
+   this->dsStatistics.iFrameThumbnails += thumbnail.isNull() ? 0 : 1;
 
    /* start painting of item on a pixmap to prevent text flickering */
    hbufpainter = new QPainter(&hbufpxmp);
@@ -95,11 +104,24 @@ void IBItemDelegate::paintItem(QPainter *painter, const QStyleOptionViewItem &op
       hbufpainter->setPen(option.palette.color(QPalette::Text));
    }
 
-   hbufpainter->drawRect(4, 4, hbufrect.width() - 8, hbufrect.height() - 46);
-   
-   hbufpainter->drawPixmap(4 + ((hbufrect.width() - 8 - thumbnail.width()) / 2),
-                           4 + ((hbufrect.height() - 46 - thumbnail.height()) / 2),
-                           thumbnail);
+   framerect = QRect(4, 4, hbufrect.width() - 8, hbufrect.height() - 46);
+   hbufpainter->drawRect(framerect);
+
+   if(imagefailed)
+   {
+      /* a broken image is crossed out, so that it is not mistaken for an image, which is still loading */
+      hbufpainter->drawLine(framerect.topLeft(), framerect.bottomRight());
+      hbufpainter->drawLine(framerect.topRight(), framerect.bottomLeft());
+      hbufpainter->fillRect(framerect.center().x() - 60, framerect.center().y() - 12, 120, 24,
+                            (option.state & QStyle::State_Selected) ? option.palette.highlight() : option.palette.base());
+      hbufpainter->drawText(framerect, Qt::AlignCenter, QStringLiteral("Broken image"));
+   }
+   else
+   {
+      hbufpainter->drawPixmap(4 + ((hbufrect.width() - 8 - thumbnail.width()) / 2),
+                              4 + ((hbufrect.height() - 46 - thumbnail.height()) / 2),
+                              thumbnail);
+   }
 
    paintfont = hbufpainter->font();
    paintfont.setPixelSize(16);
@@ -119,13 +141,25 @@ void IBItemDelegate::paintItem(QPainter *painter, const QStyleOptionViewItem &op
                          hbufrect.width() - 8, hbufrect.height() - 28), 
                          Qt::AlignHCenter, fname);
     
+   if(imagefailed)
+   {
+      sizetext = QStringLiteral("Unreadable");
+   }
+   else if(imageloaded)
+   {
+      sizetext = QString("Size: %1x%2").arg(imagesize.width()).arg(imagesize.height());
+   }
+   else
+   {
+      sizetext = QStringLiteral("Loading...");
+   }
+
    paintfont.setBold(false);
    paintfont.setPixelSize(14);
    hbufpainter->setFont(paintfont);
    hbufpainter->drawText(QRect(hbufrect.x() + 4, hbufrect.y() + hbufrect.height() - 23, 
                          hbufrect.width() / 2, hbufrect.height() - 10), 
-                         Qt::AlignLeft,
-                         imageloaded ? QString("Size: %1x%2").arg(imagesize.width()).arg(imagesize.height()) : QStringLiteral("Loading..."));
+                         Qt::AlignLeft, sizetext);
    
 
    hbufpainter->drawText(QRect(hbufrect.x() + 4 + (hbufrect.width() / 2), 
@@ -164,3 +198,16 @@ void IBItemDelegate::resizeSectionSize(const QSize &newsize)
 {
    this->szSectionSize.setWidth(newsize.width());
 }
+
+/* Starts a new frame, the frame counters of the statistics are reset. */
+void IBItemDelegate::beginFrame()
+{
+   this->dsStatistics.iFrameItems = 0;
+   this->dsStatistics.iFrameThumbnails = 0;
+}
+
+/* Returns the counters of the painting. */
+IBItemDelegateStatistics IBItemDelegate::getStatistics() const
+{
+   return this->dsStatistics;
+}
@@ -12,6 +12,19 @@
 #include <QSize>
 
 #include "ibimagelistmodel.hpp"
+#include "ibtrace.hpp"
+
+/* struct IBItemDelegateStatistics */
+
+struct IBItemDelegateStatistics
+{
+   /* number of image items painted since the start of the frame */
+   qint64 iFrameItems = 0;
+   /* number of image items painted with a thumbnail since the start of the frame */
+   qint64 iFrameThumbnails = 0;
+};
+
+/* class IBItemDelegate */
 
 class IBItemDelegate : public QAbstractItemDelegate
 {
@@ -25,6 +38,9 @@ class IBItemDelegate : public QAbstractItemDelegate
 
       void resizeSectionSize(const QSize &newsize);
 
+      void beginFrame();
+      IBItemDelegateStatistics getStatistics() const;
+
    protected:
       void paintItem(QPainter *painter, const QStyleOptionViewItem &option,
                        const QModelIndex &index) const;
@@ -37,6 +53,8 @@ class IBItemDelegate : public QAbstractItemDelegate
       QSize szItemSize;
       /* size of a section item */
       QSize szSectionSize;
+      /* counters of the painting */
+      mutable IBItemDelegateStatistics dsStatistics;
 };
 
 #endif /*H_IBIMAGEITEMDELEGATE*/
@@ -3,10 +3,12 @@
 
 #include "ibmainwindow.hpp"
 
-/* Constructs the main window and all its components. */
+/* Constructs the main window and all its components. The start directory is only loaded by the image list view,
+   the path combobox and the image list view are connected afterwards. */
 IBMainWindow::IBMainWindow(QWidget *parent, Qt::WindowFlags flags)
-   : QMainWindow(parent, flags)
+   : QMainWindow(parent, flags), bZoomViewer(false), iPreviewRow(-1), iPreviewDirection(1)
 {
+   QString startpath = QDir::homePath();
    QActionGroup *hactgrp;
    QMenu *hsubmn;
    QAction *hmnact;
@@ -37,15 +39,21 @@ IBMainWindow::IBMainWindow(QWidget *parent, Qt::WindowFlags flags)
    this->tbMain->addWidget(this->tbRefresh);
 
    /* file system combobox */
-   this->cbPath = new IBFileComboBox(this);
+   this->cbPath = new IBFileComboBox(startpath, this);
    this->cbPath->setSizePolicy(QSizePolicy::Expanding,QSizePolicy::Preferred);
-   this->cbPath->setPath(QDir::homePath());
    this->tbMain->addWidget(cbPath);
 
    this->connect(this->tbHistoryBack, SIGNAL(clicked()), this->cbPath, SLOT(goHistoryBack()));
    this->connect(this->tbHistoryForward, SIGNAL(clicked()), this->cbPath, SLOT(goHistoryForward()));
    this->connect(this->tbHome, SIGNAL(clicked()), this->cbPath, SLOT(goToHomeDirectory()));
 
+   /* file name filter */
+   this->leFilter = new QLineEdit(this->tbMain);
+   this->leFilter->setPlaceholderText(QStringLiteral("Filter by name"));
+   this->leFilter->setClearButtonEnabled(true);
+   this->leFilter->setMaximumWidth(200);
+   this->tbMain->addWidget(this->leFilter);
+
    /* menu with button */
    this->tbMenu = new QToolButton(this->tbMain);
    this->tbMenu->setIcon(QIcon::fromTheme(QStringLiteral("application-menu")));
@@ -67,9 +75,21 @@ IBMainWindow::IBMainWindow(QWidget *parent, Qt::WindowFlags flags)
    this->createNewMenuAction(hsubmn, QStringLiteral("Date"), false, true,
                              IBMainWindow::ActionFlag_SectionDate, hactgrp);
 
+   this->createNewMenuAction(hsubmn, QStringLiteral("Capture date"), false, true,
+                             IBMainWindow::ActionFlag_SectionCaptureDate, hactgrp);
+
    this->createNewMenuAction(hsubmn, QStringLiteral("Filetype"), false, true,
                              IBMainWindow::ActionFlag_SectionFileType, hactgrp);
 
+   this->createNewMenuAction(hsubmn, QStringLiteral("Folder"), false, true,
+                             IBMainWindow::ActionFlag_SectionFolder, hactgrp);
+
+   this->createNewMenuAction(hsubmn, QStringLiteral("Similar images"), false, true,
+                             IBMainWindow::ActionFlag_SectionSimilar, hactgrp);
+
+   this->createNewMenuAction(hsubmn, QStringLiteral("Color"), false, true,
+                             IBMainWindow::ActionFlag_SectionHue, hactgrp);
+
    hsubmn->addSection(QStringLiteral("Sorting order"));
    hactgrp = new QActionGroup(hsubmn);
 
@@ -93,10 +113,16 @@ IBMainWindow::IBMainWindow(QWidget *parent, Qt::WindowFlags flags)
    this->createNewMenuAction(hsubmn, QStringLiteral("Date"), false, true,
                              IBMainWindow::ActionFlag_SortImageDate, hactgrp);
 
+   this->createNewMenuAction(hsubmn, QStringLiteral("Capture date"), false, true,
+                             IBMainWindow::ActionFlag_SortImageCaptureDate, hactgrp);
+
    
    this->createNewMenuAction(hsubmn, QStringLiteral("Filetype"), false, true,
                              IBMainWindow::ActionFlag_SortImageFileType, hactgrp);
 
+   this->createNewMenuAction(hsubmn, QStringLiteral("Color"), false, true,
+                             IBMainWindow::ActionFlag_SortImageColor, hactgrp);
+
    hsubmn->addSection(QStringLiteral("Sorting order"));
    hactgrp = new QActionGroup(hsubmn);
 
@@ -108,6 +134,31 @@ IBMainWindow::IBMainWindow(QWidget *parent, Qt::WindowFlags flags)
                              IBMainWindow::ActionFlag_Image | IBMainWindow::ActionFlag_SortDescending,
                              hactgrp);
 
+   /* preview submenu */
+   hsubmn = mnMain->addMenu(QStringLiteral("Preview"));
+
+   hsubmn->addSection(QStringLiteral("Showing"));
+   hactgrp = new QActionGroup(hsubmn);
+
+   this->createNewMenuAction(hsubmn, QStringLiteral("Image information"), true, true,
+                             IBMainWindow::ActionFlag_PreviewInformation, hactgrp);
+
+   this->createNewMenuAction(hsubmn, QStringLiteral("Zoomable viewer"), false, true,
+                             IBMainWindow::ActionFlag_PreviewZoomable, hactgrp);
+
+   this->mnMain->addSeparator();
+
+   hmnact = this->mnMain->addAction(QStringLiteral("Include subdirectories"));
+   hmnact->setCheckable(true);
+   hmnact->setData(IBMainWindow::ActionFlag_Recursive);
+
+   /* the overlay is also added to the window, so that its shortcut works while the menu is closed */
+   hmnact = this->mnMain->addAction(QStringLiteral("Performance overlay"));
+   hmnact->setCheckable(true);
+   hmnact->setShortcut(QKeySequence(Qt::Key_F12));
+   hmnact->setData(IBMainWindow::ActionFlag_PerformanceOverlay);
+   this->addAction(hmnact);
+
    this->mnMain->addSeparator();
 
    hmnact = this->mnMain->addAction(QStringLiteral("About"));
@@ -130,23 +181,36 @@ IBMainWindow::IBMainWindow(QWidget *parent, Qt::WindowFlags flags)
    this->addToolBar(this->tbMain);
 
    /* central widget */
-   this->ilwView = new IBImageListWidget(this);
-   this->ilwView->setImagePath(QDir::homePath());
+   this->ilwView = new IBImageListWidget(startpath, this);
+   this->connect(this->ilwView, SIGNAL(firstFramePainted()), SIGNAL(firstFramePainted()));
+   this->connect(this->ilwView, SIGNAL(firstThumbnailPainted()), SIGNAL(firstThumbnailPainted()));
    this->connect(ilwView, SIGNAL(selectionChanged(const QModelIndex &)), SLOT(onImageWidgetSelectionChanged(const QModelIndex &)));
    this->connect(this->tbRefresh, SIGNAL(clicked()), this->ilwView, SLOT(refresh()));
+   this->connect(this->leFilter, SIGNAL(textChanged(const QString &)), this->ilwView,
+                 SLOT(setFileNameFilter(const QString &)));
 
    this->iiwPreview = new IBImageInfoWidget(this);
    this->iiwPreview->hide();
    this->iiwPreview->setMinimumWidth(100);
 
+   this->ppfPrefetcher = new IBPreviewPrefetcher(this);
+   this->iiwPreview->setPrefetcher(this->ppfPrefetcher);
+
    this->swCentralWidget = new QSplitter(Qt::Horizontal, this);
    this->swCentralWidget->addWidget(this->ilwView);
    this->swCentralWidget->addWidget(this->iiwPreview);
 
+   this->itvZoomView = new IBTiledImageView(this);
+   this->itvZoomView->hide();
+   this->itvZoomView->setMinimumWidth(100);
+   this->swCentralWidget->addWidget(this->itvZoomView);
+
    this->setCentralWidget(swCentralWidget);
 
    this->connect(this->cbPath, SIGNAL(pathChanged(const QString &)), 
                  this, SLOT(onPathChanged(const QString &)));
+   this->connect(this->cbPath, SIGNAL(directoryHovered(const QString &)), SLOT(onDirectoryHovered(const QString &)));
+   this->updatePrefetchCandidates();
 }
 
 /* Creates a new menu action and adds it to the parent menu (parentmenu) and an action group (actiongroup). */
@@ -166,7 +230,34 @@ inline void IBMainWindow::createNewMenuAction(QMenu *parentmenu, const QString &
    }
 }
 
+/* Sets the maximal Hamming distance (distance) of the perceptual hashes of images, which are sectioned as similar. */
+void IBMainWindow::setSimilarityDistance(int distance)
+{
+   this->ilwView->setSimilarityDistance(distance);
+}
+
+
+/* Queues the neighbours of the previewed item (index) for prefetching. Two thirds of the ring are spent 
+   in the direction of the user's navigation and the rest in the opposite direction. */
+void IBMainWindow::prefetchNeighbours(const QModelIndex &index)
+{
+   QStringList paths;
+   int ringsize, ahead;
+
+   if(this->iPreviewRow >= 0 && index.row() != this->iPreviewRow)
+   {
+      this->iPreviewDirection = index.row() > this->iPreviewRow ? 1 : -1;
+   }
+   this->iPreviewRow = index.row();
+
+   ringsize = this->ppfPrefetcher->getRingSize();
+   ahead = (ringsize * 2 + 2) / 3;
 
+   paths = this->ilwView->getNeighbourImagePaths(index, this->iPreviewDirection, ahead);
+   paths += this->ilwView->getNeighbourImagePaths(index, -this->iPreviewDirection, ringsize - ahead);
+
+   this->ppfPrefetcher->prefetch(paths);
+}
 
 /* Handles a click on a menu entry. */
 void IBMainWindow::onMenuTriggered(QAction *action)
@@ -176,7 +267,12 @@ void IBMainWindow::onMenuTriggered(QAction *action)
    if(action)
    {
       data = action->data().toUInt();      
-      action->setChecked(true);
+
+      /* the actions of a group stay checked, the other checkable actions are toggled */
+      if(action->actionGroup())
+      {
+         action->setChecked(true);
+      }
 
       switch(data & IBMainWindow::ActionFlag_ActionMask)
       {
@@ -214,10 +310,26 @@ void IBMainWindow::onMenuTriggered(QAction *action)
             this->ilwView->setSectionType(IBImageListModel::DateSection);
             break;
 
+         case IBMainWindow::ActionFlag_SectionCaptureDate:
+            this->ilwView->setSectionType(IBImageListModel::CaptureDateSection);
+            break;
+
          case IBMainWindow::ActionFlag_SectionFileType:
             this->ilwView->setSectionType(IBImageListModel::FileTypeSection);
             break;
 
+         case IBMainWindow::ActionFlag_SectionFolder:
+            this->ilwView->setSectionType(IBImageListModel::FolderSection);
+            break;
+
+         case IBMainWindow::ActionFlag_SectionSimilar:
+            this->ilwView->setSectionType(IBImageListModel::SimilarSection);
+            break;
+
+         case IBMainWindow::ActionFlag_SectionHue:
+            this->ilwView->setSectionType(IBImageListModel::HueSection);
+            break;
+
          case IBMainWindow::ActionFlag_SortImageName:
             this->ilwView->setImageSortField(IBImageListModel::SortByName);
             break;
@@ -226,10 +338,28 @@ void IBMainWindow::onMenuTriggered(QAction *action)
             this->ilwView->setImageSortField(IBImageListModel::SortByDate);
             break;
 
+         case IBMainWindow::ActionFlag_SortImageCaptureDate:
+            this->ilwView->setImageSortField(IBImageListModel::SortByCaptureDate);
+            break;
+
          case IBMainWindow::ActionFlag_SortImageFileType:
             this->ilwView->setImageSortField(IBImageListModel::SortByFileType);
             break;
 
+         case IBMainWindow::ActionFlag_SortImageColor:
+            this->ilwView->setImageSortField(IBImageListModel::SortByColor);
+            break;
+
+         case IBMainWindow::ActionFlag_PreviewInformation:
+            this->bZoomViewer = false;
+            this->onImageWidgetSelectionChanged(this->ilwView->currentIndex());
+            break;
+
+         case IBMainWindow::ActionFlag_PreviewZoomable:
+            this->bZoomViewer = true;
+            this->onImageWidgetSelectionChanged(this->ilwView->currentIndex());
+            break;
+
          default:
             switch(data & ActionFlag_TypeMask)
             {
@@ -246,6 +376,14 @@ void IBMainWindow::onMenuTriggered(QAction *action)
                case IBMainWindow::ActionFlag_AboutQt:
                   QMessageBox::aboutQt(this, QStringLiteral("About Qt")); 
                   break;
+
+               case IBMainWindow::ActionFlag_PerformanceOverlay:
+                  this->ilwView->setOverlayVisible(action->isChecked());
+                  break;
+
+               case IBMainWindow::ActionFlag_Recursive:
+                  this->ilwView->setRecursive(action->isChecked());
+                  break;
             }
             break;
       }
@@ -253,16 +391,47 @@ void IBMainWindow::onMenuTriggered(QAction *action)
 }
 
 /* Hides the preview widget, enables/disables history toolbar button
-   and sets the new path to the list view widget */
+   and sets the new path and the likely next directories to the list view widget */
 void IBMainWindow::onPathChanged(const QString &newpath)
 {
    this->tbHistoryBack->setEnabled(!this->cbPath->isHistoryAtFirstIndex());
    this->tbHistoryForward->setEnabled(!this->cbPath->isHistoryAtLastIndex());
    this->iiwPreview->hide();
+   this->itvZoomView->hide();
+   this->iPreviewRow = -1;
+   this->ppfPrefetcher->prefetch(QStringList());
    this->ilwView->setImagePath(newpath);
+   this->strHoveredPath.clear();
+   this->updatePrefetchCandidates();
 }
 
-/* Shows or hides the image preview widget. */
+/* Prefers the directory (path) under the mouse in the popup of the path combobox for the prefetching. */
+void IBMainWindow::onDirectoryHovered(const QString &path)
+{
+   this->strHoveredPath = path;
+   this->updatePrefetchCandidates();
+}
+
+/* Passes the likely next directories to the image list view: the directory under the mouse in the path popup and the
+   next entry of the history. The view adds the siblings of the current directory. */
+void IBMainWindow::updatePrefetchCandidates()
+{
+   QStringList candidates;
+
+   if(!this->strHoveredPath.isEmpty())
+   {
+      candidates.append(this->strHoveredPath);
+   }
+
+   if(!this->cbPath->getForwardHistoryPath().isEmpty())
+   {
+      candidates.append(this->cbPath->getForwardHistoryPath());
+   }
+
+   this->ilwView->setPrefetchCandidates(candidates);
+}
+
+/* Shows or hides the image preview widget or the zoomable viewer. */
 void IBMainWindow::onImageWidgetSelectionChanged(const QModelIndex &index)
 {
    bool issection;
@@ -271,6 +440,7 @@ void IBMainWindow::onImageWidgetSelectionChanged(const QModelIndex &index)
    if(!index.isValid())
    {
       this->iiwPreview->hide();
+      this->itvZoomView->hide();
       return;
    }
 
@@ -278,13 +448,26 @@ void IBMainWindow::onImageWidgetSelectionChanged(const QModelIndex &index)
    
    if(!issection)
    {
-      this->iiwPreview->show();
       imagepath = index.model()->data(index, IBImageListModel::ItemFilePath).toString(); 
-      this->iiwPreview->setImagePath(imagepath);
-      this->iiwPreview->show();
+
+      if(this->bZoomViewer)
+      {
+         this->iiwPreview->hide();
+         this->itvZoomView->show();
+         this->itvZoomView->setImagePath(imagepath);
+      }
+      else
+      {
+         this->itvZoomView->hide();
+         this->iiwPreview->show();
+         this->iiwPreview->setImagePath(imagepath);
+         this->iiwPreview->show();
+         this->prefetchNeighbours(index);
+      }
    }
    else
    {
       this->iiwPreview->hide();
+      this->itvZoomView->hide();
    }
 }
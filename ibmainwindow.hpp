@@ -8,6 +8,7 @@
 #include <QActionGroup>
 #include <QKeySequence>
 #include <QLabel>
+#include <QLineEdit>
 #include <QMainWindow>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -19,6 +20,8 @@
 #include "ibimagelistwidget.hpp"
 #include "ibimagelistmodel.hpp"
 #include "ibimageinfowidget.hpp"
+#include "ibpreviewprefetcher.hpp"
+#include "ibtiledimageview.hpp"
 
 class IBMainWindow : public QMainWindow
 {
@@ -38,25 +41,44 @@ class IBMainWindow : public QMainWindow
        ActionFlag_SortImageName = 0x07,
        ActionFlag_SortImageDate = 0x08,
        ActionFlag_SortImageFileType = 0x09,
-       ActionFlag_ActionMask = 0x0F,
-       ActionFlag_Section = 0x10,
-       ActionFlag_Image = 0x20,
-       ActionFlag_About = 0x30,
-       ActionFlag_AboutQt = 0x40,
-       ActionFlag_TypeMask = 0xF0
+       ActionFlag_PreviewInformation = 0x0A,
+       ActionFlag_PreviewZoomable = 0x0B,
+       ActionFlag_SectionFolder = 0x0C,
+       ActionFlag_SectionSimilar = 0x0D,
+       ActionFlag_SectionHue = 0x0E,
+       ActionFlag_SortImageColor = 0x0F,
+       ActionFlag_SectionCaptureDate = 0x10,
+       ActionFlag_SortImageCaptureDate = 0x11,
+       ActionFlag_ActionMask = 0xFF,
+       ActionFlag_Section = 0x100,
+       ActionFlag_Image = 0x200,
+       ActionFlag_About = 0x300,
+       ActionFlag_AboutQt = 0x400,
+       ActionFlag_PerformanceOverlay = 0x500,
+       ActionFlag_Recursive = 0x600,
+       ActionFlag_TypeMask = 0xF00
     };
     Q_ENUM(ActionFlags)
 
     IBMainWindow(QWidget *parent = nullptr, Qt::WindowFlags flags = Qt::WindowFlags());
+
+    void setSimilarityDistance(int distance);
+
+  signals:
+    void firstFramePainted();
+    void firstThumbnailPainted();
     
   private slots:
     void onMenuTriggered(QAction *action);
     void onPathChanged(const QString &newpath);
+    void onDirectoryHovered(const QString &path);
     void onImageWidgetSelectionChanged(const QModelIndex &index);
 
   private:
     inline void createNewMenuAction(QMenu *parentmenu, const QString &text, bool checked = false, bool checkable = false, 
                                     const uint data = 0, QActionGroup *actiongroup = nullptr);
+    void prefetchNeighbours(const QModelIndex &index);
+    void updatePrefetchCandidates();
     
     /* main menu assigned to the tool button tbMenu */
     QMenu *mnMain;
@@ -76,10 +98,24 @@ class IBMainWindow : public QMainWindow
     QSplitter *swCentralWidget;
     /* combobox to selecting working directory */
     IBFileComboBox *cbPath;
+    /* line edit with the fragment of the file names of the shown images */
+    QLineEdit *leFilter;
     /* list view */
     IBImageListWidget *ilwView;
     /* preview widget */
     IBImageInfoWidget *iiwPreview;
+    /* zoomable and pannable preview widget */
+    IBTiledImageView *itvZoomView;
+    /* is true if images are previewed in the zoomable viewer */
+    bool bZoomViewer;
+    /* decodes the neighbours of the previewed image in advance */
+    IBPreviewPrefetcher *ppfPrefetcher;
+    /* row of the previewed image, -1 if no image is previewed */
+    int iPreviewRow;
+    /* direction of the user's navigation through the images (1 = forward, -1 = backward) */
+    int iPreviewDirection;
+    /* directory under the mouse in the popup of the path combobox */
+    QString strHoveredPath;
 };
 
 #endif
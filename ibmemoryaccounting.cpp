@@ -0,0 +1,254 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibmemoryaccounting.hpp"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTextStream>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif /*Q_OS_UNIX*/
+
+std::atomic<qint64> IBMemoryAccounting::iLiveBytes[IBMemoryAccounting::SubsystemCount];
+std::atomic<qint64> IBMemoryAccounting::iLiveObjects[IBMemoryAccounting::SubsystemCount];
+std::atomic<qint64> IBMemoryAccounting::iPeakBytes[IBMemoryAccounting::SubsystemCount];
+std::atomic<qint64> IBMemoryAccounting::iAllocations[IBMemoryAccounting::SubsystemCount];
+
+#ifdef Q_OS_UNIX
+/* pipe from the signal handler to the event loop, the handler writes into the second descriptor */
+static int iReportPipe[2] = {-1, -1};
+
+/* Wakes the event loop to write the memory report. Only async-signal-safe functions are called here. */
+static void onReportSignal(int signal)
+{
+   char byte = 1;
+   ssize_t written;
+
+   Q_UNUSED(signal)
+
+   written = ::write(iReportPipe[1], &byte, 1);
+   Q_UNUSED(written)
+}
+#endif /*Q_OS_UNIX*/
+
+/* class IBMemoryAccounting */
+
+/* Accounts the allocation of the given number of objects (objects) with a size of bytes in the subsystem
+   (subsystem). */
+void IBMemoryAccounting::allocate(IBMemoryAccounting::Subsystem subsystem, qint64 bytes, qint64 objects)
+{
+   qint64 live = IBMemoryAccounting::iLiveBytes[subsystem].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+   IBMemoryAccounting::iLiveObjects[subsystem].fetch_add(objects, std::memory_order_relaxed);
+   IBMemoryAccounting::iAllocations[subsystem].fetch_add(objects, std::memory_order_relaxed);
+   IBMemoryAccounting::updatePeak(subsystem, live);
+}
+
+/* Accounts the release of the given number of objects (objects) with a size of bytes in the subsystem
+   (subsystem). */
+void IBMemoryAccounting::release(IBMemoryAccounting::Subsystem subsystem, qint64 bytes, qint64 objects)
+{
+   IBMemoryAccounting::iLiveBytes[subsystem].fetch_sub(bytes, std::memory_order_relaxed);
+   IBMemoryAccounting::iLiveObjects[subsystem].fetch_sub(objects, std::memory_order_relaxed);
+}
+
+/* Accounts the replacement of a buffer with the size oldbytes by a buffer with the size newbytes in the subsystem
+   (subsystem). Empty buffers are not counted as objects. */
+void IBMemoryAccounting::resize(IBMemoryAccounting::Subsystem subsystem, qint64 oldbytes, qint64 newbytes)
+{
+   if(oldbytes == newbytes)
+   {
+      return;
+   }
+
+   if(oldbytes > 0)
+   {
+      IBMemoryAccounting::release(subsystem, oldbytes);
+   }
+
+   if(newbytes > 0)
+   {
+      IBMemoryAccounting::allocate(subsystem, newbytes);
+   }
+}
+
+/* Sets the bytes (bytes) and objects (objects) held by the subsystem (subsystem) and adds the given number of
+   allocations (allocations). It is used for caches, which only know their totals, and must not be mixed with
+   allocate and release for the same subsystem. */
+void IBMemoryAccounting::setUsage(IBMemoryAccounting::Subsystem subsystem, qint64 bytes, qint64 objects,
+                                  qint64 allocations)
+{
+   IBMemoryAccounting::iLiveBytes[subsystem].store(bytes, std::memory_order_relaxed);
+   IBMemoryAccounting::iLiveObjects[subsystem].store(objects, std::memory_order_relaxed);
+   IBMemoryAccounting::iAllocations[subsystem].fetch_add(allocations, std::memory_order_relaxed);
+   IBMemoryAccounting::updatePeak(subsystem, bytes);
+}
+
+/* Returns the current usage of the subsystem (subsystem). */
+IBMemoryUsage IBMemoryAccounting::getUsage(IBMemoryAccounting::Subsystem subsystem)
+{
+   IBMemoryUsage usage;
+
+   usage.iLiveBytes = IBMemoryAccounting::iLiveBytes[subsystem].load(std::memory_order_relaxed);
+   usage.iLiveObjects = IBMemoryAccounting::iLiveObjects[subsystem].load(std::memory_order_relaxed);
+   usage.iPeakBytes = IBMemoryAccounting::iPeakBytes[subsystem].load(std::memory_order_relaxed);
+   usage.iAllocations = IBMemoryAccounting::iAllocations[subsystem].load(std::memory_order_relaxed);
+
+   return usage;
+}
+
+/* Returns the name of the subsystem (subsystem) as used in the report. */
+QString IBMemoryAccounting::getSubsystemName(IBMemoryAccounting::Subsystem subsystem)
+{
+   switch(subsystem)
+   {
+      case IBMemoryAccounting::ModelItems:
+         return QStringLiteral("model items");
+
+      case IBMemoryAccounting::SectionLists:
+         return QStringLiteral("section lists");
+
+      case IBMemoryAccounting::Thumbnails:
+         return QStringLiteral("thumbnails");
+
+      case IBMemoryAccounting::DecoderBuffers:
+         return QStringLiteral("decoder buffers");
+
+      case IBMemoryAccounting::Preview:
+         return QStringLiteral("preview");
+
+      case IBMemoryAccounting::PreviewCache:
+         return QStringLiteral("preview cache");
+
+      case IBMemoryAccounting::ViewerTiles:
+         return QStringLiteral("viewer tiles");
+
+      case IBMemoryAccounting::ViewerSource:
+         return QStringLiteral("viewer source");
+
+      case IBMemoryAccounting::DirectoryTree:
+         return QStringLiteral("directory tree");
+
+      default:
+         return QString();
+   }
+}
+
+/* Returns the resident set size of the process in bytes or -1, if it is not available. */
+qint64 IBMemoryAccounting::getResidentSize()
+{
+   QFile file(QStringLiteral("/proc/self/status"));
+   QByteArray line;
+
+   if(file.open(QIODevice::ReadOnly))
+   {
+      while(!(line = file.readLine()).isEmpty())
+      {
+         if(line.startsWith("VmRSS:"))
+         {
+            return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+         }
+      }
+   }
+
+   return -1;
+}
+
+/* Returns a text report with the live and peak KiB, the live objects and the allocations of every subsystem,
+   the accounted total and the part of the resident set size, which is not accounted. The preview is shared with
+   the preview cache, so that it may be counted twice. */
+QString IBMemoryAccounting::createReport()
+{
+   QString report;
+   QTextStream stream(&report);
+   IBMemoryAccounting::Subsystem subsystem;
+   IBMemoryUsage usage;
+   qint64 total = 0, resident = IBMemoryAccounting::getResidentSize();
+   int idx;
+
+   stream << "memory report of process " << QCoreApplication::applicationPid() << '\n';
+   stream << QString("%1 %2 %3 %4 %5\n").arg(QStringLiteral("subsystem"), -20)
+                .arg(QStringLiteral("live KiB"), 12).arg(QStringLiteral("peak KiB"), 12)
+                .arg(QStringLiteral("objects"), 12).arg(QStringLiteral("allocations"), 12);
+
+   for(idx = 0; idx < IBMemoryAccounting::SubsystemCount; idx++)
+   {
+      subsystem = static_cast<IBMemoryAccounting::Subsystem>(idx);
+      usage = IBMemoryAccounting::getUsage(subsystem);
+      total += usage.iLiveBytes;
+
+      stream << QString("%1 %2 %3 %4 %5\n").arg(IBMemoryAccounting::getSubsystemName(subsystem), -20)
+                .arg(usage.iLiveBytes / 1024, 12).arg(usage.iPeakBytes / 1024, 12)
+                .arg(usage.iLiveObjects, 12).arg(usage.iAllocations, 12);
+   }
+
+   stream << QString("%1 %2\n").arg(QStringLiteral("accounted"), -20).arg(total / 1024, 12);
+
+   if(resident >= 0)
+   {
+      stream << QString("%1 %2\n").arg(QStringLiteral("resident"), -20).arg(resident / 1024, 12);
+      stream << QString("%1 %2\n").arg(QStringLiteral("not accounted"), -20).arg((resident - total) / 1024, 12);
+   }
+
+   stream.flush();
+
+   return report;
+}
+
+/* Writes the report of createReport to the standard error output, whenever the process receives SIGUSR1.
+   The signal handler only wakes the event loop through a pipe, the report is created by the event loop.
+   It has to be called once after the construction of the application object. Returns false, if the signal
+   is not supported or the pipe cannot be created. */
+bool IBMemoryAccounting::installReportSignal()
+{
+#ifdef Q_OS_UNIX
+   QSocketNotifier *notifier;
+   struct sigaction action;
+
+   if(iReportPipe[0] >= 0 || !QCoreApplication::instance() || ::pipe(iReportPipe) != 0)
+   {
+      return false;
+   }
+
+   ::fcntl(iReportPipe[0], F_SETFD, FD_CLOEXEC);
+   ::fcntl(iReportPipe[1], F_SETFD, FD_CLOEXEC);
+   ::fcntl(iReportPipe[1], F_SETFL, ::fcntl(iReportPipe[1], F_GETFL) | O_NONBLOCK);
+
+   notifier = new QSocketNotifier(iReportPipe[0], QSocketNotifier::Read, QCoreApplication::instance());
+   QObject::connect(notifier, &QSocketNotifier::activated, notifier, []()
+      {
+         QTextStream stream(stderr);
+         char byte;
+
+         if(::read(iReportPipe[0], &byte, 1) == 1)
+         {
+            stream << IBMemoryAccounting::createReport();
+            stream.flush();
+         }
+      });
+
+   action.sa_handler = onReportSignal;
+   sigemptyset(&action.sa_mask);
+   action.sa_flags = SA_RESTART;
+
+   return ::sigaction(SIGUSR1, &action, nullptr) == 0;
+#else
+   return false;
+#endif /*Q_OS_UNIX*/
+}
+
+/* Raises the peak of the subsystem (subsystem) to the given number of bytes (bytes), if it is higher. */
+void IBMemoryAccounting::updatePeak(IBMemoryAccounting::Subsystem subsystem, qint64 bytes)
+{
+   qint64 peak = IBMemoryAccounting::iPeakBytes[subsystem].load(std::memory_order_relaxed);
+
+   while(bytes > peak && !IBMemoryAccounting::iPeakBytes[subsystem].compare_exchange_weak(peak, bytes,
+                                                                                           std::memory_order_relaxed))
+   {
+   }
+}
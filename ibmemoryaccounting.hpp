@@ -0,0 +1,68 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBMEMORYACCOUNTING
+#define H_IBMEMORYACCOUNTING
+
+#include <QString>
+
+#include <atomic>
+
+/* struct IBMemoryUsage */
+
+struct IBMemoryUsage
+{
+   /* bytes held at the moment */
+   qint64 iLiveBytes = 0;
+   /* objects or buffers held at the moment */
+   qint64 iLiveObjects = 0;
+   /* highest number of bytes held since the start */
+   qint64 iPeakBytes = 0;
+   /* number of allocated objects or buffers since the start */
+   qint64 iAllocations = 0;
+};
+
+/* class IBMemoryAccounting */
+
+class IBMemoryAccounting
+{
+   public:
+      /* subsystems, whose memory is accounted */
+      enum Subsystem
+      {
+         ModelItems,
+         SectionLists,
+         Thumbnails,
+         DecoderBuffers,
+         Preview,
+         PreviewCache,
+         ViewerTiles,
+         ViewerSource,
+         DirectoryTree,
+         SubsystemCount
+      };
+
+      static void allocate(IBMemoryAccounting::Subsystem subsystem, qint64 bytes, qint64 objects = 1);
+      static void release(IBMemoryAccounting::Subsystem subsystem, qint64 bytes, qint64 objects = 1);
+      static void resize(IBMemoryAccounting::Subsystem subsystem, qint64 oldbytes, qint64 newbytes);
+      static void setUsage(IBMemoryAccounting::Subsystem subsystem, qint64 bytes, qint64 objects,
+                           qint64 allocations = 0);
+
+      static IBMemoryUsage getUsage(IBMemoryAccounting::Subsystem subsystem);
+      static QString getSubsystemName(IBMemoryAccounting::Subsystem subsystem);
+      static qint64 getResidentSize();
+      static QString createReport();
+
+      static bool installReportSignal();
+
+   private:
+      static void updatePeak(IBMemoryAccounting::Subsystem subsystem, qint64 bytes);
+
+      /* counters of IBMemoryUsage per subsystem, they are updated from any thread */
+      static std::atomic<qint64> iLiveBytes[SubsystemCount];
+      static std::atomic<qint64> iLiveObjects[SubsystemCount];
+      static std::atomic<qint64> iPeakBytes[SubsystemCount];
+      static std::atomic<qint64> iAllocations[SubsystemCount];
+};
+
+#endif /*H_IBMEMORYACCOUNTING*/
@@ -0,0 +1,237 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibpreviewprefetcher.hpp"
+
+/* maximal number of prefetched neighbours regardless of the memory budget */
+static const int iMaxRingSize = 16;
+
+/* class IBPreviewPrefetcher */
+
+/* Constructs the thread for prefetching previews with a default memory budget of 48 MiB. */
+IBPreviewPrefetcher::IBPreviewPrefetcher(QObject *parent)
+   : QThread(parent), szPreviewSize(QSize(800, 600)), iMemoryBudget(48 * 1024 * 1024)
+{
+   this->chPreviews.setMaxCost(this->iMemoryBudget / 1024);
+}
+
+/* Stops the thread before it is destroyed. The cached previews are no longer accounted. */
+IBPreviewPrefetcher::~IBPreviewPrefetcher()
+{
+   this->stop();
+   IBMemoryAccounting::setUsage(IBMemoryAccounting::PreviewCache, 0, 0);
+}
+
+/* Decodes the queued paths one after another and stores the previews in the cache.
+   If a preview is decoded, the signal imagePrefetched is emitted. */
+void IBPreviewPrefetcher::run()
+{
+   QString path;
+   QSize previewsize;
+   IBPreviewEntry *entry;
+   bool cached;
+
+   forever
+   {
+      this->mtxQueue.lock();
+
+      while(this->slQueue.isEmpty() && !this->isInterruptionRequested())
+      {
+         this->wcQueue.wait(&this->mtxQueue);
+      }
+
+      if(this->isInterruptionRequested())
+      {
+         this->mtxQueue.unlock();
+         return;
+      }
+
+      path = this->slQueue.takeFirst();
+      IB_TRACE_COUNTER("preview", "previewsQueued", this->slQueue.size());
+      previewsize = this->szPreviewSize;
+      cached = this->chPreviews.contains(path);
+      this->mtxQueue.unlock();
+
+      if(cached)
+      {
+         continue;
+      }
+
+      entry = new IBPreviewEntry;
+      entry->imgPreview = IBPreviewPrefetcher::loadPreview(path, previewsize, &entry->szImageSize);
+      entry->szPreviewSize = previewsize;
+
+      this->mtxQueue.lock();
+      this->chPreviews.insert(path, entry, qMax<qint64>(1, entry->imgPreview.sizeInBytes() / 1024));
+      this->updateMemoryAccounting(1);
+      this->mtxQueue.unlock();
+
+      emit this->imagePrefetched(path);
+   }
+}
+
+/* Sets the upper bound (bytes) of the memory used by the cached previews. */
+void IBPreviewPrefetcher::setMemoryBudget(qint64 bytes)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->iMemoryBudget = bytes;
+   this->chPreviews.setMaxCost(bytes / 1024);
+   this->updateMemoryAccounting(0);
+}
+
+/* Returns the upper bound of the memory used by the cached previews. */
+qint64 IBPreviewPrefetcher::getMemoryBudget() const
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   return this->iMemoryBudget;
+}
+
+/* Sets the size of the area (size) the previews are decoded for. */
+void IBPreviewPrefetcher::setPreviewSize(const QSize &size)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->szPreviewSize = size.expandedTo(QSize(1, 1));
+}
+
+/* Returns the size of the area the previews are decoded for. */
+QSize IBPreviewPrefetcher::getPreviewSize() const
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   return this->szPreviewSize;
+}
+
+/* Returns the number of neighbours that fit into the memory budget beside the currently displayed image. */
+int IBPreviewPrefetcher::getRingSize() const
+{
+   QMutexLocker locker(&this->mtxQueue);
+   qint64 entrysize = qint64(this->szPreviewSize.width()) * this->szPreviewSize.height() * 4;
+
+   return qBound<qint64>(0, this->iMemoryBudget / qMax<qint64>(1, entrysize) - 1, iMaxRingSize);
+}
+
+/* Replaces the queued paths by the given paths (paths) ordered by priority and wakes the thread.
+   Already cached previews are marked as recently used, so that they are not evicted by the new ones. */
+void IBPreviewPrefetcher::prefetch(const QStringList &paths)
+{
+   QStringList::const_iterator it;
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->slQueue.clear();
+
+   for(it = paths.begin(); it != paths.end(); ++it)
+   {
+      if(this->chPreviews.object(*it) == nullptr)
+      {
+         this->slQueue.append(*it);
+      }
+   }
+
+   if(!this->slQueue.isEmpty())
+   {
+      if(!this->isRunning())
+      {
+         this->start(QThread::LowPriority);
+      }
+      this->wcQueue.wakeOne();
+   }
+}
+
+/* Looks up the preview of the given path (path). If a preview exists that is large enough for the given size
+   (previewsize), it is stored in image and the original size of the image in imagesize and true is returned.
+   Otherwise false. */
+bool IBPreviewPrefetcher::findPreview(const QString &path, const QSize &previewsize, QImage *image, QSize *imagesize)
+{
+   QMutexLocker locker(&this->mtxQueue);
+   IBPreviewEntry *entry = this->chPreviews.object(path);
+
+   if(!entry)
+   {
+      return false;
+   }
+
+   if(entry->szPreviewSize.width() < previewsize.width() || entry->szPreviewSize.height() < previewsize.height())
+   {
+      /* a preview decoded for a smaller area is only usable, if it already has the original size */
+      if(entry->imgPreview.size() != entry->szImageSize)
+      {
+         return false;
+      }
+   }
+
+   *image = entry->imgPreview;
+   *imagesize = entry->szImageSize;
+
+   return true;
+}
+
+/* Stores a preview (image) of the path (path), which was decoded outside of the thread, in the cache. */
+void IBPreviewPrefetcher::insertPreview(const QString &path, const QImage &image, const QSize &imagesize,
+                                        const QSize &previewsize)
+{
+   QMutexLocker locker(&this->mtxQueue);
+   IBPreviewEntry *entry = new IBPreviewEntry;
+
+   entry->imgPreview = image;
+   entry->szImageSize = imagesize;
+   entry->szPreviewSize = previewsize;
+
+   this->chPreviews.insert(path, entry, qMax<qint64>(1, image.sizeInBytes() / 1024));
+   this->updateMemoryAccounting(1);
+}
+
+/* Stops the thread and discards the queued paths. */
+void IBPreviewPrefetcher::stop()
+{
+   this->mtxQueue.lock();
+   this->slQueue.clear();
+   this->requestInterruption();
+   this->wcQueue.wakeAll();
+   this->mtxQueue.unlock();
+
+   this->wait();
+}
+
+/* Accounts the current size of the cache in IBMemoryAccounting and adds the number of inserted previews
+   (allocations). The mutex has to be locked by the caller. */
+void IBPreviewPrefetcher::updateMemoryAccounting(qint64 allocations)
+{
+   IBMemoryAccounting::setUsage(IBMemoryAccounting::PreviewCache, qint64(this->chPreviews.totalCost()) * 1024,
+                                this->chPreviews.size(), allocations);
+}
+
+/* Loads the image of the given path (path) scaled down to fit into the given size (previewsize). If the image format
+   supports scaled decoding, the full resolution image is never materialized. RAW files are loaded from their largest
+   embedded preview. The original size of the image is stored in imagesize. */
+QImage IBPreviewPrefetcher::loadPreview(const QString &path, const QSize &previewsize, QSize *imagesize)
+{
+   IB_TRACE_SCOPE("preview", "loadPreview");
+   QBuffer buffer;
+   QImageReader reader;
+   QSize fullsize;
+   QImage image;
+
+   if(!IBRawPreview::openPreview(path, &buffer, &reader))
+   {
+      reader.setFileName(path);
+   }
+
+   fullsize = reader.size();
+
+   if(fullsize.isValid() && (fullsize.width() > previewsize.width() || fullsize.height() > previewsize.height()))
+   {
+      reader.setScaledSize(fullsize.scaled(previewsize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1)));
+   }
+
+   image = reader.read();
+
+   if(imagesize)
+   {
+      *imagesize = fullsize.isValid() ? fullsize : image.size();
+   }
+
+   return image;
+}
@@ -0,0 +1,81 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBPREVIEWPREFETCHER
+#define H_IBPREVIEWPREFETCHER
+
+#include <QBuffer>
+#include <QCache>
+#include <QImage>
+#include <QImageReader>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "ibmemoryaccounting.hpp"
+#include "ibrawpreview.hpp"
+#include "ibtrace.hpp"
+
+/* struct IBPreviewEntry */
+
+struct IBPreviewEntry
+{
+   /* image decoded at preview resolution */
+   QImage imgPreview;
+   /* original size of the image */
+   QSize szImageSize;
+   /* preview size the image was decoded for */
+   QSize szPreviewSize;
+};
+
+/* class IBPreviewPrefetcher */
+
+class IBPreviewPrefetcher : public QThread
+{
+   Q_OBJECT
+
+   public:
+      IBPreviewPrefetcher(QObject *parent = nullptr);
+      ~IBPreviewPrefetcher();
+
+      void run() override;
+
+      void setMemoryBudget(qint64 bytes);
+      qint64 getMemoryBudget() const;
+
+      void setPreviewSize(const QSize &size);
+      QSize getPreviewSize() const;
+
+      int getRingSize() const;
+
+      void prefetch(const QStringList &paths);
+      bool findPreview(const QString &path, const QSize &previewsize, QImage *image, QSize *imagesize);
+      void insertPreview(const QString &path, const QImage &image, const QSize &imagesize, const QSize &previewsize);
+      void stop();
+
+      static QImage loadPreview(const QString &path, const QSize &previewsize, QSize *imagesize = nullptr);
+
+   signals:
+      void imagePrefetched(const QString &path);
+
+   private:
+      void updateMemoryAccounting(qint64 allocations);
+
+      /* protects the queue, the cache and the preview size */
+      mutable QMutex mtxQueue;
+      /* wakes the thread when new paths are queued */
+      QWaitCondition wcQueue;
+      /* paths to be decoded, ordered by priority */
+      QStringList slQueue;
+      /* decoded previews, the cost of an entry is its size in KiB */
+      QCache<QString, IBPreviewEntry> chPreviews;
+      /* size of the area the previews are decoded for */
+      QSize szPreviewSize;
+      /* upper bound of the memory used by the cached previews in bytes */
+      qint64 iMemoryBudget;
+};
+
+#endif /*H_IBPREVIEWPREFETCHER*/
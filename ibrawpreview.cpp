@@ -0,0 +1,362 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibrawpreview.hpp"
+
+/* tags of the IFD entries, which locate the embedded previews */
+static const quint16 iTagCompression = 0x0103;
+static const quint16 iTagStripOffsets = 0x0111;
+static const quint16 iTagStripByteCounts = 0x0117;
+static const quint16 iTagSubIfds = 0x014A;
+static const quint16 iTagJpegOffset = 0x0201;
+static const quint16 iTagJpegLength = 0x0202;
+
+/* types of the values of the IFD entries */
+static const quint16 iTypeShort = 3;
+
+/* compressions of the TIFF specification, which store a JPEG stream */
+static const quint16 iCompressionOldJpeg = 6;
+static const quint16 iCompressionJpeg = 7;
+
+/* limits of the walk, so that a damaged file cannot make it read much */
+static const int iMaxIfds = 32;
+static const quint32 iMaxEntries = 1024;
+static const quint32 iMaxSubIfds = 8;
+static const int iMaxSegments = 64;
+
+/* class IBRawPreview */
+
+/* Constructs a finder of the embedded JPEG previews of a TIFF-based RAW file (device), which has to be open. */
+IBRawPreview::IBRawPreview(QIODevice *device)
+   : pDevice(device), bLittleEndian(false), iPreviewOffset(0), iPreviewLength(0)
+{
+}
+
+/* Walks the IFDs of the file, i.e. IFD0, the following IFDs and the SubIFDs, and finds the largest embedded JPEG
+   preview. Previews are referred to by JPEGInterchangeFormat or, if the compression is JPEG, by a single strip.
+   Only the frame header of every candidate is read to get its size, so that the lossless JPEG streams of the raw data
+   in CR2 and DNG files are rejected without reading them. Returns false, if no preview is found. */
+bool IBRawPreview::findPreview()
+{
+   QList<quint32> ifds, visited;
+   uchar header[8];
+   quint32 offset;
+
+   this->iPreviewOffset = 0;
+   this->iPreviewLength = 0;
+   this->szPreview = QSize();
+
+   if(!this->readBytes(0, header, 8))
+   {
+      return false;
+   }
+
+   if(header[0] == 'I' && header[1] == 'I')
+   {
+      this->bLittleEndian = true;
+   }
+   else if(header[0] == 'M' && header[1] == 'M')
+   {
+      this->bLittleEndian = false;
+   }
+   else
+   {
+      return false;
+   }
+
+   if(this->getShort(header + 2) != 42)
+   {
+      return false;
+   }
+
+   ifds.append(this->getLong(header + 4));
+
+   while(!ifds.isEmpty() && visited.size() < iMaxIfds)
+   {
+      offset = ifds.takeFirst();
+
+      /* an offset within the header ends the chain, a visited one would loop */
+      if(offset < 8 || visited.contains(offset))
+      {
+         continue;
+      }
+
+      visited.append(offset);
+      this->readIfd(offset, &ifds);
+   }
+
+   return this->iPreviewLength > 0;
+}
+
+/* Reads the found preview into data, which has to hold getPreviewLength bytes. Returns false, if no preview was
+   found or it cannot be read. */
+bool IBRawPreview::readPreview(char *data)
+{
+   return this->iPreviewLength > 0
+          && this->readBytes(this->iPreviewOffset, reinterpret_cast<uchar *>(data), this->iPreviewLength);
+}
+
+/* Returns the number of bytes of the found preview, 0 if none is found. */
+qint64 IBRawPreview::getPreviewLength() const
+{
+   return this->iPreviewLength;
+}
+
+/* Returns the size of the found preview in pixels. */
+QSize IBRawPreview::getPreviewSize() const
+{
+   return this->szPreview;
+}
+
+/* Returns true, if the file starting with the given bytes (header) is a TIFF structure in either byte order, like the
+   RAW files of most cameras. Otherwise false. */
+bool IBRawPreview::hasSignature(const QByteArray &header)
+{
+   return header.startsWith(QByteArray("II*\0", 4)) || header.startsWith(QByteArray("MM\0*", 4));
+}
+
+/* Returns true, if the file (path) has the suffix of a supported RAW format. Otherwise false. */
+bool IBRawPreview::isRawFileName(const QString &path)
+{
+   static const QStringList suffixes = {"arw", "cr2", "dng", "nef"};
+
+   return suffixes.contains(QFileInfo(path).suffix(), Qt::CaseInsensitive);
+}
+
+/* Returns the name filters of the supported RAW formats. */
+QStringList IBRawPreview::getNameFilters()
+{
+   QStringList namefilters;
+
+   namefilters << "*.arw" << "*.cr2" << "*.dng" << "*.nef";
+
+   return namefilters;
+}
+
+/* Sets up the image reader (reader) to decode the largest embedded preview of the RAW file (path). The preview is
+   read into the buffer (buffer), which has to outlive the reader. Returns false, if the file has no suffix of a RAW
+   format or no preview is found, the reader is unchanged then. */
+bool IBRawPreview::openPreview(const QString &path, QBuffer *buffer, QImageReader *reader)
+{
+   QFile file(path);
+   IBRawPreview preview(&file);
+   QByteArray data;
+
+   if(!IBRawPreview::isRawFileName(path) || !file.open(QIODevice::ReadOnly) || !preview.findPreview())
+   {
+      return false;
+   }
+
+   IB_TRACE_SCOPE("preview", "readRawPreview");
+   data.resize(int(preview.getPreviewLength()));
+
+   if(!preview.readPreview(data.data()))
+   {
+      return false;
+   }
+
+   buffer->setData(data);
+   buffer->open(QIODevice::ReadOnly);
+   reader->setDevice(buffer);
+   reader->setFormat("jpeg");
+
+   return true;
+}
+
+/* Reads the entries of the IFD at the given offset (offset) and checks its preview. The offsets of its SubIFDs and
+   of the following IFD are appended to ifds. */
+void IBRawPreview::readIfd(quint32 offset, QList<quint32> *ifds)
+{
+   QByteArray entries;
+   const uchar *entry;
+   uchar value[4];
+   quint32 stored, count, idx, subidx, subcount, jpegoffset = 0, jpeglength = 0, stripoffset = 0, striplength = 0;
+   quint32 compression = 0;
+   bool singlestrip = false;
+
+   if(!this->readBytes(offset, value, 2))
+   {
+      return;
+   }
+
+   stored = this->getShort(value);
+   count = qMin(stored, iMaxEntries);
+   entries.resize(int(count * 12 + 4));
+
+   if(!this->readBytes(qint64(offset) + 2, reinterpret_cast<uchar *>(entries.data()), entries.size()))
+   {
+      return;
+   }
+
+   for(idx = 0; idx < count; idx++)
+   {
+      entry = reinterpret_cast<const uchar *>(entries.constData()) + idx * 12;
+
+      switch(this->getShort(entry))
+      {
+         case iTagCompression:
+            compression = this->getValue(entry);
+            break;
+
+         case iTagStripOffsets:
+            stripoffset = this->getValue(entry);
+            singlestrip = this->getLong(entry + 4) == 1;
+            break;
+
+         case iTagStripByteCounts:
+            striplength = this->getValue(entry);
+            break;
+
+         case iTagJpegOffset:
+            jpegoffset = this->getValue(entry);
+            break;
+
+         case iTagJpegLength:
+            jpeglength = this->getValue(entry);
+            break;
+
+         case iTagSubIfds:
+            subcount = qMin(this->getLong(entry + 4), iMaxSubIfds);
+
+            /* a single offset is stored in the entry, several ones in an array */
+            if(subcount == 1)
+            {
+               ifds->append(this->getLong(entry + 8));
+            }
+
+            for(subidx = 0; subcount > 1 && subidx < subcount; subidx++)
+            {
+               if(this->readBytes(qint64(this->getLong(entry + 8)) + subidx * 4, value, 4))
+               {
+                  ifds->append(this->getLong(value));
+               }
+            }
+            break;
+      }
+   }
+
+   if(jpegoffset != 0 && jpeglength != 0)
+   {
+      this->checkCandidate(jpegoffset, jpeglength);
+   }
+
+   if((compression == iCompressionOldJpeg || compression == iCompressionJpeg) && singlestrip && stripoffset != 0)
+   {
+      this->checkCandidate(stripoffset, striplength);
+   }
+
+   /* the offset of the next IFD follows the entries, unless they were cut off */
+   if(count == stored)
+   {
+      ifds->append(this->getLong(reinterpret_cast<const uchar *>(entries.constData()) + count * 12));
+   }
+}
+
+/* Reads the frame header of the JPEG stream at the given offset (offset) with the given number of bytes (length)
+   and takes it as the preview, if it is a baseline or progressive frame with 8 bit samples, which is larger than the
+   preview found so far. The segments before the frame header are skipped by their lengths, the scan is never read. */
+void IBRawPreview::checkCandidate(quint32 offset, quint32 length)
+{
+   qint64 pos = qint64(offset) + 2, end = qint64(offset) + length;
+   uchar segment[5];
+   QSize size;
+   uchar marker;
+   int idx;
+
+   if(length < 4 || length > IBRawPreview::iMaxPreviewLength || end > this->pDevice->size())
+   {
+      return;
+   }
+
+   if(!this->readBytes(offset, segment, 2) || segment[0] != 0xFF || segment[1] != 0xD8)
+   {
+      return;
+   }
+
+   for(idx = 0; idx < iMaxSegments && pos + 4 <= end; idx++)
+   {
+      if(!this->readBytes(pos, segment, 4) || segment[0] != 0xFF)
+      {
+         return;
+      }
+
+      marker = segment[1];
+
+      /* fill bytes */
+      if(marker == 0xFF)
+      {
+         pos++;
+         continue;
+      }
+
+      /* the frame header precedes the scan */
+      if(marker == 0xDA || marker == 0xD9)
+      {
+         return;
+      }
+
+      /* the frame headers except the huffman and arithmetic coding tables, only baseline, extended and progressive
+         frames are decodable previews, the lossless frames (0xC3) hold the raw data */
+      if(marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+      {
+         if(marker > 0xC2 || !this->readBytes(pos + 4, segment, 5) || segment[0] != 8)
+         {
+            return;
+         }
+
+         size = QSize((segment[3] << 8) | segment[4], (segment[1] << 8) | segment[2]);
+
+         if(!size.isEmpty() && qint64(size.width()) * size.height()
+                               > qint64(this->szPreview.width()) * this->szPreview.height())
+         {
+            this->iPreviewOffset = offset;
+            this->iPreviewLength = length;
+            this->szPreview = size;
+         }
+
+         return;
+      }
+
+      pos += 2 + ((segment[2] << 8) | segment[3]);
+   }
+}
+
+/* Reads the given number of bytes (size) at the offset (offset) of the file into data. Returns false, if the bytes
+   lie beyond the end of the file. */
+bool IBRawPreview::readBytes(qint64 offset, uchar *data, qint64 size)
+{
+   return this->pDevice->seek(offset) && this->pDevice->read(reinterpret_cast<char *>(data), size) == size;
+}
+
+/* Returns the 16 bit value at the given position (data) in the byte order of the file. */
+quint16 IBRawPreview::getShort(const uchar *data) const
+{
+   if(this->bLittleEndian)
+   {
+      return quint16(data[0] | (data[1] << 8));
+   }
+
+   return quint16((data[0] << 8) | data[1]);
+}
+
+/* Returns the 32 bit value at the given position (data) in the byte order of the file. */
+quint32 IBRawPreview::getLong(const uchar *data) const
+{
+   if(this->bLittleEndian)
+   {
+      return (quint32(data[3]) << 24) | (quint32(data[2]) << 16) | (quint32(data[1]) << 8) | quint32(data[0]);
+   }
+
+   return (quint32(data[0]) << 24) | (quint32(data[1]) << 16) | (quint32(data[2]) << 8) | quint32(data[3]);
+}
+
+/* Returns the first value of the IFD entry (entry), which is either a short or a long value. */
+quint32 IBRawPreview::getValue(const uchar *entry) const
+{
+   if(this->getShort(entry + 2) == iTypeShort)
+   {
+      return this->getShort(entry + 8);
+   }
+
+   return this->getLong(entry + 8);
+}
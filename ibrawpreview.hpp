@@ -0,0 +1,58 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBRAWPREVIEW
+#define H_IBRAWPREVIEW
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QImageReader>
+#include <QList>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+
+#include "ibtrace.hpp"
+
+/* class IBRawPreview */
+
+class IBRawPreview
+{
+   public:
+      IBRawPreview(QIODevice *device);
+
+      bool findPreview();
+      bool readPreview(char *data);
+      qint64 getPreviewLength() const;
+      QSize getPreviewSize() const;
+
+      static bool hasSignature(const QByteArray &header);
+      static bool isRawFileName(const QString &path);
+      static QStringList getNameFilters();
+      static bool openPreview(const QString &path, QBuffer *buffer, QImageReader *reader);
+
+      /* largest embedded preview, which is read */
+      static const qint64 iMaxPreviewLength = 64 * 1024 * 1024;
+
+   private:
+      void readIfd(quint32 offset, QList<quint32> *ifds);
+      void checkCandidate(quint32 offset, quint32 length);
+      bool readBytes(qint64 offset, uchar *data, qint64 size);
+      quint16 getShort(const uchar *data) const;
+      quint32 getLong(const uchar *data) const;
+      quint32 getValue(const uchar *entry) const;
+
+      /* opened device of the RAW file */
+      QIODevice *pDevice;
+      /* is true, if the values of the TIFF structure are stored in little endian order */
+      bool bLittleEndian;
+      /* position, length and size of the largest preview found so far, the length is 0 if none is found */
+      qint64 iPreviewOffset;
+      qint64 iPreviewLength;
+      QSize szPreview;
+};
+
+#endif /*H_IBRAWPREVIEW*/
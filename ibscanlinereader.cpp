@@ -0,0 +1,1266 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibscanlinereader.hpp"
+
+#include <cstring>
+
+/* size of the blocks read from the device */
+static const int iReadBlockSize = 64 * 1024;
+/* largest width and height of an image, larger values are taken as a corrupt header */
+static const int iMaxDimension = 1024 * 1024;
+/* largest number of bits of a row */
+static const qint64 iMaxRowBits = 0x3FFFFFFF;
+
+/* Returns the 32 bit big endian value stored at the given position (data). */
+static inline quint32 readBigEndian32(const uchar *data)
+{
+   return (quint32(data[0]) << 24) | (quint32(data[1]) << 16) | (quint32(data[2]) << 8) | quint32(data[3]);
+}
+
+/* Returns the 32 bit little endian value stored at the given position (data). */
+static inline quint32 readLittleEndian32(const uchar *data)
+{
+   return (quint32(data[3]) << 24) | (quint32(data[2]) << 16) | (quint32(data[1]) << 8) | quint32(data[0]);
+}
+
+/* class IBScanlineReader */
+
+/* Constructs a reader, which decodes an image row by row from the given device (device). */
+IBScanlineReader::IBScanlineReader(QIODevice *device)
+   : ioDevice(device), bAlphaChannel(false), bBottomUp(false)
+{
+}
+
+/* Destructs the reader. */
+IBScanlineReader::~IBScanlineReader()
+{
+}
+
+/* Returns the size of the image. It is valid after readHeader was called successfully. */
+QSize IBScanlineReader::getSize() const
+{
+   return this->szImage;
+}
+
+/* Returns true if the image has an alpha channel. Otherwise false. */
+bool IBScanlineReader::hasAlphaChannel() const
+{
+   return this->bAlphaChannel;
+}
+
+/* Returns true if readScanline returns the rows from the bottom to the top of the image. Otherwise false. */
+bool IBScanlineReader::isBottomUp() const
+{
+   return this->bBottomUp;
+}
+
+/* Reads exactly the given number of bytes (size) into data. Returns false if the device ends before. */
+bool IBScanlineReader::readBytes(char *data, qint64 size)
+{
+   qint64 read;
+
+   while(size > 0)
+   {
+      read = this->ioDevice->read(data, size);
+
+      if(read <= 0)
+      {
+         return false;
+      }
+
+      data += read;
+      size -= read;
+   }
+
+   return true;
+}
+
+/* Returns a new reader for the given image format (format) reading from the device (device). If the format is not
+   supported for decoding row by row, nullptr is returned. */
+IBScanlineReader *IBScanlineReader::create(QIODevice *device, const QByteArray &format)
+{
+#ifdef IB_HAVE_ZLIB
+   if(format == "png")
+   {
+      return new IBPngScanlineReader(device);
+   }
+#endif /*IB_HAVE_ZLIB*/
+
+   if(format == "bmp")
+   {
+      return new IBBmpScanlineReader(device);
+   }
+
+   if(format == "ppm" || format == "pgm")
+   {
+      return new IBPnmScanlineReader(device);
+   }
+
+   if(format == "tiff")
+   {
+      return new IBTiffScanlineReader(device);
+   }
+
+   return nullptr;
+}
+
+#ifdef IB_HAVE_ZLIB
+
+/* class IBPngScanlineReader */
+
+/* Constructs a reader for non-interlaced PNG images. */
+IBPngScanlineReader::IBPngScanlineReader(QIODevice *device)
+   : IBScanlineReader(device), bStreamInitialized(false), iChunkRemaining(0), iBitDepth(0), iColorType(0),
+     iChannels(0), iRowBytes(0), iRow(0)
+{
+}
+
+/* Releases the state of the decompression. */
+IBPngScanlineReader::~IBPngScanlineReader()
+{
+   if(this->bStreamInitialized)
+   {
+      inflateEnd(&this->zsStream);
+   }
+}
+
+/* Reads the chunks up to the first IDAT chunk. Returns false if the image is not a PNG image or uses
+   an unsupported feature (e.g. interlacing). */
+bool IBPngScanlineReader::readHeader()
+{
+   static const uchar signature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+   QByteArray type, data;
+   quint32 length;
+   uchar hbuf[13];
+   int idx;
+
+   if(!this->readBytes(reinterpret_cast<char *>(hbuf), 8) || memcmp(hbuf, signature, 8) != 0)
+   {
+      return false;
+   }
+
+   forever
+   {
+      if(!this->readChunkHeader(&length, &type))
+      {
+         return false;
+      }
+
+      if(type == "IDAT")
+      {
+         this->iChunkRemaining = length;
+         break;
+      }
+
+      if(length > 1024 * 1024)
+      {
+         /* skip large ancillary chunks like embedded profiles without buffering them */
+         if(!this->ioDevice->seek(this->ioDevice->pos() + length + 4))
+         {
+            return false;
+         }
+         continue;
+      }
+
+      data.resize(int(length));
+      if(!this->readBytes(data.data(), length) || !this->readBytes(reinterpret_cast<char *>(hbuf), 4))
+      {
+         return false;
+      }
+
+      if(type == "IHDR")
+      {
+         if(length != 13)
+         {
+            return false;
+         }
+
+         this->szImage = QSize(int(readBigEndian32(reinterpret_cast<const uchar *>(data.constData()))),
+                               int(readBigEndian32(reinterpret_cast<const uchar *>(data.constData()) + 4)));
+         this->iBitDepth = uchar(data[8]);
+         this->iColorType = uchar(data[9]);
+
+         /* compression, filter and interlace method */
+         if(data[10] != 0 || data[11] != 0 || data[12] != 0)
+         {
+            return false;
+         }
+      }
+      else if(type == "PLTE")
+      {
+         this->vecPalette.resize(int(length / 3));
+         for(idx = 0; idx < this->vecPalette.size(); idx++)
+         {
+            this->vecPalette[idx] = qRgb(uchar(data[idx * 3]), uchar(data[idx * 3 + 1]), uchar(data[idx * 3 + 2]));
+         }
+      }
+      else if(type == "tRNS" && this->iColorType == 3)
+      {
+         for(idx = 0; idx < int(length) && idx < this->vecPalette.size(); idx++)
+         {
+            this->vecPalette[idx] = qRgba(qRed(this->vecPalette[idx]), qGreen(this->vecPalette[idx]),
+                                          qBlue(this->vecPalette[idx]), uchar(data[idx]));
+         }
+         this->bAlphaChannel = true;
+      }
+   }
+
+   switch(this->iColorType)
+   {
+      case 0: this->iChannels = 1; break;
+      case 2: this->iChannels = 3; break;
+      case 3: this->iChannels = 1; break;
+      case 4: this->iChannels = 2; this->bAlphaChannel = true; break;
+      case 6: this->iChannels = 4; this->bAlphaChannel = true; break;
+      default: return false;
+   }
+
+   if(this->szImage.isEmpty() || this->szImage.width() > iMaxDimension || this->szImage.height() > iMaxDimension ||
+      qint64(this->szImage.width()) * this->iChannels * this->iBitDepth > iMaxRowBits ||
+      (this->iColorType == 3 && this->vecPalette.isEmpty()) ||
+      (this->iBitDepth != 1 && this->iBitDepth != 2 && this->iBitDepth != 4 && this->iBitDepth != 8 && this->iBitDepth != 16) ||
+      (this->iBitDepth < 8 && this->iColorType != 0 && this->iColorType != 3))
+   {
+      return false;
+   }
+
+   this->iRowBytes = int((qint64(this->szImage.width()) * this->iChannels * this->iBitDepth + 7) / 8);
+   this->baRow.resize(this->iRowBytes + 1);
+   this->baPreviousRow.fill(0, this->iRowBytes);
+
+   memset(&this->zsStream, 0, sizeof(this->zsStream));
+   if(inflateInit(&this->zsStream) != Z_OK)
+   {
+      return false;
+   }
+   this->bStreamInitialized = true;
+
+   return true;
+}
+
+/* Reads the length (length) and the type (type) of the next chunk. */
+bool IBPngScanlineReader::readChunkHeader(quint32 *length, QByteArray *type)
+{
+   uchar hbuf[8];
+
+   if(!this->readBytes(reinterpret_cast<char *>(hbuf), 8))
+   {
+      return false;
+   }
+
+   *length = readBigEndian32(hbuf);
+   *type = QByteArray(reinterpret_cast<const char *>(hbuf + 4), 4);
+
+   return *length <= 0x7FFFFFFF;
+}
+
+/* Inflates the next row with its filter byte. The compressed data is read from the IDAT chunks in blocks. */
+bool IBPngScanlineReader::inflateRow()
+{
+   QByteArray type;
+   quint32 length;
+   uchar crc[4];
+   int result;
+
+   this->zsStream.next_out = reinterpret_cast<Bytef *>(this->baRow.data());
+   this->zsStream.avail_out = uInt(this->baRow.size());
+
+   while(this->zsStream.avail_out > 0)
+   {
+      if(this->zsStream.avail_in == 0)
+      {
+         while(this->iChunkRemaining == 0)
+         {
+            /* skip the CRC of the current chunk and continue with the next IDAT chunk */
+            if(!this->readBytes(reinterpret_cast<char *>(crc), 4) || !this->readChunkHeader(&length, &type) || type != "IDAT")
+            {
+               return false;
+            }
+            this->iChunkRemaining = length;
+         }
+
+         this->baInput.resize(int(qMin<quint32>(this->iChunkRemaining, iReadBlockSize)));
+         if(!this->readBytes(this->baInput.data(), this->baInput.size()))
+         {
+            return false;
+         }
+
+         this->iChunkRemaining -= quint32(this->baInput.size());
+         this->zsStream.next_in = reinterpret_cast<Bytef *>(this->baInput.data());
+         this->zsStream.avail_in = uInt(this->baInput.size());
+      }
+
+      result = inflate(&this->zsStream, Z_NO_FLUSH);
+
+      if(result == Z_STREAM_END && this->zsStream.avail_out > 0)
+      {
+         return false;
+      }
+      else if(result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/* Reverses the filter of the current row using the previous row. */
+void IBPngScanlineReader::unfilterRow()
+{
+   uchar *row = reinterpret_cast<uchar *>(this->baRow.data()) + 1;
+   const uchar *prev = reinterpret_cast<const uchar *>(this->baPreviousRow.constData());
+   int bpp = qMax(1, this->iChannels * this->iBitDepth / 8);
+   int idx, left, up, upleft, estimate, dleft, dup, dupleft;
+
+   switch(uchar(this->baRow[0]))
+   {
+      case 1:
+         for(idx = bpp; idx < this->iRowBytes; idx++)
+         {
+            row[idx] = uchar(row[idx] + row[idx - bpp]);
+         }
+         break;
+
+      case 2:
+         for(idx = 0; idx < this->iRowBytes; idx++)
+         {
+            row[idx] = uchar(row[idx] + prev[idx]);
+         }
+         break;
+
+      case 3:
+         for(idx = 0; idx < this->iRowBytes; idx++)
+         {
+            left = idx >= bpp ? row[idx - bpp] : 0;
+            row[idx] = uchar(row[idx] + ((left + prev[idx]) >> 1));
+         }
+         break;
+
+      case 4:
+         for(idx = 0; idx < this->iRowBytes; idx++)
+         {
+            left = idx >= bpp ? row[idx - bpp] : 0;
+            up = prev[idx];
+            upleft = idx >= bpp ? prev[idx - bpp] : 0;
+            estimate = left + up - upleft;
+            dleft = qAbs(estimate - left);
+            dup = qAbs(estimate - up);
+            dupleft = qAbs(estimate - upleft);
+
+            if(dleft <= dup && dleft <= dupleft)
+            {
+               row[idx] = uchar(row[idx] + left);
+            }
+            else if(dup <= dupleft)
+            {
+               row[idx] = uchar(row[idx] + up);
+            }
+            else
+            {
+               row[idx] = uchar(row[idx] + upleft);
+            }
+         }
+         break;
+   }
+
+   memcpy(this->baPreviousRow.data(), row, size_t(this->iRowBytes));
+}
+
+/* Converts the unfiltered row into premultiplied pixels (line). Samples with 16 bit are reduced to 8 bit. */
+void IBPngScanlineReader::convertRow(QRgb *line) const
+{
+   const uchar *row = reinterpret_cast<const uchar *>(this->baRow.constData()) + 1;
+   int step = this->iBitDepth / 8;
+   int width = this->szImage.width();
+   int x, value, shift, mask;
+
+   if(this->iBitDepth < 8)
+   {
+      mask = (1 << this->iBitDepth) - 1;
+
+      for(x = 0; x < width; x++)
+      {
+         shift = 8 - this->iBitDepth - (x * this->iBitDepth) % 8;
+         value = (row[(x * this->iBitDepth) / 8] >> shift) & mask;
+
+         if(this->iColorType == 3)
+         {
+            line[x] = qPremultiply(this->vecPalette.value(value));
+         }
+         else
+         {
+            value = value * 255 / mask;
+            line[x] = qRgb(value, value, value);
+         }
+      }
+      return;
+   }
+
+   for(x = 0; x < width; x++)
+   {
+      switch(this->iColorType)
+      {
+         case 0:
+            line[x] = qRgb(row[0], row[0], row[0]);
+            break;
+
+         case 2:
+            line[x] = qRgb(row[0], row[step], row[2 * step]);
+            break;
+
+         case 3:
+            line[x] = qPremultiply(this->vecPalette.value(row[0]));
+            break;
+
+         case 4:
+            line[x] = qPremultiply(qRgba(row[0], row[0], row[0], row[step]));
+            break;
+
+         case 6:
+            line[x] = qPremultiply(qRgba(row[0], row[step], row[2 * step], row[3 * step]));
+            break;
+      }
+      row += this->iChannels * step;
+   }
+}
+
+/* reimpl. Decodes the next row into premultiplied pixels (line) and stores its number in row. */
+bool IBPngScanlineReader::readScanline(QRgb *line, int *row)
+{
+   if(this->iRow >= this->szImage.height() || !this->inflateRow())
+   {
+      return false;
+   }
+
+   this->unfilterRow();
+   this->convertRow(line);
+   *row = this->iRow++;
+
+   return true;
+}
+
+/* reimpl. Skips the rows up to the given row (row), so that it is returned by the next call of readScanline.
+   The compressed data is read in one pass, so that rows before the next one cannot be reached. */
+bool IBPngScanlineReader::seekScanline(int row)
+{
+   if(row < this->iRow || row >= this->szImage.height())
+   {
+      return false;
+   }
+
+   while(this->iRow < row)
+   {
+      if(!this->inflateRow())
+      {
+         return false;
+      }
+
+      this->unfilterRow();
+      this->iRow++;
+   }
+
+   return true;
+}
+
+#endif /*IB_HAVE_ZLIB*/
+
+/* class IBBmpScanlineReader */
+
+/* Constructs a reader for uncompressed BMP images with 24 or 32 bits per pixel. */
+IBBmpScanlineReader::IBBmpScanlineReader(QIODevice *device)
+   : IBScanlineReader(device), iDataOffset(0), iBitsPerPixel(0), iRowsRead(0)
+{
+}
+
+/* reimpl. Reads the file and info header and moves to the pixel data. */
+bool IBBmpScanlineReader::readHeader()
+{
+   uchar hbuf[34];
+   qint32 width, height;
+   quint32 offset, compression;
+
+   if(!this->readBytes(reinterpret_cast<char *>(hbuf), sizeof(hbuf)) || hbuf[0] != 'B' || hbuf[1] != 'M' ||
+      readLittleEndian32(hbuf + 14) < 40)
+   {
+      return false;
+   }
+
+   offset = readLittleEndian32(hbuf + 10);
+   width = qint32(readLittleEndian32(hbuf + 18));
+   height = qint32(readLittleEndian32(hbuf + 22));
+   this->iBitsPerPixel = hbuf[28] | (hbuf[29] << 8);
+   compression = readLittleEndian32(hbuf + 30);
+
+   if(compression != 0 || (this->iBitsPerPixel != 24 && this->iBitsPerPixel != 32) || width <= 0 || height == 0 ||
+      width > iMaxDimension || qAbs(qint64(height)) > iMaxDimension ||
+      qint64(width) * this->iBitsPerPixel > iMaxRowBits)
+   {
+      return false;
+   }
+
+   this->bBottomUp = height > 0;
+   this->szImage = QSize(width, qAbs(height));
+   this->baRow.resize(int(((qint64(width) * this->iBitsPerPixel + 31) / 32) * 4));
+   this->iDataOffset = offset;
+
+   return this->ioDevice->seek(offset);
+}
+
+/* reimpl. Decodes the next row of the file into pixels (line) and stores its number in row.
+   Bottom-up images deliver their rows from the last to the first one. */
+bool IBBmpScanlineReader::readScanline(QRgb *line, int *row)
+{
+   const uchar *data = reinterpret_cast<const uchar *>(this->baRow.constData());
+   int bytespp = this->iBitsPerPixel / 8;
+   int x;
+
+   if(this->iRowsRead >= this->szImage.height() || !this->readBytes(this->baRow.data(), this->baRow.size()))
+   {
+      return false;
+   }
+
+   for(x = 0; x < this->szImage.width(); x++)
+   {
+      line[x] = qRgb(data[2], data[1], data[0]);
+      data += bytespp;
+   }
+
+   *row = this->bBottomUp ? this->szImage.height() - 1 - this->iRowsRead : this->iRowsRead;
+   this->iRowsRead++;
+
+   return true;
+}
+
+/* reimpl. Moves to the given row (row), so that it is returned by the next call of readScanline. */
+bool IBBmpScanlineReader::seekScanline(int row)
+{
+   int index = this->bBottomUp ? this->szImage.height() - 1 - row : row;
+
+   if(row < 0 || row >= this->szImage.height() ||
+      !this->ioDevice->seek(this->iDataOffset + qint64(index) * this->baRow.size()))
+   {
+      return false;
+   }
+
+   this->iRowsRead = index;
+
+   return true;
+}
+
+/* class IBPnmScanlineReader */
+
+/* Constructs a reader for binary PGM (P5) and PPM (P6) images. */
+IBPnmScanlineReader::IBPnmScanlineReader(QIODevice *device)
+   : IBScanlineReader(device), iDataOffset(0), iChannels(0), iMaxValue(0), iRowsRead(0)
+{
+}
+
+/* Reads the next decimal value of the header into value. Comments are skipped. */
+bool IBPnmScanlineReader::readHeaderValue(int *value)
+{
+   char chr;
+
+   do
+   {
+      if(!this->ioDevice->getChar(&chr))
+      {
+         return false;
+      }
+
+      if(chr == '#')
+      {
+         while(chr != '\n' && this->ioDevice->getChar(&chr))
+         {
+         }
+      }
+   }while(chr == '#' || chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n');
+
+   *value = 0;
+
+   while(chr >= '0' && chr <= '9')
+   {
+      *value = *value * 10 + (chr - '0');
+
+      if(*value > 0xFFFFFF || !this->ioDevice->getChar(&chr))
+      {
+         return false;
+      }
+   }
+
+   /* exactly one whitespace character separates the header from the pixel data */
+   return chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n';
+}
+
+/* reimpl. Reads the header and moves to the pixel data. */
+bool IBPnmScanlineReader::readHeader()
+{
+   char magic[2];
+   int width, height;
+
+   if(!this->readBytes(magic, 2) || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6'))
+   {
+      return false;
+   }
+
+   this->iChannels = magic[1] == '5' ? 1 : 3;
+
+   if(!this->readHeaderValue(&width) || !this->readHeaderValue(&height) || !this->readHeaderValue(&this->iMaxValue) ||
+      width <= 0 || height <= 0 || width > iMaxDimension || height > iMaxDimension || this->iMaxValue <= 0 ||
+      this->iMaxValue > 65535 || qint64(width) * this->iChannels * 16 > iMaxRowBits)
+   {
+      return false;
+   }
+
+   this->szImage = QSize(width, height);
+   this->baRow.resize(width * this->iChannels * (this->iMaxValue > 255 ? 2 : 1));
+   this->iDataOffset = this->ioDevice->pos();
+
+   return true;
+}
+
+/* reimpl. Decodes the next row into pixels (line) and stores its number in row. */
+bool IBPnmScanlineReader::readScanline(QRgb *line, int *row)
+{
+   const uchar *data = reinterpret_cast<const uchar *>(this->baRow.constData());
+   int step = this->iMaxValue > 255 ? 2 : 1;
+   int x, red, green, blue;
+
+   if(this->iRowsRead >= this->szImage.height() || !this->readBytes(this->baRow.data(), this->baRow.size()))
+   {
+      return false;
+   }
+
+   for(x = 0; x < this->szImage.width(); x++)
+   {
+      red = step == 2 ? (data[0] << 8) | data[1] : data[0];
+      green = this->iChannels == 3 ? (step == 2 ? (data[2] << 8) | data[3] : data[1]) : red;
+      blue = this->iChannels == 3 ? (step == 2 ? (data[4] << 8) | data[5] : data[2]) : red;
+
+      line[x] = qRgb(red * 255 / this->iMaxValue, green * 255 / this->iMaxValue, blue * 255 / this->iMaxValue);
+      data += this->iChannels * step;
+   }
+
+   *row = this->iRowsRead++;
+
+   return true;
+}
+
+/* reimpl. Moves to the given row (row), so that it is returned by the next call of readScanline. */
+bool IBPnmScanlineReader::seekScanline(int row)
+{
+   if(row < 0 || row >= this->szImage.height() ||
+      !this->ioDevice->seek(this->iDataOffset + qint64(row) * this->baRow.size()))
+   {
+      return false;
+   }
+
+   this->iRowsRead = row;
+
+   return true;
+}
+
+/* class IBTiffScanlineReader */
+
+/* Constructs a reader for TIFF images stored in strips with 1, 8 or 16 bits per sample, which are uncompressed or
+   compressed with LZW, Deflate or PackBits. */
+IBTiffScanlineReader::IBTiffScanlineReader(QIODevice *device)
+   : IBScanlineReader(device), bBigEndian(false), iCompression(1), iPhotometric(-1), bPredictor(false),
+     bAssociatedAlpha(false), iBitDepth(1), iChannels(1), iRowsPerStrip(0), iRowBytes(0), iInputPos(0),
+     iStripRemaining(0), iPendingPos(0), iLzwNextCode(258), iLzwCodeWidth(9), iLzwPreviousCode(-1), iLzwBits(0),
+     iLzwBitCount(0), iRowsRead(0)
+{
+#ifdef IB_HAVE_ZLIB
+   this->bStreamInitialized = false;
+#endif /*IB_HAVE_ZLIB*/
+}
+
+/* Releases the state of the decompression. */
+IBTiffScanlineReader::~IBTiffScanlineReader()
+{
+#ifdef IB_HAVE_ZLIB
+   if(this->bStreamInitialized)
+   {
+      inflateEnd(&this->zsStream);
+   }
+#endif /*IB_HAVE_ZLIB*/
+}
+
+/* reimpl. Reads the first IFD of the file. Returns false if the image is tiled, stored in separate planes, uses a
+   palette or an unsupported compression. */
+bool IBTiffScanlineReader::readHeader()
+{
+   QVector<quint32> values;
+   QByteArray entries;
+   const uchar *entry;
+   uchar hbuf[8];
+   int count, idx, width, height, planar, predictor, extrasamples, colorchannels, strips;
+   quint16 tag;
+
+   if(!this->readBytes(reinterpret_cast<char *>(hbuf), 8) ||
+      (memcmp(hbuf, "II*\0", 4) != 0 && memcmp(hbuf, "MM\0*", 4) != 0))
+   {
+      return false;
+   }
+
+   this->bBigEndian = hbuf[0] == 'M';
+
+   if(!this->ioDevice->seek(this->getLong(hbuf + 4)) || !this->readBytes(reinterpret_cast<char *>(hbuf), 2))
+   {
+      return false;
+   }
+
+   count = this->getShort(hbuf);
+   entries.resize(count * 12);
+
+   if(!this->readBytes(entries.data(), entries.size()))
+   {
+      return false;
+   }
+
+   width = height = 0;
+   planar = predictor = 1;
+   extrasamples = 0;
+
+   for(idx = 0; idx < count; idx++)
+   {
+      entry = reinterpret_cast<const uchar *>(entries.constData()) + idx * 12;
+      tag = this->getShort(entry);
+
+      switch(tag)
+      {
+         case 322:
+            /* tiled images are not supported */
+            return false;
+
+         case 256: case 257: case 258: case 259: case 262: case 273: case 277: case 278: case 279: case 284:
+         case 317: case 338:
+            break;
+
+         default:
+            continue;
+      }
+
+      if(!this->readTagValues(entry, &values))
+      {
+         return false;
+      }
+
+      switch(tag)
+      {
+         case 256: width = int(qMin<quint32>(values[0], 0x7FFFFFFF)); break;
+         case 257: height = int(qMin<quint32>(values[0], 0x7FFFFFFF)); break;
+         case 258: this->iBitDepth = values.count(values[0]) == values.size() ? int(values[0]) : 0; break;
+         case 259: this->iCompression = int(values[0]); break;
+         case 262: this->iPhotometric = int(values[0]); break;
+         case 273: this->vecStripOffsets = values; break;
+         case 277: this->iChannels = int(values[0]); break;
+         case 278: this->iRowsPerStrip = int(qMin<quint32>(values[0], 0x7FFFFFFF)); break;
+         case 279: this->vecStripByteCounts = values; break;
+         case 284: planar = int(values[0]); break;
+         case 317: predictor = int(values[0]); break;
+         case 338: extrasamples = int(values[0]); break;
+      }
+   }
+
+   colorchannels = this->iPhotometric == 2 ? 3 : 1;
+
+   if(width <= 0 || height <= 0 || width > iMaxDimension || height > iMaxDimension ||
+      this->iChannels < colorchannels || this->iChannels > 8 ||
+      (planar != 1 && this->iChannels > 1) || (predictor != 1 && predictor != 2) ||
+      (this->iPhotometric != 0 && this->iPhotometric != 1 && this->iPhotometric != 2) ||
+      (this->iBitDepth != 1 && this->iBitDepth != 8 && this->iBitDepth != 16) ||
+      (this->iBitDepth == 1 && (this->iChannels != 1 || predictor != 1)) ||
+      qint64(width) * this->iChannels * this->iBitDepth > iMaxRowBits)
+   {
+      return false;
+   }
+
+#ifdef IB_HAVE_ZLIB
+   if(this->iCompression == 8 || this->iCompression == 32946)
+   {
+      memset(&this->zsStream, 0, sizeof(this->zsStream));
+      if(inflateInit(&this->zsStream) != Z_OK)
+      {
+         return false;
+      }
+      this->bStreamInitialized = true;
+   }
+   else
+#endif /*IB_HAVE_ZLIB*/
+   if(this->iCompression != 1 && this->iCompression != 5 && this->iCompression != 32773)
+   {
+      return false;
+   }
+
+   if(this->iRowsPerStrip <= 0 || this->iRowsPerStrip > height)
+   {
+      this->iRowsPerStrip = height;
+   }
+
+   strips = (height - 1) / this->iRowsPerStrip + 1;
+
+   if(this->vecStripOffsets.size() < strips || this->vecStripByteCounts.size() < strips)
+   {
+      return false;
+   }
+
+   if(this->iCompression == 5)
+   {
+      this->vecLzwPrefix.fill(0, 4096);
+      this->baLzwSuffix.fill(0, 4096);
+      this->baLzwFirst.fill(0, 4096);
+      this->vecLzwLength.fill(1, 4096);
+
+      for(idx = 0; idx < 256; idx++)
+      {
+         this->baLzwSuffix[idx] = char(idx);
+         this->baLzwFirst[idx] = char(idx);
+      }
+   }
+
+   this->szImage = QSize(width, height);
+   this->bAlphaChannel = this->iChannels > colorchannels && (extrasamples == 1 || extrasamples == 2);
+   this->bAssociatedAlpha = extrasamples == 1;
+   this->bPredictor = predictor == 2;
+   this->iRowBytes = int((qint64(width) * this->iChannels * this->iBitDepth + 7) / 8);
+   this->baRow.resize(this->iRowBytes);
+
+   return true;
+}
+
+/* reimpl. Decodes the next row into premultiplied pixels (line) and stores its number in row. Samples with 16 bit are
+   reduced to 8 bit. */
+bool IBTiffScanlineReader::readScanline(QRgb *line, int *row)
+{
+   if(this->iRowsRead >= this->szImage.height())
+   {
+      return false;
+   }
+
+   if(this->iRowsRead % this->iRowsPerStrip == 0 && !this->startStrip(this->iRowsRead / this->iRowsPerStrip))
+   {
+      return false;
+   }
+
+   if(!this->decompressRow())
+   {
+      return false;
+   }
+
+   if(this->bPredictor)
+   {
+      this->predictRow();
+   }
+
+   this->convertRow(line);
+   *row = this->iRowsRead++;
+
+   return true;
+}
+
+/* reimpl. Moves to the strip of the given row (row) and skips the rows before it in the strip, so that it is returned
+   by the next call of readScanline. */
+bool IBTiffScanlineReader::seekScanline(int row)
+{
+   if(row < 0 || row >= this->szImage.height())
+   {
+      return false;
+   }
+
+   /* the first row of a strip starts the strip, when it is read */
+   this->iRowsRead = row - row % this->iRowsPerStrip;
+
+   if(this->iRowsRead < row && !this->startStrip(row / this->iRowsPerStrip))
+   {
+      return false;
+   }
+
+   while(this->iRowsRead < row)
+   {
+      if(!this->decompressRow())
+      {
+         return false;
+      }
+
+      this->iRowsRead++;
+   }
+
+   return true;
+}
+
+/* Reads the values of the IFD entry (entry) with the type BYTE, SHORT or LONG into values. Returns false for other
+   types or if the values cannot be read. */
+bool IBTiffScanlineReader::readTagValues(const uchar *entry, QVector<quint32> *values)
+{
+   QByteArray data;
+   const uchar *value;
+   quint16 type = this->getShort(entry + 2);
+   quint32 count = this->getLong(entry + 4);
+   int size, idx;
+
+   size = type == 1 ? 1 : (type == 3 ? 2 : (type == 4 ? 4 : 0));
+
+   if(size == 0 || count == 0 || count > 0x1000000)
+   {
+      return false;
+   }
+
+   if(count * quint32(size) <= 4)
+   {
+      value = entry + 8;
+   }
+   else
+   {
+      data.resize(int(count) * size);
+
+      if(!this->ioDevice->seek(this->getLong(entry + 8)) || !this->readBytes(data.data(), data.size()))
+      {
+         return false;
+      }
+
+      value = reinterpret_cast<const uchar *>(data.constData());
+   }
+
+   values->resize(int(count));
+
+   for(idx = 0; idx < int(count); idx++)
+   {
+      (*values)[idx] = size == 1 ? value[idx]
+                                 : (size == 2 ? this->getShort(value + idx * 2) : this->getLong(value + idx * 4));
+   }
+
+   return true;
+}
+
+/* Moves to the start of the given strip (strip) and resets the state of the decompression. */
+bool IBTiffScanlineReader::startStrip(int strip)
+{
+   if(!this->ioDevice->seek(this->vecStripOffsets[strip]))
+   {
+      return false;
+   }
+
+   this->iStripRemaining = this->vecStripByteCounts[strip];
+   this->baInput.clear();
+   this->iInputPos = 0;
+   this->baPending.clear();
+   this->iPendingPos = 0;
+   this->iLzwNextCode = 258;
+   this->iLzwCodeWidth = 9;
+   this->iLzwPreviousCode = -1;
+   this->iLzwBits = 0;
+   this->iLzwBitCount = 0;
+
+#ifdef IB_HAVE_ZLIB
+   if(this->bStreamInitialized)
+   {
+      inflateReset(&this->zsStream);
+      this->zsStream.next_in = nullptr;
+      this->zsStream.avail_in = 0;
+   }
+#endif /*IB_HAVE_ZLIB*/
+
+   return true;
+}
+
+/* Reads the next byte (byte) of the compressed data of the current strip, which is read from the device in blocks.
+   Returns false at the end of the strip. */
+bool IBTiffScanlineReader::readInputByte(uchar *byte)
+{
+   if(this->iInputPos >= this->baInput.size())
+   {
+      if(this->iStripRemaining == 0)
+      {
+         return false;
+      }
+
+      this->baInput.resize(int(qMin<quint32>(this->iStripRemaining, iReadBlockSize)));
+      if(!this->readBytes(this->baInput.data(), this->baInput.size()))
+      {
+         return false;
+      }
+
+      this->iStripRemaining -= quint32(this->baInput.size());
+      this->iInputPos = 0;
+   }
+
+   *byte = uchar(this->baInput.constData()[this->iInputPos++]);
+
+   return true;
+}
+
+/* Decompresses the next row of the current strip. */
+bool IBTiffScanlineReader::decompressRow()
+{
+   char *row = this->baRow.data();
+   int filled, count;
+#ifdef IB_HAVE_ZLIB
+   int result;
+#endif /*IB_HAVE_ZLIB*/
+
+   if(this->iCompression == 1)
+   {
+      return this->readBytes(row, this->iRowBytes);
+   }
+
+#ifdef IB_HAVE_ZLIB
+   if(this->bStreamInitialized)
+   {
+      this->zsStream.next_out = reinterpret_cast<Bytef *>(row);
+      this->zsStream.avail_out = uInt(this->iRowBytes);
+
+      while(this->zsStream.avail_out > 0)
+      {
+         if(this->zsStream.avail_in == 0)
+         {
+            if(this->iStripRemaining == 0)
+            {
+               return false;
+            }
+
+            this->baInput.resize(int(qMin<quint32>(this->iStripRemaining, iReadBlockSize)));
+            if(!this->readBytes(this->baInput.data(), this->baInput.size()))
+            {
+               return false;
+            }
+
+            this->iStripRemaining -= quint32(this->baInput.size());
+            this->zsStream.next_in = reinterpret_cast<Bytef *>(this->baInput.data());
+            this->zsStream.avail_in = uInt(this->baInput.size());
+         }
+
+         result = inflate(&this->zsStream, Z_NO_FLUSH);
+
+         if(result == Z_STREAM_END && this->zsStream.avail_out > 0)
+         {
+            return false;
+         }
+         else if(result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+         {
+            return false;
+         }
+      }
+
+      return true;
+   }
+#endif /*IB_HAVE_ZLIB*/
+
+   /* a string of LZW or a run of PackBits can reach into the next row, its rest is kept as pending bytes */
+   for(filled = 0; filled < this->iRowBytes; filled += count)
+   {
+      if(this->iPendingPos >= this->baPending.size())
+      {
+         this->iPendingPos = 0;
+
+         if(!(this->iCompression == 5 ? this->decodeLzwString() : this->decodePackBitsRun()))
+         {
+            return false;
+         }
+      }
+
+      count = qMin(this->iRowBytes - filled, this->baPending.size() - this->iPendingPos);
+      memcpy(row + filled, this->baPending.constData() + this->iPendingPos, size_t(count));
+      this->iPendingPos += count;
+   }
+
+   return true;
+}
+
+/* Decodes the string of the next LZW code into the pending bytes and adds the new string to the table. Clear codes
+   reset the table. Returns false at the end of the strip or for an invalid code. */
+bool IBTiffScanlineReader::decodeLzwString()
+{
+   char *data;
+   uchar byte;
+   int code, next, length, idx;
+
+   do
+   {
+      while(this->iLzwBitCount < this->iLzwCodeWidth)
+      {
+         if(!this->readInputByte(&byte))
+         {
+            return false;
+         }
+
+         this->iLzwBits = (this->iLzwBits << 8) | byte;
+         this->iLzwBitCount += 8;
+      }
+
+      this->iLzwBitCount -= this->iLzwCodeWidth;
+      code = int((this->iLzwBits >> this->iLzwBitCount) & ((1u << this->iLzwCodeWidth) - 1));
+
+      if(code == 256)
+      {
+         this->iLzwNextCode = 258;
+         this->iLzwCodeWidth = 9;
+         this->iLzwPreviousCode = -1;
+      }
+   }while(code == 256);
+
+   next = this->iLzwNextCode;
+
+   if(code == 257 || code > next || (this->iLzwPreviousCode < 0 && code > 255))
+   {
+      return false;
+   }
+
+   if(this->iLzwPreviousCode >= 0 && next < 4096)
+   {
+      /* the new string is the previous one followed by the first byte of the current one, which is the first byte of
+         the previous one, if the current code is the new one */
+      this->vecLzwPrefix[next] = quint16(this->iLzwPreviousCode);
+      this->baLzwFirst[next] = this->baLzwFirst[this->iLzwPreviousCode];
+      this->baLzwSuffix[next] = this->baLzwFirst[code == next ? this->iLzwPreviousCode : code];
+      this->vecLzwLength[next] = quint16(this->vecLzwLength[this->iLzwPreviousCode] + 1);
+      this->iLzwNextCode++;
+
+      /* the codes get wider one code before the table reaches the next power of two */
+      if(this->iLzwNextCode >= (1 << this->iLzwCodeWidth) - 1 && this->iLzwCodeWidth < 12)
+      {
+         this->iLzwCodeWidth++;
+      }
+   }
+   else if(code == next)
+   {
+      return false;
+   }
+
+   this->iLzwPreviousCode = code;
+   length = this->vecLzwLength[code];
+   this->baPending.resize(length);
+   data = this->baPending.data();
+
+   for(idx = length - 1; idx >= 0; idx--)
+   {
+      data[idx] = this->baLzwSuffix[code];
+      code = this->vecLzwPrefix[code];
+   }
+
+   return true;
+}
+
+/* Decodes the next run of the PackBits data into the pending bytes. */
+bool IBTiffScanlineReader::decodePackBitsRun()
+{
+   uchar header, byte;
+   int idx;
+
+   do
+   {
+      if(!this->readInputByte(&header))
+      {
+         return false;
+      }
+   }while(header == 128);
+
+   if(header < 128)
+   {
+      /* a literal run of header + 1 bytes */
+      this->baPending.resize(header + 1);
+
+      for(idx = 0; idx <= header; idx++)
+      {
+         if(!this->readInputByte(&byte))
+         {
+            return false;
+         }
+
+         this->baPending[idx] = char(byte);
+      }
+   }
+   else
+   {
+      /* a byte repeated 257 - header times */
+      if(!this->readInputByte(&byte))
+      {
+         return false;
+      }
+
+      this->baPending.fill(char(byte), 257 - header);
+   }
+
+   return true;
+}
+
+/* Reverses the horizontal differencing of the current row. */
+void IBTiffScanlineReader::predictRow()
+{
+   uchar *row = reinterpret_cast<uchar *>(this->baRow.data());
+   int idx, value, high;
+
+   if(this->iBitDepth == 8)
+   {
+      for(idx = this->iChannels; idx < this->iRowBytes; idx++)
+      {
+         row[idx] = uchar(row[idx] + row[idx - this->iChannels]);
+      }
+   }
+   else
+   {
+      high = this->bBigEndian ? 0 : 1;
+
+      for(idx = this->iChannels * 2; idx < this->iRowBytes; idx += 2)
+      {
+         value = this->getShort(row + idx) + this->getShort(row + idx - this->iChannels * 2);
+         row[idx + high] = uchar(value >> 8);
+         row[idx + 1 - high] = uchar(value);
+      }
+   }
+}
+
+/* Converts the current row into premultiplied pixels (line). */
+void IBTiffScanlineReader::convertRow(QRgb *line) const
+{
+   const uchar *row = reinterpret_cast<const uchar *>(this->baRow.constData());
+   int step = this->iBitDepth / 8;
+   int high = (this->bBigEndian || step == 1) ? 0 : 1;
+   int width = this->szImage.width();
+   int invert = this->iPhotometric == 0 ? 255 : 0;
+   int alpha = (this->iPhotometric == 2 ? 3 : 1) * step + high;
+   int x, value;
+
+   if(this->iBitDepth == 1)
+   {
+      for(x = 0; x < width; x++)
+      {
+         value = ((row[x / 8] >> (7 - x % 8)) & 1) ? 255 - invert : invert;
+         line[x] = qRgb(value, value, value);
+      }
+      return;
+   }
+
+   for(x = 0; x < width; x++)
+   {
+      if(this->iPhotometric == 2)
+      {
+         line[x] = qRgba(row[high], row[step + high], row[2 * step + high], this->bAlphaChannel ? row[alpha] : 255);
+      }
+      else
+      {
+         value = row[high] ^ invert;
+         line[x] = qRgba(value, value, value, this->bAlphaChannel ? row[alpha] : 255);
+      }
+
+      if(this->bAlphaChannel && !this->bAssociatedAlpha)
+      {
+         line[x] = qPremultiply(line[x]);
+      }
+
+      row += this->iChannels * step;
+   }
+}
+
+/* Returns the 16 bit value stored at the given position (data) in the byte order of the file. */
+quint16 IBTiffScanlineReader::getShort(const uchar *data) const
+{
+   return this->bBigEndian ? quint16((data[0] << 8) | data[1]) : quint16((data[1] << 8) | data[0]);
+}
+
+/* Returns the 32 bit value stored at the given position (data) in the byte order of the file. */
+quint32 IBTiffScanlineReader::getLong(const uchar *data) const
+{
+   return this->bBigEndian ? readBigEndian32(data) : readLittleEndian32(data);
+}
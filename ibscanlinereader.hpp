@@ -0,0 +1,230 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBSCANLINEREADER
+#define H_IBSCANLINEREADER
+
+#include <QByteArray>
+#include <QColor>
+#include <QIODevice>
+#include <QSize>
+#include <QVector>
+
+#ifdef IB_HAVE_ZLIB
+#include <zlib.h>
+#endif /*IB_HAVE_ZLIB*/
+
+/* class IBScanlineReader */
+
+class IBScanlineReader
+{
+   public:
+      IBScanlineReader(QIODevice *device);
+      virtual ~IBScanlineReader();
+
+      virtual bool readHeader() = 0;
+      virtual bool readScanline(QRgb *line, int *row) = 0;
+      virtual bool seekScanline(int row) = 0;
+
+      QSize getSize() const;
+      bool hasAlphaChannel() const;
+      bool isBottomUp() const;
+
+      static IBScanlineReader *create(QIODevice *device, const QByteArray &format);
+
+   protected:
+      bool readBytes(char *data, qint64 size);
+
+      /* device the image is read from */
+      QIODevice *ioDevice;
+      /* size of the image */
+      QSize szImage;
+      /* is true if the image has an alpha channel */
+      bool bAlphaChannel;
+      /* is true if the rows are read from the bottom to the top of the image */
+      bool bBottomUp;
+};
+
+#ifdef IB_HAVE_ZLIB
+
+/* class IBPngScanlineReader */
+
+class IBPngScanlineReader : public IBScanlineReader
+{
+   public:
+      IBPngScanlineReader(QIODevice *device);
+      ~IBPngScanlineReader();
+
+      bool readHeader() override;
+      bool readScanline(QRgb *line, int *row) override;
+      bool seekScanline(int row) override;
+
+   private:
+      bool readChunkHeader(quint32 *length, QByteArray *type);
+      bool inflateRow();
+      void unfilterRow();
+      void convertRow(QRgb *line) const;
+
+      /* state of the decompression */
+      z_stream zsStream;
+      /* is true if the decompression is initialized */
+      bool bStreamInitialized;
+      /* compressed data read from the current IDAT chunk */
+      QByteArray baInput;
+      /* unread bytes of the current IDAT chunk */
+      quint32 iChunkRemaining;
+      /* current row with its leading filter byte */
+      QByteArray baRow;
+      /* previous unfiltered row without filter byte */
+      QByteArray baPreviousRow;
+      /* color palette with the transparency of the tRNS chunk */
+      QVector<QRgb> vecPalette;
+      /* bits per sample */
+      int iBitDepth;
+      /* PNG color type */
+      int iColorType;
+      /* samples per pixel */
+      int iChannels;
+      /* bytes of a row without filter byte */
+      int iRowBytes;
+      /* number of the next row */
+      int iRow;
+};
+
+#endif /*IB_HAVE_ZLIB*/
+
+/* class IBBmpScanlineReader */
+
+class IBBmpScanlineReader : public IBScanlineReader
+{
+   public:
+      IBBmpScanlineReader(QIODevice *device);
+
+      bool readHeader() override;
+      bool readScanline(QRgb *line, int *row) override;
+      bool seekScanline(int row) override;
+
+   private:
+      /* raw data of a row including its padding */
+      QByteArray baRow;
+      /* offset of the pixel data in the file */
+      qint64 iDataOffset;
+      /* bits per pixel */
+      int iBitsPerPixel;
+      /* number of read rows */
+      int iRowsRead;
+};
+
+/* class IBPnmScanlineReader */
+
+class IBPnmScanlineReader : public IBScanlineReader
+{
+   public:
+      IBPnmScanlineReader(QIODevice *device);
+
+      bool readHeader() override;
+      bool readScanline(QRgb *line, int *row) override;
+      bool seekScanline(int row) override;
+
+   private:
+      bool readHeaderValue(int *value);
+
+      /* raw data of a row */
+      QByteArray baRow;
+      /* offset of the pixel data in the file */
+      qint64 iDataOffset;
+      /* samples per pixel, 1 for PGM (P5) and 3 for PPM (P6) */
+      int iChannels;
+      /* largest sample value */
+      int iMaxValue;
+      /* number of read rows */
+      int iRowsRead;
+};
+
+/* class IBTiffScanlineReader */
+
+class IBTiffScanlineReader : public IBScanlineReader
+{
+   public:
+      IBTiffScanlineReader(QIODevice *device);
+      ~IBTiffScanlineReader();
+
+      bool readHeader() override;
+      bool readScanline(QRgb *line, int *row) override;
+      bool seekScanline(int row) override;
+
+   private:
+      bool readTagValues(const uchar *entry, QVector<quint32> *values);
+      bool startStrip(int strip);
+      bool readInputByte(uchar *byte);
+      bool decompressRow();
+      bool decodeLzwString();
+      bool decodePackBitsRun();
+      void predictRow();
+      void convertRow(QRgb *line) const;
+      quint16 getShort(const uchar *data) const;
+      quint32 getLong(const uchar *data) const;
+
+      /* is true if the file is stored in big endian (Motorola) byte order */
+      bool bBigEndian;
+      /* offsets of the strips in the file */
+      QVector<quint32> vecStripOffsets;
+      /* compressed sizes of the strips */
+      QVector<quint32> vecStripByteCounts;
+      /* TIFF compression scheme, 1 (none), 5 (LZW), 8 (Deflate) or 32773 (PackBits) */
+      int iCompression;
+      /* TIFF photometric interpretation, 0 (white is zero), 1 (black is zero) or 2 (RGB) */
+      int iPhotometric;
+      /* is true if the rows are stored as horizontal differences */
+      bool bPredictor;
+      /* is true if the alpha channel is stored premultiplied */
+      bool bAssociatedAlpha;
+      /* bits per sample */
+      int iBitDepth;
+      /* samples per pixel */
+      int iChannels;
+      /* number of rows of a strip */
+      int iRowsPerStrip;
+      /* bytes of a decompressed row */
+      int iRowBytes;
+      /* current decompressed row */
+      QByteArray baRow;
+      /* compressed data read from the current strip */
+      QByteArray baInput;
+      /* position of the next unread byte in the compressed data */
+      int iInputPos;
+      /* unread bytes of the current strip */
+      quint32 iStripRemaining;
+      /* decompressed bytes, which belong to the following rows */
+      QByteArray baPending;
+      /* position of the next unused byte in the decompressed bytes */
+      int iPendingPos;
+      /* code of the prefix string of every LZW code */
+      QVector<quint16> vecLzwPrefix;
+      /* last byte of the string of every LZW code */
+      QByteArray baLzwSuffix;
+      /* first byte of the string of every LZW code */
+      QByteArray baLzwFirst;
+      /* length of the string of every LZW code */
+      QVector<quint16> vecLzwLength;
+      /* next free LZW code */
+      int iLzwNextCode;
+      /* current width of the LZW codes in bits */
+      int iLzwCodeWidth;
+      /* previous LZW code, -1 after a clear code */
+      int iLzwPreviousCode;
+      /* unread bits of the LZW data */
+      quint32 iLzwBits;
+      /* number of unread bits of the LZW data */
+      int iLzwBitCount;
+#ifdef IB_HAVE_ZLIB
+      /* state of the Deflate decompression */
+      z_stream zsStream;
+      /* is true if the Deflate decompression is initialized */
+      bool bStreamInitialized;
+#endif /*IB_HAVE_ZLIB*/
+      /* number of read rows */
+      int iRowsRead;
+};
+
+#endif /*H_IBSCANLINEREADER*/
@@ -0,0 +1,213 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibthumbnailbatch.hpp"
+
+/* class IBThumbnailBatchWorker */
+
+/* Constructs a worker, which generates the thumbnails of the given size (thumbsize) of the files (files) and stores
+   them in the cache (cache). The next file is taken from the shared index (next). */
+IBThumbnailBatchWorker::IBThumbnailBatchWorker(const QStringList &files, QAtomicInt *next, const QSize &thumbsize,
+                                               const IBThumbnailCache &cache)
+   : lstFiles(files), iNext(next), szThumbnail(thumbsize), tcCache(cache)
+{
+}
+
+/* Generates the thumbnails with the same decoder as IBThumbnailLoader, until all files are taken. Thumbnails, which
+   are already up to date in the cache, are skipped. Images, which failed before and did not change since, are
+   counted as failures without decoding them again. New failures are recorded in the cache. */
+void IBThumbnailBatchWorker::run()
+{
+   IBThumbnailDecoder decoder;
+   QDateTime lastmodified;
+   QFileInfo info;
+   QImage thumbnail;
+   QSize imagesize;
+   QString path;
+   int idx;
+
+   while((idx = this->iNext->fetchAndAddRelaxed(1)) < this->lstFiles.size())
+   {
+      path = this->lstFiles.at(idx);
+      info.setFile(path);
+      lastmodified = info.lastModified();
+
+      if(this->tcCache.contains(path, lastmodified, this->szThumbnail))
+      {
+         this->bsStatistics.iUpToDate++;
+         continue;
+      }
+
+      if(this->tcCache.containsFailure(path, lastmodified, info.size()))
+      {
+         thumbnail = QImage();
+      }
+      else
+      {
+         thumbnail = decoder.decode(path, this->szThumbnail, &imagesize);
+
+         /* a file, which could not be read, is not recorded as broken */
+         if(thumbnail.isNull() && imagesize.isValid())
+         {
+            this->tcCache.storeFailure(path, lastmodified, info.size());
+         }
+      }
+
+      if(thumbnail.isNull() || !this->tcCache.store(path, lastmodified, this->szThumbnail, thumbnail, imagesize))
+      {
+         this->bsStatistics.iFailures++;
+         this->bsStatistics.slFailedPaths.append(path);
+         continue;
+      }
+
+      this->bsStatistics.iGenerated++;
+   }
+
+   this->bsStatistics.dsDecoder = decoder.getStatistics();
+}
+
+/* class IBThumbnailBatch */
+
+/* Constructs a batch with the thumbnail size of the image list view, one thread per core and the default cache. */
+IBThumbnailBatch::IBThumbnailBatch()
+   : szThumbnailSize(IBImageListModel::getDefaultThumbnailSize()), iJobs(QThread::idealThreadCount()),
+     bRecursive(false)
+{
+}
+
+/* Sets the size (size) of the thumbnails. */
+void IBThumbnailBatch::setThumbnailSize(const QSize &size)
+{
+   this->szThumbnailSize = size;
+}
+
+/* Returns the size of the thumbnails. */
+QSize IBThumbnailBatch::getThumbnailSize() const
+{
+   return this->szThumbnailSize;
+}
+
+/* Sets the number of decoding threads (jobs). */
+void IBThumbnailBatch::setJobs(int jobs)
+{
+   this->iJobs = qMax(1, jobs);
+}
+
+/* Returns the number of decoding threads. */
+int IBThumbnailBatch::getJobs() const
+{
+   return this->iJobs;
+}
+
+/* Includes the subdirectories in the search for images, if recursive is true. */
+void IBThumbnailBatch::setRecursive(bool recursive)
+{
+   this->bRecursive = recursive;
+}
+
+/* Returns true, if the subdirectories are included in the search for images. Otherwise false. */
+bool IBThumbnailBatch::isRecursive() const
+{
+   return this->bRecursive;
+}
+
+/* Sets the cache (cache), which receives the thumbnails. */
+void IBThumbnailBatch::setCache(const IBThumbnailCache &cache)
+{
+   this->tcCache = cache;
+}
+
+/* Returns the cache, which receives the thumbnails. */
+IBThumbnailCache IBThumbnailBatch::getCache() const
+{
+   return this->tcCache;
+}
+
+/* Returns the sorted canonical paths of the images in the directory (dir), which match the name filters of
+   IBImageListModel. Symbolic links to directories are not followed. */
+QStringList IBThumbnailBatch::findImages(const QString &dir) const
+{
+   QDirIterator it(dir, IBImageListModel::getImageNameFilters(), QDir::Files | QDir::Readable,
+                   this->bRecursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+   QStringList files;
+
+   while(it.hasNext())
+   {
+      it.next();
+      files.append(it.fileInfo().canonicalFilePath());
+   }
+
+   files.sort();
+
+   return files;
+}
+
+/* Generates the thumbnails of the files (files) with the configured number of threads and returns the statistics
+   of all threads. */
+IBThumbnailBatchStatistics IBThumbnailBatch::generate(const QStringList &files) const
+{
+   QList<IBThumbnailBatchWorker *> workers;
+   IBThumbnailBatchStatistics stats;
+   QElapsedTimer timer;
+   QAtomicInt next(0);
+   int idx;
+
+   timer.start();
+
+   for(idx = 0; idx < qMin(this->iJobs, qMax(1, int(files.size()))); idx++)
+   {
+      workers.append(new IBThumbnailBatchWorker(files, &next, this->szThumbnailSize, this->tcCache));
+      workers.last()->start();
+   }
+
+   for(IBThumbnailBatchWorker *worker : workers)
+   {
+      worker->wait();
+
+      stats.iGenerated += worker->bsStatistics.iGenerated;
+      stats.iUpToDate += worker->bsStatistics.iUpToDate;
+      stats.iFailures += worker->bsStatistics.iFailures;
+      stats.dsDecoder.iImages += worker->bsStatistics.dsDecoder.iImages;
+      stats.dsDecoder.iFailures += worker->bsStatistics.dsDecoder.iFailures;
+      stats.dsDecoder.iRejected += worker->bsStatistics.dsDecoder.iRejected;
+      stats.dsDecoder.iRefused += worker->bsStatistics.dsDecoder.iRefused;
+      stats.dsDecoder.iReadTime += worker->bsStatistics.dsDecoder.iReadTime;
+      stats.dsDecoder.iDecodeTime += worker->bsStatistics.dsDecoder.iDecodeTime;
+      stats.dsDecoder.iScaleTime += worker->bsStatistics.dsDecoder.iScaleTime;
+      stats.slFailedPaths.append(worker->bsStatistics.slFailedPaths);
+   }
+
+   stats.iElapsedTime = timer.nsecsElapsed();
+   stats.iImages = files.size();
+   stats.slFailedPaths.sort();
+
+   qDeleteAll(workers);
+
+   return stats;
+}
+
+/* Returns a text report with the throughput, the time of the pipeline stages summed over all threads and the paths
+   of the failed images. */
+QString IBThumbnailBatch::createReport(const IBThumbnailBatchStatistics &stats)
+{
+   QString report;
+   QTextStream stream(&report);
+   double seconds = stats.iElapsedTime / 1e9;
+
+   stream << QStringLiteral("%1 images: %2 generated, %3 up to date, %4 failed\n").arg(stats.iImages)
+                .arg(stats.iGenerated).arg(stats.iUpToDate).arg(stats.iFailures);
+   stream << QStringLiteral("%1 s, %2 images/s, %3 thumbnails/s\n").arg(seconds, 0, 'f', 3)
+                .arg(seconds > 0.0 ? stats.iImages / seconds : 0.0, 0, 'f', 1)
+                .arg(seconds > 0.0 ? stats.iGenerated / seconds : 0.0, 0, 'f', 1);
+   stream << QStringLiteral("read %1 ms, decode %2 ms, scale %3 ms\n").arg(stats.dsDecoder.iReadTime / 1000000)
+                .arg(stats.dsDecoder.iDecodeTime / 1000000).arg(stats.dsDecoder.iScaleTime / 1000000);
+
+   for(const QString &path : stats.slFailedPaths)
+   {
+      stream << "failed: " << path << '\n';
+   }
+
+   stream.flush();
+
+   return report;
+}
@@ -0,0 +1,101 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBTHUMBNAILBATCH
+#define H_IBTHUMBNAILBATCH
+
+#include <QAtomicInt>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QList>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include "ibimagelistmodel.hpp"
+#include "ibthumbnailcache.hpp"
+#include "ibthumbnaildecoder.hpp"
+
+/* struct IBThumbnailBatchStatistics */
+
+struct IBThumbnailBatchStatistics
+{
+   /* number of found images */
+   qint64 iImages = 0;
+   /* number of generated and stored thumbnails */
+   qint64 iGenerated = 0;
+   /* number of images, whose cached thumbnails were already up to date */
+   qint64 iUpToDate = 0;
+   /* number of images, which could not be decoded or whose thumbnails could not be stored */
+   qint64 iFailures = 0;
+   /* wall time of the generation in nanoseconds */
+   qint64 iElapsedTime = 0;
+   /* work of the decoders of all threads */
+   IBThumbnailDecoderStatistics dsDecoder;
+   /* paths of the failed images */
+   QStringList slFailedPaths;
+};
+
+/* class IBThumbnailBatchWorker */
+
+class IBThumbnailBatchWorker : public QThread
+{
+   public:
+      IBThumbnailBatchWorker(const QStringList &files, QAtomicInt *next, const QSize &thumbsize,
+                             const IBThumbnailCache &cache);
+
+      void run() override;
+
+      /* work of the worker */
+      IBThumbnailBatchStatistics bsStatistics;
+
+   private:
+      /* files of the batch */
+      const QStringList &lstFiles;
+      /* index of the next file, which is shared by all workers */
+      QAtomicInt *iNext;
+      /* size of the thumbnails */
+      QSize szThumbnail;
+      /* cache, which receives the thumbnails */
+      IBThumbnailCache tcCache;
+};
+
+/* class IBThumbnailBatch */
+
+class IBThumbnailBatch
+{
+   public:
+      IBThumbnailBatch();
+
+      void setThumbnailSize(const QSize &size);
+      QSize getThumbnailSize() const;
+
+      void setJobs(int jobs);
+      int getJobs() const;
+
+      void setRecursive(bool recursive);
+      bool isRecursive() const;
+
+      void setCache(const IBThumbnailCache &cache);
+      IBThumbnailCache getCache() const;
+
+      QStringList findImages(const QString &dir) const;
+      IBThumbnailBatchStatistics generate(const QStringList &files) const;
+
+      static QString createReport(const IBThumbnailBatchStatistics &stats);
+
+   private:
+      /* size of the thumbnails */
+      QSize szThumbnailSize;
+      /* number of decoding threads */
+      int iJobs;
+      /* is true, if the subdirectories are included */
+      bool bRecursive;
+      /* cache, which receives the thumbnails */
+      IBThumbnailCache tcCache;
+};
+
+#endif /*H_IBTHUMBNAILBATCH*/
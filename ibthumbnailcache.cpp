@@ -0,0 +1,210 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibthumbnailcache.hpp"
+
+QString IBThumbnailCache::strDefaultCacheDir;
+
+/* class IBThumbnailCache */
+
+/* Constructs a thumbnail cache in the default cache directory. see IBThumbnailCache::getDefaultCacheDir */
+IBThumbnailCache::IBThumbnailCache()
+   : strCacheDir(IBThumbnailCache::getDefaultCacheDir()), bEnabled(true)
+{
+}
+
+/* Constructs a thumbnail cache in the given directory (cachedir). */
+IBThumbnailCache::IBThumbnailCache(const QString &cachedir)
+   : strCacheDir(cachedir), bEnabled(true)
+{
+}
+
+/* Sets the directory (cachedir) of the cache. */
+void IBThumbnailCache::setCacheDir(const QString &cachedir)
+{
+   this->strCacheDir = cachedir;
+}
+
+/* Returns the directory of the cache. */
+QString IBThumbnailCache::getCacheDir() const
+{
+   return this->strCacheDir;
+}
+
+/* Enables or disables (enabled) the lookup and the storing of thumbnails. */
+void IBThumbnailCache::setEnabled(bool enabled)
+{
+   this->bEnabled = enabled;
+}
+
+/* Returns true, if thumbnails are looked up and stored. Otherwise false. */
+bool IBThumbnailCache::isEnabled() const
+{
+   return this->bEnabled && !this->strCacheDir.isEmpty();
+}
+
+/* Returns the path of the cached thumbnail of the image (path) with the given size (thumbsize). As in the thumbnail
+   specification of freedesktop.org, the name of the file is the MD5 hash of the URI of the image. */
+QString IBThumbnailCache::getCacheFilePath(const QString &path, const QSize &thumbsize) const
+{
+   QByteArray hash = QCryptographicHash::hash(QUrl::fromLocalFile(path).toEncoded(), QCryptographicHash::Md5);
+
+   return QStringLiteral("%1/%2x%3/%4.png").arg(this->strCacheDir).arg(thumbsize.width()).arg(thumbsize.height())
+                                           .arg(QString::fromLatin1(hash.toHex()));
+}
+
+/* Returns true, if the cache contains an up-to-date thumbnail of the image (path) with the timestamp of the last
+   modification (lastmodified) and the given size (thumbsize). Only the header of the cached file is read. */
+bool IBThumbnailCache::contains(const QString &path, const QDateTime &lastmodified, const QSize &thumbsize) const
+{
+   QImageReader reader(this->getCacheFilePath(path, thumbsize), "png");
+
+   return this->isEnabled() && this->isValidEntry(reader, path, lastmodified);
+}
+
+/* Loads the cached thumbnail of the image (path) with the timestamp of the last modification (lastmodified) and the
+   given size (thumbsize) into thumbnail and the original size of the image into imagesize. Returns false, if the
+   cache contains no thumbnail or if it is older than the image. */
+bool IBThumbnailCache::load(const QString &path, const QDateTime &lastmodified, const QSize &thumbsize,
+                            QImage *thumbnail, QSize *imagesize) const
+{
+   QImageReader reader(this->getCacheFilePath(path, thumbsize), "png");
+
+   if(!this->isEnabled() || !this->isValidEntry(reader, path, lastmodified) || !reader.read(thumbnail))
+   {
+      return false;
+   }
+
+   if(imagesize)
+   {
+      *imagesize = QSize(reader.text(QStringLiteral("Thumb::Image::Width")).toInt(),
+                         reader.text(QStringLiteral("Thumb::Image::Height")).toInt());
+   }
+
+   return true;
+}
+
+/* Stores the thumbnail (thumbnail) with the given size (thumbsize) of the image (path) with the timestamp of the last
+   modification (lastmodified) and the original size (imagesize). The file is replaced atomically, so that several
+   processes may fill the same cache. Returns false, if the thumbnail could not be written. */
+bool IBThumbnailCache::store(const QString &path, const QDateTime &lastmodified, const QSize &thumbsize,
+                             const QImage &thumbnail, const QSize &imagesize) const
+{
+   QList<QPair<QString, QString> > texts;
+
+   if(thumbnail.isNull())
+   {
+      return false;
+   }
+
+   texts << qMakePair(QStringLiteral("Thumb::Image::Width"), QString::number(imagesize.width()))
+         << qMakePair(QStringLiteral("Thumb::Image::Height"), QString::number(imagesize.height()));
+
+   return this->writeEntry(this->getCacheFilePath(path, thumbsize), path, lastmodified, thumbnail, texts);
+}
+
+/* Returns the path of the entry, which records that the image (path) could not be decoded. As in the thumbnail
+   specification of freedesktop.org, the failures are kept in the subdirectory fail independent of the size. */
+QString IBThumbnailCache::getFailureFilePath(const QString &path) const
+{
+   QByteArray hash = QCryptographicHash::hash(QUrl::fromLocalFile(path).toEncoded(), QCryptographicHash::Md5);
+
+   return QStringLiteral("%1/fail/%2.png").arg(this->strCacheDir).arg(QString::fromLatin1(hash.toHex()));
+}
+
+/* Returns true, if the image (path) with the timestamp of the last modification (lastmodified) and the file size
+   (size) could not be decoded before. A failure is forgotten, as soon as the file changes. */
+bool IBThumbnailCache::containsFailure(const QString &path, const QDateTime &lastmodified, qint64 size) const
+{
+   QImageReader reader(this->getFailureFilePath(path), "png");
+
+   return this->isEnabled() && this->isValidEntry(reader, path, lastmodified)
+          && reader.text(QStringLiteral("Thumb::Size")) == QString::number(size);
+}
+
+/* Records that the image (path) with the timestamp of the last modification (lastmodified) and the file size (size)
+   could not be decoded, so that it is not decoded again until it changes. The entry is an image of one transparent
+   pixel. Returns false, if the entry could not be written. */
+bool IBThumbnailCache::storeFailure(const QString &path, const QDateTime &lastmodified, qint64 size) const
+{
+   QList<QPair<QString, QString> > texts;
+   QImage pixel(1, 1, QImage::Format_ARGB32);
+
+   pixel.fill(Qt::transparent);
+   texts << qMakePair(QStringLiteral("Thumb::Size"), QString::number(size));
+
+   return this->writeEntry(this->getFailureFilePath(path), path, lastmodified, pixel, texts);
+}
+
+/* Sets the directory (cachedir) of the caches, which are constructed afterwards. It has to be called before any
+   thread uses a cache. */
+void IBThumbnailCache::setDefaultCacheDir(const QString &cachedir)
+{
+   IBThumbnailCache::strDefaultCacheDir = cachedir;
+}
+
+/* Returns the directory of the caches, which are constructed without a directory. If it is not set, the environment
+   variable IB_THUMBNAIL_CACHE or the subdirectory simpleimagebrowser/thumbnails of the generic cache location of the
+   user is used. */
+QString IBThumbnailCache::getDefaultCacheDir()
+{
+   QString cachedir = IBThumbnailCache::strDefaultCacheDir;
+
+   if(cachedir.isEmpty())
+   {
+      cachedir = qEnvironmentVariable("IB_THUMBNAIL_CACHE");
+   }
+
+   if(cachedir.isEmpty())
+   {
+      cachedir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+      cachedir = cachedir.isEmpty() ? QString() : cachedir + QStringLiteral("/simpleimagebrowser/thumbnails");
+   }
+
+   return cachedir;
+}
+
+/* Writes the image (image) of the entry (cachepath) of the image file (path) with the timestamp of its last
+   modification (lastmodified) and the additional texts (texts). The file is replaced atomically, so that several
+   processes may fill the same cache. Returns false, if the entry could not be written. */
+bool IBThumbnailCache::writeEntry(const QString &cachepath, const QString &path, const QDateTime &lastmodified,
+                                  const QImage &image, const QList<QPair<QString, QString> > &texts) const
+{
+   QSaveFile file(cachepath);
+   QImageWriter writer(&file, "png");
+   QList<QPair<QString, QString> >::const_iterator it;
+
+   if(!this->isEnabled() || !QDir().mkpath(QFileInfo(cachepath).path()) || !file.open(QIODevice::WriteOnly))
+   {
+      return false;
+   }
+
+   writer.setText(QStringLiteral("Thumb::URI"), QString::fromLatin1(QUrl::fromLocalFile(path).toEncoded()));
+   writer.setText(QStringLiteral("Thumb::MTime"), QString::number(lastmodified.toSecsSinceEpoch()));
+
+   for(it = texts.begin(); it != texts.end(); ++it)
+   {
+      writer.setText(it->first, it->second);
+   }
+
+   if(!writer.write(image))
+   {
+      file.cancelWriting();
+      return false;
+   }
+
+   return file.commit();
+}
+
+/* Returns true, if the header of the cached file (reader) belongs to the image (path) and if its timestamp matches
+   the timestamp of the last modification (lastmodified). */
+bool IBThumbnailCache::isValidEntry(QImageReader &reader, const QString &path, const QDateTime &lastmodified) const
+{
+   if(!reader.canRead())
+   {
+      return false;
+   }
+
+   return reader.text(QStringLiteral("Thumb::MTime")) == QString::number(lastmodified.toSecsSinceEpoch())
+          && reader.text(QStringLiteral("Thumb::URI")) == QString::fromLatin1(QUrl::fromLocalFile(path).toEncoded());
+}
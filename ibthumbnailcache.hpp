@@ -0,0 +1,64 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBTHUMBNAILCACHE
+#define H_IBTHUMBNAILCACHE
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QList>
+#include <QPair>
+#include <QSaveFile>
+#include <QSize>
+#include <QStandardPaths>
+#include <QString>
+#include <QUrl>
+
+/* class IBThumbnailCache */
+
+class IBThumbnailCache
+{
+   public:
+      IBThumbnailCache();
+      IBThumbnailCache(const QString &cachedir);
+
+      void setCacheDir(const QString &cachedir);
+      QString getCacheDir() const;
+
+      void setEnabled(bool enabled);
+      bool isEnabled() const;
+
+      QString getCacheFilePath(const QString &path, const QSize &thumbsize) const;
+      bool contains(const QString &path, const QDateTime &lastmodified, const QSize &thumbsize) const;
+      bool load(const QString &path, const QDateTime &lastmodified, const QSize &thumbsize, QImage *thumbnail,
+                QSize *imagesize) const;
+      bool store(const QString &path, const QDateTime &lastmodified, const QSize &thumbsize, const QImage &thumbnail,
+                 const QSize &imagesize) const;
+
+      QString getFailureFilePath(const QString &path) const;
+      bool containsFailure(const QString &path, const QDateTime &lastmodified, qint64 size) const;
+      bool storeFailure(const QString &path, const QDateTime &lastmodified, qint64 size) const;
+
+      static void setDefaultCacheDir(const QString &cachedir);
+      static QString getDefaultCacheDir();
+
+   private:
+      bool isValidEntry(QImageReader &reader, const QString &path, const QDateTime &lastmodified) const;
+      bool writeEntry(const QString &cachepath, const QString &path, const QDateTime &lastmodified,
+                      const QImage &image, const QList<QPair<QString, QString> > &texts) const;
+
+      /* directory with a subdirectory of thumbnails per thumbnail size */
+      QString strCacheDir;
+      /* is false, if thumbnails are neither looked up nor stored */
+      bool bEnabled;
+
+      /* cache directory of new caches, it is set once at the start */
+      static QString strDefaultCacheDir;
+};
+
+#endif /*H_IBTHUMBNAILCACHE*/
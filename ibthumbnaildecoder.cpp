@@ -0,0 +1,528 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibthumbnaildecoder.hpp"
+
+/* class IBScanlineScaler */
+
+/* Constructs an area-averaging scaler, which reduces an image of the source size (sourcesize) to the target
+   size (targetsize) while its rows are added one by one. Only the sums of one target row are kept in memory. */
+IBScanlineScaler::IBScanlineScaler(const QSize &sourcesize, const QSize &targetsize, bool alphachannel)
+   : szSource(sourcesize), iCurrentRow(-1), iRowCount(0)
+{
+   int x, column;
+
+   this->imgTarget = QImage(targetsize, alphachannel ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+   this->imgTarget.fill(0);
+
+   this->vecColumnMap.resize(sourcesize.width());
+   this->vecColumnCount.fill(0, targetsize.width());
+   this->vecSums.fill(0, targetsize.width() * 4);
+
+   for(x = 0; x < sourcesize.width(); x++)
+   {
+      column = int(qint64(x) * targetsize.width() / sourcesize.width());
+      this->vecColumnMap[x] = column;
+      this->vecColumnCount[column]++;
+   }
+}
+
+/* Adds the premultiplied pixels (line) of the source row (row). The rows have to be added in ascending
+   or descending order. */
+void IBScanlineScaler::addScanline(int row, const QRgb *line)
+{
+   int targetrow = int(qint64(row) * this->imgTarget.height() / this->szSource.height());
+   quint64 *sums;
+   int x;
+
+   if(targetrow != this->iCurrentRow)
+   {
+      this->flushRow();
+      this->iCurrentRow = targetrow;
+   }
+
+   for(x = 0; x < this->szSource.width(); x++)
+   {
+      sums = this->vecSums.data() + this->vecColumnMap[x] * 4;
+      sums[0] += qRed(line[x]);
+      sums[1] += qGreen(line[x]);
+      sums[2] += qBlue(line[x]);
+      sums[3] += qAlpha(line[x]);
+   }
+
+   this->iRowCount++;
+}
+
+/* Returns the scaled down image. */
+QImage IBScanlineScaler::getImage()
+{
+   this->flushRow();
+
+   return this->imgTarget;
+}
+
+/* Writes the averages of the current target row into the target image and resets the sums. */
+void IBScanlineScaler::flushRow()
+{
+   QRgb *target;
+   quint64 *sums, count;
+   int x;
+
+   if(this->iCurrentRow < 0 || this->iRowCount == 0)
+   {
+      return;
+   }
+
+   target = reinterpret_cast<QRgb *>(this->imgTarget.scanLine(this->iCurrentRow));
+
+   for(x = 0; x < this->imgTarget.width(); x++)
+   {
+      sums = this->vecSums.data() + x * 4;
+      count = quint64(this->vecColumnCount[x]) * quint64(this->iRowCount);
+
+      if(count > 0)
+      {
+         target[x] = qRgba(int((sums[0] + count / 2) / count), int((sums[1] + count / 2) / count),
+                           int((sums[2] + count / 2) / count), int((sums[3] + count / 2) / count));
+      }
+
+      sums[0] = sums[1] = sums[2] = sums[3] = 0;
+   }
+
+   this->iRowCount = 0;
+}
+
+/* class IBThumbnailDecoder */
+
+/* Constructs a decoder for thumbnails. Images with more than 24 megapixels are decoded row by row,
+   if their format supports it. Images with more than 64 megapixels, which can neither be decoded row by row nor
+   scaled while decoding, are refused. Scratch buffers up to 64 MiB are kept for the next decode. */
+IBThumbnailDecoder::IBThumbnailDecoder()
+   : iStreamingThreshold(24 * 1024 * 1024), iDecodeLimit(64 * 1024 * 1024), iScratchLimit(64 * 1024 * 1024),
+     iAccountedScratch(0)
+{
+}
+
+/* Destructs the decoder and releases the accounted memory of its scratch buffers. */
+IBThumbnailDecoder::~IBThumbnailDecoder()
+{
+   IBMemoryAccounting::resize(IBMemoryAccounting::DecoderBuffers, this->iAccountedScratch, 0);
+}
+
+/* Decodes the image of the given path (path) and scales it down to fit into the size of the thumbnails (thumbsize).
+   The original size of the image is stored in imagesize. The size is read from the header first: oversized images
+   and TIFF images are reduced while they are read from the file, so that neither the file content nor the full
+   frame is held in memory, other images are decoded from the file content read into a scratch buffer. The decoded
+   frame and the scaler intermediates are kept in scratch buffers too, so that decoding images of similar sizes does
+   not allocate them again. The format is sniffed from the first bytes of the file, so that empty, unsupported and
+   misnamed files are rejected without decoding them and the image is decoded by its content regardless of its
+   extension. The sniffed format is stored in sniffedformat, it is empty if the format is not supported. TIFF-based
+   RAW files are decoded from their largest embedded JPEG preview, whose size is stored as the size of the image,
+   other TIFF files are decoded as images. If the image could not be decoded, imagesize is 0x0, if its file was read,
+   and invalid, if the file could not be opened or read, so that an I/O error is not taken for a broken image. */
+QImage IBThumbnailDecoder::decode(const QString &path, const QSize &thumbsize, QSize *imagesize,
+                                  QByteArray *sniffedformat)
+{
+   QFile file(path);
+   QBuffer buffer;
+   QImageReader reader;
+   QSize fullsize, scaledsize;
+   QImage image;
+   QElapsedTimer timer;
+   QByteArray format;
+   qint64 filesize;
+   bool refused;
+
+   timer.start();
+
+   if(file.open(QIODevice::ReadOnly))
+   {
+      format = IBThumbnailDecoder::sniffFormat(file.peek(64));
+
+      if(sniffedformat)
+      {
+         *sniffedformat = format;
+      }
+
+      /* RAW files are decoded from their largest embedded preview, the raw data is never read, other TIFF files are
+         decoded as images even if they carry an EXIF thumbnail */
+      if(format == "tiff" && IBRawPreview::isRawFileName(path))
+      {
+         format = this->readRawPreview(&file, &buffer) ? QByteArrayLiteral("jpeg") : QByteArray();
+      }
+
+      this->dsStatistics.iRejected += format.isEmpty() ? 1 : 0;
+   }
+
+   if(format.isEmpty())
+   {
+      if(imagesize)
+      {
+         *imagesize = file.isOpen() ? QSize(0, 0) : QSize();
+      }
+
+      this->dsStatistics.iFailures++;
+      return QImage();
+   }
+
+   if(buffer.isOpen())
+   {
+      reader.setDevice(&buffer);
+   }
+   else
+   {
+      file.seek(0);
+      reader.setDevice(&file);
+   }
+
+   reader.setFormat(format);
+   fullsize = reader.size();
+
+   this->dsStatistics.iReadTime += timer.nsecsElapsed();
+   timer.restart();
+
+   /* TIFF images are always read row by row, their image plugin is optional */
+   if(!buffer.isOpen() && (format == "tiff" || !fullsize.isValid() ||
+                           qint64(fullsize.width()) * fullsize.height() > this->iStreamingThreshold))
+   {
+      file.seek(0);
+      image = this->decodeStreaming(&file, format, thumbsize, &fullsize);
+   }
+
+   /* the full frame of an oversized image, which can neither be streamed nor scaled while decoding, is never
+      allocated */
+   refused = image.isNull() && fullsize.isValid() && !reader.supportsOption(QImageIOHandler::ScaledSize) &&
+             qint64(fullsize.width()) * fullsize.height() > this->iDecodeLimit;
+
+   if(image.isNull() && !refused && !buffer.isOpen())
+   {
+      IB_TRACE_SCOPE("thumbnails", "readFile");
+
+      this->dsStatistics.iDecodeTime += timer.nsecsElapsed();
+      timer.restart();
+
+      filesize = file.size();
+      file.seek(0);
+
+      if(filesize > 0 && filesize <= this->iScratchLimit)
+      {
+         if(this->baFileBuffer.size() < filesize)
+         {
+            this->baFileBuffer.resize(int(filesize));
+         }
+
+         if(file.read(this->baFileBuffer.data(), filesize) == filesize)
+         {
+            /* the raw data refers to the scratch buffer without copying it */
+            buffer.setData(QByteArray::fromRawData(this->baFileBuffer.constData(), int(filesize)));
+            buffer.open(QIODevice::ReadOnly);
+         }
+      }
+
+      /* the reader is set up again, because it has already read the header from the file */
+      if(buffer.isOpen())
+      {
+         reader.setDevice(&buffer);
+      }
+      else
+      {
+         file.seek(0);
+         reader.setDevice(&file);
+      }
+
+      reader.setFormat(format);
+
+      this->dsStatistics.iReadTime += timer.nsecsElapsed();
+      timer.restart();
+   }
+
+   if(image.isNull() && !refused && fullsize.isValid())
+   {
+      scaledsize = fullsize;
+
+      if(fullsize.width() > thumbsize.width() || fullsize.height() > thumbsize.height())
+      {
+         scaledsize = fullsize.scaled(thumbsize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+      }
+
+      if(scaledsize != fullsize && reader.supportsOption(QImageIOHandler::ScaledSize))
+      {
+         reader.setScaledSize(scaledsize);
+         image = reader.read();
+      }
+   }
+
+   if(image.isNull() && !refused && reader.read(&this->imgDecodeBuffer))
+   {
+      fullsize = fullsize.isValid() ? fullsize : this->imgDecodeBuffer.size();
+
+      if(this->imgDecodeBuffer.width() > thumbsize.width() || this->imgDecodeBuffer.height() > thumbsize.height())
+      {
+         this->dsStatistics.iDecodeTime += timer.nsecsElapsed();
+         timer.restart();
+
+         image = IBImageScaler::scale(this->imgDecodeBuffer, thumbsize, Qt::KeepAspectRatio, &this->sbScalerBuffers);
+
+         this->dsStatistics.iScaleTime += timer.nsecsElapsed();
+         timer.invalidate();
+      }
+      else
+      {
+         /* the small image is handed out, so that the scratch buffer is not shared with the caller */
+         image = this->imgDecodeBuffer;
+         this->imgDecodeBuffer = QImage();
+      }
+   }
+
+   if(timer.isValid())
+   {
+      this->dsStatistics.iDecodeTime += timer.nsecsElapsed();
+   }
+
+   if(image.isNull())
+   {
+      this->dsStatistics.iFailures++;
+      this->dsStatistics.iRefused += refused ? 1 : 0;
+   }
+   else
+   {
+      this->dsStatistics.iImages++;
+   }
+
+   this->trimScratchBuffers();
+
+   if(imagesize)
+   {
+      *imagesize = !image.isNull() ? fullsize : (file.error() == QFileDevice::NoError ? QSize(0, 0) : QSize());
+   }
+
+   return image;
+}
+
+/* Returns the format of the image, whose file starts with the given bytes (header), as it is named by QImageReader.
+   Only the formats of IBImageListModel::getImageNameFilters are recognized, the TIFF-based RAW formats are returned
+   as "tiff". If the header matches none of them, an empty format is returned. */
+QByteArray IBThumbnailDecoder::sniffFormat(const QByteArray &header)
+{
+   if(header.startsWith("\xff\xd8\xff"))
+   {
+      return QByteArrayLiteral("jpeg");
+   }
+   else if(header.startsWith("\x89PNG\r\n\x1a\n"))
+   {
+      return QByteArrayLiteral("png");
+   }
+   else if(header.startsWith("BM") && header.size() >= 14)
+   {
+      return QByteArrayLiteral("bmp");
+   }
+   else if(header.size() >= 3 && header.at(0) == 'P' && header.at(1) >= '1' && header.at(1) <= '6'
+           && QChar::isSpace(uchar(header.at(2))))
+   {
+      switch(header.at(1))
+      {
+         case '1':
+         case '4':
+            return QByteArrayLiteral("pbm");
+
+         case '2':
+         case '5':
+            return QByteArrayLiteral("pgm");
+
+         default:
+            return QByteArrayLiteral("ppm");
+      }
+   }
+   else if(IBRawPreview::hasSignature(header))
+   {
+      return QByteArrayLiteral("tiff");
+   }
+   else if(header.startsWith("/* XPM */"))
+   {
+      return QByteArrayLiteral("xpm");
+   }
+   else if(header.trimmed().startsWith("#define"))
+   {
+      return QByteArrayLiteral("xbm");
+   }
+
+   return QByteArray();
+}
+
+/* Sets the number of pixels (pixels) above which images are decoded row by row. */
+void IBThumbnailDecoder::setStreamingThreshold(qint64 pixels)
+{
+   this->iStreamingThreshold = pixels;
+}
+
+/* Returns the number of pixels above which images are decoded row by row. */
+qint64 IBThumbnailDecoder::getStreamingThreshold() const
+{
+   return this->iStreamingThreshold;
+}
+
+/* Sets the number of pixels (pixels) above which images are refused, if they can neither be decoded row by row
+   nor scaled while decoding. */
+void IBThumbnailDecoder::setDecodeLimit(qint64 pixels)
+{
+   this->iDecodeLimit = pixels;
+}
+
+/* Returns the number of pixels above which images are refused, if they can neither be decoded row by row nor scaled
+   while decoding. */
+qint64 IBThumbnailDecoder::getDecodeLimit() const
+{
+   return this->iDecodeLimit;
+}
+
+/* Sets the maximum size in bytes (bytes) of a single scratch buffer, which is kept for the next decode.
+   Larger buffers are released after use and files larger than the limit are read directly. */
+void IBThumbnailDecoder::setScratchLimit(qint64 bytes)
+{
+   this->iScratchLimit = bytes;
+   this->trimScratchBuffers();
+}
+
+/* Returns the maximum size in bytes of a single scratch buffer, which is kept for the next decode. */
+qint64 IBThumbnailDecoder::getScratchLimit() const
+{
+   return this->iScratchLimit;
+}
+
+/* Returns the number of bytes currently held by the scratch buffers. */
+qint64 IBThumbnailDecoder::getScratchSize() const
+{
+   return qint64(this->baFileBuffer.capacity()) + qint64(this->imgDecodeBuffer.sizeInBytes())
+          + this->sbScalerBuffers.getSize() + qint64(this->vecScanline.capacity()) * qint64(sizeof(QRgb));
+}
+
+/* Releases all scratch buffers. */
+void IBThumbnailDecoder::releaseScratchBuffers()
+{
+   this->baFileBuffer = QByteArray();
+   this->imgDecodeBuffer = QImage();
+   this->sbScalerBuffers.clear();
+   this->vecScanline = QVector<QRgb>();
+   this->updateMemoryAccounting();
+}
+
+/* Returns the accumulated work of the decoder since its construction or the last reset. */
+IBThumbnailDecoderStatistics IBThumbnailDecoder::getStatistics() const
+{
+   return this->dsStatistics;
+}
+
+/* Resets the accumulated work of the decoder. */
+void IBThumbnailDecoder::resetStatistics()
+{
+   this->dsStatistics = IBThumbnailDecoderStatistics();
+}
+
+/* Releases the scratch buffers, which exceed the scratch limit. */
+void IBThumbnailDecoder::trimScratchBuffers()
+{
+   if(this->baFileBuffer.capacity() > this->iScratchLimit)
+   {
+      this->baFileBuffer = QByteArray();
+   }
+
+   if(this->imgDecodeBuffer.sizeInBytes() > this->iScratchLimit)
+   {
+      this->imgDecodeBuffer = QImage();
+   }
+
+   if(this->sbScalerBuffers.getSize() > this->iScratchLimit)
+   {
+      this->sbScalerBuffers.clear();
+   }
+
+   if(qint64(this->vecScanline.capacity()) * qint64(sizeof(QRgb)) > this->iScratchLimit)
+   {
+      this->vecScanline = QVector<QRgb>();
+   }
+
+   this->updateMemoryAccounting();
+}
+
+/* Accounts the current size of the scratch buffers in IBMemoryAccounting. */
+void IBThumbnailDecoder::updateMemoryAccounting()
+{
+   qint64 bytes = this->getScratchSize();
+
+   IBMemoryAccounting::resize(IBMemoryAccounting::DecoderBuffers, this->iAccountedScratch, bytes);
+   this->iAccountedScratch = bytes;
+}
+
+/* Reads the largest embedded JPEG preview of the RAW file (file) into the file buffer and opens the buffer (buffer)
+   on it. Previews larger than the scratch limit are rejected. Returns false, if no preview is found or it cannot be
+   read. */
+bool IBThumbnailDecoder::readRawPreview(QFile *file, QBuffer *buffer)
+{
+   IB_TRACE_SCOPE("thumbnails", "readRawPreview");
+   IBRawPreview preview(file);
+   qint64 length;
+
+   if(!preview.findPreview() || preview.getPreviewLength() > this->iScratchLimit)
+   {
+      return false;
+   }
+
+   length = preview.getPreviewLength();
+
+   if(this->baFileBuffer.size() < length)
+   {
+      this->baFileBuffer.resize(int(length));
+   }
+
+   if(!preview.readPreview(this->baFileBuffer.data()))
+   {
+      return false;
+   }
+
+   /* the raw data refers to the scratch buffer without copying it */
+   buffer->setData(QByteArray::fromRawData(this->baFileBuffer.constData(), int(length)));
+
+   return buffer->open(QIODevice::ReadOnly);
+}
+
+/* Decodes the image of the given format (format) row by row from the device (device) and reduces the rows into an
+   image, which fits into the given size (thumbsize), with an area-averaging accumulator. The peak memory is bound to
+   a few rows. The size of the image is stored in imagesize, when the header was read. If the format or one of its
+   features is not supported, a null image is returned. */
+QImage IBThumbnailDecoder::decodeStreaming(QIODevice *device, const QByteArray &format, const QSize &thumbsize,
+                                           QSize *imagesize)
+{
+   IB_TRACE_SCOPE("thumbnails", "decodeStreaming");
+   QScopedPointer<IBScanlineReader> reader(IBScanlineReader::create(device, format));
+   QSize fullsize, scaledsize;
+   int idx, row;
+
+   if(!reader || !reader->readHeader())
+   {
+      return QImage();
+   }
+
+   fullsize = reader->getSize();
+   scaledsize = fullsize;
+   *imagesize = fullsize;
+
+   if(fullsize.width() > thumbsize.width() || fullsize.height() > thumbsize.height())
+   {
+      scaledsize = fullsize.scaled(thumbsize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+   }
+
+   IBScanlineScaler scaler(fullsize, scaledsize, reader->hasAlphaChannel());
+   this->vecScanline.resize(fullsize.width());
+
+   for(idx = 0; idx < fullsize.height(); idx++)
+   {
+      if(!reader->readScanline(this->vecScanline.data(), &row))
+      {
+         return QImage();
+      }
+
+      scaler.addScanline(row, this->vecScanline.constData());
+   }
+
+   return scaler.getImage();
+}
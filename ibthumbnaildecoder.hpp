@@ -0,0 +1,127 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBTHUMBNAILDECODER
+#define H_IBTHUMBNAILDECODER
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QScopedPointer>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+#include "ibimagescaler.hpp"
+#include "ibmemoryaccounting.hpp"
+#include "ibrawpreview.hpp"
+#include "ibscanlinereader.hpp"
+#include "ibtrace.hpp"
+
+/* class IBScanlineScaler */
+
+class IBScanlineScaler
+{
+   public:
+      IBScanlineScaler(const QSize &sourcesize, const QSize &targetsize, bool alphachannel);
+
+      void addScanline(int row, const QRgb *line);
+      QImage getImage();
+
+   private:
+      void flushRow();
+
+      /* size of the source image */
+      QSize szSource;
+      /* scaled down image */
+      QImage imgTarget;
+      /* target column of every source column */
+      QVector<int> vecColumnMap;
+      /* number of source columns of every target column */
+      QVector<quint32> vecColumnCount;
+      /* sums of the four channels of every target column in the current target row */
+      QVector<quint64> vecSums;
+      /* target row which is currently accumulated, -1 if none */
+      int iCurrentRow;
+      /* number of source rows accumulated in the current target row */
+      int iRowCount;
+};
+
+/* accumulated work of a thumbnail decoder, the times are given in nanoseconds */
+struct IBThumbnailDecoderStatistics
+{
+   /* number of decoded images */
+   qint64 iImages = 0;
+   /* number of images, which could not be decoded */
+   qint64 iFailures = 0;
+   /* number of files, which were rejected by their content before decoding, they are counted as failures too */
+   qint64 iRejected = 0;
+   /* number of oversized images, which were refused instead of decoding their full frame, they are counted as
+      failures too */
+   qint64 iRefused = 0;
+   /* time of reading the files into the memory */
+   qint64 iReadTime = 0;
+   /* time of decoding the images, including the scaling of streamed images */
+   qint64 iDecodeTime = 0;
+   /* time of scaling the decoded images */
+   qint64 iScaleTime = 0;
+};
+
+/* class IBThumbnailDecoder */
+
+class IBThumbnailDecoder
+{
+   public:
+      IBThumbnailDecoder();
+      ~IBThumbnailDecoder();
+
+      QImage decode(const QString &path, const QSize &thumbsize, QSize *imagesize = nullptr,
+                    QByteArray *sniffedformat = nullptr);
+
+      static QByteArray sniffFormat(const QByteArray &header);
+
+      void setStreamingThreshold(qint64 pixels);
+      qint64 getStreamingThreshold() const;
+      void setDecodeLimit(qint64 pixels);
+      qint64 getDecodeLimit() const;
+      void setScratchLimit(qint64 bytes);
+      qint64 getScratchLimit() const;
+      qint64 getScratchSize() const;
+      void releaseScratchBuffers();
+
+      IBThumbnailDecoderStatistics getStatistics() const;
+      void resetStatistics();
+
+   private:
+      Q_DISABLE_COPY(IBThumbnailDecoder)
+
+      QImage decodeStreaming(QIODevice *device, const QByteArray &format, const QSize &thumbsize, QSize *imagesize);
+      bool readRawPreview(QFile *file, QBuffer *buffer);
+      void trimScratchBuffers();
+      void updateMemoryAccounting();
+
+      /* images with more pixels are decoded row by row, if their format supports it */
+      qint64 iStreamingThreshold;
+      /* images with more pixels are refused, if they can neither be decoded row by row nor scaled while decoding */
+      qint64 iDecodeLimit;
+      /* maximum size of a single scratch buffer kept between two decodes */
+      qint64 iScratchLimit;
+      /* reusable buffer of the file content, sized by the largest file read so far */
+      QByteArray baFileBuffer;
+      /* reusable target of the full-size decode */
+      QImage imgDecodeBuffer;
+      /* reusable intermediate buffers of the scaler */
+      IBImageScalerBuffers sbScalerBuffers;
+      /* reusable row of the streaming decode */
+      QVector<QRgb> vecScanline;
+      /* accumulated work of the decoder */
+      IBThumbnailDecoderStatistics dsStatistics;
+      /* bytes of the scratch buffers, which are accounted in IBMemoryAccounting */
+      qint64 iAccountedScratch;
+};
+
+#endif /*H_IBTHUMBNAILDECODER*/
@@ -0,0 +1,754 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibtiledimageview.hpp"
+
+/* largest number of pixels of an image, which is decoded completely if it can neither be decoded by regions nor row
+   by row */
+static const qint64 iMaxFullDecodePixels = 64 * 1024 * 1024;
+/* largest number of pixels of the level, which is reduced from all rows of an image decoded row by row */
+static const qint64 iMaxSourceLevelPixels = 4 * 1024 * 1024;
+/* largest zoom factor */
+static const qreal dMaxZoom = 16.0;
+
+/* class IBTileLoader */
+
+/* Constructs the thread for decoding the tiles of an image. */
+IBTileLoader::IBTileLoader(QObject *parent)
+   : QThread(parent), dcDecoding(IBTileLoader::FullDecoding), iGeneration(0), iSourceGeneration(0), iSourceLevel(0),
+     srReader(nullptr), iBandLevel(0), iBandRow(0)
+{
+}
+
+/* Stops the thread before it is destroyed and releases the decoded image and the row reader. */
+IBTileLoader::~IBTileLoader()
+{
+   this->stop();
+   this->releaseSource();
+}
+
+/* Decodes the requested tiles one after another. If a tile is decoded, the signal tileLoaded is emitted. */
+void IBTileLoader::run()
+{
+   QString path;
+   QSize imagesize;
+   QImage tile;
+   quint64 key;
+   Decoding decoding;
+   uint generation;
+
+   forever
+   {
+      this->mtxQueue.lock();
+
+      while(this->lstQueue.isEmpty() && !this->isInterruptionRequested())
+      {
+         this->wcQueue.wait(&this->mtxQueue);
+      }
+
+      if(this->isInterruptionRequested())
+      {
+         this->mtxQueue.unlock();
+         return;
+      }
+
+      key = this->lstQueue.takeFirst();
+      IB_TRACE_COUNTER("tiles", "tilesQueued", this->lstQueue.size());
+      path = this->strPath;
+      imagesize = this->szImageSize;
+      decoding = this->dcDecoding;
+      generation = this->iGeneration;
+      this->mtxQueue.unlock();
+
+      if(generation != this->iSourceGeneration)
+      {
+         this->releaseSource();
+         this->iSourceGeneration = generation;
+
+         /* an image decoded row by row is reduced to the finest level, which fits into the pixel budget */
+         this->iSourceLevel = 0;
+         while(qint64(IBTileLoader::getLevelSize(this->iSourceLevel, imagesize).width()) *
+               IBTileLoader::getLevelSize(this->iSourceLevel, imagesize).height() > iMaxSourceLevelPixels)
+         {
+            this->iSourceLevel++;
+         }
+      }
+
+      tile = this->loadTile(key, path, imagesize, decoding, generation);
+      emit this->tileLoaded(generation, key, tile);
+   }
+}
+
+/* Sets the image (path) with its size (imagesize) to be tiled and the way of decoding its tiles (decoding).
+   All requested tiles of the previous image are discarded. */
+void IBTileLoader::setImage(const QString &path, const QSize &imagesize, Decoding decoding, uint generation)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->strPath = path;
+   this->szImageSize = imagesize;
+   this->dcDecoding = decoding;
+   this->iGeneration = generation;
+   this->lstQueue.clear();
+}
+
+/* Replaces the requested tiles by the tiles of the given keys (keys) and wakes the thread. */
+void IBTileLoader::request(const QList<quint64> &keys)
+{
+   QMutexLocker locker(&this->mtxQueue);
+
+   this->lstQueue = keys;
+
+   if(!this->lstQueue.isEmpty())
+   {
+      if(!this->isRunning())
+      {
+         this->start(QThread::LowPriority);
+      }
+      this->wcQueue.wakeOne();
+   }
+}
+
+/* Stops the thread and discards the requested tiles. */
+void IBTileLoader::stop()
+{
+   this->mtxQueue.lock();
+   this->lstQueue.clear();
+   this->requestInterruption();
+   this->wcQueue.wakeAll();
+   this->mtxQueue.unlock();
+
+   this->wait();
+}
+
+/* Returns the key of a tile given by its level (level), column (column) and row (row). */
+quint64 IBTileLoader::getTileKey(int level, int column, int row)
+{
+   return (quint64(level) << 56) | (quint64(row & 0xFFFFFFF) << 28) | quint64(column & 0xFFFFFFF);
+}
+
+/* Returns the size of an image (imagesize) in the given level (level) of the pyramid. Every level halves the size
+   of the previous one. */
+QSize IBTileLoader::getLevelSize(int level, const QSize &imagesize)
+{
+   return QSize((imagesize.width() + (1 << level) - 1) >> level, (imagesize.height() + (1 << level) - 1) >> level);
+}
+
+/* Returns the rectangle of a tile given by its level (level), column (column) and row (row) in the coordinates
+   of its level. Tiles on the right and bottom border are smaller than the tile size. */
+QRect IBTileLoader::getTileRect(int level, int column, int row, const QSize &imagesize)
+{
+   QRect levelrect(QPoint(0, 0), IBTileLoader::getLevelSize(level, imagesize));
+
+   return QRect(column * IBTileLoader::TileSize, row * IBTileLoader::TileSize,
+                IBTileLoader::TileSize, IBTileLoader::TileSize).intersected(levelrect);
+}
+
+/* Returns the rectangle of the full resolution image (imagesize) which is covered by a tile (tilerect)
+   of the given level (level). */
+QRect IBTileLoader::getTileSourceRect(int level, const QRect &tilerect, const QSize &imagesize)
+{
+   return QRect(tilerect.x() << level, tilerect.y() << level,
+                tilerect.width() << level, tilerect.height() << level).intersected(QRect(QPoint(0, 0), imagesize));
+}
+
+/* Decodes the tile of the given key (key). With region decoding, only the region of the tile is decoded and scaled
+   while decoding. With row decoding, the tile is reduced from the rows of the image. Otherwise the image is decoded
+   once and the tiles are cut out of it. RAW files are decoded once from their largest embedded preview. */
+QImage IBTileLoader::loadTile(quint64 key, const QString &path, const QSize &imagesize, Decoding decoding,
+                              uint generation)
+{
+   IB_TRACE_SCOPE("tiles", "loadTile");
+   int level = int(key >> 56);
+   int row = int((key >> 28) & 0xFFFFFFF);
+   int column = int(key & 0xFFFFFFF);
+   QRect tilerect = IBTileLoader::getTileRect(level, column, row, imagesize);
+   QRect sourcerect = IBTileLoader::getTileSourceRect(level, tilerect, imagesize);
+   QImageReader reader;
+   QBuffer buffer;
+
+   if(tilerect.isEmpty())
+   {
+      return QImage();
+   }
+
+   if(decoding == IBTileLoader::RegionDecoding)
+   {
+      reader.setFileName(path);
+      reader.setClipRect(sourcerect);
+      if(level > 0)
+      {
+         reader.setScaledSize(tilerect.size());
+      }
+      return reader.read();
+   }
+
+   if(decoding == IBTileLoader::RowDecoding)
+   {
+      return this->loadRowTile(level, tilerect, path, imagesize, generation);
+   }
+
+   if(this->imgSource.isNull())
+   {
+      if(!IBRawPreview::openPreview(path, &buffer, &reader))
+      {
+         reader.setFileName(path);
+      }
+
+      this->imgSource = reader.read();
+      IBMemoryAccounting::resize(IBMemoryAccounting::ViewerSource, 0, this->imgSource.sizeInBytes());
+   }
+
+   if(level == 0)
+   {
+      return this->imgSource.copy(sourcerect);
+   }
+
+   return this->imgSource.copy(sourcerect).scaled(tilerect.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+/* Decodes the tile (tilerect) of the given level (level) of an image, which is read row by row. The tiles of the
+   levels from iSourceLevel on are cut out of the image, which is reduced to iSourceLevel in one pass over all rows.
+   The tiles of the finer levels are cut out of a band of one tile row, which is reduced from the rows covered by it,
+   so that the full resolution image is never held in memory. */
+QImage IBTileLoader::loadRowTile(int level, const QRect &tilerect, const QString &path, const QSize &imagesize,
+                                 uint generation)
+{
+   QRect sourcerect;
+   int shift;
+
+   if(level < this->iSourceLevel)
+   {
+      if(this->imgBand.isNull() || this->iBandLevel != level || this->iBandRow != tilerect.y() / IBTileLoader::TileSize)
+      {
+         IBMemoryAccounting::resize(IBMemoryAccounting::ViewerSource, this->imgBand.sizeInBytes(), 0);
+         this->imgBand = this->readRows(path, imagesize, level, tilerect.y(), tilerect.height(), generation);
+         this->iBandLevel = level;
+         this->iBandRow = tilerect.y() / IBTileLoader::TileSize;
+         IBMemoryAccounting::resize(IBMemoryAccounting::ViewerSource, 0, this->imgBand.sizeInBytes());
+      }
+
+      return this->imgBand.copy(tilerect.x(), 0, tilerect.width(), tilerect.height());
+   }
+
+   if(this->imgSource.isNull())
+   {
+      this->imgSource = this->readRows(path, imagesize, this->iSourceLevel, 0,
+                                       IBTileLoader::getLevelSize(this->iSourceLevel, imagesize).height(), generation);
+      IBMemoryAccounting::resize(IBMemoryAccounting::ViewerSource, 0, this->imgSource.sizeInBytes());
+   }
+
+   shift = level - this->iSourceLevel;
+   sourcerect = QRect(tilerect.x() << shift, tilerect.y() << shift, tilerect.width() << shift,
+                      tilerect.height() << shift).intersected(this->imgSource.rect());
+
+   if(shift == 0)
+   {
+      return this->imgSource.copy(sourcerect);
+   }
+
+   return this->imgSource.copy(sourcerect).scaled(tilerect.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+/* Reduces the rows of the image (path), which are covered by the given number of rows (rows) from the row (firstrow)
+   on of the given level (level), into an image with the full width of the level. The reader is kept open, so that
+   the following bands are read on from its current row. It is opened again, if it cannot go back to the first row.
+   Returns a null image, if the rows cannot be read or the image is replaced (generation) meanwhile. */
+QImage IBTileLoader::readRows(const QString &path, const QSize &imagesize, int level, int firstrow, int rows,
+                              uint generation)
+{
+   IB_TRACE_SCOPE("tiles", "readRows");
+   QSize levelsize = IBTileLoader::getLevelSize(level, imagesize);
+   int top = firstrow << level;
+   int bottom = qMin(imagesize.height(), (firstrow + rows) << level);
+   int idx, row;
+
+   if(!this->srReader || !this->srReader->seekScanline(this->srReader->isBottomUp() ? bottom - 1 : top))
+   {
+      delete this->srReader;
+      this->fileSource.close();
+      this->fileSource.setFileName(path);
+
+      this->srReader = this->fileSource.open(QIODevice::ReadOnly) ?
+                       IBScanlineReader::create(&this->fileSource,
+                                                IBThumbnailDecoder::sniffFormat(this->fileSource.peek(64))) : nullptr;
+
+      if(!this->srReader || !this->srReader->readHeader() || this->srReader->getSize() != imagesize ||
+         !this->srReader->seekScanline(this->srReader->isBottomUp() ? bottom - 1 : top))
+      {
+         return QImage();
+      }
+   }
+
+   IBScanlineScaler scaler(QSize(imagesize.width(), bottom - top), QSize(levelsize.width(), rows),
+                           this->srReader->hasAlphaChannel());
+   this->vecScanline.resize(imagesize.width());
+
+   for(idx = top; idx < bottom; idx++)
+   {
+      /* a pass over many rows is given up, when another image is displayed */
+      if(idx % 64 == 0)
+      {
+         QMutexLocker locker(&this->mtxQueue);
+
+         if(this->iGeneration != generation || this->isInterruptionRequested())
+         {
+            return QImage();
+         }
+      }
+
+      if(!this->srReader->readScanline(this->vecScanline.data(), &row))
+      {
+         return QImage();
+      }
+
+      scaler.addScanline(row - top, this->vecScanline.constData());
+   }
+
+   return scaler.getImage();
+}
+
+/* Releases the decoded image, the band and the row reader of the previous image. */
+void IBTileLoader::releaseSource()
+{
+   IBMemoryAccounting::resize(IBMemoryAccounting::ViewerSource,
+                              this->imgSource.sizeInBytes() + this->imgBand.sizeInBytes(), 0);
+   this->imgSource = QImage();
+   this->imgBand = QImage();
+
+   delete this->srReader;
+   this->srReader = nullptr;
+   this->fileSource.close();
+}
+
+/* class IBTiledImageView */
+
+/* Constructs the zoomable and pannable image view with a tile cache of 96 MiB. */
+IBTiledImageView::IBTiledImageView(QWidget *parent)
+   : QAbstractScrollArea(parent), iMaxLevel(0), iGeneration(0), dZoom(1.0), bFitToView(true)
+{
+   this->tlLoader = new IBTileLoader(this);
+   this->connect(this->tlLoader, &IBTileLoader::tileLoaded, this, &IBTiledImageView::onTileLoaded);
+
+   this->setCacheBudget(96 * 1024 * 1024);
+   this->setFocusPolicy(Qt::StrongFocus);
+   this->viewport()->setCursor(Qt::OpenHandCursor);
+}
+
+/* Destructs the view, its tile cache is no longer accounted. */
+IBTiledImageView::~IBTiledImageView()
+{
+   IBMemoryAccounting::setUsage(IBMemoryAccounting::ViewerTiles, 0, 0);
+}
+
+/* Sets the path (path) of the image to be displayed and scales it to fit into the viewport. Images, whose format
+   does not support region decoding, are decoded row by row, if their format allows it. TIFF images need no image
+   plugin then. RAW files are displayed by their largest embedded preview, which is decoded completely, so that it is
+   read only once. */
+void IBTiledImageView::setImagePath(const QString &path)
+{
+   QImageReader reader(path);
+   QFile file(path);
+   IBRawPreview preview(&file);
+   QScopedPointer<IBScanlineReader> rowreader;
+   IBTileLoader::Decoding decoding;
+   QSize imagesize;
+   bool raw;
+
+   this->strPath = path;
+   this->strMessage.clear();
+   this->chTiles.clear();
+   this->updateMemoryAccounting(0);
+   this->iGeneration++;
+
+   raw = IBRawPreview::isRawFileName(path) && file.open(QIODevice::ReadOnly) && preview.findPreview();
+   imagesize = raw ? preview.getPreviewSize() : reader.size();
+   decoding = IBTileLoader::FullDecoding;
+
+   if(!raw && reader.supportsOption(QImageIOHandler::ClipRect))
+   {
+      decoding = IBTileLoader::RegionDecoding;
+   }
+   else if(!raw && (file.isOpen() || file.open(QIODevice::ReadOnly)) && file.seek(0))
+   {
+      rowreader.reset(IBScanlineReader::create(&file, IBThumbnailDecoder::sniffFormat(file.peek(64))));
+
+      if(rowreader && rowreader->readHeader())
+      {
+         imagesize = rowreader->getSize();
+         decoding = IBTileLoader::RowDecoding;
+      }
+   }
+
+   if(!imagesize.isValid())
+   {
+      this->strMessage = QStringLiteral("The image cannot be read.");
+      imagesize = QSize();
+   }
+   else if(decoding == IBTileLoader::FullDecoding &&
+           qint64(imagesize.width()) * imagesize.height() > iMaxFullDecodePixels)
+   {
+      this->strMessage = QString("The image format %1 can neither be decoded by regions nor row by row. "
+                                 "Images of this format are only displayed up to %2 megapixels.")
+                                 .arg(QString(reader.format()).toUpper()).arg(iMaxFullDecodePixels / (1024 * 1024));
+      imagesize = QSize();
+   }
+
+   this->szImageSize = imagesize;
+   this->tlLoader->setImage(path, imagesize, decoding, this->iGeneration);
+
+   this->iMaxLevel = 0;
+   while(imagesize.isValid() &&
+         (IBTileLoader::getLevelSize(this->iMaxLevel, imagesize).width() > IBTileLoader::TileSize ||
+          IBTileLoader::getLevelSize(this->iMaxLevel, imagesize).height() > IBTileLoader::TileSize))
+   {
+      this->iMaxLevel++;
+   }
+
+   this->zoomToFit();
+}
+
+/* Returns the path of the displayed image. */
+QString IBTiledImageView::getImagePath() const
+{
+   return this->strPath;
+}
+
+/* Returns the size of the displayed image in full resolution. */
+QSize IBTiledImageView::getImageSize() const
+{
+   return this->szImageSize;
+}
+
+/* Sets the zoom factor (zoom) and keeps the image point under the given viewport position (anchor) in place. */
+void IBTiledImageView::setZoom(qreal zoom, const QPointF &anchor)
+{
+   QPointF imagepos;
+
+   zoom = qBound(qMin(this->getFitZoom(), 1.0), zoom, dMaxZoom);
+   imagepos = (anchor - this->getContentOrigin()) / this->dZoom;
+
+   this->dZoom = zoom;
+   this->updateScrollBars();
+
+   this->horizontalScrollBar()->setValue(qRound(imagepos.x() * zoom - anchor.x()));
+   this->verticalScrollBar()->setValue(qRound(imagepos.y() * zoom - anchor.y()));
+   this->viewport()->update();
+}
+
+/* Returns the zoom factor. */
+qreal IBTiledImageView::getZoom() const
+{
+   return this->dZoom;
+}
+
+/* Sets the upper bound (bytes) of the memory used by the decoded tiles. */
+void IBTiledImageView::setCacheBudget(qint64 bytes)
+{
+   this->chTiles.setMaxCost(bytes / 1024);
+   this->updateMemoryAccounting(0);
+}
+
+/* Returns the upper bound of the memory used by the decoded tiles. */
+qint64 IBTiledImageView::getCacheBudget() const
+{
+   return qint64(this->chTiles.maxCost()) * 1024;
+}
+
+/* Increases the zoom factor by one step around the center of the viewport. */
+void IBTiledImageView::zoomIn()
+{
+   this->bFitToView = false;
+   this->setZoom(this->dZoom * 1.25, QRectF(this->viewport()->rect()).center());
+}
+
+/* Decreases the zoom factor by one step around the center of the viewport. */
+void IBTiledImageView::zoomOut()
+{
+   this->bFitToView = false;
+   this->setZoom(this->dZoom / 1.25, QRectF(this->viewport()->rect()).center());
+}
+
+/* Scales the image to fit into the viewport. Images smaller than the viewport are displayed in their original size. */
+void IBTiledImageView::zoomToFit()
+{
+   this->bFitToView = true;
+   this->setZoom(qMin(this->getFitZoom(), 1.0), QRectF(this->viewport()->rect()).center());
+}
+
+/* Displays the image pixel by pixel around the center of the viewport. */
+void IBTiledImageView::zoomToOriginal()
+{
+   this->bFitToView = false;
+   this->setZoom(1.0, QRectF(this->viewport()->rect()).center());
+}
+
+/* reimpl. Draws the visible tiles of the pyramid level matching the zoom factor. Missing tiles are requested
+   from the loader and replaced by the scaled tiles of a coarser level, until they are decoded. */
+void IBTiledImageView::paintEvent(QPaintEvent *event)
+{
+   QPainter painter(this->viewport());
+   QList<quint64> missing;
+   QPointF origin = this->getContentOrigin();
+   QRect tilerect;
+   QRectF target, visible;
+   QSize levelsize;
+   QImage *tile;
+   quint64 key;
+   qreal levelscale;
+   int level, column, row, firstcolumn, lastcolumn, firstrow, lastrow;
+
+   painter.fillRect(event->rect(), this->palette().base());
+
+   if(!this->szImageSize.isValid())
+   {
+      painter.setPen(this->palette().color(QPalette::Text));
+      painter.drawText(this->viewport()->rect() - QMargins(20, 20, 20, 20),
+                       Qt::AlignCenter | Qt::TextWordWrap, this->strMessage);
+      return;
+   }
+
+   level = this->getLevelForZoom();
+   levelscale = this->dZoom * (1 << level);
+   levelsize = IBTileLoader::getLevelSize(level, this->szImageSize);
+
+   visible = QRectF((event->rect().left() - origin.x()) / levelscale, (event->rect().top() - origin.y()) / levelscale,
+                    event->rect().width() / levelscale, event->rect().height() / levelscale);
+
+   firstcolumn = qMax(0, int(visible.left()) / IBTileLoader::TileSize);
+   lastcolumn = qMin((levelsize.width() - 1) / IBTileLoader::TileSize, int(visible.right()) / IBTileLoader::TileSize);
+   firstrow = qMax(0, int(visible.top()) / IBTileLoader::TileSize);
+   lastrow = qMin((levelsize.height() - 1) / IBTileLoader::TileSize, int(visible.bottom()) / IBTileLoader::TileSize);
+
+   /* pixels of level 0 are drawn 1:1 without any interpolation */
+   painter.setRenderHint(QPainter::SmoothPixmapTransform, !qFuzzyCompare(levelscale, 1.0));
+
+   for(row = firstrow; row <= lastrow; row++)
+   {
+      for(column = firstcolumn; column <= lastcolumn; column++)
+      {
+         key = IBTileLoader::getTileKey(level, column, row);
+         tilerect = IBTileLoader::getTileRect(level, column, row, this->szImageSize);
+         target = QRectF(origin.x() + tilerect.x() * levelscale, origin.y() + tilerect.y() * levelscale,
+                         tilerect.width() * levelscale, tilerect.height() * levelscale);
+
+         tile = this->chTiles.object(key);
+
+         if(tile)
+         {
+            painter.drawImage(target, *tile);
+         }
+         else
+         {
+            missing.append(key);
+            this->paintCoarserTile(painter, level, tilerect, target);
+         }
+      }
+   }
+
+   this->tlLoader->request(missing);
+}
+
+/* Draws the part of the next available coarser tile which covers the tile (tilerect) of the given level (level)
+   into the target rectangle (target). */
+void IBTiledImageView::paintCoarserTile(QPainter &painter, int level, const QRect &tilerect, const QRectF &target)
+{
+   QRect coarserect, source;
+   QImage *tile;
+   int coarselevel, shift;
+
+   for(coarselevel = level + 1; coarselevel <= this->iMaxLevel; coarselevel++)
+   {
+      shift = coarselevel - level;
+      coarserect = QRect(tilerect.x() >> shift, tilerect.y() >> shift,
+                         qMax(1, tilerect.width() >> shift), qMax(1, tilerect.height() >> shift));
+
+      tile = this->chTiles.object(IBTileLoader::getTileKey(coarselevel, coarserect.x() / IBTileLoader::TileSize,
+                                                            coarserect.y() / IBTileLoader::TileSize));
+      if(tile)
+      {
+         source = coarserect.translated(-(coarserect.x() / IBTileLoader::TileSize) * IBTileLoader::TileSize,
+                                        -(coarserect.y() / IBTileLoader::TileSize) * IBTileLoader::TileSize);
+         painter.drawImage(target, *tile, source.intersected(tile->rect()));
+         return;
+      }
+   }
+}
+
+/* reimpl. Keeps the image fitted into the viewport, if it was fitted before. */
+void IBTiledImageView::resizeEvent(QResizeEvent *event)
+{
+   QAbstractScrollArea::resizeEvent(event);
+
+   if(this->bFitToView)
+   {
+      this->zoomToFit();
+   }
+   else
+   {
+      this->updateScrollBars();
+   }
+}
+
+/* reimpl. Zooms around the mouse position. */
+void IBTiledImageView::wheelEvent(QWheelEvent *event)
+{
+   int delta = event->angleDelta().y();
+
+   if(delta == 0)
+   {
+      return;
+   }
+
+   this->bFitToView = false;
+   this->setZoom(delta > 0 ? this->dZoom * 1.25 : this->dZoom / 1.25, event->position());
+   event->accept();
+}
+
+/* reimpl. Starts panning the image. */
+void IBTiledImageView::mousePressEvent(QMouseEvent *event)
+{
+   if(event->button() == Qt::LeftButton)
+   {
+      this->ptLastMousePos = event->pos();
+      this->viewport()->setCursor(Qt::ClosedHandCursor);
+   }
+}
+
+/* reimpl. Pans the image while the left mouse button is pressed. */
+void IBTiledImageView::mouseMoveEvent(QMouseEvent *event)
+{
+   QPoint delta;
+
+   if(event->buttons() & Qt::LeftButton)
+   {
+      delta = event->pos() - this->ptLastMousePos;
+      this->ptLastMousePos = event->pos();
+      this->horizontalScrollBar()->setValue(this->horizontalScrollBar()->value() - delta.x());
+      this->verticalScrollBar()->setValue(this->verticalScrollBar()->value() - delta.y());
+   }
+}
+
+/* reimpl. Stops panning the image. */
+void IBTiledImageView::mouseReleaseEvent(QMouseEvent *event)
+{
+   Q_UNUSED(event)
+
+   this->viewport()->setCursor(Qt::OpenHandCursor);
+}
+
+/* reimpl. Handles the zoom keys (+, -, 0 = fit into viewport, 1 = original size). */
+void IBTiledImageView::keyPressEvent(QKeyEvent *event)
+{
+   switch(event->key())
+   {
+      case Qt::Key_Plus:
+         this->zoomIn();
+         break;
+
+      case Qt::Key_Minus:
+         this->zoomOut();
+         break;
+
+      case Qt::Key_0:
+         this->zoomToFit();
+         break;
+
+      case Qt::Key_1:
+         this->zoomToOriginal();
+         break;
+
+      default:
+         QAbstractScrollArea::keyPressEvent(event);
+   }
+}
+
+/* Stores a decoded tile (tile) of the given key (key) in the cache and repaints the viewport. Tiles of
+   previously displayed images (generation) are discarded. */
+void IBTiledImageView::onTileLoaded(uint generation, quint64 key, const QImage &tile)
+{
+   if(generation != this->iGeneration || tile.isNull())
+   {
+      return;
+   }
+
+   this->chTiles.insert(key, new QImage(tile), qMax<qint64>(1, tile.sizeInBytes() / 1024));
+   this->updateMemoryAccounting(1);
+   this->viewport()->update();
+}
+
+/* Accounts the current size of the tile cache in IBMemoryAccounting and adds the number of inserted tiles
+   (allocations). */
+void IBTiledImageView::updateMemoryAccounting(qint64 allocations)
+{
+   IBMemoryAccounting::setUsage(IBMemoryAccounting::ViewerTiles, qint64(this->chTiles.totalCost()) * 1024,
+                                this->chTiles.size(), allocations);
+}
+
+/* Adjusts the ranges of the scroll bars to the zoomed image size. */
+void IBTiledImageView::updateScrollBars()
+{
+   QSize viewsize = this->viewport()->size();
+   int contentwidth = qCeil(this->szImageSize.width() * this->dZoom);
+   int contentheight = qCeil(this->szImageSize.height() * this->dZoom);
+
+   this->horizontalScrollBar()->setPageStep(viewsize.width());
+   this->horizontalScrollBar()->setSingleStep(qMax(1, viewsize.width() / 20));
+   this->horizontalScrollBar()->setRange(0, qMax(0, contentwidth - viewsize.width()));
+   this->verticalScrollBar()->setPageStep(viewsize.height());
+   this->verticalScrollBar()->setSingleStep(qMax(1, viewsize.height() / 20));
+   this->verticalScrollBar()->setRange(0, qMax(0, contentheight - viewsize.height()));
+}
+
+/* Returns the pyramid level whose resolution is the next larger or equal one of the zoom factor. */
+int IBTiledImageView::getLevelForZoom() const
+{
+   int level = 0;
+
+   while(level < this->iMaxLevel && this->dZoom * (2 << level) <= 1.0)
+   {
+      level++;
+   }
+
+   return level;
+}
+
+/* Returns the zoom factor with which the image fits into the viewport. */
+qreal IBTiledImageView::getFitZoom() const
+{
+   if(!this->szImageSize.isValid() || this->szImageSize.isEmpty())
+   {
+      return 1.0;
+   }
+
+   return qMin(qreal(this->viewport()->width()) / this->szImageSize.width(),
+               qreal(this->viewport()->height()) / this->szImageSize.height());
+}
+
+/* Returns the viewport position of the top left corner of the image. Images smaller than the viewport are centered. */
+QPointF IBTiledImageView::getContentOrigin() const
+{
+   qreal contentwidth = this->szImageSize.width() * this->dZoom;
+   qreal contentheight = this->szImageSize.height() * this->dZoom;
+   QPointF origin;
+
+   if(contentwidth < this->viewport()->width())
+   {
+      origin.setX(qRound((this->viewport()->width() - contentwidth) / 2));
+   }
+   else
+   {
+      origin.setX(-this->horizontalScrollBar()->value());
+   }
+
+   if(contentheight < this->viewport()->height())
+   {
+      origin.setY(qRound((this->viewport()->height() - contentheight) / 2));
+   }
+   else
+   {
+      origin.setY(-this->verticalScrollBar()->value());
+   }
+
+   return origin;
+}
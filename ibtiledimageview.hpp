@@ -0,0 +1,185 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBTILEDIMAGEVIEW
+#define H_IBTILEDIMAGEVIEW
+
+#include <QAbstractScrollArea>
+#include <QBuffer>
+#include <QCache>
+#include <QFile>
+#include <QImage>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QKeyEvent>
+#include <QList>
+#include <QMouseEvent>
+#include <QMutex>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QRect>
+#include <QResizeEvent>
+#include <QScopedPointer>
+#include <QScrollBar>
+#include <QSize>
+#include <QString>
+#include <QThread>
+#include <QtMath>
+#include <QVector>
+#include <QWaitCondition>
+#include <QWheelEvent>
+
+#include "ibmemoryaccounting.hpp"
+#include "ibrawpreview.hpp"
+#include "ibscanlinereader.hpp"
+#include "ibthumbnaildecoder.hpp"
+#include "ibtrace.hpp"
+
+/* class IBTileLoader */
+
+class IBTileLoader : public QThread
+{
+   Q_OBJECT
+
+   public:
+      /* edge length of a tile in pixels */
+      static const int TileSize = 256;
+
+      /* ways of decoding the tiles of an image */
+      enum Decoding
+      {
+         /* the image is decoded completely and the tiles are cut out of it */
+         FullDecoding,
+         /* every tile is decoded from its region of the image */
+         RegionDecoding,
+         /* the tiles are decoded from the rows of the image */
+         RowDecoding
+      };
+
+      IBTileLoader(QObject *parent = nullptr);
+      ~IBTileLoader();
+
+      void run() override;
+
+      void setImage(const QString &path, const QSize &imagesize, Decoding decoding, uint generation);
+      void request(const QList<quint64> &keys);
+      void stop();
+
+      static quint64 getTileKey(int level, int column, int row);
+      static QSize getLevelSize(int level, const QSize &imagesize);
+      static QRect getTileRect(int level, int column, int row, const QSize &imagesize);
+      static QRect getTileSourceRect(int level, const QRect &tilerect, const QSize &imagesize);
+
+   signals:
+      void tileLoaded(uint generation, quint64 key, const QImage &tile);
+
+   private:
+      QImage loadTile(quint64 key, const QString &path, const QSize &imagesize, Decoding decoding, uint generation);
+      QImage loadRowTile(int level, const QRect &tilerect, const QString &path, const QSize &imagesize,
+                         uint generation);
+      QImage readRows(const QString &path, const QSize &imagesize, int level, int firstrow, int rows, uint generation);
+      void releaseSource();
+
+      /* protects the queue and the image properties */
+      QMutex mtxQueue;
+      /* wakes the thread when new tiles are requested */
+      QWaitCondition wcQueue;
+      /* keys of the requested tiles */
+      QList<quint64> lstQueue;
+      /* path of the image to be tiled */
+      QString strPath;
+      /* size of the image in full resolution */
+      QSize szImageSize;
+      /* way of decoding the tiles of the image */
+      Decoding dcDecoding;
+      /* generation of the image, is changed with every new image */
+      uint iGeneration;
+      /* fully decoded image or the image reduced to the level iSourceLevel, only used by the thread */
+      QImage imgSource;
+      /* generation of the decoded image and the row reader */
+      uint iSourceGeneration;
+      /* level of the image reduced from all its rows, the finer levels are decoded in bands of one tile row */
+      int iSourceLevel;
+      /* file of the row reader */
+      QFile fileSource;
+      /* reader of the image rows, which is kept open for the following bands */
+      IBScanlineReader *srReader;
+      /* band of the last decoded tile row with the full width of its level */
+      QImage imgBand;
+      /* level of the band */
+      int iBandLevel;
+      /* tile row of the band */
+      int iBandRow;
+      /* reusable row of the row reader */
+      QVector<QRgb> vecScanline;
+};
+
+/* class IBTiledImageView */
+
+class IBTiledImageView : public QAbstractScrollArea
+{
+   Q_OBJECT
+
+   public:
+      IBTiledImageView(QWidget *parent = nullptr);
+      ~IBTiledImageView();
+
+      void setImagePath(const QString &path);
+      QString getImagePath() const;
+      QSize getImageSize() const;
+
+      void setZoom(qreal zoom, const QPointF &anchor);
+      qreal getZoom() const;
+
+      void setCacheBudget(qint64 bytes);
+      qint64 getCacheBudget() const;
+
+   public slots:
+      void zoomIn();
+      void zoomOut();
+      void zoomToFit();
+      void zoomToOriginal();
+
+   protected:
+      void paintEvent(QPaintEvent *event) override;
+      void resizeEvent(QResizeEvent *event) override;
+      void wheelEvent(QWheelEvent *event) override;
+      void mousePressEvent(QMouseEvent *event) override;
+      void mouseMoveEvent(QMouseEvent *event) override;
+      void mouseReleaseEvent(QMouseEvent *event) override;
+      void keyPressEvent(QKeyEvent *event) override;
+
+   private slots:
+      void onTileLoaded(uint generation, quint64 key, const QImage &tile);
+
+   private:
+      void updateMemoryAccounting(qint64 allocations);
+      void updateScrollBars();
+      void paintCoarserTile(QPainter &painter, int level, const QRect &tilerect, const QRectF &target);
+      int getLevelForZoom() const;
+      qreal getFitZoom() const;
+      QPointF getContentOrigin() const;
+
+      /* decodes the tiles in the background */
+      IBTileLoader *tlLoader;
+      /* decoded tiles of all levels, the cost of a tile is its size in KiB */
+      QCache<quint64, QImage> chTiles;
+      /* path of the displayed image */
+      QString strPath;
+      /* size of the displayed image in full resolution */
+      QSize szImageSize;
+      /* level of the pyramid whose whole image fits into one tile */
+      int iMaxLevel;
+      /* generation of the displayed image */
+      uint iGeneration;
+      /* number of viewport pixels per image pixel */
+      qreal dZoom;
+      /* is true if the image is scaled to fit into the viewport */
+      bool bFitToView;
+      /* last mouse position while panning */
+      QPoint ptLastMousePos;
+      /* message shown instead of the image, if it cannot be displayed */
+      QString strMessage;
+};
+
+#endif /*H_IBTILEDIMAGEVIEW*/
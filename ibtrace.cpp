@@ -0,0 +1,160 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#include "ibtrace.hpp"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+
+std::atomic<bool> IBTrace::bEnabled(false);
+QMutex IBTrace::mtxEvents;
+QVector<IBTraceEvent> IBTrace::vecEvents;
+QHash<quint64, QString> IBTrace::hshThreadNames;
+QElapsedTimer IBTrace::etClock;
+QString IBTrace::strFileName;
+
+/* class IBTrace */
+
+/* Starts the recording of a trace, which is written to the given file (filename) by stop. Returns false if a trace
+   is already recorded. */
+bool IBTrace::start(const QString &filename)
+{
+   QMutexLocker locker(&IBTrace::mtxEvents);
+
+   if(IBTrace::bEnabled.load() || filename.isEmpty())
+   {
+      return false;
+   }
+
+   IBTrace::strFileName = filename;
+   IBTrace::vecEvents.clear();
+   IBTrace::vecEvents.reserve(64 * 1024);
+   IBTrace::hshThreadNames.clear();
+   IBTrace::etClock.start();
+   IBTrace::bEnabled.store(true);
+
+   return true;
+}
+
+/* Stops the recording and writes the events in the trace event format of Chrome and Perfetto. It returns false if
+   no trace is recorded or the file cannot be written. */
+bool IBTrace::stop()
+{
+   QMutexLocker locker(&IBTrace::mtxEvents);
+   QHash<quint64, QString>::const_iterator it;
+   QVector<IBTraceEvent>::const_iterator eit;
+   QFile file;
+   QByteArray line;
+   qint64 pid = QCoreApplication::applicationPid();
+
+   if(!IBTrace::bEnabled.load())
+   {
+      return false;
+   }
+
+   IBTrace::bEnabled.store(false);
+   file.setFileName(IBTrace::strFileName);
+
+   if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+   {
+      return false;
+   }
+
+   file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+   for(it = IBTrace::hshThreadNames.constBegin(); it != IBTrace::hshThreadNames.constEnd(); ++it)
+   {
+      line = QString("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%1,\"tid\":%2,\"args\":{\"name\":\"%3\"}},\n")
+                .arg(pid).arg(it.key()).arg(it.value()).toUtf8();
+      file.write(line);
+   }
+
+   for(eit = IBTrace::vecEvents.constBegin(); eit != IBTrace::vecEvents.constEnd(); ++eit)
+   {
+      if(eit->chPhase == 'X')
+      {
+         line = QString("{\"ph\":\"X\",\"cat\":\"%1\",\"name\":\"%2\",\"pid\":%3,\"tid\":%4,\"ts\":%5,\"dur\":%6},\n")
+                   .arg(QLatin1String(eit->chCategory), QLatin1String(eit->chName)).arg(pid).arg(eit->iThreadId)
+                   .arg(eit->iTimestamp / 1000.0, 0, 'f', 3).arg(eit->iValue / 1000.0, 0, 'f', 3).toUtf8();
+      }
+      else
+      {
+         line = QString("{\"ph\":\"C\",\"cat\":\"%1\",\"name\":\"%2\",\"pid\":%3,\"tid\":%4,\"ts\":%5,"
+                        "\"args\":{\"value\":%6}},\n")
+                   .arg(QLatin1String(eit->chCategory), QLatin1String(eit->chName)).arg(pid).arg(eit->iThreadId)
+                   .arg(eit->iTimestamp / 1000.0, 0, 'f', 3).arg(eit->iValue).toUtf8();
+      }
+
+      file.write(line);
+   }
+
+   /* the trailing metadata event avoids a dangling comma */
+   file.write(QString("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%1,\"args\":{\"name\":\"%2\"}}\n]}\n")
+                 .arg(pid).arg(QCoreApplication::applicationName()).toUtf8());
+
+   IBTrace::vecEvents = QVector<IBTraceEvent>();
+   IBTrace::hshThreadNames.clear();
+
+   return file.error() == QFileDevice::NoError;
+}
+
+/* Returns the time since the start of the trace in nanoseconds. */
+qint64 IBTrace::getTimestamp()
+{
+   return IBTrace::etClock.nsecsElapsed();
+}
+
+/* Adds a span of the given category (category) and name (name), which started at the given time (start) and took
+   the given time (duration) in nanoseconds. */
+void IBTrace::addSpan(const char *category, const char *name, qint64 start, qint64 duration)
+{
+   IBTraceEvent event = {name, category, 'X', start, duration, IBTrace::getThreadId()};
+
+   IBTrace::addEvent(event);
+}
+
+/* Adds the current value (value) of the counter of the given category (category) and name (name). */
+void IBTrace::addCounter(const char *category, const char *name, qint64 value)
+{
+   IBTraceEvent event = {name, category, 'C', IBTrace::getTimestamp(), value, IBTrace::getThreadId()};
+
+   IBTrace::addEvent(event);
+}
+
+/* Adds an event (event) and registers the name of its thread. */
+void IBTrace::addEvent(const IBTraceEvent &event)
+{
+   QMutexLocker locker(&IBTrace::mtxEvents);
+   QThread *thread;
+
+   if(!IBTrace::bEnabled.load(std::memory_order_relaxed))
+   {
+      return;
+   }
+
+   if(!IBTrace::hshThreadNames.contains(event.iThreadId))
+   {
+      thread = QThread::currentThread();
+
+      if(QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+      {
+         IBTrace::hshThreadNames.insert(event.iThreadId, QStringLiteral("GUI"));
+      }
+      else
+      {
+         IBTrace::hshThreadNames.insert(event.iThreadId, thread->objectName().isEmpty()
+                                                            ? QString(thread->metaObject()->className())
+                                                            : thread->objectName());
+      }
+   }
+
+   IBTrace::vecEvents.append(event);
+}
+
+/* Returns the id of the current thread. */
+quint64 IBTrace::getThreadId()
+{
+   return quint64(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+}
@@ -0,0 +1,100 @@
+/* Copyright (C) 2022 Martin Pietsch <@pmfoss>
+   SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef H_IBTRACE
+#define H_IBTRACE
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+/* creates a span from the declaration to the end of the enclosing scope, if the tracing is enabled */
+#define IB_TRACE_CONCAT2(a, b) a##b
+#define IB_TRACE_CONCAT(a, b) IB_TRACE_CONCAT2(a, b)
+#define IB_TRACE_SCOPE(category, name) IBTraceScope IB_TRACE_CONCAT(ibtracescope, __LINE__)(category, name)
+/* records the value of a counter, e.g. a queue depth, if the tracing is enabled */
+#define IB_TRACE_COUNTER(category, name, value) \
+   do { if(IBTrace::isEnabled()) { IBTrace::addCounter(category, name, value); } } while(0)
+
+/* event of a trace */
+struct IBTraceEvent
+{
+   /* name and category of the event, they have to be string literals */
+   const char *chName;
+   const char *chCategory;
+   /* type of the event: 'X' for spans and 'C' for counters */
+   char chPhase;
+   /* start of the event in nanoseconds since the start of the trace */
+   qint64 iTimestamp;
+   /* duration of the span in nanoseconds or value of the counter */
+   qint64 iValue;
+   /* id of the thread, which recorded the event */
+   quint64 iThreadId;
+};
+
+/* class IBTrace */
+
+class IBTrace
+{
+   public:
+      static bool start(const QString &filename);
+      static bool stop();
+      static inline bool isEnabled() { return bEnabled.load(std::memory_order_relaxed); }
+
+      static qint64 getTimestamp();
+      static void addSpan(const char *category, const char *name, qint64 start, qint64 duration);
+      static void addCounter(const char *category, const char *name, qint64 value);
+
+   private:
+      static void addEvent(const IBTraceEvent &event);
+      static quint64 getThreadId();
+
+      /* is true while a trace is recorded */
+      static std::atomic<bool> bEnabled;
+      /* protects the events and the thread names */
+      static QMutex mtxEvents;
+      /* recorded events */
+      static QVector<IBTraceEvent> vecEvents;
+      /* names of the threads, which recorded events */
+      static QHash<quint64, QString> hshThreadNames;
+      /* measures the time since the start of the trace */
+      static QElapsedTimer etClock;
+      /* file, which receives the trace */
+      static QString strFileName;
+};
+
+/* class IBTraceScope */
+
+class IBTraceScope
+{
+   public:
+      /* Starts a span of the given category (category) and name (name), if the tracing is enabled. */
+      inline IBTraceScope(const char *category, const char *name)
+         : chCategory(category), chName(name), iStart(IBTrace::isEnabled() ? IBTrace::getTimestamp() : -1)
+      {
+      }
+
+      /* Finishes the span. */
+      inline ~IBTraceScope()
+      {
+         if(this->iStart >= 0 && IBTrace::isEnabled())
+         {
+            IBTrace::addSpan(this->chCategory, this->chName, this->iStart, IBTrace::getTimestamp() - this->iStart);
+         }
+      }
+
+   private:
+      Q_DISABLE_COPY(IBTraceScope)
+
+      /* category and name of the span */
+      const char *chCategory;
+      const char *chName;
+      /* start of the span or -1 if the tracing is disabled */
+      qint64 iStart;
+};
+
+#endif /*H_IBTRACE*/
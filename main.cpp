@@ -2,14 +2,186 @@
    SPDX-License-Identifier: BSD-3-Clause */
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QTextStream>
+#include "ibdirectoryindex.hpp"
 #include "ibmainwindow.hpp"
+#include "ibmemoryaccounting.hpp"
+#include "ibthumbnailbatch.hpp"
+#include "ibtrace.hpp"
+
+/* Returns true, if the arguments (argc, argv) request the batch generation of thumbnails. It is checked before the
+   application object is constructed, because the batch generation must not connect to a display. */
+static bool isBatchMode(int argc, char **argv)
+{
+  int idx;
+
+  for(idx = 1; idx < argc; idx++)
+  {
+     if(qstrcmp(argv[idx], "--generate-thumbs") == 0 || qstrncmp(argv[idx], "--generate-thumbs=", 18) == 0)
+     {
+        return true;
+     }
+  }
+
+  return false;
+}
+
+/* Generates the thumbnails of the images in the directory (dir) and its subdirectories, if recursive is true, with the
+   given number of threads (jobs) into the thumbnail cache. The report is written to the standard output. Returns 0 on
+   success, 1 if the generation could not be started and 2 if thumbnails failed. */
+static int generateThumbnails(const QString &dir, bool recursive, int jobs)
+{
+  QTextStream out(stdout), err(stderr);
+  IBThumbnailBatchStatistics stats;
+  IBThumbnailBatch batch;
+  QStringList files;
+
+  if(!QFileInfo(dir).isDir())
+  {
+     err << "not a directory: " << dir << '\n';
+     return 1;
+  }
+
+  if(!batch.getCache().isEnabled())
+  {
+     err << "no thumbnail cache directory, use --thumbnail-cache\n";
+     return 1;
+  }
+
+  batch.setRecursive(recursive);
+
+  if(jobs > 0)
+  {
+     batch.setJobs(jobs);
+  }
+
+  files = batch.findImages(dir);
+  err << "generating " << files.size() << " thumbnails with " << batch.getJobs() << " threads into "
+      << batch.getCache().getCacheDir() << '\n';
+  err.flush();
+
+  stats = batch.generate(files);
+  out << IBThumbnailBatch::createReport(stats);
+
+  return stats.iFailures > 0 ? 2 : 0;
+}
+
+/* Records the time from the start (startup) to a start-up milestone (name) as a span of the trace and writes it to
+   the standard error output, if report is true. */
+static void reportStartup(const QElapsedTimer &startup, const char *name, bool report)
+{
+  qint64 elapsed = startup.nsecsElapsed();
+  qint64 now, start;
+
+  /* the trace clock is started after the application object, the span is clipped at its start */
+  if(IBTrace::isEnabled())
+  {
+     now = IBTrace::getTimestamp();
+     start = qMax<qint64>(0, now - elapsed);
+     IBTrace::addSpan("startup", name, start, now - start);
+  }
+
+  if(report)
+  {
+     QTextStream(stderr) << "startup: " << name << " after " << QString::number(elapsed / 1e6, 'f', 1) << " ms\n";
+  }
+}
 
 int main(int argc, char **argv)
 {
-  QApplication app(argc, argv);
-  IBMainWindow mainwin;
+  QElapsedTimer startup;
+  startup.start();
+
+  QScopedPointer<QCoreApplication> app(isBatchMode(argc, argv) ? new QCoreApplication(argc, argv)
+                                                               : new QApplication(argc, argv));
+  QCommandLineParser parser;
+  QCommandLineOption traceoption("trace", "Writes a trace of the loading and painting stages in the Chrome trace "
+                                          "event format into the file. The environment variable IB_TRACE has the "
+                                          "same effect.", "file");
+  QCommandLineOption generateoption("generate-thumbs", "Generates the thumbnails of the images in the directory "
+                                                       "into the thumbnail cache without a display and exits.", "dir");
+  QCommandLineOption recursiveoption("recursive", "Includes the subdirectories in --generate-thumbs.");
+  QCommandLineOption jobsoption("jobs", "Number of threads of --generate-thumbs, by default one per core.", "n");
+  QCommandLineOption cacheoption("thumbnail-cache", "Directory of the thumbnail cache. The environment variable "
+                                                    "IB_THUMBNAIL_CACHE has the same effect.", "dir");
+  QCommandLineOption indexoption("directory-index", "Directory of the indexes of the image directories. The "
+                                                    "environment variable IB_DIRECTORY_INDEX has the same effect.",
+                                 "dir");
+  QCommandLineOption similarityoption("similarity-distance", "Maximal Hamming distance of the perceptual hashes of "
+                                                            "images, which are sectioned as similar, by default 6.",
+                                      "n");
+  QCommandLineOption startupoption("startup-time", "Writes the time from the start to the first painted frame and "
+                                                  "to the first painted thumbnail to the standard error output.");
+  QString tracefile = qEnvironmentVariable("IB_TRACE");
+  int ret;
+
+  parser.addHelpOption();
+  parser.addOption(traceoption);
+  parser.addOption(generateoption);
+  parser.addOption(recursiveoption);
+  parser.addOption(jobsoption);
+  parser.addOption(cacheoption);
+  parser.addOption(indexoption);
+  parser.addOption(similarityoption);
+  parser.addOption(startupoption);
+  parser.process(*app);
+
+  if(parser.isSet(traceoption))
+  {
+     tracefile = parser.value(traceoption);
+  }
+
+  if(parser.isSet(cacheoption))
+  {
+     IBThumbnailCache::setDefaultCacheDir(parser.value(cacheoption));
+  }
+
+  if(parser.isSet(indexoption))
+  {
+     IBDirectoryIndex::setDefaultIndexDir(parser.value(indexoption));
+  }
+
+  if(!tracefile.isEmpty())
+  {
+     IBTrace::start(tracefile);
+  }
+
+  if(parser.isSet(generateoption))
+  {
+     ret = generateThumbnails(parser.value(generateoption), parser.isSet(recursiveoption),
+                              parser.value(jobsoption).toInt());
+  }
+  else
+  {
+     /* kill -USR1 <pid> writes the memory report to the standard error output */
+     IBMemoryAccounting::installReportSignal();
+
+     IBMainWindow mainwin;
+     bool report = parser.isSet(startupoption);
+
+     QObject::connect(&mainwin, &IBMainWindow::firstFramePainted, [&startup, report]()
+        {
+           reportStartup(startup, "firstFrame", report);
+        });
+     QObject::connect(&mainwin, &IBMainWindow::firstThumbnailPainted, [&startup, report]()
+        {
+           reportStartup(startup, "firstThumbnail", report);
+        });
+
+     if(parser.isSet(similarityoption))
+     {
+        mainwin.setSimilarityDistance(parser.value(similarityoption).toInt());
+     }
+
+     mainwin.showMaximized();
+
+     ret = app->exec();
+  }
 
-  mainwin.showMaximized();
+  IBTrace::stop();
 
-  return app.exec();
+  return ret;
 }
@@ -0,0 +1,62 @@
+######################################################################
+# Sources of the Simple Image Browser without the main function, which
+# are shared by the application and the benchmarks
+######################################################################
+
+INCLUDEPATH += $$PWD
+QT += widgets gui
+
+# zlib is used to decode oversized PNG images row by row for the thumbnails
+unix {
+   DEFINES += IB_HAVE_ZLIB
+   LIBS += -lz
+}
+
+HEADERS += $$PWD/ibdirectoryindex.hpp \
+           $$PWD/ibdirectoryprefetcher.hpp \
+           $$PWD/ibdirectorytreemodel.hpp \
+           $$PWD/ibdirectorywalker.hpp \
+           $$PWD/ibexifreader.hpp \
+           $$PWD/ibfilecombobox.hpp \
+           $$PWD/ibfilenameindex.hpp \
+           $$PWD/ibimagecolor.hpp \
+           $$PWD/ibimagehash.hpp \
+           $$PWD/ibimageinfowidget.hpp \
+           $$PWD/ibimagescaler.hpp \
+           $$PWD/ibimagelistmodel.hpp \
+           $$PWD/ibimagelistwidget.hpp \
+           $$PWD/ibitemdelegate.hpp \
+           $$PWD/ibmainwindow.hpp \
+           $$PWD/ibmemoryaccounting.hpp \
+           $$PWD/ibpreviewprefetcher.hpp \
+           $$PWD/ibrawpreview.hpp \
+           $$PWD/ibscanlinereader.hpp \
+           $$PWD/ibthumbnailbatch.hpp \
+           $$PWD/ibthumbnailcache.hpp \
+           $$PWD/ibthumbnaildecoder.hpp \
+           $$PWD/ibtiledimageview.hpp \
+           $$PWD/ibtrace.hpp
+SOURCES += $$PWD/ibdirectoryindex.cpp \
+           $$PWD/ibdirectoryprefetcher.cpp \
+           $$PWD/ibdirectorytreemodel.cpp \
+           $$PWD/ibdirectorywalker.cpp \
+           $$PWD/ibexifreader.cpp \
+           $$PWD/ibfilecombobox.cpp \
+           $$PWD/ibfilenameindex.cpp \
+           $$PWD/ibimagecolor.cpp \
+           $$PWD/ibimagehash.cpp \
+           $$PWD/ibimageinfowidget.cpp \
+           $$PWD/ibimagescaler.cpp \
+           $$PWD/ibimagelistmodel.cpp \
+           $$PWD/ibimagelistwidget.cpp \
+           $$PWD/ibitemdelegate.cpp \
+           $$PWD/ibmainwindow.cpp \
+           $$PWD/ibmemoryaccounting.cpp \
+           $$PWD/ibpreviewprefetcher.cpp \
+           $$PWD/ibrawpreview.cpp \
+           $$PWD/ibscanlinereader.cpp \
+           $$PWD/ibthumbnailbatch.cpp \
+           $$PWD/ibthumbnailcache.cpp \
+           $$PWD/ibthumbnaildecoder.cpp \
+           $$PWD/ibtiledimageview.cpp \
+           $$PWD/ibtrace.cpp
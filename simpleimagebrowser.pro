@@ -14,17 +14,7 @@ QT += widgets gui
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(simpleimagebrowser.pri)
+
 # Input
-HEADERS += ibfilecombobox.hpp \
-           ibimageinfowidget.hpp \
-           ibimagelistmodel.hpp \
-           ibimagelistwidget.hpp \
-           ibitemdelegate.hpp \
-           ibmainwindow.hpp
-SOURCES += ibfilecombobox.cpp \
-           ibimageinfowidget.cpp \
-           ibimagelistmodel.cpp \
-           ibimagelistwidget.cpp \
-           ibitemdelegate.cpp \
-           ibmainwindow.cpp \
-           main.cpp
+SOURCES += main.cpp